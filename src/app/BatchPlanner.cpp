@@ -0,0 +1,63 @@
+#include "app/BatchPlanner.hpp"
+
+#include "domain/chess/Position.hpp"
+#include "domain/chess_san_to_fen.hpp"
+
+#include <unordered_set>
+
+namespace sf::client::app {
+
+using namespace sf::client::domain::chess;
+
+namespace {
+
+// "12. Nf3" / "12... Nf6" for ply index i of a game starting at startFen.
+std::string moveLabel(const Position& start, int ply, const std::string& san) {
+    const int fromBlack = start.sideToMove() == Color::Black ? 1 : 0;
+    const int halfMoves = ply + fromBlack;
+    const int moveNo = start.fullmoveNumber() + halfMoves / 2;
+    return std::to_string(moveNo) + (halfMoves % 2 == 0 ? ". " : "... ") + san;
+}
+
+} // namespace
+
+BatchPlan planBatch(const std::vector<BatchGame>& games) {
+    BatchPlan plan;
+    std::unordered_set<std::uint64_t> seen;
+
+    for (const auto& game : games) {
+        // Lazy: positions are packed, FENs only built for the ones we keep.
+        const auto timeline = fenTimelineFromSanMoves(game.movetext, game.startFen, FenTimelineMode::Lazy);
+        if (!timeline.ok) {
+            plan.errors.push_back(game.label + ": " + timeline.error);
+            continue;
+        }
+        ++plan.games;
+
+        const auto start = Position::fromFen(timeline.startFen);
+        if (!start) {
+            continue;
+        }
+
+        const auto add = [&](std::uint64_t key, int ply, std::string label) {
+            if (!seen.insert(key).second) {
+                ++plan.duplicates;
+                return;
+            }
+            plan.positions.push_back(BatchPosition{std::move(label), timeline.fenAt(ply), key});
+        };
+
+        add(start->key(), -1, game.label + ", start");
+        const int n = static_cast<int>(timeline.plies.size());
+        for (int ply = 0; ply < n; ++ply) {
+            // Key of the position after ply = key before the next one.
+            const std::uint64_t key = ply + 1 < n
+                ? timeline.plies[static_cast<std::size_t>(ply + 1)].posHashBefore
+                : Position::unpack(timeline.packedAfter[static_cast<std::size_t>(ply)]).key();
+            add(key, ply, game.label + ", " + moveLabel(*start, ply, timeline.plies[static_cast<std::size_t>(ply)].san));
+        }
+    }
+    return plan;
+}
+
+} // namespace sf::client::app
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sf::client::app {
+
+// Batch analysis input: one game (ICCF game, PGN game, ...).
+struct BatchGame {
+    std::string                label;    // e.g. "ICCF #123: A vs B"
+    std::string                movetext; // SAN / PGN movetext
+    std::optional<std::string> startFen; // SetUp games; nullopt = standard start
+};
+
+struct BatchPosition {
+    std::string   label; // game label plus the move that led here
+    std::string   fen;
+    std::uint64_t key{0}; // Zobrist key (no move counters)
+};
+
+struct BatchPlan {
+    std::vector<BatchPosition> positions;
+    int                        games{0};      // games that could be replayed
+    int                        duplicates{0}; // positions dropped as already listed
+    std::vector<std::string>   errors;        // one per game that could not be replayed
+};
+
+// Every position of every game (the start position and the one after each
+// ply), first occurrence only: transpositions and shared openings are
+// analysed once. A game whose movetext does not replay is skipped with an
+// entry in errors.
+BatchPlan planBatch(const std::vector<BatchGame>& games);
+
+} // namespace sf::client::app
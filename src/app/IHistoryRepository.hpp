@@ -1,11 +1,34 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "domain/domain_model.hpp"
 
 namespace sf::client::app {
 
+// A finished result that can answer later jobs on the same position.
+struct CachedAnalysis {
+    sf::client::domain::JobId       jobId;      // job that produced it
+    int                             limitValue{0};
+    int                             multiPv{1};
+    sf::client::domain::JobSnapshot snapshot;
+};
+
+// Keyset position in the history (newest first): the last row already seen.
+struct HistoryCursor {
+    std::int64_t              createdAtMs{0};
+    sf::client::domain::JobId id;
+};
+
+struct HistoryPage {
+    std::vector<sf::client::domain::Job> jobs;
+    std::optional<HistoryCursor>         next; // nullopt = no more rows
+};
+
 // Port/interface for persisting and loading terminal jobs history.
 // Implementations live in infra (e.g. SQLite via QtSql).
 class IHistoryRepository {
@@ -14,8 +37,38 @@ public:
 
     virtual void saveJob(const sf::client::domain::Job& job) = 0;
 
-    // Load all saved jobs (terminal history).
+    // Load all saved jobs (terminal history), with snapshots and logs.
     virtual std::vector<sf::client::domain::Job> loadAllJobs() const = 0;
+
+    // Up to limit jobs older than after (nullopt = from the newest). Rows
+    // carry metadata only, plus the snapshot if withSnapshots; never logs.
+    virtual HistoryPage loadJobsPage(const std::optional<HistoryCursor>& after,
+                                     int limit,
+                                     bool withSnapshots = false) const = 0;
+
+    // Snapshot and log of one job, for a row loaded by loadJobsPage().
+    virtual std::optional<sf::client::domain::Job> loadJobDetails(const sf::client::domain::JobId& id) const = 0;
+
+    // Every saved job, newest first, handed to visit one at a time (with its
+    // log if withLogs) until visit returns false; total is the row count.
+    // Safe to call from any thread. Returns false if history is unreadable.
+    using JobVisitor = std::function<bool(const sf::client::domain::Job& job, int total)>;
+    virtual bool scanJobs(bool withLogs, const JobVisitor& visit) const = 0;
+
+    // The job left memory (removed or evicted) after its last saveJob():
+    // per-job save state can go.
+    virtual void forgetJob(const sf::client::domain::JobId& /*id*/) {}
+
+    // Analysis cache keyed by the position's Zobrist key (no move counters,
+    // so transpositions hit too), limit type and MultiPV. A save keeps the
+    // deeper of the stored and the new result; find returns the deepest
+    // entry with at least multiPv lines.
+    virtual void saveCachedAnalysis(std::uint64_t /*positionKey*/, const sf::client::domain::Job& /*job*/) {}
+    virtual std::optional<CachedAnalysis> findCachedAnalysis(std::uint64_t /*positionKey*/,
+                                                             sf::client::domain::LimitType /*type*/,
+                                                             int /*multiPv*/) const {
+        return std::nullopt;
+    }
 };
 
 } // namespace sf::client::app
@@ -0,0 +1,318 @@
+#include "app/IccfAnalysisPipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include "app/JobManager.hpp"
+#include "domain/chess_san_to_fen.hpp"
+#include "domain/chess/Position.hpp"
+#include "infra/refdb/ReferenceDbQuery.hpp"
+
+namespace sf::client::app {
+
+using sf::client::domain::Job;
+using sf::client::domain::JobStatus;
+using sf::client::domain::chess::Move;
+using sf::client::domain::chess::Position;
+using sf::client::infra::iccf::IccfGame;
+using sf::client::infra::refdb::ReferenceDbQuery;
+
+namespace {
+
+// A lookup the DB thread has not answered by then (closed meanwhile, query
+// failed) falls back to the MultiPV probe.
+constexpr auto kReferenceTimeout = std::chrono::seconds(5);
+
+} // namespace
+
+IccfAnalysisPipeline::IccfAnalysisPipeline(JobManager& jobManager, QObject* parent)
+    : QObject(parent)
+    , jobManager_(jobManager) {
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(0);
+    QObject::connect(&flushTimer_, &QTimer::timeout, this, &IccfAnalysisPipeline::flush);
+    referenceTimer_.setSingleShot(true);
+    QObject::connect(&referenceTimer_, &QTimer::timeout, this, &IccfAnalysisPipeline::onReferenceTimeout);
+}
+
+void IccfAnalysisPipeline::setEnabled(bool on) {
+    enabled_ = on;
+    if (!on) {
+        // Jobs already submitted run on; nothing new is queued.
+        pendingGames_.clear();
+        finishedProbes_.clear();
+        probes_.clear();
+        lastKey_.clear();
+        referenceLookups_.clear();
+        referenceTimer_.stop();
+    }
+}
+
+void IccfAnalysisPipeline::setOptions(IccfAnalysisOptions options) {
+    options.multiPv    = std::max(1, options.multiPv);
+    options.replyCount = std::max(0, options.replyCount);
+    options_ = options;
+}
+
+void IccfAnalysisPipeline::setReferenceQuery(ReferenceDbQuery* query) {
+    if (refQuery_) {
+        QObject::disconnect(refQuery_, nullptr, this, nullptr);
+    }
+    refQuery_ = query;
+    if (refQuery_) {
+        QObject::connect(refQuery_, &ReferenceDbQuery::positionReady, this, &IccfAnalysisPipeline::onReferencePosition);
+    }
+}
+
+void IccfAnalysisPipeline::onGamesChanged(const IccfGamesDelta& delta) {
+    if (!enabled_) return;
+    for (const int id : delta.analysisIds) {
+        for (const QVector<IccfGame>* list : {&delta.changed, &delta.added}) {
+            const auto it = std::find_if(list->begin(), list->end(), [id](const IccfGame& g) { return g.id == id; });
+            if (it != list->end()) {
+                queueGame(*it);
+                break;
+            }
+        }
+    }
+}
+
+void IccfAnalysisPipeline::analyzeAll(const QVector<IccfGame>& games) {
+    if (!enabled_) return;
+    for (const IccfGame& g : games) {
+        queueGame(g);
+    }
+}
+
+void IccfAnalysisPipeline::onJobUpdated(const Job& job) {
+    const auto it = probes_.find(job.id);
+    if (it == probes_.end()) return;
+    switch (job.status) {
+        case JobStatus::Finished:
+            finishedProbes_.push_back(job.id);
+            scheduleFlush();
+            break;
+        case JobStatus::Error:
+        case JobStatus::Cancelled:
+        case JobStatus::Stopped: // the user does not want these replies
+            probes_.erase(it);
+            break;
+        default:
+            break;
+    }
+}
+
+int IccfAnalysisPipeline::myTurnPriority(const IccfGame& game) {
+    const int minutesLeft = game.daysPlayer * 1440 + game.hoursPlayer * 60 + game.minutesPlayer;
+    const int daysLeft = std::max(0, minutesLeft) / 1440;
+    return kMyTurnPriority + std::clamp(kUrgencyDays - daysLeft, 0, kUrgencyDays);
+}
+
+void IccfAnalysisPipeline::queueGame(const IccfGame& game) {
+    const auto it = std::find_if(pendingGames_.begin(), pendingGames_.end(),
+                                 [&](const IccfGame& g) { return g.id == game.id; });
+    if (it != pendingGames_.end()) {
+        *it = game;
+    } else {
+        pendingGames_.push_back(game);
+    }
+    scheduleFlush();
+}
+
+void IccfAnalysisPipeline::scheduleFlush() {
+    if (!flushTimer_.isActive()) {
+        flushTimer_.start();
+    }
+}
+
+void IccfAnalysisPipeline::flush() {
+    if (!enabled_) return;
+
+    const QVector<IccfGame> games = std::move(pendingGames_);
+    pendingGames_.clear();
+    for (const IccfGame& g : games) {
+        submitGame(g);
+    }
+
+    // Probes answered from the cache finish inside submitGame() and land
+    // here too.
+    while (!finishedProbes_.empty()) {
+        const auto done = std::move(finishedProbes_);
+        finishedProbes_.clear();
+        for (const auto& id : done) {
+            const auto it = probes_.find(id);
+            if (it == probes_.end()) continue;
+            const Probe probe = it->second;
+            probes_.erase(it);
+            if (const Job* job = jobManager_.jobById(id)) {
+                expandProbe(probe, *job);
+            }
+        }
+    }
+}
+
+void IccfAnalysisPipeline::submitGame(const IccfGame& game) {
+    const std::optional<Position> start = (game.setup && !game.fen.trimmed().isEmpty())
+        ? Position::fromFen(game.fen.trimmed().toStdString())
+        : std::optional<Position>(Position::startpos());
+    if (!start) {
+        emit status(tr("ICCF #%1: invalid start FEN, not analysed").arg(game.id));
+        return;
+    }
+
+    const std::string moves = game.moves.toStdString();
+    sf::client::domain::chess::SanReplay replay(moves, *start);
+    while (replay.next()) {
+    }
+    if (!replay.ok()) {
+        emit status(tr("ICCF #%1: %2, not analysed").arg(game.id).arg(QString::fromStdString(replay.error())));
+        return;
+    }
+
+    const Position& pos = replay.position();
+    auto [last, inserted] = lastKey_.try_emplace(game.id, pos.key());
+    if (!inserted && last->second == pos.key()) {
+        return; // this position was submitted already
+    }
+    last->second = pos.key();
+
+    const std::string label = QStringLiteral("ICCF #%1: %2 vs %3")
+                                  .arg(game.id)
+                                  .arg(game.white, game.black)
+                                  .toStdString();
+    const std::string fen = pos.toFen();
+
+    if (game.myTurn) {
+        jobManager_.enqueueJob(label, fen, options_.limit, options_.multiPv, std::nullopt, myTurnPriority(game));
+        return;
+    }
+    if (options_.replyCount == 0) {
+        return;
+    }
+
+    const Probe probe{game.id, QString::fromStdString(label)};
+    // A newer position of the game supersedes its pending lookup.
+    referenceLookups_.erase(game.id);
+    if (refQuery_ && refQuery_->isOpen()) {
+        if (refQuery_->cached(pos.key())) {
+            if (expandFromReference(probe, pos)) return;
+        } else {
+            referenceLookups_[game.id] = ReferenceLookup{pos.key(), fen, probe,
+                                                         sf::client::domain::Clock::now() + kReferenceTimeout};
+            if (!referenceTimer_.isActive()) {
+                referenceTimer_.start(kReferenceTimeout);
+            }
+            refQuery_->lookup(pos.key()); // request() would redirect the viewer's prefetch
+            return;
+        }
+    }
+    submitReplyProbe(probe, fen);
+}
+
+void IccfAnalysisPipeline::submitReplyProbe(const Probe& probe, const std::string& fen) {
+    const auto id = jobManager_.enqueueJob(probe.label.toStdString() + " (replies)", fen, options_.limit,
+                                           options_.replyCount, std::nullopt, kReplyPriority);
+    probes_[id] = probe;
+    if (const Job* job = jobManager_.jobById(id); job && job->status == JobStatus::Finished) {
+        finishedProbes_.push_back(id);
+        scheduleFlush();
+    }
+}
+
+bool IccfAnalysisPipeline::expandFromReference(const Probe& probe, const Position& pos) {
+    const auto stats = refQuery_ ? refQuery_->cached(pos.key()) : nullptr;
+    if (!stats) return false;
+
+    // Most played first, as move_agg orders them.
+    std::vector<Move> replies;
+    for (const auto& m : stats->moves) {
+        if (static_cast<int>(replies.size()) == options_.replyCount) break;
+        if (const auto mv = pos.findLegalUci(m.uci.toStdString())) replies.push_back(*mv);
+    }
+    if (replies.empty()) return false;
+    expandReplies(probe, pos, replies, tr("most played"));
+    return true;
+}
+
+void IccfAnalysisPipeline::onReferencePosition(quint64 posHash) {
+    if (!enabled_) return;
+    for (auto it = referenceLookups_.begin(); it != referenceLookups_.end();) {
+        if (it->second.key != posHash) {
+            ++it;
+            continue;
+        }
+        const ReferenceLookup lookup = std::move(it->second);
+        it = referenceLookups_.erase(it);
+        const auto pos = Position::fromFen(lookup.fen);
+        if (pos && expandFromReference(lookup.probe, *pos)) continue;
+        submitReplyProbe(lookup.probe, lookup.fen);
+    }
+}
+
+void IccfAnalysisPipeline::onReferenceTimeout() {
+    if (!enabled_) return;
+    const auto now = sf::client::domain::Clock::now();
+    for (auto it = referenceLookups_.begin(); it != referenceLookups_.end();) {
+        if (it->second.deadline > now) {
+            ++it;
+            continue;
+        }
+        const ReferenceLookup lookup = std::move(it->second);
+        it = referenceLookups_.erase(it);
+        // Someone else (the viewer) may have fetched it meanwhile: a cache
+        // hit inside the DB thread signals nothing.
+        const auto pos = Position::fromFen(lookup.fen);
+        if (pos && expandFromReference(lookup.probe, *pos)) continue;
+        submitReplyProbe(lookup.probe, lookup.fen);
+    }
+    if (!referenceLookups_.empty()) {
+        referenceTimer_.start(kReferenceTimeout);
+    }
+}
+
+void IccfAnalysisPipeline::expandProbe(const Probe& probe, const Job& job) {
+    const auto pos = Position::fromFen(job.fen);
+    if (!pos) return;
+
+    // The probe's lines, best first by multipv; each starts with a reply.
+    std::vector<const sf::client::domain::PvLine*> lines;
+    for (const auto& line : job.snapshot.lines) {
+        if (!line.pv.empty()) lines.push_back(&line);
+    }
+    std::sort(lines.begin(), lines.end(), [](const auto* a, const auto* b) { return a->multipv < b->multipv; });
+
+    std::vector<sf::client::domain::chess::PackedMove> packed;
+    for (const auto* line : lines) {
+        if (static_cast<int>(packed.size()) == options_.replyCount) break;
+        packed.push_back(line->pv.front());
+    }
+    if (packed.empty() && !job.snapshot.pv.empty()) {
+        packed.push_back(job.snapshot.pv.front());
+    }
+
+    std::vector<Move> replies;
+    for (const auto reply : packed) {
+        if (const auto mv = pos->findLegalPacked(reply)) replies.push_back(*mv);
+    }
+    expandReplies(probe, *pos, replies, tr("likely"));
+}
+
+void IccfAnalysisPipeline::expandReplies(const Probe& probe, const Position& pos,
+                                         const std::vector<Move>& replies, const QString& source) {
+    int rank = 0;
+    for (const Move& mv : replies) {
+        Position next = pos;
+        if (!next.applyMove(mv)) continue;
+        ++rank;
+        const std::string label = probe.label.toStdString() + " after "
+                                + sf::client::domain::chess::moveToSan(pos, mv);
+        jobManager_.enqueueJob(label, next.toFen(), options_.limit, options_.multiPv,
+                               std::nullopt, kReplyPriority - rank);
+    }
+    if (rank > 0) {
+        emit status(tr("ICCF #%1: pre-analysing %2 %3 replies").arg(probe.gameId).arg(rank).arg(source));
+    }
+}
+
+} // namespace sf::client::app
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "app/IccfGameCache.hpp"
+#include "domain/domain_model.hpp"
+#include "infra/iccf/IccfModels.hpp"
+
+namespace sf::client::domain::chess {
+class Position;
+struct Move;
+}
+
+namespace sf::client::infra::refdb {
+class ReferenceDbQuery;
+}
+
+namespace sf::client::app {
+
+class JobManager;
+
+struct IccfAnalysisOptions {
+    sf::client::domain::SearchLimit limit{sf::client::domain::depth(30)};
+    int multiPv{1};
+
+    // While the opponent is to move: the replyCount replies most played in
+    // the reference DB, or, when none is open or it lacks the position, the
+    // engine's best replyCount found by a MultiPV probe of the opponent's
+    // position; the position after each of them is then analysed like a
+    // my-turn one.
+    int replyCount{3};
+};
+
+// Keeps the cluster busy with the ICCF games: when a sync reports that a
+// move arrived, the game's current position is submitted (the analysis
+// cache and in-flight jobs answer repeats, see JobManager::enqueueJob);
+// games waiting for the opponent get their likely replies pre-analysed,
+// the reference DB's most played ones when it knows the position.
+//
+// Priorities: my-turn positions rank above everything a user queues by
+// default (more so the less thinking time is left), reply pre-analysis
+// below it, so it only fills otherwise idle engines.
+//
+// Feed it gamesChanged() deltas and every job update; jobs are submitted
+// from the event loop, never from inside a JobManager callback.
+class IccfAnalysisPipeline final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kMyTurnPriority = 10;  // + up to kUrgencyDays for little time left
+    static constexpr int kUrgencyDays   = 30;
+    static constexpr int kReplyPriority  = -10; // - reply rank
+
+    explicit IccfAnalysisPipeline(JobManager& jobManager, QObject* parent = nullptr);
+
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled_; }
+    void setOptions(IccfAnalysisOptions options);
+    // Source of the most played replies; nullptr (or a closed DB) leaves
+    // them all to the MultiPV probe.
+    void setReferenceQuery(sf::client::infra::refdb::ReferenceDbQuery* query);
+
+    // Queues the games the delta marks for analysis (IccfGamesDelta::analysisIds).
+    void onGamesChanged(const IccfGamesDelta& delta);
+    // Queues every game, e.g. the cached ones when the pipeline is switched on.
+    void analyzeAll(const QVector<sf::client::infra::iccf::IccfGame>& games);
+    // Picks up finished reply probes.
+    void onJobUpdated(const sf::client::domain::Job& job);
+
+    // Higher for less time left on my clock.
+    static int myTurnPriority(const sf::client::infra::iccf::IccfGame& game);
+
+signals:
+    void status(const QString& text);
+
+private:
+    struct Probe {
+        int         gameId{0};
+        QString     label;
+    };
+
+    // An opponent-to-move position waiting for its reference DB answer.
+    struct ReferenceLookup {
+        std::uint64_t key{0};
+        std::string   fen;
+        Probe         probe;
+        sf::client::domain::TimePoint deadline; // MultiPV probe if the DB has not answered by then
+    };
+
+    void queueGame(const sf::client::infra::iccf::IccfGame& game);
+    void scheduleFlush();
+    void flush();
+    void submitGame(const sf::client::infra::iccf::IccfGame& game);
+    void expandProbe(const Probe& probe, const sf::client::domain::Job& job);
+    void submitReplyProbe(const Probe& probe, const std::string& fen);
+    // Queues the replies the DB has for the position; false when it has none.
+    bool expandFromReference(const Probe& probe, const sf::client::domain::chess::Position& pos);
+    void expandReplies(const Probe& probe, const sf::client::domain::chess::Position& pos,
+                       const std::vector<sf::client::domain::chess::Move>& replies, const QString& source);
+    void onReferencePosition(quint64 posHash);
+    void onReferenceTimeout();
+
+    JobManager&         jobManager_;
+    IccfAnalysisOptions options_;
+    bool                enabled_{false};
+    QTimer              flushTimer_;
+    QTimer              referenceTimer_;
+
+    sf::client::infra::refdb::ReferenceDbQuery* refQuery_{nullptr};
+    // Game id -> lookup in flight.
+    std::unordered_map<int, ReferenceLookup> referenceLookups_;
+
+    QVector<sf::client::infra::iccf::IccfGame> pendingGames_;
+    std::vector<sf::client::domain::JobId>     finishedProbes_;
+    std::unordered_map<sf::client::domain::JobId, Probe> probes_;
+    // Game id -> key of the position last submitted for it.
+    std::unordered_map<int, std::uint64_t>     lastKey_;
+};
+
+} // namespace sf::client::app
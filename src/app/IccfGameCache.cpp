@@ -0,0 +1,132 @@
+#include "app/IccfGameCache.hpp"
+
+#include <algorithm>
+
+#include <QSet>
+
+namespace sf::client::app {
+
+using sf::client::infra::iccf::IccfGame;
+
+namespace {
+
+// FNV-1a, fed field by field.
+struct Fnv {
+    std::uint64_t h{14695981039346656037ull};
+
+    void byte(std::uint8_t b) { h = (h ^ b) * 1099511628211ull; }
+
+    void add(std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) byte(static_cast<std::uint8_t>(v >> (i * 8)));
+    }
+
+    void add(const QString& s) {
+        for (const QChar c : s) {
+            byte(static_cast<std::uint8_t>(c.unicode() & 0xFF));
+            byte(static_cast<std::uint8_t>(c.unicode() >> 8));
+        }
+        byte(0xFF); // field separator
+    }
+};
+
+} // namespace
+
+std::uint64_t IccfGameCache::movesHash(const IccfGame& g) {
+    // Whitespace differs between polls for the same moves (line breaks);
+    // hash the movetext without it.
+    Fnv f;
+    for (const QChar c : g.moves) {
+        if (c.isSpace()) continue;
+        f.byte(static_cast<std::uint8_t>(c.unicode() & 0xFF));
+        f.byte(static_cast<std::uint8_t>(c.unicode() >> 8));
+    }
+    f.add(g.fen);
+    return f.h;
+}
+
+std::uint64_t IccfGameCache::stateHash(const IccfGame& g) {
+    Fnv f;
+    f.add(static_cast<std::uint64_t>(g.myTurn) | (std::uint64_t{g.drawOffered} << 1)
+          | (std::uint64_t{g.setup} << 2) | (std::uint64_t{g.hasWhite} << 3));
+    f.add(static_cast<std::uint64_t>(g.daysPlayer * 1440 + g.hoursPlayer * 60 + g.minutesPlayer));
+    f.add(static_cast<std::uint64_t>(g.daysOpponent * 1440 + g.hoursOpponent * 60 + g.minutesOpponent));
+    f.add(static_cast<std::uint64_t>(g.whiteElo) << 32 | static_cast<std::uint32_t>(g.blackElo));
+    for (const QString* s : {&g.white, &g.black, &g.event, &g.site, &g.board, &g.result, &g.message,
+                             &g.serverInfo, &g.gameLink, &g.eventDate, &g.timeControl}) {
+        f.add(*s);
+    }
+    return f.h;
+}
+
+IccfGamesDelta IccfGameCache::apply(const QVector<IccfGame>& games) {
+    IccfGamesDelta delta;
+
+    QSet<int> seen;
+    seen.reserve(games.size());
+    for (const IccfGame& g : games) {
+        seen.insert(g.id);
+        const std::uint64_t moves = movesHash(g);
+        const std::uint64_t state = stateHash(g);
+
+        auto it = entries_.find(g.id);
+        if (it == entries_.end()) {
+            entries_.insert(g.id, Entry{g, moves, state});
+            delta.added.push_back(g);
+            if (g.myTurn) delta.analysisIds.push_back(g.id);
+            continue;
+        }
+
+        Entry& e = it.value();
+        const bool movesChanged = e.movesHash != moves;
+        if (!movesChanged && e.stateHash == state) {
+            continue;
+        }
+        const bool turnArrived = g.myTurn && !e.game.myTurn;
+        e.game      = g;
+        e.movesHash = moves;
+        e.stateHash = state;
+        delta.changed.push_back(g);
+        if (movesChanged || turnArrived) delta.analysisIds.push_back(g.id);
+    }
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (!seen.contains(it.key())) {
+            delta.removedIds.push_back(it.key());
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return delta;
+}
+
+const IccfGame* IccfGameCache::find(int id) const {
+    const auto it = entries_.constFind(id);
+    return it == entries_.cend() ? nullptr : &it.value().game;
+}
+
+std::size_t IccfGameCache::byteSize() const {
+    std::size_t bytes = static_cast<std::size_t>(entries_.capacity()) * (sizeof(int) + sizeof(Entry) + sizeof(void*));
+    for (const Entry& e : entries_) {
+        const IccfGame& g = e.game;
+        for (const QString* s : {&g.white, &g.black, &g.event, &g.site, &g.moves, &g.message, &g.serverInfo,
+                                 &g.gameLink, &g.whiteTitle, &g.blackTitle, &g.whiteNA, &g.blackNA,
+                                 &g.eventSponsor, &g.section, &g.stage, &g.board, &g.timeControl,
+                                 &g.variant, &g.eventDate, &g.fen, &g.result}) {
+            bytes += static_cast<std::size_t>(s->capacity()) * sizeof(QChar);
+        }
+    }
+    return bytes;
+}
+
+QVector<IccfGame> IccfGameCache::sortedGames() const {
+    QVector<IccfGame> games;
+    games.reserve(entries_.size());
+    for (const Entry& e : entries_) {
+        games.push_back(e.game);
+    }
+    std::sort(games.begin(), games.end(), iccfGameBefore);
+    return games;
+}
+
+} // namespace sf::client::app
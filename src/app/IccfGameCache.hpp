@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <QHash>
+#include <QVector>
+
+#include "infra/iccf/IccfModels.hpp"
+
+namespace sf::client::app {
+
+// What one GetMyGames poll changed compared to the previous one.
+struct IccfGamesDelta {
+    QVector<sf::client::infra::iccf::IccfGame> added;
+    QVector<sf::client::infra::iccf::IccfGame> changed; // any shown field differs
+    QVector<int>                               removedIds;
+
+    // Ids of added or changed games worth (re-)analysing: a move arrived
+    // (the movetext changed) or it just became my turn. Games seen for the
+    // first time only count when it is my turn.
+    QVector<int> analysisIds;
+
+    bool isEmpty() const { return added.isEmpty() && changed.isEmpty() && removedIds.isEmpty(); }
+};
+
+// Display order of the ICCF games table: my turn first, then by id.
+inline bool iccfGameBefore(const sf::client::infra::iccf::IccfGame& a,
+                           const sf::client::infra::iccf::IccfGame& b) {
+    if (a.myTurn != b.myTurn) return a.myTurn > b.myTurn;
+    return a.id < b.id;
+}
+
+// The games of the last poll keyed by id, each with a hash of its
+// movetext and one of everything else the client shows. apply() diffs a
+// new poll against them, so a poll where nothing happened costs two
+// hashes per game and emits nothing.
+class IccfGameCache {
+public:
+    IccfGamesDelta apply(const QVector<sf::client::infra::iccf::IccfGame>& games);
+
+    const sf::client::infra::iccf::IccfGame* find(int id) const;
+    int size() const { return static_cast<int>(entries_.size()); }
+    // Approximate memory of the cached games. Copies handed out (e.g. to
+    // IccfGamesModel) share the string data and add little beyond it.
+    std::size_t byteSize() const;
+
+    // Cached games in iccfGameBefore() order.
+    QVector<sf::client::infra::iccf::IccfGame> sortedGames() const;
+
+private:
+    struct Entry {
+        sf::client::infra::iccf::IccfGame game;
+        std::uint64_t                     movesHash{0};
+        std::uint64_t                     stateHash{0};
+    };
+
+    static std::uint64_t movesHash(const sf::client::infra::iccf::IccfGame& g);
+    static std::uint64_t stateHash(const sf::client::infra::iccf::IccfGame& g);
+
+    QHash<int, Entry> entries_;
+};
+
+} // namespace sf::client::app
@@ -1,7 +1,5 @@
 #include "app/IccfSyncManager.hpp"
 
-#include <algorithm>
-
 #include "infra/iccf/IccfXfccParser.hpp"
 
 namespace sf::client::app {
@@ -86,16 +84,18 @@ void IccfSyncManager::handleSoapFinished(sf::client::net::iccf::IccfXfccSoap::Op
         return;
     }
 
-    games_ = parsed.games;
-
-    // Stable, user-friendly order: myTurn first, then by id.
-    std::stable_sort(games_.begin(), games_.end(), [](const auto& a, const auto& b) {
-        if (a.myTurn != b.myTurn) return a.myTurn > b.myTurn;
-        return a.id < b.id;
-    });
+    const IccfGamesDelta delta = cache_.apply(parsed.games);
+    if (delta.isEmpty()) {
+        emit status(tr("ICCF: %1 games, no changes").arg(cache_.size()));
+        return;
+    }
 
-    emit status(tr("ICCF: %1 games").arg(games_.size()));
-    emit gamesUpdated(games_);
+    emit status(tr("ICCF: %1 games (%2 new, %3 changed, %4 gone)")
+                    .arg(cache_.size())
+                    .arg(delta.added.size())
+                    .arg(delta.changed.size())
+                    .arg(delta.removedIds.size()));
+    emit gamesChanged(delta);
 }
 
 } // namespace sf::client::app
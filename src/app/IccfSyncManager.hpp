@@ -4,6 +4,7 @@
 
 #include <QTimer>
 
+#include "app/IccfGameCache.hpp"
 #include "infra/iccf/IccfModels.hpp"
 #include "net/iccf/IccfXfccSoap.hpp"
 
@@ -11,6 +12,9 @@ namespace sf::client::app {
 
 // Orchestrates periodic synchronization with ICCF using the XfccBasic SOAP service.
 // MVP scope: GetMyGames only (read-only).
+//
+// Each poll is diffed against the games of the previous one (see
+// IccfGameCache); only a poll that changed something emits gamesChanged.
 class IccfSyncManager final : public QObject {
     Q_OBJECT
 
@@ -34,10 +38,14 @@ public:
     void stopPolling();
     bool isPolling() const;
 
+    // Games of the last successful poll.
+    const IccfGameCache& games() const { return cache_; }
+
 signals:
     void status(const QString& text);
     void error(const QString& message);
-    void gamesUpdated(QVector<sf::client::infra::iccf::IccfGame> games);
+    // The first poll reports every game as added.
+    void gamesChanged(const sf::client::app::IccfGamesDelta& delta);
 
 private:
     void handleSoapFinished(sf::client::net::iccf::IccfXfccSoap::Operation op,
@@ -50,7 +58,7 @@ private:
     QTimer pollTimer_;
 
     bool busy_{false};
-    QVector<sf::client::infra::iccf::IccfGame> games_;
+    IccfGameCache cache_;
 };
 
 } // namespace sf::client::app
@@ -0,0 +1,68 @@
+#include "app/JobCostModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sf::client::app {
+
+using namespace sf::client::domain;
+
+namespace {
+
+int effectiveThreadsPerJob(const ServerInfo& s) {
+    if (s.threadsPerJob > 0) {
+        return s.threadsPerJob;
+    }
+    const int maxJobs = std::max(1, s.runtime.maxJobs > 0 ? s.runtime.maxJobs : s.maxJobs);
+    return std::max(1, s.cores / maxJobs);
+}
+
+} // namespace
+
+JobCost estimateJobCost(const SearchLimit& limit, int multiPv) {
+    const double mpvFactor = 1.0 + kMultiPvExtraCost * static_cast<double>(std::max(1, multiPv) - 1);
+
+    JobCost cost;
+    switch (limit.type) {
+        case LimitType::Depth:
+            cost.nodes = kDepthNodesBase * std::pow(kDepthBranching, std::max(1, limit.value)) * mpvFactor;
+            break;
+        case LimitType::Nodes:
+            // The engine counts all lines against the node limit.
+            cost.nodes = static_cast<double>(std::max(1, limit.value));
+            break;
+        case LimitType::TimeMs:
+            cost.fixedSeconds = static_cast<double>(std::max(0, limit.value)) / 1000.0;
+            break;
+    }
+    return cost;
+}
+
+double estimateJobNps(const ServerInfo& s) {
+    const int threads = effectiveThreadsPerJob(s);
+    // A pinning server knows the CPU set the next job lands on; slots can
+    // differ in size, so scale the per-job figures to that one.
+    const bool freeSlot = s.runtime.numaNodes > 0 && s.runtime.nextJobThreads > 0;
+    const double slotScale = freeSlot
+        ? static_cast<double>(s.runtime.nextJobThreads) / static_cast<double>(threads)
+        : 1.0;
+    double nps = s.runtime.measuredNps > 0.0
+        ? s.runtime.measuredNps * slotScale
+        : kPriorNpsPerThread * static_cast<double>(freeSlot ? s.runtime.nextJobThreads : threads);
+
+    // Jobs beyond the core count share CPUs with the ones already running
+    // (not on a free pinned slot, whose CPUs no other job uses).
+    if (s.cores > 0 && !freeSlot) {
+        const double demand = static_cast<double>(threads) * static_cast<double>(s.runtime.runningJobs + 1);
+        if (demand > static_cast<double>(s.cores)) {
+            nps *= static_cast<double>(s.cores) / demand;
+        }
+    }
+    return std::max(1.0, nps);
+}
+
+double expectedCompletionSeconds(const ServerInfo& s, const JobCost& cost) {
+    return cost.fixedSeconds + cost.nodes / estimateJobNps(s);
+}
+
+} // namespace sf::client::app
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::app {
+
+// Rough cost model used by the ExpectedCompletion scheduling policy.
+//
+// Only relative numbers matter: the scheduler compares the same job across
+// servers, so a systematic error in the node estimate cancels out and what
+// decides is the ratio of server throughputs.
+
+struct JobCost {
+    double nodes{0.0};        // nodes to search (depth/nodes limits)
+    double fixedSeconds{0.0}; // wall time fixed by the limit (movetime)
+};
+
+// Depth d costs about kDepthNodesBase * kDepthBranching^d nodes (Stockfish's
+// effective branching factor is ~1.5-1.6); every extra MultiPV line adds
+// roughly half the work of the first one.
+inline constexpr double kDepthNodesBase  = 2000.0;
+inline constexpr double kDepthBranching  = 1.55;
+inline constexpr double kMultiPvExtraCost = 0.5;
+
+// Per-thread NPS assumed for a server that has not reported any yet.
+inline constexpr double kPriorNpsPerThread = 1.0e6;
+
+JobCost estimateJobCost(const sf::client::domain::SearchLimit& limit, int multiPv);
+
+// NPS one more job would get on this server: measured per-job NPS if known,
+// else the prior from cores / threads per job, scaled down when the job
+// would oversubscribe the server's logical cores. On a server that pins
+// engines, a free CPU slot sets the thread count and is never oversubscribed.
+double estimateJobNps(const sf::client::domain::ServerInfo& server);
+
+double expectedCompletionSeconds(const sf::client::domain::ServerInfo& server, const JobCost& cost);
+
+} // namespace sf::client::app
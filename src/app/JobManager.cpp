@@ -1,12 +1,15 @@
 #include "app/JobManager.hpp"
 
 #include "app/JobSnapshotMerger.hpp"
+#include "infra/trace/Trace.hpp"
 
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
 
 #include "app/ServerManager.hpp"
 #include "app/IHistoryRepository.hpp"
+#include "domain/chess/Position.hpp"
 
 namespace sf::client::app {
 
@@ -27,6 +30,83 @@ inline int effectiveMaxJobs(const ServerInfo& s) {
     return 0;
 }
 
+// Counter-free Zobrist key; nullopt for a FEN we cannot parse.
+std::optional<std::uint64_t> positionKeyOf(const std::string& fen) {
+    if (const auto pos = chess::Position::fromFen(fen)) {
+        return pos->key();
+    }
+    return std::nullopt;
+}
+
+std::string describeLimit(const SearchLimit& limit, int value) {
+    switch (limit.type) {
+        case LimitType::Depth:  return "depth " + std::to_string(value);
+        case LimitType::TimeMs: return std::to_string(value) + " ms";
+        case LimitType::Nodes:  return std::to_string(value) + " nodes";
+    }
+    return std::to_string(value);
+}
+
+// Spill file name for a job id. Ids also come from servers, so anything
+// beyond [A-Za-z0-9_-] (path separators, "..") is replaced, and a renamed or
+// overlong id gets an FNV-1a suffix of the original to stay unique.
+std::string spillFileName(const JobId& id) {
+    constexpr std::size_t kMaxStem = 96;
+    std::string stem;
+    bool changed = id.empty() || id.size() > kMaxStem;
+    for (const char c : id.substr(0, kMaxStem)) {
+        const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                          c == '-' || c == '_';
+        stem += safe ? c : '_';
+        changed = changed || !safe;
+    }
+    if (changed) {
+        std::uint64_t h = 14695981039346656037ull;
+        for (const char c : id) {
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        char suffix[18];
+        std::snprintf(suffix, sizeof suffix, "~%016llx", static_cast<unsigned long long>(h));
+        stem += suffix;
+    }
+    return stem + ".log";
+}
+
+// Heap block of a string, 0 while it fits the small-string buffer.
+std::size_t stringHeap(const std::string& s) {
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+std::size_t snapshotBytes(const JobSnapshot& s) {
+    std::size_t bytes = stringHeap(s.bestMove) + s.pv.heapBytes() + s.lines.capacity() * sizeof(PvLine);
+    for (const auto& line : s.lines) {
+        bytes += line.pv.heapBytes();
+    }
+    return bytes;
+}
+
+// The record with its strings and lists, the list node and index entry.
+std::size_t recordBytes(const Job& job) {
+    std::size_t bytes = sizeof(Job) + 4 * sizeof(void*) + sizeof(JobId)
+                      + 2 * stringHeap(job.id) + stringHeap(job.opponent) + stringHeap(job.fen)
+                      + job.searchMoves.capacity() * sizeof(std::string)
+                      + job.subJobIds.capacity() * sizeof(JobId);
+    if (job.assignedServer) {
+        bytes += stringHeap(*job.assignedServer);
+    }
+    for (const auto& m : job.searchMoves) {
+        bytes += stringHeap(m);
+    }
+    for (const auto& id : job.subJobIds) {
+        bytes += stringHeap(id);
+    }
+    return bytes;
+}
+
+std::size_t residentBytesOf(const Job& job) {
+    return recordBytes(job) + snapshotBytes(job.snapshot) + job.logLines.byteSize();
+}
+
 inline void recalcLoad(ServerInfo& s) {
     const int maxJobs = effectiveMaxJobs(s);
     if (maxJobs > 0) {
@@ -63,76 +143,149 @@ void JobManager::setCallbacks(JobManagerCallbacks callbacks) {
     callbacks_ = std::move(callbacks);
 }
 
-Job* JobManager::findJob(const JobId& id) {
-    for (auto& j : jobs_) {
-        if (j.id == id) {
-            return &j;
-        }
+bool JobManager::isBatchItem(const Job& job) const {
+    if (!job.parentJobId) {
+        return false;
     }
-    return nullptr;
+    const Job* parent = findJob(*job.parentJobId);
+    return parent && parent->batch;
 }
 
-const Job* JobManager::findJob(const JobId& id) const {
-    for (const auto& j : jobs_) {
-        if (j.id == id) {
-            return &j;
-        }
+void JobManager::notifyAdded(const Job& job) {
+    if (!isBatchItem(job)) {
+        summaries_.upsert(job);
+    }
+    if (callbacks_.onJobAdded) {
+        callbacks_.onJobAdded(job);
     }
-    return nullptr;
 }
 
-void JobManager::tryDispatchPendingJobs() {
-    // Dispatch as many pending jobs as we can (capacity-based).
-    while (tryDispatchOnePendingJob()) {
-        // keep dispatching
+void JobManager::notifyUpdated(const Job& job) {
+    if (!isBatchItem(job)) {
+        CORRCHESS_TRACE_SCOPE("app.summaryUpsert");
+        summaries_.upsert(job);
     }
+    if (callbacks_.onJobUpdated) {
+        callbacks_.onJobUpdated(job);
+    }
+    refreshSharingBatches(job, job.status);
 }
 
-bool JobManager::tryDispatchOnePendingJob() {
-    // FIFO: jobs_ is append-only for new jobs; so first Pending wins.
-    for (auto& job : jobs_) {
-        if (job.status != JobStatus::Pending) {
-            continue;
-        }
+void JobManager::notifyExtended(const Job& job) {
+    summaries_.upsert(job);
+    if (callbacks_.onJobExtended) {
+        callbacks_.onJobExtended(job);
+    }
+}
 
-        // If user chose a specific server earlier, we may have kept it in assignedServer
-        // while Pending (as a pin). If it's set, treat it as preferred.
-        std::optional<std::string> preferred;
-        if (job.assignedServer.has_value()) {
-            preferred = job.assignedServer;
-        }
+void JobManager::notifyRemoved(const Job& job) {
+    summaries_.erase(job.id);
+    if (callbacks_.onJobRemoved) {
+        callbacks_.onJobRemoved(job);
+    }
+    refreshSharingBatches(job, std::nullopt);
+}
 
-        auto* srv = serverManager_.pickServerForJob(preferred);
-        if (!srv) {
-            // Can't dispatch this job right now; try next Pending (maybe it is Auto).
-            continue;
-        }
+Job* JobManager::findJob(const JobId& id) {
+    const auto it = index_.find(id);
+    return it == index_.end() ? nullptr : &*it->second;
+}
 
-        // Assign + optimistic load accounting
-        job.assignedServer = srv->id;
-        job.status = JobStatus::Queued;
-        job.lastUpdateAt = Clock::now();
-        job.logLines.push_back("Server available: queued on " + srv->id + ".");
+const Job* JobManager::findJob(const JobId& id) const {
+    const auto it = index_.find(id);
+    return it == index_.end() ? nullptr : &*it->second;
+}
 
-        srv->runtime.runningJobs++;
-        if (srv->runtime.maxJobs <= 0) {
-            srv->runtime.maxJobs = (srv->maxJobs > 0 ? srv->maxJobs : 0);
-        }
-        recalcLoad(*srv);
+void JobManager::setLogLimits(std::size_t capacity, std::string spillDir) {
+    logCapacity_ = capacity;
+    logSpillDir_ = std::move(spillDir);
+}
+
+Job& JobManager::appendJob(Job job) {
+    JobLogOptions logOptions;
+    logOptions.capacity = logCapacity_;
+    if (!logSpillDir_.empty()) {
+        logOptions.spillPath = logSpillDir_ + "/" + spillFileName(job.id);
+    }
+    job.logLines.configure(std::move(logOptions));
+    JobSnapshotMerger::reserveLines(job.snapshot, job.multiPv);
 
-        if (callbacks_.onJobUpdated) {
-            callbacks_.onJobUpdated(job); // main.cpp will send job_submit_or_update
+    const JobId id = job.id;
+    jobs_.push_back(std::move(job));
+    index_[id] = std::prev(jobs_.end());
+    return jobs_.back();
+}
+
+void JobManager::syncPendingQueue(const Job& job) {
+    if (job.status == JobStatus::Pending) {
+        // While Pending, assignedServer holds the user's pin (if any).
+        pending_.push(job.id, job.priority, job.assignedServer);
+    } else {
+        pending_.erase(job.id);
+    }
+}
+
+void JobManager::tryDispatchPendingJobs() {
+    // Dispatch as many pending jobs as we can (capacity-based). Each round
+    // offers the best job of every sub-queue, best first; a pinned job may
+    // still run elsewhere when its server is unavailable (see pickServerForJob).
+    bool dispatched = true;
+    while (dispatched && !pending_.empty()) {
+        dispatched = false;
+        for (const auto& head : pending_.heads()) {
+            Job* job = findJob(head.id);
+            if (!job || job->status != JobStatus::Pending) {
+                pending_.erase(head.id); // stale entry
+                dispatched = true;
+                break;
+            }
+            if (tryDispatchPendingJob(*job)) {
+                dispatched = true;
+                break;
+            }
         }
-        return true; // dispatched one
     }
-    return false;
+}
+
+bool JobManager::tryDispatchPendingJob(Job& job) {
+    // If user chose a specific server earlier, we may have kept it in assignedServer
+    // while Pending (as a pin). If it's set, treat it as preferred.
+    std::optional<std::string> preferred;
+    if (job.assignedServer.has_value()) {
+        preferred = job.assignedServer;
+    }
+
+    auto* srv = serverManager_.pickServerForJob(preferred, job.limit, job.multiPv);
+    if (!srv) {
+        return false;
+    }
+
+    // Assign + optimistic load accounting
+    job.assignedServer = srv->id;
+    job.status = JobStatus::Queued;
+    job.lastUpdateAt = Clock::now();
+    job.logLines.push_back("Server available: queued on " + srv->id + ".");
+    pending_.erase(job.id);
+    if (const auto it = failedOver_.find(job.id); it != failedOver_.end()) {
+        it->second = true; // a new search; its first report replaces the snapshot
+    }
+
+    srv->runtime.runningJobs++;
+    if (srv->runtime.maxJobs <= 0) {
+        srv->runtime.maxJobs = (srv->maxJobs > 0 ? srv->maxJobs : 0);
+    }
+    recalcLoad(*srv);
+
+    notifyUpdated(job); // main.cpp will send job_submit_or_update
+    return true;
 }
 
 JobId JobManager::enqueueJob(const std::string& opponent,
                              const std::string& fen,
                              const SearchLimit& limit,
                              int multiPv,
-                             std::optional<std::string> preferredServer) {
+                             std::optional<std::string> preferredServer,
+                             int priority) {
     // Important: if some old jobs are Pending but server already has free slots,
     // dispatch them first (FIFO).
     tryDispatchPendingJobs();
@@ -143,12 +296,279 @@ JobId JobManager::enqueueJob(const std::string& opponent,
     job.fen          = fen;
     job.limit        = limit;
     job.multiPv      = (multiPv < 1 ? 1 : multiPv);
+    job.priority     = priority;
     job.createdAt    = Clock::now();
     job.lastUpdateAt = job.createdAt;
-    job.status       = JobStatus::Queued;
+
+    if (auto reused = reuseAnalysis(job)) {
+        return *reused;
+    }
+    return submitJob(std::move(job), std::move(preferredServer)).id;
+}
+
+std::optional<JobId> JobManager::reuseAnalysis(Job& job) {
+    const auto key = positionKeyOf(job.fen);
+    if (!key) {
+        return std::nullopt;
+    }
+
+    // Identical (or covering) work already running: don't search twice.
+    if (Job* same = findInFlight(*key, job.limit, job.multiPv)) {
+        same->logLines.push_back("Same position requested again (" + job.opponent + "); sharing this job.");
+        notifyUpdated(*same);
+        return same->id;
+    }
+
+    if (historyRepo_) {
+        if (auto hit = historyRepo_->findCachedAnalysis(*key, job.limit.type, job.multiPv)) {
+            if (hit->limitValue >= job.limit.value) {
+                auto& lines = hit->snapshot.lines;
+                lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                           [&](const PvLine& l) { return l.multipv > job.multiPv; }),
+                            lines.end());
+
+                job.status     = JobStatus::Finished;
+                job.startedAt  = job.createdAt;
+                job.finishedAt = job.createdAt;
+                job.snapshot   = std::move(hit->snapshot);
+                job.logLines.push_back("Result from cache (" + describeLimit(job.limit, hit->limitValue) +
+                                       ", job " + hit->jobId + ").");
+
+                Job& added = appendJob(std::move(job));
+                notifyAdded(added);
+                persistIfTerminal(added);
+                return added.id;
+            }
+
+            // Stockfish can't be handed a TT, so the shallower result only
+            // goes into the log; the search itself starts from scratch.
+            std::string note = "Cache has " + describeLimit(job.limit, hit->limitValue);
+            if (!hit->snapshot.bestMove.empty()) {
+                note += ": " + hit->snapshot.bestMove;
+                if (hit->snapshot.score.type != ScoreType::None) {
+                    note += " (" + to_string(hit->snapshot.score) + ")";
+                }
+            }
+            job.logLines.push_back(note + "; searching deeper.");
+        }
+    }
+
+    // Batch items have no summaries() row of their own to follow.
+    if (!isBatchItem(job)) {
+        inFlightByPosition_[*key].push_back(job.id);
+    }
+    return std::nullopt;
+}
+
+void JobManager::trackInFlight(const Job& job) {
+    if (const auto key = positionKeyOf(job.fen)) {
+        inFlightByPosition_[*key].push_back(job.id);
+    }
+}
+
+Job* JobManager::findInFlight(std::uint64_t positionKey, const SearchLimit& limit, int multiPv) {
+    const auto it = inFlightByPosition_.find(positionKey);
+    if (it == inFlightByPosition_.end()) {
+        return nullptr;
+    }
+
+    auto& ids = it->second;
+    Job* match = nullptr;
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [&](const JobId& id) {
+                  Job* j = findJob(id);
+                  if (!j || isTerminal(j->status)) {
+                      return true;
+                  }
+                  // A sub-job's result only covers its own root moves.
+                  if (!match && j->searchMoves.empty() && !isBatchItem(*j) && j->limit.type == limit.type &&
+                      j->limit.value >= limit.value && j->multiPv >= multiPv) {
+                      match = j;
+                  }
+                  return false;
+              }),
+              ids.end());
+    if (ids.empty()) {
+        inFlightByPosition_.erase(it);
+    }
+    return match;
+}
+
+void JobManager::cacheResult(Job& job) {
+    if (!historyRepo_ || job.status != JobStatus::Finished || !job.searchMoves.empty()) {
+        return; // a sub-job only saw part of the root moves
+    }
+    if (job.snapshot.bestMove.empty() && job.snapshot.lines.empty()) {
+        return;
+    }
+    if (const auto it = extendedFrom_.find(job.id); it != extendedFrom_.end() &&
+        job.snapshot.depth.value_or(0) <= it->second.depth) {
+        // The extension ended without passing its earlier result, which the
+        // snapshot still holds: that is cached under the earlier limit.
+        job.logLines.push_back("Extension did not get past depth " + std::to_string(it->second.depth) +
+                               "; the cache keeps the " +
+                               describeLimit(job.limit, it->second.limitValue) + " result.");
+        return;
+    }
+    if (const auto key = positionKeyOf(job.fen)) {
+        historyRepo_->saveCachedAnalysis(*key, job);
+    }
+}
+
+JobId JobManager::enqueueClusterJob(const std::string& opponent,
+                                    const std::string& fen,
+                                    const SearchLimit& limit,
+                                    int multiPv,
+                                    int maxParts,
+                                    int priority) {
+    std::vector<std::string> rootMoves;
+    if (const auto pos = chess::Position::fromFen(fen)) {
+        chess::MoveList legal;
+        pos->generateLegalMoves(legal);
+        for (const auto& m : legal) {
+            rootMoves.push_back(chess::moveToUci(m));
+        }
+    }
+
+    if (maxParts <= 0) {
+        maxParts = static_cast<int>(std::count_if(serverManager_.servers().begin(),
+                                                  serverManager_.servers().end(),
+                                                  [](const ServerInfo& s) { return s.enabled; }));
+    }
+    const int parts = std::min(maxParts, static_cast<int>(rootMoves.size()));
+    if (parts < 2) {
+        return enqueueJob(opponent, fen, limit, multiPv, std::nullopt, priority);
+    }
+
+    tryDispatchPendingJobs();
+
+    Job parent;
+    parent.id           = makeJobId();
+    parent.opponent     = opponent;
+    parent.fen          = fen;
+    parent.limit        = limit;
+    parent.multiPv      = (multiPv < 1 ? 1 : multiPv);
+    parent.priority     = priority;
+    parent.createdAt    = Clock::now();
+    parent.lastUpdateAt = parent.createdAt;
+    parent.status       = JobStatus::Queued; // never Pending: the parent itself is not dispatched
+
+    if (auto reused = reuseAnalysis(parent)) {
+        return *reused;
+    }
+
+    // Round-robin keeps move-generation order (pieces, then targets) from
+    // piling all pawn or all king moves into one part.
+    std::vector<Job> children(static_cast<std::size_t>(parts));
+    for (std::size_t i = 0; i < rootMoves.size(); ++i) {
+        children[i % children.size()].searchMoves.push_back(rootMoves[i]);
+    }
+    for (std::size_t k = 0; k < children.size(); ++k) {
+        Job& child = children[k];
+        child.id           = parent.id + "-s" + std::to_string(k + 1);
+        child.opponent     = opponent;
+        child.fen          = fen;
+        child.limit        = limit;
+        // Each part has to deliver the global top N on its own.
+        child.multiPv      = std::min(parent.multiPv, static_cast<int>(child.searchMoves.size()));
+        child.priority     = priority;
+        child.createdAt    = parent.createdAt;
+        child.lastUpdateAt = parent.createdAt;
+        child.parentJobId  = parent.id;
+        parent.subJobIds.push_back(child.id);
+    }
+    parent.logLines.push_back("Cluster job: " + std::to_string(rootMoves.size()) +
+                              " root moves split into " + std::to_string(parts) + " sub-jobs.");
+
+    const JobId id = parent.id;
+    Job& added = appendJob(std::move(parent));
+    notifyAdded(added);
+
+    for (auto& child : children) {
+        submitJob(std::move(child), std::nullopt);
+    }
+    refreshClusterJob(id);
+    return id;
+}
+
+JobId JobManager::enqueueBatch(const std::string& name,
+                               const std::vector<BatchPosition>& positions,
+                               const SearchLimit& limit,
+                               int multiPv,
+                               int priority) {
+    tryDispatchPendingJobs();
+
+    Job batch;
+    batch.id           = makeJobId();
+    batch.opponent     = name;
+    batch.fen          = positions.empty() ? std::string() : positions.front().fen;
+    batch.limit        = limit;
+    batch.multiPv      = (multiPv < 1 ? 1 : multiPv);
+    batch.priority     = priority;
+    batch.createdAt    = Clock::now();
+    batch.lastUpdateAt = batch.createdAt;
+    batch.status       = JobStatus::Queued; // never dispatched itself
+    batch.batch        = BatchProgress{};
+
+    // List nodes are stable, so this stays valid while items are added.
+    Job& added = appendJob(std::move(batch));
+    const JobId id = added.id;
+    notifyAdded(added);
+
+    int shared = 0;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        Job item;
+        item.id           = id + "-b" + std::to_string(i + 1);
+        item.opponent     = positions[i].label;
+        item.fen          = positions[i].fen;
+        item.limit        = limit;
+        item.multiPv      = (multiPv < 1 ? 1 : multiPv);
+        item.priority     = priority;
+        item.createdAt    = Clock::now();
+        item.lastUpdateAt = item.createdAt;
+        item.parentJobId  = id;
+
+        // Link first: the cache path below announces the item straight away.
+        const JobId itemId = item.id;
+        added.subJobIds.push_back(itemId);
+
+        JobStatus status = JobStatus::Finished; // answered by the cache
+        if (const auto reused = reuseAnalysis(item)) {
+            if (*reused != itemId) {
+                const Job& other = *findJob(*reused);
+                ++shared;
+                added.subJobIds.pop_back();
+                shareWithBatch(other, id);
+                status = other.status;
+            }
+        } else {
+            status = submitJob(std::move(item), std::nullopt).status;
+        }
+
+        ++added.batch->total;
+        if (status == JobStatus::Finished) {
+            ++added.batch->finished;
+        } else if (status == JobStatus::Running) {
+            ++added.batch->running;
+        }
+    }
+
+    added.logLines.push_back("Batch: " + std::to_string(added.batch->total) + " positions" +
+                             (added.batch->finished > 0
+                                  ? ", " + std::to_string(added.batch->finished) + " answered from cache"
+                                  : std::string()) +
+                             (shared > 0
+                                  ? ", " + std::to_string(shared) + " shared with jobs already analysing them"
+                                  : std::string()) +
+                             ".");
+    refreshBatchJob(added);
+    return id;
+}
+
+Job& JobManager::submitJob(Job job, std::optional<std::string> preferredServer) {
+    job.status = JobStatus::Queued;
 
     // Pick server.
-    if (auto* srv = serverManager_.pickServerForJob(preferredServer)) {
+    if (auto* srv = serverManager_.pickServerForJob(preferredServer, job.limit, job.multiPv)) {
         job.assignedServer = srv->id;
 
         // Local optimistic load accounting (server_status will later correct this).
@@ -171,13 +591,185 @@ JobId JobManager::enqueueJob(const std::string& opponent,
         job.logLines.push_back("No available server (Offline/Busy).");
     }
 
-    jobs_.push_back(job);
+    Job& added = appendJob(std::move(job));
+    syncPendingQueue(added);
 
-    if (callbacks_.onJobAdded) {
-        callbacks_.onJobAdded(jobs_.back());
+    notifyAdded(added);
+
+    return added;
+}
+
+void JobManager::refreshClusterJob(const JobId& parentId) {
+    Job* parent = findJob(parentId);
+    if (!parent || isTerminal(parent->status)) {
+        return;
+    }
+
+    // Member scratch: a running cluster job is re-merged on every update of
+    // any of its parts.
+    auto& parts = clusterParts_;
+    parts.clear();
+    bool allTerminal = true;
+    bool allFinished = true;
+    bool anyStarted = false;
+    bool anyFinished = false;
+    std::optional<JobStatus> failure;
+    for (const auto& childId : parent->subJobIds) {
+        const Job* child = findJob(childId);
+        if (!child) {
+            continue;
+        }
+        parts.push_back(&child->snapshot);
+        if (isTerminal(child->status)) {
+            anyStarted = true;
+            if (child->status == JobStatus::Finished) {
+                anyFinished = true;
+            } else {
+                allFinished = false;
+                if (!failure) {
+                    failure = child->status;
+                }
+            }
+        } else {
+            allTerminal = false;
+            anyStarted = anyStarted || child->status == JobStatus::Running;
+        }
+    }
+
+    JobStatus status = JobStatus::Queued;
+    if (allTerminal) {
+        status = anyFinished ? JobStatus::Finished : failure.value_or(JobStatus::Cancelled);
+    } else if (anyStarted) {
+        status = JobStatus::Running;
+    }
+
+    if (!parent->startedAt && status == JobStatus::Running) {
+        parent->startedAt = Clock::now();
+    }
+    if (isTerminal(status)) {
+        parent->finishedAt = Clock::now();
+        parent->logLines.push_back("All sub-jobs done.");
+    }
+    parent->status = status;
+    JobSnapshotMerger::mergeParts(parts, parent->multiPv, parent->snapshot);
+    parent->lastUpdateAt = Clock::now();
+
+    notifyUpdated(*parent);
+    persistIfTerminal(*parent);
+
+    // Only a result over every root move answers the position.
+    if (allTerminal && allFinished) {
+        cacheResult(*parent);
+    }
+}
+
+void JobManager::refreshParentJob(const JobId& parentId,
+                                  std::optional<JobStatus> before,
+                                  std::optional<JobStatus> after) {
+    Job* parent = findJob(parentId);
+    if (!parent) {
+        return;
+    }
+    if (!parent->batch) {
+        refreshClusterJob(parentId);
+        return;
+    }
+
+    // Batch items only matter when their status moves between buckets;
+    // the counts are kept incrementally so a batch of thousands of
+    // positions is never rescanned.
+    if (before == after) {
+        return;
+    }
+    BatchProgress& p = *parent->batch;
+    const auto count = [&p](JobStatus s, int delta) {
+        if (s == JobStatus::Running) {
+            p.running += delta;
+        } else if (s == JobStatus::Finished) {
+            p.finished += delta;
+        } else if (isTerminal(s)) {
+            p.failed += delta;
+        }
+    };
+    if (before) {
+        count(*before, -1);
+    } else {
+        ++p.total;
+    }
+    if (after) {
+        count(*after, +1);
+    } else {
+        --p.total;
+    }
+    refreshBatchJob(*parent);
+}
+
+void JobManager::shareWithBatch(const Job& job, const JobId& batchId) {
+    batchShares_[job.id].push_back(BatchShare{batchId, job.status});
+}
+
+void JobManager::refreshSharingBatches(const Job& job, std::optional<JobStatus> status) {
+    if (batchShares_.empty()) {
+        return; // the common case: no batch shares anything
+    }
+    const auto it = batchShares_.find(job.id);
+    if (it == batchShares_.end()) {
+        return;
     }
+    // Taken out first: refreshing a batch announces it in turn.
+    std::vector<BatchShare> shares = std::move(it->second);
+    batchShares_.erase(it);
+
+    // A removed job never analysed the position for the batch.
+    const JobStatus now = status.value_or(JobStatus::Cancelled);
+    std::vector<BatchShare> kept;
+    for (BatchShare& share : shares) {
+        const Job* batch = findJob(share.batchId);
+        if (!batch || isTerminal(batch->status)) {
+            continue;
+        }
+        if (share.counted != now) {
+            refreshParentJob(share.batchId, share.counted, now);
+            share.counted = now;
+        }
+        if (status && !isTerminal(now)) {
+            kept.push_back(std::move(share));
+        }
+    }
+    if (!kept.empty()) {
+        batchShares_[job.id] = std::move(kept);
+    }
+}
+
+void JobManager::refreshBatchJob(Job& batch) {
+    const BatchProgress& p = *batch.batch;
+
+    bool becameTerminal = false;
+    if (!isTerminal(batch.status)) {
+        JobStatus status = JobStatus::Queued;
+        if (p.done() >= p.total) {
+            status = (p.finished > 0 || p.total == 0) ? JobStatus::Finished : JobStatus::Cancelled;
+        } else if (p.running > 0 || p.done() > 0) {
+            status = JobStatus::Running;
+        }
 
-    return job.id;
+        if (!batch.startedAt && status == JobStatus::Running) {
+            batch.startedAt = Clock::now();
+        }
+        batch.status = status;
+        if (isTerminal(status)) {
+            becameTerminal = true;
+            batch.finishedAt = Clock::now();
+            batch.logLines.push_back("Batch done: " + std::to_string(p.finished) + " finished, " +
+                                     std::to_string(p.failed) + " failed.");
+        }
+    }
+    batch.lastUpdateAt = Clock::now();
+
+    notifyUpdated(batch);
+    if (becameTerminal) {
+        persistIfTerminal(batch);
+    }
 }
 
 void JobManager::persistIfTerminal(const Job& job) {
@@ -189,23 +781,33 @@ void JobManager::persistIfTerminal(const Job& job) {
             if (historyRepo_) {
                 historyRepo_->saveJob(job);
             }
+            // Lines evicted from the ring are on disk once the job is over.
+            job.logLines.flushSpill();
             break;
         default:
             break;
     }
 }
 
-void JobManager::removeJobAtIndex(std::size_t index) {
-    if (index >= jobs_.size()) {
-        return;
+void JobManager::removeJob(JobList::iterator it) {
+    // Sub-jobs go together with their cluster job.
+    for (const auto& childId : it->subJobIds) {
+        if (const auto child = index_.find(childId); child != index_.end()) {
+            child->second->parentJobId.reset();
+            removeJob(child->second);
+        }
     }
 
-    Job jobCopy = jobs_[index]; // for callbacks and history
+    // Moved out, not copied: the list node goes anyway, and callbacks and
+    // history only need the record for the duration of this call.
+    const Job removed = std::move(*it);
+    index_.erase(removed.id);
+    jobs_.erase(it);
 
     // Update server load.
-    if (jobCopy.assignedServer) {
+    if (removed.assignedServer) {
         for (auto& s : serverManager_.servers()) {
-            if (s.id == *jobCopy.assignedServer) {
+            if (s.id == *removed.assignedServer) {
                 if (s.runtime.runningJobs > 0) {
                     s.runtime.runningJobs--;
                 }
@@ -217,96 +819,384 @@ void JobManager::removeJobAtIndex(std::size_t index) {
         }
     }
 
-    persistIfTerminal(jobCopy);
+    persistIfTerminal(removed);
+    if (historyRepo_) {
+        historyRepo_->forgetJob(removed.id);
+    }
 
-    jobs_.erase(jobs_.begin() + static_cast<long long>(index));
+    pending_.erase(removed.id);
+    failedOver_.erase(removed.id);
+    extendedFrom_.erase(removed.id);
 
-    if (callbacks_.onJobRemoved) {
-        callbacks_.onJobRemoved(jobCopy);
+    notifyRemoved(removed);
+
+    if (removed.parentJobId) {
+        if (Job* parent = findJob(*removed.parentJobId)) {
+            auto& ids = parent->subJobIds;
+            ids.erase(std::remove(ids.begin(), ids.end(), removed.id), ids.end());
+            refreshParentJob(parent->id, removed.status, std::nullopt);
+        }
     }
 
     // Removing a job may free capacity -> try dispatch pending.
     tryDispatchPendingJobs();
 }
 
+JobMemoryUsage JobManager::memoryUsage() const {
+    JobMemoryUsage usage;
+    for (const Job& job : jobs_) {
+        const std::size_t snapshot = snapshotBytes(job.snapshot);
+        const std::size_t log = job.logLines.byteSize();
+        ++usage.jobs;
+        usage.snapshotBytes += snapshot;
+        usage.logLines += job.logLines.size();
+        usage.logBytes += log;
+        usage.bytes += recordBytes(job) + snapshot + log;
+    }
+    usage.evicted = evicted_.size();
+    for (const auto& id : evicted_) {
+        usage.bytes += sizeof(JobId) + sizeof(void*) + stringHeap(id);
+    }
+    return usage;
+}
+
+bool JobManager::isTerminalFamily(const Job& job) const {
+    if (!isTerminal(job.status)) {
+        return false;
+    }
+    for (const auto& childId : job.subJobIds) {
+        if (const Job* child = findJob(childId); child && !isTerminalFamily(*child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int JobManager::evictFamily(JobList::iterator it, std::size_t& residentBytes) {
+    int evicted = 0;
+    for (const auto& childId : it->subJobIds) {
+        if (const auto child = index_.find(childId); child != index_.end()) {
+            evicted += evictFamily(child->second, residentBytes);
+        }
+    }
+
+    // Saved when it became terminal; this adds what arrived since.
+    persistIfTerminal(*it);
+    historyRepo_->forgetJob(it->id); // evictTerminalJobs() requires one
+    residentBytes -= std::min(residentBytes, residentBytesOf(*it));
+
+    evicted_.insert(it->id);
+    pending_.erase(it->id);
+    failedOver_.erase(it->id);
+    extendedFrom_.erase(it->id);
+    index_.erase(it->id);
+    jobs_.erase(it);
+    return evicted + 1;
+}
+
+int JobManager::evictTerminalJobs(TimePoint finishedBefore, std::size_t maxBytes) {
+    if (!historyRepo_) {
+        return 0; // nowhere to reload them from
+    }
+
+    struct Candidate {
+        TimePoint finishedAt;
+        JobId     id;
+    };
+    std::vector<Candidate> candidates;
+    std::size_t residentBytes = 0;
+    for (const Job& job : jobs_) {
+        residentBytes += residentBytesOf(job);
+        if (!job.parentJobId && isTerminal(job.status)) {
+            candidates.push_back(Candidate{job.finishedAt.value_or(job.lastUpdateAt), job.id});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.finishedAt < b.finishedAt; });
+
+    int evicted = 0;
+    for (const Candidate& c : candidates) {
+        if (c.finishedAt >= finishedBefore && residentBytes <= maxBytes) {
+            break; // the rest are newer still
+        }
+        const auto it = index_.find(c.id);
+        if (it != index_.end() && isTerminalFamily(*it->second)) {
+            evicted += evictFamily(it->second, residentBytes);
+        }
+    }
+    return evicted;
+}
+
 void JobManager::requestStopJob(const JobId& id) {
-    for (std::size_t i = 0; i < jobs_.size(); ++i) {
-        if (jobs_[i].id == id) {
-            jobs_[i].status       = JobStatus::Stopped;
-            jobs_[i].finishedAt   = Clock::now();
-            jobs_[i].lastUpdateAt = *jobs_[i].finishedAt;
-            jobs_[i].logLines.push_back("Stopped by user.");
-            persistIfTerminal(jobs_[i]);
-
-            if (callbacks_.onJobUpdated) {
-                callbacks_.onJobUpdated(jobs_[i]);
-            }
+    Job* job = findJob(id);
+    if (!job) {
+        return;
+    }
+    const JobStatus prevStatus = job->status;
+
+    job->status       = JobStatus::Stopped;
+    job->finishedAt   = Clock::now();
+    job->lastUpdateAt = *job->finishedAt;
+    job->logLines.push_back("Stopped by user.");
+    syncPendingQueue(*job);
+    persistIfTerminal(*job);
+
+    notifyUpdated(*job);
+
+    // The parent is already terminal, so its sub-jobs won't refresh it.
+    const std::vector<JobId> subJobs = job->subJobIds;
+    for (const auto& childId : subJobs) {
+        if (const Job* child = findJob(childId); child && !isTerminal(child->status)) {
+            requestStopJob(childId);
+        }
+    }
+    if (job->parentJobId) {
+        refreshParentJob(*job->parentJobId, prevStatus, job->status);
+    }
 
-            // Keep the job visible; network layer will send job_cancel based on Stopped status.
-            return;
+    // Keep the job visible; network layer will send job_cancel based on Stopped status.
+}
+
+bool JobManager::canExtend(const Job& job, int limitValue) const {
+    if ((job.status != JobStatus::Finished && job.status != JobStatus::Stopped) ||
+        limitValue <= job.limit.value || !job.assignedServer) {
+        return false;
+    }
+    const auto& servers = serverManager_.servers();
+    const auto it = std::find_if(servers.begin(), servers.end(),
+                                 [&](const ServerInfo& s) { return s.id == *job.assignedServer; });
+    return it != servers.end() && it->enabled && it->runtime.canExtendJobs &&
+           (it->runtime.status == ServerStatus::Online || it->runtime.status == ServerStatus::Degraded);
+}
+
+void JobManager::extendOne(Job& job, int limitValue) {
+    extendedFrom_[job.id] = ExtendedFrom{job.limit.value, job.snapshot.depth.value_or(0)};
+    const std::string from = describeLimit(job.limit, job.limit.value);
+    job.limit.value  = limitValue;
+    job.status       = JobStatus::Queued;
+    job.finishedAt.reset();
+    job.lastUpdateAt = Clock::now();
+    job.logLines.push_back("Extending " + from + " to " + describeLimit(job.limit, limitValue) +
+                           " on " + *job.assignedServer + ".");
+    syncPendingQueue(job);
+
+    for (auto& s : serverManager_.servers()) {
+        if (s.id == *job.assignedServer) {
+            s.runtime.runningJobs++;
+            recalcLoad(s);
         }
     }
+    // Later requests for the position can share the deeper search; a
+    // sub-job only searches some of the root moves, so its parent does.
+    if (job.searchMoves.empty()) {
+        trackInFlight(job);
+    }
+
+    notifyExtended(job); // main.cpp sends job_extend
+}
+
+bool JobManager::extendJob(const JobId& id, int limitValue) {
+    Job* job = findJob(id);
+    if (!job || job->batch || job->parentJobId) {
+        return false;
+    }
+
+    if (job->subJobIds.empty()) {
+        if (!canExtend(*job, limitValue)) {
+            return false;
+        }
+        extendOne(*job, limitValue);
+        return true;
+    }
+
+    // Cluster job: every part has to go deeper, or the ranking mixes depths.
+    if ((job->status != JobStatus::Finished && job->status != JobStatus::Stopped) ||
+        limitValue <= job->limit.value) {
+        return false;
+    }
+    for (const auto& childId : job->subJobIds) {
+        const Job* child = findJob(childId);
+        if (child && !canExtend(*child, limitValue)) {
+            return false;
+        }
+    }
+    job->logLines.push_back("Extending all sub-jobs to " + describeLimit(job->limit, limitValue) + ".");
+    extendedFrom_[job->id] = ExtendedFrom{job->limit.value, job->snapshot.depth.value_or(0)};
+    job->limit.value = limitValue;
+    job->status      = JobStatus::Queued;
+    job->finishedAt.reset();
+    for (const auto& childId : std::vector<JobId>(job->subJobIds)) {
+        if (Job* child = findJob(childId)) {
+            extendOne(*child, limitValue);
+        }
+    }
+    trackInFlight(*job);
+    refreshClusterJob(id);
+    return true;
+}
+
+void JobManager::setJobPriority(const JobId& id, int priority) {
+    Job* job = findJob(id);
+    if (!job || job->priority == priority) {
+        return;
+    }
+    job->priority = priority;
+    syncPendingQueue(*job);
+
+    notifyUpdated(*job);
+
+    for (const auto& childId : std::vector<JobId>(job->subJobIds)) {
+        setJobPriority(childId, priority);
+    }
+
+    // A raised priority may make this job the next one to go.
+    tryDispatchPendingJobs();
 }
 
 void JobManager::applyRemoteUpdate(const JobId& id,
                                    JobStatus status,
                                    const JobSnapshot& snapshot,
                                    std::optional<std::string> logLine) {
-    for (std::size_t i = 0; i < jobs_.size(); ++i) {
-        if (jobs_[i].id != id) {
-            continue;
-        }
+    std::vector<std::string> logLines;
+    if (logLine) {
+        logLines.push_back(std::move(*logLine));
+    }
+    applyRemoteUpdates(id, status, snapshot, logLines);
+}
 
-        Job& job = jobs_[i];
-        const JobStatus prevStatus = job.status;
+void JobManager::applyRemoteUpdates(const JobId& id,
+                                    JobStatus status,
+                                    const JobSnapshot& snapshot,
+                                    const std::vector<std::string>& logLines) {
+    Job* found = findJob(id);
+    if (!found) {
+        return;
+    }
 
-        if (!job.startedAt && status == JobStatus::Running) {
-            job.startedAt = Clock::now();
-        }
-        if ((status == JobStatus::Finished ||
-             status == JobStatus::Error ||
-             status == JobStatus::Cancelled ||
-             status == JobStatus::Stopped) &&
-            !job.finishedAt) {
-            job.finishedAt = Clock::now();
-        }
+    Job& job = *found;
+    const JobStatus prevStatus = job.status;
 
-        job.status = status;
+    if (!job.startedAt && status == JobStatus::Running) {
+        job.startedAt = Clock::now();
+    }
+    if (isTerminal(status) && !job.finishedAt) {
+        job.finishedAt = Clock::now();
+    }
 
-        // Keep all snapshot merging rules in one place.
+    job.status = status;
+    syncPendingQueue(job);
+
+    if (const auto it = failedOver_.find(id); it != failedOver_.end() && it->second) {
+        // First report of the search that replaced a failed-over one.
+        JobSnapshotMerger::reset(job.snapshot);
+        it->second = false;
+    }
+
+    // Measured speed drives the cost-based scheduler.
+    if (snapshot.nps && job.assignedServer) {
+        serverManager_.recordJobNps(*job.assignedServer, *snapshot.nps);
+    }
+
+    // Keep all snapshot merging rules in one place.
+    {
+        CORRCHESS_TRACE_SCOPE("app.snapshotMerge");
         JobSnapshotMerger::merge(job.snapshot, snapshot);
+    }
 
-        job.lastUpdateAt = Clock::now();
+    job.lastUpdateAt = Clock::now();
 
-        if (logLine) {
-            job.logLines.push_back(*logLine);
-        }
+    job.logLines.append(logLines);
+
+    notifyUpdated(job);
+
+    // Persist finished/failed/cancelled/stopped jobs but keep them visible in the UI.
+    if (isTerminal(status)) {
+        persistIfTerminal(job);
+    }
+    if (prevStatus != JobStatus::Finished && status == JobStatus::Finished) {
+        cacheResult(job);
+    }
+
+    if (job.parentJobId) {
+        refreshParentJob(*job.parentJobId, prevStatus, status);
+    }
+
+    // If a job just became terminal, try dispatch pending ones.
+    // This fixes "queue ended but one job still Pending".
+    if (!isTerminal(prevStatus) && isTerminal(status)) {
+        tryDispatchPendingJobs();
+    }
+}
 
-        if (callbacks_.onJobUpdated) {
-            callbacks_.onJobUpdated(job);
+int JobManager::failOverServer(const std::string& serverId) {
+    // Jobs with a search of their own; cluster and batch parents follow
+    // their sub-jobs.
+    std::vector<JobId> moved;
+    for (const Job& job : jobs_) {
+        if (job.assignedServer == serverId && job.subJobIds.empty() && !job.batch &&
+            (job.status == JobStatus::Queued || job.status == JobStatus::Running)) {
+            moved.push_back(job.id);
         }
+    }
 
-        // Persist finished/failed/cancelled/stopped jobs but keep them visible in the UI.
-        if (isTerminal(status)) {
-            persistIfTerminal(job);
+    for (const auto& id : moved) {
+        Job& job = *findJob(id);
+        const JobStatus prevStatus = job.status;
+
+        job.status       = JobStatus::Pending;
+        job.lastUpdateAt = Clock::now();
+        std::string line = "Server " + serverId + " offline: back in the queue";
+        if (job.snapshot.depth) {
+            line += " (reached depth " + std::to_string(*job.snapshot.depth) + ")";
         }
+        job.logLines.push_back(line + ".");
+        failedOver_[id] = false;
+        syncPendingQueue(job);
 
-        // If a job just became terminal, try dispatch pending ones.
-        // This fixes "queue ended but one job still Pending".
-        if (!isTerminal(prevStatus) && isTerminal(status)) {
-            tryDispatchPendingJobs();
+        notifyUpdated(job);
+
+        if (job.parentJobId) {
+            refreshParentJob(*job.parentJobId, prevStatus, job.status);
         }
+    }
 
-        return;
+    if (!moved.empty()) {
+        tryDispatchPendingJobs();
+    }
+    return static_cast<int>(moved.size());
+}
+
+bool JobManager::claimRemoteReport(const JobId& id, const std::string& serverId) {
+    const auto it = failedOver_.find(id);
+    if (it == failedOver_.end()) {
+        return true;
     }
+    Job* job = findJob(id);
+    if (!job) {
+        failedOver_.erase(it);
+        return true;
+    }
+    if (job->assignedServer != serverId) {
+        return false;
+    }
+    if (job->status == JobStatus::Pending) {
+        // Not dispatched again yet and the old server is still on it.
+        job->logLines.push_back("Server " + serverId + " is back: resuming there.");
+        failedOver_.erase(it);
+    }
+    return true;
 }
 
 void JobManager::upsertRemoteJob(const sf::client::domain::Job& remote) {
+    // Servers keep listing finished jobs; evicted ones stay in history.
+    if (evicted_.count(remote.id) != 0) {
+        return;
+    }
+
     // If we already have this job, update in-place and notify UI.
-    for (auto& job : jobs_) {
-        if (job.id != remote.id) {
-            continue;
-        }
+    if (Job* existing = findJob(remote.id)) {
+        Job& job = *existing;
+        const JobStatus prevStatus = job.status;
 
         job.opponent = remote.opponent;
         job.fen = remote.fen;
@@ -319,35 +1209,46 @@ void JobManager::upsertRemoteJob(const sf::client::domain::Job& remote) {
         job.finishedAt = remote.finishedAt;
         job.lastUpdateAt = remote.lastUpdateAt;
         job.snapshot = remote.snapshot;
+        syncPendingQueue(job);
 
         if (!remote.logLines.empty()) {
             // Replace only if remote has more info (e.g. server tail) or local is empty.
             if (job.logLines.empty() || remote.logLines.size() >= job.logLines.size()) {
-                job.logLines = remote.logLines;
+                job.logLines.assign(std::vector<std::string>(remote.logLines.begin(), remote.logLines.end()));
             }
         }
 
-        if (callbacks_.onJobUpdated) {
-            callbacks_.onJobUpdated(job);
-        }
+        notifyUpdated(job);
 
         if (isTerminal(job.status)) {
             persistIfTerminal(job);
         }
+        if (prevStatus != JobStatus::Finished && job.status == JobStatus::Finished) {
+            cacheResult(job); // finished while we were offline
+        }
+
+        if (job.parentJobId) {
+            refreshParentJob(*job.parentJobId, prevStatus, job.status);
+        }
 
         // After reconnect/upsert we may have new capacity visible -> attempt dispatch.
         tryDispatchPendingJobs();
         return;
     }
 
-    // New job discovered from server (likely after reconnect).
-    jobs_.push_back(remote);
-    if (callbacks_.onJobAdded) {
-        callbacks_.onJobAdded(jobs_.back());
+    // New job discovered from server (likely after reconnect). Its log
+    // starts again from the server's tail, so lines a previous session
+    // spilled for it would only be repeated.
+    if (!logSpillDir_.empty()) {
+        std::remove((logSpillDir_ + "/" + spillFileName(remote.id)).c_str());
     }
-    if (isTerminal(remote.status)) {
-        persistIfTerminal(jobs_.back());
+    Job& added = appendJob(remote);
+    syncPendingQueue(added);
+    notifyAdded(added);
+    if (isTerminal(added.status)) {
+        persistIfTerminal(added);
     }
+    cacheResult(added);
 
     // After discovering remote jobs, try dispatch local pending ones too.
     tryDispatchPendingJobs();
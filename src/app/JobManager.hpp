@@ -1,10 +1,18 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <list>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "app/BatchPlanner.hpp"
+#include "app/JobSummaryStore.hpp"
+#include "app/PendingJobQueue.hpp"
 #include "domain/domain_model.hpp"
 
 namespace sf::client::app {
@@ -18,40 +26,154 @@ struct JobManagerCallbacks {
     std::function<void(const sf::client::domain::Job&)> onJobAdded;
     std::function<void(const sf::client::domain::Job&)> onJobUpdated;
     std::function<void(const sf::client::domain::Job&)> onJobRemoved;
+    // extendJob() put a finished job back in the queue of its server.
+    std::function<void(const sf::client::domain::Job&)> onJobExtended;
 };
 
+// What the live jobs hold in memory (approximate heap bytes).
+struct JobMemoryUsage {
+    std::size_t jobs{0};
+    std::size_t bytes{0};         // all of it: records, snapshots, logs, indexes
+    std::size_t snapshotBytes{0}; // PVs and MultiPV lines
+    std::size_t logLines{0};
+    std::size_t logBytes{0};
+    std::size_t evicted{0};       // jobs evictTerminalJobs() dropped (their ids stay)
+};
+
+// Jobs live in a std::list (insertion order = FIFO dispatch order) indexed
+// by id, so lookups are O(1) and a Job reference handed to a callback stays
+// valid until that job itself is removed.
 class JobManager {
 public:
+    using JobList = std::list<sf::client::domain::Job>;
+
     JobManager(ServerManager& serverManager,
                sf::client::app::IHistoryRepository* historyRepo = nullptr);
 
     void setCallbacks(JobManagerCallbacks callbacks);
 
-    const std::vector<sf::client::domain::Job>& jobs() const noexcept {
+    // Ring capacity for each job's log, and a directory for the lines that
+    // fall out of it (<dir>/<job id>.log, the id reduced to [A-Za-z0-9_-]
+    // plus a hash suffix if it had anything else); empty = evicted lines
+    // are dropped. Applies to jobs added afterwards. A job a server lists
+    // again (upsertRemoteJob) starts a fresh file.
+    void setLogLimits(std::size_t capacity, std::string spillDir = {});
+
+    const JobList& jobs() const noexcept {
         return jobs_;
     }
 
+    // nullptr if the job is not (or no longer) live: removed, or evicted to
+    // history by evictTerminalJobs().
+    const sf::client::domain::Job* jobById(const sf::client::domain::JobId& id) const {
+        return findJob(id);
+    }
+
+    // One summary row per live job, kept in step before every callback.
+    // Views page history rows in behind them (JobSummaryStore::appendNew).
+    JobSummaryStore&       summaries() noexcept { return summaries_; }
+    const JobSummaryStore& summaries() const noexcept { return summaries_; }
+
+    // A position already analysed at least this deep (same limit type, at
+    // least multiPv lines; see IHistoryRepository) is answered at once with
+    // a Finished job; a shallower cached result is noted in the job's log.
+    // A request covered by a job still in flight returns that job's id.
     sf::client::domain::JobId enqueueJob(
         const std::string& opponent,
         const std::string& fen,
         const sf::client::domain::SearchLimit& limit,
         int multiPv,
-        std::optional<std::string> preferredServer);
+        std::optional<std::string> preferredServer,
+        int priority = 0);
+
+    // Splits the root moves of fen across up to maxParts sub-jobs (0 = one
+    // per enabled server) that run in parallel like ordinary jobs; the
+    // returned parent job shows their results ranked as one MultiPV list.
+    // Falls back to enqueueJob() when there is nothing to split.
+    sf::client::domain::JobId enqueueClusterJob(
+        const std::string& opponent,
+        const std::string& fen,
+        const sf::client::domain::SearchLimit& limit,
+        int multiPv,
+        int maxParts = 0,
+        int priority = 0);
+
+    // Queues every position as a sub-job of one batch job, which stands in
+    // for them in summaries() with progress counts (Job::batch). Positions
+    // the cache already answers finish at once; ones another job is still
+    // searching are left to it, and its outcome counts toward the batch
+    // (stopping that job leaves the position failed, not done).
+    sf::client::domain::JobId enqueueBatch(
+        const std::string& name,
+        const std::vector<BatchPosition>& positions,
+        const sf::client::domain::SearchLimit& limit,
+        int multiPv,
+        int priority = 0);
 
+    // Stopping a cluster or batch job stops its sub-jobs as well.
     void requestStopJob(const sf::client::domain::JobId& id);
 
+    // Searches a Finished or Stopped job again with a higher limit value of
+    // the same type, on the server that ran it: the server continues on the
+    // engine that still holds the search, so only the extra depth costs
+    // time, and the new lines merge into the job's snapshot. A cluster job
+    // extends all its sub-jobs. False (nothing changed) for batch jobs and
+    // their items, sub-jobs, evicted jobs, a limit that is not higher, or a
+    // server that is offline or does not support it; enqueue a new job then.
+    bool extendJob(const sf::client::domain::JobId& id, int limitValue);
+
+    // Changes the dispatch priority; a Pending job moves in the queue but
+    // keeps its age. Running jobs just carry the new value.
+    void setJobPriority(const sf::client::domain::JobId& id, int priority);
+
     // Called from network layer when server reports progress or result.
     void applyRemoteUpdate(const sf::client::domain::JobId& id,
                            sf::client::domain::JobStatus status,
                            const sf::client::domain::JobSnapshot& snapshot,
                            std::optional<std::string> logLine);
 
+    // Same, for an update already coalesced from several messages
+    // (see JobUpdateCoalescer): one merge, one callback.
+    void applyRemoteUpdates(const sf::client::domain::JobId& id,
+                            sf::client::domain::JobStatus status,
+                            const sf::client::domain::JobSnapshot& snapshot,
+                            const std::vector<std::string>& logLines);
+
     // Called from network layer when reconnecting: restore jobs that are
     // still running on the server (or finished while the client was offline).
     void upsertRemoteJob(const sf::client::domain::Job& remote);
 
+    // Failover for a server that stayed offline too long: its Queued and
+    // Running jobs go back to Pending, keeping that server as their
+    // preference, and are dispatched elsewhere. Each keeps the snapshot it
+    // reached as partial progress until its new server reports. Returns
+    // how many jobs moved.
+    int failOverServer(const std::string& serverId);
+
+    // Whether a job update or jobs_list entry from serverId may be applied:
+    // always for jobs never failed over; for one that was, only from its
+    // current server (a Pending one its old server reports again simply
+    // resumes there). False for a duplicate left behind by failover, which
+    // the caller cancels on serverId.
+    bool claimRemoteReport(const sf::client::domain::JobId& id, const std::string& serverId);
+
+    // ---- Memory ----
+    JobMemoryUsage memoryUsage() const;
+
+    // Moves terminal jobs out of memory, keeping their summaries() rows: a
+    // job (with its sub-jobs) that finished before finishedBefore goes, and
+    // while the live jobs take more than maxBytes the oldest terminal ones
+    // go as well. Their details stay in history for whoever shows them
+    // (IHistoryRepository::loadJobDetails), and a server listing them again
+    // is ignored. Families with a job still in flight stay, and nothing is
+    // evicted without a history repository. Returns how many jobs went.
+    int evictTerminalJobs(sf::client::domain::TimePoint finishedBefore,
+                          std::size_t maxBytes = std::numeric_limits<std::size_t>::max());
+
     // Re-try assigning servers for Pending jobs (when capacity becomes available).
-    // Safe to call often (e.g. after server_status updates).
+    // Safe to call often (e.g. after server_status updates): only the head of
+    // each pending sub-queue is considered, so a round costs O(servers) picks
+    // plus O(log n) per dispatched job.
     void tryDispatchPendingJobs();
 
 private:
@@ -59,16 +181,96 @@ private:
     sf::client::domain::Job*       findJob(const sf::client::domain::JobId& id);
     const sf::client::domain::Job* findJob(const sf::client::domain::JobId& id) const;
 
-    void removeJobAtIndex(std::size_t index);
+    sf::client::domain::Job& appendJob(sf::client::domain::Job job);
+
+    // Pick a server (or leave Pending), append and announce the job.
+    sf::client::domain::Job& submitJob(sf::client::domain::Job job,
+                                        std::optional<std::string> preferredServer);
+
+    // Cache / in-flight lookup for a new job (fields filled, not yet added).
+    // Returns the id that answers it, or nullopt when it has to run.
+    std::optional<sf::client::domain::JobId> reuseAnalysis(sf::client::domain::Job& job);
+    sf::client::domain::Job* findInFlight(std::uint64_t positionKey,
+                                          const sf::client::domain::SearchLimit& limit,
+                                          int multiPv);
+    // A batch position that job is already searching: the batch counts
+    // job's status in its progress from now on.
+    void shareWithBatch(const sf::client::domain::Job& job, const sf::client::domain::JobId& batchId);
+    // notifyUpdated/notifyRemoved: move job in the counts of the batches
+    // sharing it (status after the change; nullopt = removed).
+    void refreshSharingBatches(const sf::client::domain::Job& job,
+                               std::optional<sf::client::domain::JobStatus> status);
+    // Let later requests for job's position share it (reuseAnalysis does
+    // this itself for new jobs).
+    void trackInFlight(const sf::client::domain::Job& job);
+    // Store a freshly finished full-width result in the analysis cache
+    // (an extended job's only if it got deeper; see extendedFrom_).
+    void cacheResult(sf::client::domain::Job& job);
+
+    // A sub-job changed (before/after: its status, nullopt = added/removed).
+    // Cluster jobs re-merge their parts, batch jobs adjust their counts.
+    void refreshParentJob(const sf::client::domain::JobId& parentId,
+                          std::optional<sf::client::domain::JobStatus> before,
+                          std::optional<sf::client::domain::JobStatus> after);
+    // Re-derive a cluster job's status and snapshot from its sub-jobs.
+    void refreshClusterJob(const sf::client::domain::JobId& parentId);
+    // Derive a batch job's status from its counts and announce it.
+    void refreshBatchJob(sf::client::domain::Job& batch);
+    void removeJob(JobList::iterator it);
+    // evictTerminalJobs() helpers: the family is terminal throughout; drop
+    // it, taking its size off residentBytes.
+    bool isTerminalFamily(const sf::client::domain::Job& job) const;
+    int evictFamily(JobList::iterator it, std::size_t& residentBytes);
     void persistIfTerminal(const sf::client::domain::Job& job);
 
-    // Assign server to one pending job (if possible) and notify callbacks.
-    bool tryDispatchOnePendingJob();
+    // extendJob() for one job with a search of its own.
+    bool canExtend(const sf::client::domain::Job& job, int limitValue) const;
+    void extendOne(sf::client::domain::Job& job, int limitValue);
+
+    // Assign a server to this pending job (if possible) and notify callbacks.
+    bool tryDispatchPendingJob(sf::client::domain::Job& job);
+
+    // Keep pending_ in step with job.status / priority / pin.
+    void syncPendingQueue(const sf::client::domain::Job& job);
+
+    // Update summaries_ (batch sub-jobs are not listed), run the matching
+    // callback, then the counts of batches sharing the job.
+    void notifyAdded(const sf::client::domain::Job& job);
+    void notifyUpdated(const sf::client::domain::Job& job);
+    void notifyRemoved(const sf::client::domain::Job& job);
+    void notifyExtended(const sf::client::domain::Job& job);
+    bool isBatchItem(const sf::client::domain::Job& job) const;
 
     ServerManager&                         serverManager_;
     sf::client::app::IHistoryRepository*  historyRepo_;
-    std::vector<sf::client::domain::Job>   jobs_;
+    JobList                                jobs_;
+    std::unordered_map<sf::client::domain::JobId, JobList::iterator> index_;
+    PendingJobQueue                        pending_;
+    // Position key -> jobs submitted for it (stale ids are pruned on lookup).
+    std::unordered_map<std::uint64_t, std::vector<sf::client::domain::JobId>> inFlightByPosition_;
+    // Job -> batches that left one of their positions to it, with the
+    // status each batch last counted (dropped once either side is terminal).
+    struct BatchShare {
+        sf::client::domain::JobId     batchId;
+        sf::client::domain::JobStatus counted;
+    };
+    std::unordered_map<sf::client::domain::JobId, std::vector<BatchShare>> batchShares_;
     JobManagerCallbacks                    callbacks_;
+    JobSummaryStore                        summaries_;
+    // Jobs moved by failOverServer(); true once dispatched again, until the
+    // new server's first report replaces the partial snapshot.
+    std::unordered_map<sf::client::domain::JobId, bool> failedOver_;
+    // Jobs extendJob() searched again: the limit value and depth they had
+    // before. A result only goes to the analysis cache once it got deeper.
+    struct ExtendedFrom {
+        int limitValue;
+        int depth;
+    };
+    std::unordered_map<sf::client::domain::JobId, ExtendedFrom> extendedFrom_;
+    std::unordered_set<sf::client::domain::JobId> evicted_;
+    std::vector<const sf::client::domain::JobSnapshot*> clusterParts_; // refreshClusterJob scratch
+    std::size_t                            logCapacity_{sf::client::domain::JobLogOptions::kDefaultCapacity};
+    std::string                            logSpillDir_;
     // Unique job IDs even across client restarts.
     long long                              lastIdMs_{0};
     int                                    seqWithinMs_{0};
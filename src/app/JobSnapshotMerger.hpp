@@ -3,8 +3,10 @@
 #include "domain/domain_model.hpp"
 
 #include <algorithm>
+#include <climits>
 #include <optional>
 #include <utility>
+#include <vector>
 
 namespace sf::client::app {
 
@@ -14,8 +16,16 @@ namespace sf::client::app {
 //  - optional fields are merged only if incoming has a value
 //  - depth/selDepth/nodes/nps are monotonic (never decrease)
 //  - score is merged only if incoming.score.type != None
-//  - bestMove/pv are merged only if incoming string is non-empty
+//  - bestMove/pv are merged only if incoming value is non-empty
 //  - Pv lines are upserted by multipv and kept sorted
+//
+// Merging writes into the destination's existing line slots, so once a
+// snapshot has seen all its MultiPV lines (or had reserveLines()), further
+// updates allocate nothing: PVs that fit MoveLine's inline buffer never
+// do, longer ones reuse the buffer of the line they replace.
+//
+// mergeParts() combines the snapshots of sub-jobs that searched disjoint
+// root moves of one position (see JobManager::enqueueClusterJob).
 struct JobSnapshotMerger final {
     static void merge(domain::JobSnapshot& dst, const domain::JobSnapshot& in) {
         mergeOptionalMax(dst.depth, in.depth);
@@ -34,32 +44,142 @@ struct JobSnapshotMerger final {
             dst.pv = in.pv;
         }
 
-        if (!in.lines.empty()) {
-            for (const auto& lineIn : in.lines) {
-                const int mpv = (lineIn.multipv <= 0) ? 1 : lineIn.multipv;
-                bool replaced = false;
-                for (auto& lineDst : dst.lines) {
-                    if (lineDst.multipv == mpv) {
-                        lineDst = lineIn;
-                        lineDst.multipv = mpv;
-                        replaced = true;
-                        break;
-                    }
+        for (const auto& lineIn : in.lines) {
+            domain::PvLine& slot = lineSlot(dst.lines, (lineIn.multipv <= 0) ? 1 : lineIn.multipv);
+            const int mpv = slot.multipv;
+            slot = lineIn;
+            slot.multipv = mpv;
+        }
+    }
+
+    // Room for multiPv lines, so the first updates do not grow the vector.
+    static void reserveLines(domain::JobSnapshot& s, int multiPv) {
+        s.lines.reserve(static_cast<std::size_t>(std::max(1, multiPv)));
+    }
+
+    // Back to an empty snapshot, keeping the lines' capacity.
+    static void reset(domain::JobSnapshot& s) {
+        s.depth.reset();
+        s.selDepth.reset();
+        s.score = domain::Score{};
+        s.nodes.reset();
+        s.nps.reset();
+        s.bestMove.clear();
+        s.pv.clear();
+        s.lines.clear();
+    }
+
+    // Lines of all parts ranked by score and renumbered 1..multiPv; the top
+    // line provides score/pv/bestMove. depth is the lowest one reached by
+    // every reporting part (the depth the whole move list is searched to),
+    // nodes and nps are summed. out is overwritten; its line slots are
+    // reused.
+    static void mergeParts(const std::vector<const domain::JobSnapshot*>& parts, int multiPv,
+                           domain::JobSnapshot& out) {
+        out.depth.reset();
+        out.selDepth.reset();
+        out.nodes.reset();
+        out.nps.reset();
+
+        std::size_t count = 0;
+        for (const auto* part : parts) {
+            if (!part) {
+                continue;
+            }
+            if (part->depth) {
+                out.depth = out.depth ? std::min(*out.depth, *part->depth) : *part->depth;
+            }
+            mergeOptionalMax(out.selDepth, part->selDepth);
+            if (part->nodes) {
+                out.nodes = out.nodes.value_or(0) + *part->nodes;
+            }
+            if (part->nps) {
+                out.nps = out.nps.value_or(0) + *part->nps;
+            }
+
+            for (const auto& line : part->lines) {
+                if (line.score.type == domain::ScoreType::None || line.pv.empty()) {
+                    continue;
                 }
-                if (!replaced) {
-                    auto copy = lineIn;
-                    copy.multipv = mpv;
-                    dst.lines.push_back(std::move(copy));
+                if (count < out.lines.size()) {
+                    out.lines[count] = line;
+                } else {
+                    out.lines.push_back(line);
                 }
+                // Rank in collection order among equals (see below).
+                out.lines[count].multipv = static_cast<int>(count);
+                ++count;
             }
+        }
+        out.lines.resize(count);
+
+        // Lines searched deeper win ties between equal scores, then the
+        // earlier part. A plain sort with that total order stays stable
+        // without stable_sort's scratch buffer.
+        std::sort(out.lines.begin(), out.lines.end(), [](const domain::PvLine& a, const domain::PvLine& b) {
+            const long long ka = scoreKey(a.score);
+            const long long kb = scoreKey(b.score);
+            if (ka != kb) {
+                return ka > kb;
+            }
+            const int da = a.depth.value_or(0);
+            const int db = b.depth.value_or(0);
+            if (da != db) {
+                return da > db;
+            }
+            return a.multipv < b.multipv;
+        });
+        if (static_cast<int>(out.lines.size()) > std::max(1, multiPv)) {
+            out.lines.resize(static_cast<std::size_t>(std::max(1, multiPv)));
+        }
+        for (std::size_t i = 0; i < out.lines.size(); ++i) {
+            out.lines[i].multipv = static_cast<int>(i) + 1;
+        }
+
+        if (!out.lines.empty()) {
+            const auto& top = out.lines.front();
+            out.score = top.score;
+            out.pv    = top.pv;
+            out.bestMove = domain::chess::packedToUci(top.pv.front());
+        } else {
+            out.score = domain::Score{};
+            out.pv.clear();
+            out.bestMove.clear();
+        }
+    }
 
-            std::sort(dst.lines.begin(), dst.lines.end(), [](const domain::PvLine& a, const domain::PvLine& b) {
-                return a.multipv < b.multipv;
-            });
+    // Orders scores from the side to move's point of view:
+    // mate-in-1 > mate-in-5 > any cp > mated-in-5 > mated-in-1.
+    static long long scoreKey(const domain::Score& s) {
+        constexpr long long kMateBase = static_cast<long long>(INT_MAX) + 1;
+        switch (s.type) {
+            case domain::ScoreType::Cp:
+                return s.value;
+            case domain::ScoreType::Mate:
+                return s.value > 0 ? kMateBase * 2 - s.value : -kMateBase * 2 - s.value;
+            default:
+                return LLONG_MIN;
         }
     }
 
 private:
+    // Slot for multipv in lines sorted by multipv, inserted if missing.
+    // Lines 1..N are normally all present, so index mpv - 1 is tried first.
+    static domain::PvLine& lineSlot(std::vector<domain::PvLine>& lines, int mpv) {
+        const auto direct = static_cast<std::size_t>(mpv - 1);
+        if (direct < lines.size() && lines[direct].multipv == mpv) {
+            return lines[direct];
+        }
+        auto it = std::lower_bound(lines.begin(), lines.end(), mpv, [](const domain::PvLine& l, int m) {
+            return l.multipv < m;
+        });
+        if (it == lines.end() || it->multipv != mpv) {
+            it = lines.insert(it, domain::PvLine{});
+            it->multipv = mpv;
+        }
+        return *it;
+    }
+
     template <typename T>
     static void mergeOptionalMax(std::optional<T>& dst, const std::optional<T>& in) {
         if (!in.has_value()) {
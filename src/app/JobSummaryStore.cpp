@@ -0,0 +1,211 @@
+#include "app/JobSummaryStore.hpp"
+
+#include <chrono>
+#include <unordered_set>
+
+namespace sf::client::app {
+
+using namespace sf::client::domain;
+
+namespace {
+
+std::int64_t toMs(TimePoint tp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
+
+TimePoint fromMs(std::int64_t ms) {
+    return TimePoint(std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(ms)));
+}
+
+} // namespace
+
+void JobSummaryStore::setListener(JobSummaryStoreListener listener) {
+    listener_ = std::move(listener);
+}
+
+std::optional<int> JobSummaryStore::rowOf(const JobId& id) const {
+    const auto it = rowById_.find(id);
+    if (it == rowById_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::uint32_t JobSummaryStore::intern(const std::string& name) {
+    const auto it = nameIndex_.find(name);
+    if (it != nameIndex_.end()) {
+        return it->second;
+    }
+    const auto idx = static_cast<std::uint32_t>(names_.size());
+    names_.push_back(name);
+    nameIndex_.emplace(name, idx);
+    return idx;
+}
+
+void JobSummaryStore::writeRow(int row, const Job& job) {
+    opponent_[row]     = intern(job.opponent);
+    server_[row]       = job.assignedServer ? intern(*job.assignedServer) : 0;
+    status_[row]       = static_cast<std::uint8_t>(job.status);
+    priority_[row]     = job.priority;
+    depth_[row]        = job.snapshot.depth.value_or(-1);
+    scoreType_[row]    = static_cast<std::uint8_t>(job.snapshot.score.type);
+    scoreValue_[row]   = job.snapshot.score.value;
+    nodes_[row]        = job.snapshot.nodes.value_or(-1);
+    createdMs_[row]    = toMs(job.createdAt);
+    lastUpdateMs_[row] = toMs(job.lastUpdateAt);
+    batchDone_[row]    = job.batch ? job.batch->done() : 0;
+    batchTotal_[row]   = job.batch ? job.batch->total : 0;
+}
+
+void JobSummaryStore::pushRow(const Job& job) {
+    const int row = size();
+    ids_.push_back(job.id);
+    opponent_.emplace_back();
+    server_.emplace_back();
+    status_.emplace_back();
+    priority_.emplace_back();
+    depth_.emplace_back();
+    scoreType_.emplace_back();
+    scoreValue_.emplace_back();
+    nodes_.emplace_back();
+    createdMs_.emplace_back();
+    lastUpdateMs_.emplace_back();
+    batchDone_.emplace_back();
+    batchTotal_.emplace_back();
+    writeRow(row, job);
+    rowById_.emplace(job.id, row);
+}
+
+void JobSummaryStore::upsert(const Job& job) {
+    if (const auto row = rowOf(job.id)) {
+        writeRow(*row, job);
+        if (listener_.rowChanged) {
+            listener_.rowChanged(*row);
+        }
+        return;
+    }
+
+    const int row = size();
+    if (listener_.rowsAboutToBeInserted) {
+        listener_.rowsAboutToBeInserted(row, row);
+    }
+    pushRow(job);
+    if (listener_.rowsInserted) {
+        listener_.rowsInserted();
+    }
+}
+
+int JobSummaryStore::appendNew(const std::vector<Job>& jobs) {
+    std::vector<const Job*> fresh;
+    std::unordered_set<JobId> seen;
+    fresh.reserve(jobs.size());
+    for (const auto& job : jobs) {
+        if (rowById_.find(job.id) == rowById_.end() && seen.insert(job.id).second) {
+            fresh.push_back(&job);
+        }
+    }
+    if (fresh.empty()) {
+        return 0;
+    }
+
+    const int first = size();
+    const int count = static_cast<int>(fresh.size());
+    if (listener_.rowsAboutToBeInserted) {
+        listener_.rowsAboutToBeInserted(first, first + count - 1);
+    }
+    for (const Job* job : fresh) {
+        pushRow(*job);
+    }
+    if (listener_.rowsInserted) {
+        listener_.rowsInserted();
+    }
+    return count;
+}
+
+void JobSummaryStore::erase(const JobId& id) {
+    const auto it = rowById_.find(id);
+    if (it == rowById_.end()) {
+        return;
+    }
+
+    const int row = it->second;
+    if (listener_.rowAboutToBeRemoved) {
+        listener_.rowAboutToBeRemoved(row);
+    }
+
+    rowById_.erase(it);
+    ids_.erase(ids_.begin() + row);
+    opponent_.erase(opponent_.begin() + row);
+    server_.erase(server_.begin() + row);
+    status_.erase(status_.begin() + row);
+    priority_.erase(priority_.begin() + row);
+    depth_.erase(depth_.begin() + row);
+    scoreType_.erase(scoreType_.begin() + row);
+    scoreValue_.erase(scoreValue_.begin() + row);
+    nodes_.erase(nodes_.begin() + row);
+    createdMs_.erase(createdMs_.begin() + row);
+    lastUpdateMs_.erase(lastUpdateMs_.begin() + row);
+    batchDone_.erase(batchDone_.begin() + row);
+    batchTotal_.erase(batchTotal_.begin() + row);
+
+    // Rows below shift up by one (removal is rare compared to updates).
+    for (int r = row; r < size(); ++r) {
+        rowById_[ids_[r]] = r;
+    }
+
+    if (listener_.rowRemoved) {
+        listener_.rowRemoved();
+    }
+}
+
+std::optional<int> JobSummaryStore::depth(int row) const {
+    if (depth_[row] < 0) {
+        return std::nullopt;
+    }
+    return depth_[row];
+}
+
+Score JobSummaryStore::score(int row) const {
+    return Score{static_cast<ScoreType>(scoreType_[row]), scoreValue_[row]};
+}
+
+std::optional<int64_t> JobSummaryStore::nodes(int row) const {
+    if (nodes_[row] < 0) {
+        return std::nullopt;
+    }
+    return nodes_[row];
+}
+
+TimePoint JobSummaryStore::createdAt(int row) const {
+    return fromMs(createdMs_[row]);
+}
+
+TimePoint JobSummaryStore::lastUpdateAt(int row) const {
+    return fromMs(lastUpdateMs_[row]);
+}
+
+std::size_t JobSummaryStore::byteSize() const {
+    const auto heap = [](const std::string& s) {
+        return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+    };
+    const auto column = [](const auto& v) { return v.capacity() * sizeof(v.front()); };
+
+    std::size_t bytes = column(ids_) + column(opponent_) + column(server_) + column(status_)
+                      + column(priority_) + column(depth_) + column(scoreType_) + column(scoreValue_)
+                      + column(nodes_) + column(createdMs_) + column(lastUpdateMs_)
+                      + column(batchDone_) + column(batchTotal_) + column(names_);
+    for (const auto& id : ids_) {
+        bytes += heap(id);
+    }
+    // Hash nodes hold a copy of the key plus a next pointer and the value.
+    for (const auto& [id, row] : rowById_) {
+        bytes += sizeof(id) + sizeof(row) + sizeof(void*) + heap(id);
+    }
+    for (const auto& name : names_) {
+        bytes += 2 * heap(name); // names_ entry and its nameIndex_ key
+    }
+    bytes += nameIndex_.size() * (sizeof(std::string) + sizeof(std::uint32_t) + sizeof(void*));
+    return bytes + (rowById_.bucket_count() + nameIndex_.bucket_count()) * sizeof(void*);
+}
+
+} // namespace sf::client::app
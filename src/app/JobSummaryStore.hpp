@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::app {
+
+// Change notifications, in the order a Qt item model needs them: "about
+// to" fires before the rows change, the plain one after.
+struct JobSummaryStoreListener {
+    std::function<void(int first, int last)> rowsAboutToBeInserted;
+    std::function<void()>                    rowsInserted;
+    std::function<void(int row)>             rowChanged;
+    std::function<void(int row)>             rowAboutToBeRemoved;
+    std::function<void()>                    rowRemoved;
+};
+
+// What the jobs table shows, one column per field instead of one Job per
+// row: tens of thousands of history rows cost a few dozen bytes each and
+// no snapshot, log or move lists. Opponent and server names are interned.
+//
+// Rows keep insertion order; sorting and filtering are the view's job.
+class JobSummaryStore {
+public:
+    void setListener(JobSummaryStoreListener listener);
+
+    int  size() const noexcept { return static_cast<int>(ids_.size()); }
+    bool empty() const noexcept { return ids_.empty(); }
+
+    std::optional<int> rowOf(const sf::client::domain::JobId& id) const;
+
+    // Approximate heap use of the columns, the id index and the names.
+    std::size_t byteSize() const;
+
+    // Update the job's row, or append one.
+    void upsert(const sf::client::domain::Job& job);
+
+    // Append jobs not listed yet (one insert notification); returns how many.
+    int appendNew(const std::vector<sf::client::domain::Job>& jobs);
+
+    void erase(const sf::client::domain::JobId& id);
+
+    // ---- Columns (row in [0, size())) ----
+    const sf::client::domain::JobId& id(int row) const { return ids_[row]; }
+    const std::string& opponent(int row) const { return names_[opponent_[row]]; }
+    // Empty = not assigned.
+    const std::string& server(int row) const { return names_[server_[row]]; }
+    sf::client::domain::JobStatus status(int row) const {
+        return static_cast<sf::client::domain::JobStatus>(status_[row]);
+    }
+    int                    priority(int row) const { return priority_[row]; }
+    std::optional<int>     depth(int row) const;
+    sf::client::domain::Score score(int row) const;
+    std::optional<int64_t> nodes(int row) const;
+    sf::client::domain::TimePoint createdAt(int row) const;
+    sf::client::domain::TimePoint lastUpdateAt(int row) const;
+    // Batch jobs: positions done / in the batch; total 0 = not a batch.
+    int batchDone(int row) const { return batchDone_[row]; }
+    int batchTotal(int row) const { return batchTotal_[row]; }
+
+private:
+    std::uint32_t intern(const std::string& name);
+    void writeRow(int row, const sf::client::domain::Job& job);
+    void pushRow(const sf::client::domain::Job& job);
+
+    std::vector<sf::client::domain::JobId> ids_;
+    std::vector<std::uint32_t>             opponent_;  // index into names_
+    std::vector<std::uint32_t>             server_;    // index into names_, 0 = none
+    std::vector<std::uint8_t>              status_;
+    std::vector<std::int32_t>              priority_;
+    std::vector<std::int32_t>              depth_;     // -1 = none
+    std::vector<std::uint8_t>              scoreType_;
+    std::vector<std::int32_t>              scoreValue_;
+    std::vector<std::int64_t>              nodes_;     // -1 = none
+    std::vector<std::int64_t>              createdMs_;
+    std::vector<std::int64_t>              lastUpdateMs_;
+    std::vector<std::int32_t>              batchDone_;
+    std::vector<std::int32_t>              batchTotal_;
+
+    std::unordered_map<sf::client::domain::JobId, int> rowById_;
+
+    std::vector<std::string>                        names_{std::string()};
+    std::unordered_map<std::string, std::uint32_t>  nameIndex_{{std::string(), 0}};
+
+    JobSummaryStoreListener listener_;
+};
+
+} // namespace sf::client::app
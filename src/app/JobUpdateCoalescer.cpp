@@ -0,0 +1,164 @@
+#include "app/JobUpdateCoalescer.hpp"
+
+#include "app/JobManager.hpp"
+#include "app/JobSnapshotMerger.hpp"
+#include "infra/trace/Trace.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace sf::client::app {
+
+using namespace sf::client::domain;
+
+namespace {
+
+inline bool isTerminal(JobStatus s) {
+    return s == JobStatus::Finished ||
+           s == JobStatus::Error ||
+           s == JobStatus::Cancelled ||
+           s == JobStatus::Stopped;
+}
+
+} // namespace
+
+JobUpdateCoalescer::JobUpdateCoalescer(JobManager& jobManager, int frameIntervalMs, QObject* parent)
+    : QObject(parent)
+    , jobManager_(jobManager) {
+    // Single-shot: the timer only runs while something is pending.
+    frameTimer_.setSingleShot(true);
+    frameTimer_.setInterval(std::max(1, frameIntervalMs));
+    connect(&frameTimer_, &QTimer::timeout, this, &JobUpdateCoalescer::flush);
+}
+
+void JobUpdateCoalescer::push(const JobId& id,
+                              JobStatus status,
+                              const JobSnapshot& snapshot,
+                              std::vector<std::string> logLines) {
+    auto it = slots_.find(id);
+    if (it == slots_.end()) {
+        it = slots_.emplace(id, Pending{}).first;
+    }
+
+    Pending& p = it->second;
+    if (!p.queued) {
+        p.queued = true;
+        order_.push_back(&*it);
+    }
+    p.idleFlushes = 0;
+    p.status = status;
+    JobSnapshotMerger::merge(p.snapshot, snapshot);
+    p.logLines.insert(p.logLines.end(),
+                      std::make_move_iterator(logLines.begin()),
+                      std::make_move_iterator(logLines.end()));
+
+    if (isTerminal(status)) {
+        flushJob(id);
+        release(slots_.find(id));
+        return;
+    }
+    if (!frameTimer_.isActive()) {
+        frameTimer_.start();
+    }
+}
+
+void JobUpdateCoalescer::apply(Slot& slot) {
+    Pending& p = slot.second;
+    p.queued = false;
+
+    // Hand the update over from a local: callbacks may push to this job
+    // again. Its buffers go back to the slot unless they did.
+    Pending update;
+    update.status = p.status;
+    std::swap(update.snapshot, p.snapshot);
+    std::swap(update.logLines, p.logLines);
+
+    ++applying_;
+    jobManager_.applyRemoteUpdates(slot.first, update.status, update.snapshot, update.logLines);
+    --applying_;
+
+    if (!p.queued) {
+        JobSnapshotMerger::reset(update.snapshot);
+        update.logLines.clear();
+        std::swap(update.snapshot, p.snapshot);
+        std::swap(update.logLines, p.logLines);
+    }
+}
+
+void JobUpdateCoalescer::flush() {
+    CORRCHESS_TRACE_SCOPE("app.coalescerFlush");
+    frameTimer_.stop();
+
+    // Pushes from inside the callbacks go to the next frame, unless they hit
+    // a job still waiting in this one.
+    std::vector<Slot*> order;
+    order.swap(order_);
+
+    ++applying_;
+    for (Slot* slot : order) {
+        if (slot->second.queued) {
+            apply(*slot);
+        }
+    }
+    --applying_;
+
+    order.clear();
+    if (order_.empty()) {
+        order_.swap(order); // keep the capacity
+    }
+    if (applying_ == 0) {
+        releaseIdleSlots();
+    }
+}
+
+void JobUpdateCoalescer::flushJob(const JobId& id) {
+    const auto it = slots_.find(id);
+    if (it == slots_.end() || !it->second.queued) {
+        return;
+    }
+    dequeue(*it);
+    apply(*it);
+}
+
+void JobUpdateCoalescer::discard(const JobId& id) {
+    const auto it = slots_.find(id);
+    if (it == slots_.end()) {
+        return;
+    }
+    if (it->second.queued) {
+        dequeue(*it);
+        it->second.queued = false;
+    }
+    JobSnapshotMerger::reset(it->second.snapshot);
+    it->second.logLines.clear();
+    release(it);
+}
+
+void JobUpdateCoalescer::dequeue(Slot& slot) {
+    order_.erase(std::remove(order_.begin(), order_.end(), &slot), order_.end());
+}
+
+void JobUpdateCoalescer::release(Slots::iterator it) {
+    if (it == slots_.end() || it->second.queued) {
+        return;
+    }
+    if (applying_ > 0) {
+        it->second.idleFlushes = kIdleFlushesBeforeRelease;
+        return;
+    }
+    slots_.erase(it);
+}
+
+void JobUpdateCoalescer::releaseIdleSlots() {
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        Pending& p = it->second;
+        if (!p.queued && ++p.idleFlushes > kIdleFlushesBeforeRelease) {
+            it = slots_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace sf::client::app
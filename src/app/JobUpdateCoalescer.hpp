@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::app {
+
+class JobManager;
+
+// Rate limiter between the network layer and JobManager.
+//
+// Engines emit many "info" lines per second per MultiPV line; forwarding
+// each one costs a full Job copy into the model plus a repaint. Updates are
+// merged per job (JobSnapshotMerger rules, last status wins, log lines kept
+// in order) and applied once per frame, so UI cost is bounded by
+// jobs x frame rate regardless of how fast the cluster produces updates.
+//
+// Terminal updates (finished, error, ...) are applied immediately together
+// with anything still pending for that job.
+//
+// Each reporting job keeps its slot (and the slot's line and log buffers)
+// between frames, so a steady update stream merges without allocating;
+// slots are released once their job finishes or has been quiet for
+// kIdleFlushesBeforeRelease flushes.
+class JobUpdateCoalescer final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultFrameIntervalMs = 50; // 20 Hz
+    static constexpr int kIdleFlushesBeforeRelease = 100;
+
+    explicit JobUpdateCoalescer(JobManager& jobManager,
+                                int frameIntervalMs = kDefaultFrameIntervalMs,
+                                QObject* parent = nullptr);
+
+    void push(const sf::client::domain::JobId& id,
+              sf::client::domain::JobStatus status,
+              const sf::client::domain::JobSnapshot& snapshot,
+              std::vector<std::string> logLines);
+
+    // Apply everything pending now (e.g. before a full jobs_list sync).
+    void flush();
+    void flushJob(const sf::client::domain::JobId& id);
+
+    // Drop pending updates, e.g. for a job the user just stopped.
+    void discard(const sf::client::domain::JobId& id);
+
+    std::size_t pendingCount() const { return order_.size(); }
+
+private:
+    struct Pending {
+        sf::client::domain::JobStatus   status{sf::client::domain::JobStatus::Running};
+        sf::client::domain::JobSnapshot snapshot;
+        std::vector<std::string>        logLines;
+        bool                            queued{false}; // holds an update for the next flush
+        int                             idleFlushes{0};
+    };
+    using Slots = std::unordered_map<sf::client::domain::JobId, Pending>;
+    using Slot  = Slots::value_type;
+
+    void apply(Slot& slot);
+    void dequeue(Slot& slot);
+    // Drops the slot now, or at the next flush while callbacks are running.
+    void release(Slots::iterator it);
+    void releaseIdleSlots();
+
+    JobManager& jobManager_;
+    QTimer      frameTimer_;
+
+    Slots              slots_;
+    std::vector<Slot*> order_; // queued slots, first arrival within the frame
+    int                applying_{0}; // > 0 while JobManager callbacks run
+};
+
+} // namespace sf::client::app
@@ -0,0 +1,42 @@
+#include "app/MemoryBudget.hpp"
+
+#include "app/JobManager.hpp"
+
+namespace sf::client::app {
+
+MemoryBudget::MemoryBudget(JobManager& jobManager, MemoryBudgetOptions options)
+    : jobManager_(jobManager)
+    , options_(options) {
+}
+
+void MemoryBudget::addProbe(Probe probe) {
+    probes_.push_back(std::move(probe));
+}
+
+int MemoryBudget::enforce(sf::client::domain::TimePoint now) {
+    const int evicted = jobManager_.evictTerminalJobs(now - options_.evictAfter, options_.jobBytes);
+    evictedTotal_ += evicted;
+    return evicted;
+}
+
+std::vector<SubsystemMemory> MemoryBudget::report() const {
+    std::vector<SubsystemMemory> rows;
+
+    const JobMemoryUsage jobs = jobManager_.memoryUsage();
+    rows.push_back(SubsystemMemory{
+        "Live jobs", jobs.jobs, jobs.bytes,
+        std::to_string(jobs.logLines) + " log lines (" + std::to_string(jobs.logBytes >> 10)
+            + " KiB), snapshots " + std::to_string(jobs.snapshotBytes >> 10) + " KiB, "
+            + std::to_string(jobs.evicted) + " evicted to history"});
+
+    const JobSummaryStore& summaries = jobManager_.summaries();
+    rows.push_back(SubsystemMemory{"Job summaries", static_cast<std::size_t>(summaries.size()),
+                                   summaries.byteSize(), "jobs table rows, live and history"});
+
+    for (const Probe& probe : probes_) {
+        rows.push_back(probe());
+    }
+    return rows;
+}
+
+} // namespace sf::client::app
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::app {
+
+class JobManager;
+
+struct MemoryBudgetOptions {
+    // Terminal jobs leave memory this long after they finished ...
+    std::chrono::minutes evictAfter{120};
+    // ... or sooner, oldest first, while the live jobs take more than this.
+    std::size_t          jobBytes{256u << 20};
+};
+
+// One row of the memory diagnostics.
+struct SubsystemMemory {
+    std::string name;
+    std::size_t items{0};
+    std::size_t bytes{0}; // approximate heap use
+    std::string detail;
+};
+
+// Keeps a long session's memory bounded: enforce() (run it every minute or
+// so) moves finished jobs out of the JobManager once they are older than
+// the budget allows, leaving their summary rows; selecting one reloads it
+// from history. report() lists what each subsystem holds, from the job
+// manager plus whatever probes the owners of other caches register.
+class MemoryBudget {
+public:
+    using Probe = std::function<SubsystemMemory()>;
+
+    explicit MemoryBudget(JobManager& jobManager, MemoryBudgetOptions options = {});
+
+    const MemoryBudgetOptions& options() const noexcept { return options_; }
+    void setOptions(const MemoryBudgetOptions& options) { options_ = options; }
+
+    void addProbe(Probe probe);
+
+    // Evicts what the budget no longer covers; returns how many jobs went.
+    int enforce(sf::client::domain::TimePoint now = sf::client::domain::Clock::now());
+    // Jobs evicted by enforce() since startup.
+    int evictedTotal() const noexcept { return evictedTotal_; }
+
+    std::vector<SubsystemMemory> report() const;
+
+private:
+    JobManager&         jobManager_;
+    MemoryBudgetOptions options_;
+    std::vector<Probe>  probes_;
+    int                 evictedTotal_{0};
+};
+
+} // namespace sf::client::app
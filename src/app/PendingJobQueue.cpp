@@ -0,0 +1,57 @@
+#include "app/PendingJobQueue.hpp"
+
+#include <algorithm>
+
+namespace sf::client::app {
+
+using namespace sf::client::domain;
+
+void PendingJobQueue::push(const JobId& id, int priority, const std::optional<std::string>& pinnedServer) {
+    const std::string pin = pinnedServer.value_or(std::string());
+
+    std::uint64_t seq = nextSeq_;
+    if (const auto it = index_.find(id); it != index_.end()) {
+        seq = it->second.it->seq;
+        erase(id);
+    } else {
+        ++nextSeq_;
+    }
+
+    Queue& q = queueFor(pin);
+    const auto pos = q.insert(Entry{priority, seq, id}).first;
+    index_[id] = Slot{pin, pos};
+}
+
+bool PendingJobQueue::erase(const JobId& id) {
+    const auto it = index_.find(id);
+    if (it == index_.end()) {
+        return false;
+    }
+    const std::string& pin = it->second.pin;
+    if (pin.empty()) {
+        shared_.erase(it->second.it);
+    } else {
+        const auto qit = pinned_.find(pin);
+        qit->second.erase(it->second.it);
+        if (qit->second.empty()) {
+            pinned_.erase(qit);
+        }
+    }
+    index_.erase(it);
+    return true;
+}
+
+std::vector<PendingJobQueue::Entry> PendingJobQueue::heads() const {
+    std::vector<Entry> out;
+    out.reserve(pinned_.size() + 1);
+    if (!shared_.empty()) {
+        out.push_back(*shared_.begin());
+    }
+    for (const auto& [pin, q] : pinned_) {
+        out.push_back(*q.begin());
+    }
+    std::sort(out.begin(), out.end(), Order{});
+    return out;
+}
+
+} // namespace sf::client::app
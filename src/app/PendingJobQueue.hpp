@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::app {
+
+// Pending jobs ordered by priority (higher first), then age (older first).
+//
+// Jobs pinned to a server wait in that server's sub-queue, the rest in the
+// shared one, so dispatch only ever looks at one head per sub-queue instead
+// of scanning every job. Insert, erase and re-prioritise are O(log n).
+class PendingJobQueue {
+public:
+    struct Entry {
+        int                       priority{0};
+        std::uint64_t             seq{0}; // arrival order, kept across re-prioritising
+        sf::client::domain::JobId id;
+    };
+
+    // Insert, or move an already queued job (new priority / pin) keeping its age.
+    void push(const sf::client::domain::JobId& id,
+              int priority,
+              const std::optional<std::string>& pinnedServer);
+
+    bool erase(const sf::client::domain::JobId& id);
+    bool contains(const sf::client::domain::JobId& id) const { return index_.count(id) != 0; }
+
+    std::size_t size() const noexcept { return index_.size(); }
+    bool        empty() const noexcept { return index_.empty(); }
+
+    // Front entry of every non-empty sub-queue, best first.
+    std::vector<Entry> heads() const;
+
+private:
+    struct Order {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.priority != b.priority) {
+                return a.priority > b.priority;
+            }
+            return a.seq < b.seq;
+        }
+    };
+    using Queue = std::set<Entry, Order>;
+
+    struct Slot {
+        std::string     pin; // empty = shared queue
+        Queue::iterator it;
+    };
+
+    Queue& queueFor(const std::string& pin) { return pin.empty() ? shared_ : pinned_[pin]; }
+
+    Queue                                                   shared_;
+    std::unordered_map<std::string, Queue>                  pinned_;
+    std::unordered_map<sf::client::domain::JobId, Slot>     index_;
+    std::uint64_t                                           nextSeq_{0};
+};
+
+} // namespace sf::client::app
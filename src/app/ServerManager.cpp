@@ -1,5 +1,7 @@
 #include "app/ServerManager.hpp"
 
+#include "app/JobCostModel.hpp"
+
 #include <algorithm>
 
 namespace sf::client::app {
@@ -48,8 +50,17 @@ double ServerManager::computeLoad(const ServerInfo& s) {
     return static_cast<double>(s.runtime.runningJobs) / static_cast<double>(maxJobs);
 }
 
+namespace {
+
+// Weight of a new NPS sample in the running average.
+constexpr double kNpsSmoothing = 0.2;
+
+} // namespace
+
 ServerInfo* ServerManager::pickServerForJob(
-    const std::optional<std::string>& preferredId) {
+    const std::optional<std::string>& preferredId,
+    const SearchLimit& limit,
+    int multiPv) {
     if (preferredId) {
         if (auto* s = findServer(*preferredId)) {
             if (isAvailable(*s) &&
@@ -60,8 +71,12 @@ ServerInfo* ServerManager::pickServerForJob(
         }
     }
 
-    auto pickFrom = [this](ServerStatus wanted) -> ServerInfo* {
+    const bool byCost = policy_ == SchedulingPolicy::ExpectedCompletion;
+    const JobCost cost = estimateJobCost(limit, multiPv);
+
+    auto pickFrom = [&](ServerStatus wanted) -> ServerInfo* {
         ServerInfo* best = nullptr;
+        double bestTime = 1e300;
         double bestLoad = 1e9;
         for (auto& s : servers_) {
             if (!isAvailable(s)) {
@@ -71,8 +86,13 @@ ServerInfo* ServerManager::pickServerForJob(
                 continue;
             }
             const double load = computeLoad(s);
-            if (!best || load < bestLoad) {
+            const double time = byCost ? expectedCompletionSeconds(s, cost) : 0.0;
+            // Relative tolerance so "the same" time (e.g. movetime jobs) falls back to load.
+            const bool faster = time < bestTime * (1.0 - 1e-6);
+            const bool tie = !faster && time <= bestTime * (1.0 + 1e-6);
+            if (!best || faster || (tie && load < bestLoad)) {
                 best = &s;
+                bestTime = time;
                 bestLoad = load;
             }
         }
@@ -90,6 +110,25 @@ ServerInfo* ServerManager::pickServerForJob(
     return nullptr;
 }
 
+void ServerManager::recordJobNps(const std::string& id, std::int64_t nps) {
+    if (nps <= 0) {
+        return;
+    }
+    if (auto* s = findServer(id)) {
+        double& avg = s->runtime.measuredNps;
+        avg = avg > 0.0 ? avg + kNpsSmoothing * (static_cast<double>(nps) - avg)
+                        : static_cast<double>(nps);
+    }
+}
+
+void ServerManager::seedThroughput(const std::vector<Job>& jobs) {
+    for (const auto& job : jobs) {
+        if (job.assignedServer && job.snapshot.nps) {
+            recordJobNps(*job.assignedServer, *job.snapshot.nps);
+        }
+    }
+}
+
 void ServerManager::updateServerRuntime(const std::string& id,
                                         ServerStatus status,
                                         int runningJobs,
@@ -126,4 +165,32 @@ void ServerManager::updateServerRuntime(const std::string& id,
     }
 }
 
+void ServerManager::updateEnginePool(const std::string& id, int poolSize, int poolIdle, int poolBusy) {
+    if (auto* s = findServer(id)) {
+        s->runtime.enginePoolSize = std::max(0, poolSize);
+        s->runtime.enginePoolIdle = std::max(0, poolIdle);
+        s->runtime.enginePoolBusy = std::max(0, poolBusy);
+    }
+}
+
+void ServerManager::updateCpuAllocation(const std::string& id, int numaNodes, int freeCpus, int nextJobThreads) {
+    if (auto* s = findServer(id)) {
+        s->runtime.numaNodes      = std::max(0, numaNodes);
+        s->runtime.freeCpus       = std::max(0, freeCpus);
+        s->runtime.nextJobThreads = std::max(0, nextJobThreads);
+    }
+}
+
+void ServerManager::updateServerFeatures(const std::string& id, bool canExtendJobs) {
+    if (auto* s = findServer(id)) {
+        s->runtime.canExtendJobs = canExtendJobs;
+    }
+}
+
+void ServerManager::updateTelemetry(const std::string& id, const ServerTelemetry& telemetry) {
+    if (auto* s = findServer(id)) {
+        s->runtime.telemetry = telemetry;
+    }
+}
+
 } // namespace sf::client::app
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -19,13 +20,26 @@ public:
         return servers_;
     }
 
+    void setSchedulingPolicy(sf::client::domain::SchedulingPolicy policy) noexcept { policy_ = policy; }
+    sf::client::domain::SchedulingPolicy schedulingPolicy() const noexcept { return policy_; }
+
     // Choose the best server for a job.
     // - If preferredId is set and server is available -> return it.
-    // - Otherwise pick minimal load among Online servers.
+    // - Otherwise pick among Online servers by policy: minimal load, or
+    //   minimal expected completion time for this limit/MultiPV (ties go
+    //   to the less loaded server).
     // - If no Online servers, fall back to Unknown servers.
     // - If none available -> nullptr.
     sf::client::domain::ServerInfo* pickServerForJob(
-        const std::optional<std::string>& preferredId);
+        const std::optional<std::string>& preferredId,
+        const sf::client::domain::SearchLimit& limit,
+        int multiPv);
+
+    // Feed a per-job NPS observed on a server into its throughput estimate.
+    void recordJobNps(const std::string& id, std::int64_t nps);
+
+    // Seed throughput estimates from finished jobs (e.g. history at startup).
+    void seedThroughput(const std::vector<sf::client::domain::Job>& jobs);
 
     // Update runtime and (optionally) hardware info from server_status.
     void updateServerRuntime(const std::string& id,
@@ -35,12 +49,24 @@ public:
                              int threadsPerJob,
                              int logicalCores);
 
+    void updateEnginePool(const std::string& id, int poolSize, int poolIdle, int poolBusy);
+
+    // numaNodes 0 clears it (server does not pin engines).
+    void updateCpuAllocation(const std::string& id, int numaNodes, int freeCpus, int nextJobThreads);
+
+    // Optional requests from the server's hello answer.
+    void updateServerFeatures(const std::string& id, bool canExtendJobs);
+
+    // Connection metrics from the network thread (RTT, message rate, NPS).
+    void updateTelemetry(const std::string& id, const sf::client::domain::ServerTelemetry& telemetry);
+
 private:
     sf::client::domain::ServerInfo* findServer(const std::string& id);
     static bool isAvailable(const sf::client::domain::ServerInfo& s);
     static double computeLoad(const sf::client::domain::ServerInfo& s);
 
     std::vector<sf::client::domain::ServerInfo> servers_;
+    sf::client::domain::SchedulingPolicy        policy_{sf::client::domain::SchedulingPolicy::ExpectedCompletion};
 };
 
 } // namespace sf::client::app
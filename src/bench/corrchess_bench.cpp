@@ -0,0 +1,494 @@
+// Domain-layer benchmark suite: the hot paths behind the game viewer, PGN
+// import and live analysis, measured in isolation.
+//
+//   corrchess_bench [--json] [--filter=TEXT] [--min-time=SECONDS]
+//                   [--pgn=FILE] [--updates=FILE]
+//
+// Benchmarks (items are plies, games or messages, see each one):
+//
+//   fenTimelineFromSanMoves/eager   timeline with a FEN per ply
+//   fenTimelineFromSanMoves/lazy    timeline with packed positions
+//   fenFromSanMoves                 final FEN only
+//   SanReplay                       replay only, as the reference DB import does
+//   GameTree::fromMovetext          game tree as the viewer builds it
+//   parsePgnText                    whole PGN text held in memory
+//   scanPgnFile                     streaming scan of the PGN written to disk
+//   JobSnapshotMerger::merge/mpv10  one MultiPV 10 update stream into a snapshot
+//   decodeJobUpdate                 JSON job_update line -> wire::JobUpdate
+//
+// Without --pgn a deterministic ICCF-style PGN of about 8 MiB is generated;
+// without --updates, a MultiPV 10 job_update stream (one line per message,
+// as recorded with CORRCHESS_CAPTURE_DIR from a JSON session).
+//
+// --json prints the results as {"context":{...},"benchmarks":[...]} with
+// the field names Google Benchmark uses (real_time in ns per iteration,
+// items_per_second, bytes_per_second), so its compare tooling can diff two
+// runs, e.g. before and after a compiler or library upgrade.
+
+#include "app/JobSnapshotMerger.hpp"
+#include "domain/chess_san_to_fen.hpp"
+#include "domain/game_tree.hpp"
+#include "domain/pgn/PgnParser.hpp"
+#include "domain/pgn/PgnStreamScanner.hpp"
+#include "net/WireProtocol.hpp"
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace chess = sf::client::domain::chess;
+namespace pgn = sf::client::domain::pgn;
+namespace wire = sf::client::net::wire;
+
+using sf::client::app::JobSnapshotMerger;
+using sf::client::domain::JobSnapshot;
+using sf::client::domain::PvLine;
+using sf::client::domain::ScoreType;
+
+namespace {
+
+// ---- Inputs ----
+
+// Real games, so SAN replay sees captures, checks, castling both ways and
+// promotions instead of one repeated opening.
+const char* const kGames[] = {
+    "[Event \"ICCF corr\"]\n[Site \"ICCF\"]\n[Date \"2019.03.14\"]\n"
+    "[White \"Player, White\"]\n[Black \"Player, Black\"]\n[Result \"1/2-1/2\"]\n\n"
+    "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be3 e5 7. Nb3 Be6\n"
+    "8. f3 Be7 9. Qd2 O-O 10. O-O-O Nbd7 11. g4 b5 12. g5 b4 13. Ne2 Ne8\n"
+    "14. f4 a5 15. f5 a4 16. Nbd4 exd4 17. Nxd4 b3 18. Kb1 bxc2+ 19. Nxc2 Bb3\n"
+    "20. axb3 axb3 21. Na3 Ne5 22. h4 Ra5 1/2-1/2\n\n",
+
+    "[Event \"Paris\"]\n[Site \"Paris FRA\"]\n[Date \"1858.??.??\"]\n"
+    "[White \"Morphy, Paul\"]\n[Black \"Duke Karl / Count Isouard\"]\n[Result \"1-0\"]\n\n"
+    "1. e4 e5 2. Nf3 d6 3. d4 Bg4 {This is a weak move already.} 4. dxe5 Bxf3\n"
+    "5. Qxf3 dxe5 6. Bc4 Nf6 7. Qb3 Qe7 8. Nc3 c6 9. Bg5 b5 10. Nxb5 cxb5\n"
+    "11. Bxb5+ Nbd7 12. O-O-O Rd8 13. Rxd7 Rxd7 14. Rd1 Qe6 15. Bxd7+ Nxd7\n"
+    "16. Qb8+ Nxb8 17. Rd8# 1-0\n\n",
+
+    "[Event \"London\"]\n[Site \"London ENG\"]\n[Date \"1851.06.21\"]\n"
+    "[White \"Anderssen, Adolf\"]\n[Black \"Kieseritzky, Lionel\"]\n[Result \"1-0\"]\n\n"
+    "1. e4 e5 2. f4 exf4 3. Bc4 Qh4+ 4. Kf1 b5 5. Bxb5 Nf6 6. Nf3 Qh6 7. d3 Nh5\n"
+    "8. Nh4 Qg5 9. Nf5 c6 10. g4 Nf6 11. Rg1 cxb5 12. h4 Qg6 13. h5 Qg5 14. Qf3 Ng8\n"
+    "15. Bxf4 Qf6 16. Nc3 Bc5 17. Nd5 Qxb2 18. Bd6 Bxg1 19. e5 Qxa1+ 20. Ke2 Na6\n"
+    "21. Nxg7+ Kd8 22. Qf6+ Nxf6 23. Be7# 1-0\n\n",
+
+    "[Event \"ICCF corr\"]\n[Site \"ICCF\"]\n[Date \"2021.01.05\"]\n"
+    "[White \"Player, White\"]\n[Black \"Player, Black\"]\n[Result \"1-0\"]\n"
+    "[FEN \"8/P5k1/8/8/8/8/5K2/8 w - - 0 1\"]\n[SetUp \"1\"]\n\n"
+    "1. a8=Q Kf6 2. Qd5 Ke7 3. Ke3 Kf6 4. Kf4 Ke7 5. Qe5+ Kd7 6. Kf5 Kd8\n"
+    "7. Ke6 Kc8 8. Qb5 Kd8 9. Qd7# 1-0\n\n",
+};
+
+std::string makeSyntheticPgn(std::size_t targetBytes) {
+    std::string out;
+    out.reserve(targetBytes + 4096);
+    while (out.size() < targetBytes) {
+        for (const char* game : kGames) {
+            out += game;
+        }
+    }
+    return out;
+}
+
+QByteArray makeSyntheticUpdates(qsizetype targetBytes) {
+    QByteArray out;
+    out.reserve(targetBytes + 4096);
+    const QByteArray pv = QByteArrayLiteral("e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6 c1e3 e7e5");
+    qint64 nodes = 0;
+    int depth = 20;
+    while (out.size() < targetBytes) {
+        for (int job = 0; job < 4; ++job) {
+            const QByteArray jobId = QByteArrayLiteral("job-") + QByteArray::number(job);
+            for (int mpv = 1; mpv <= 10; ++mpv) {
+                nodes += 150000;
+                out += QByteArrayLiteral("{\"type\":\"job_update\",\"job_id\":\"") + jobId +
+                       QByteArrayLiteral("\",\"status\":2,\"multipv\":") + QByteArray::number(mpv) +
+                       QByteArrayLiteral(",\"depth\":") + QByteArray::number(depth) +
+                       QByteArrayLiteral(",\"seldepth\":") + QByteArray::number(depth + 12) +
+                       QByteArrayLiteral(",\"score_cp\":") + QByteArray::number(30 - mpv * 7) +
+                       QByteArrayLiteral(",\"nodes\":") + QByteArray::number(nodes) +
+                       QByteArrayLiteral(",\"nps\":2400000,\"pv\":\"") + pv +
+                       QByteArrayLiteral("\",\"log_line\":\"info depth ") + QByteArray::number(depth) +
+                       QByteArrayLiteral(" multipv ") + QByteArray::number(mpv) + QByteArrayLiteral(" pv ") + pv +
+                       QByteArrayLiteral("\"}\n");
+            }
+        }
+        depth = (depth < 60) ? depth + 1 : 20;
+    }
+    return out;
+}
+
+std::vector<QByteArray> splitLines(const QByteArray& data) {
+    std::vector<QByteArray> lines;
+    for (const auto& line : data.split('\n')) {
+        if (!line.trimmed().isEmpty()) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+bool readFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// ---- Harness ----
+
+// s as the body of a JSON string: quotes, backslashes and control
+// characters escaped (a path passed as argv[0] may hold any of them).
+std::string jsonEscaped(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (const char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out += buf;
+            } else {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+struct Work {
+    double items{0};
+    double bytes{0};
+};
+
+struct Measurement {
+    std::string  name;
+    std::int64_t iterations{0};
+    double       seconds{0};
+    Work         work;
+};
+
+class Suite {
+public:
+    Suite(std::string filter, double minSeconds)
+        : filter_(std::move(filter))
+        , minSeconds_(minSeconds) {}
+
+    // fn() runs one iteration and returns the work it did.
+    template <typename Fn>
+    void run(const std::string& name, Fn&& fn) {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos) {
+            return;
+        }
+        using Clock = std::chrono::steady_clock;
+
+        fn(); // warm-up: page in inputs, fill caches and allocator pools
+
+        Measurement m;
+        m.name = name;
+        const auto t0 = Clock::now();
+        do {
+            const Work w = fn();
+            m.work.items += w.items;
+            m.work.bytes += w.bytes;
+            ++m.iterations;
+            m.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        } while (m.seconds < minSeconds_);
+
+        results_.push_back(std::move(m));
+        if (!json_) {
+            printRow(results_.back());
+        }
+    }
+
+    void setJson(bool json) { json_ = json; }
+
+    void printJson(const char* executable) const {
+        std::printf("{\n  \"context\": {\n");
+        std::printf("    \"executable\": \"%s\",\n", jsonEscaped(executable).c_str());
+#ifdef NDEBUG
+        std::printf("    \"library_build_type\": \"release\",\n");
+#else
+        std::printf("    \"library_build_type\": \"debug\",\n");
+#endif
+        std::printf("    \"min_time\": %.3f\n  },\n  \"benchmarks\": [\n", minSeconds_);
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const Measurement& m = results_[i];
+            std::printf("    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %lld, "
+                        "\"real_time\": %.1f, \"time_unit\": \"ns\", "
+                        "\"items_per_second\": %.1f, \"bytes_per_second\": %.1f}%s\n",
+                        jsonEscaped(m.name).c_str(), static_cast<long long>(m.iterations),
+                        m.seconds * 1e9 / static_cast<double>(m.iterations),
+                        m.work.items / m.seconds, m.work.bytes / m.seconds,
+                        i + 1 < results_.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+
+private:
+    static void printRow(const Measurement& m) {
+        const double perIter = m.seconds / static_cast<double>(m.iterations);
+        std::printf("%-34s %10.3f ms/iter %12.0f items/s", m.name.c_str(), perIter * 1e3, m.work.items / m.seconds);
+        if (m.work.bytes > 0) {
+            std::printf(" %9.1f MiB/s", m.work.bytes / (1024.0 * 1024.0) / m.seconds);
+        }
+        std::printf("  (%lld iters)\n", static_cast<long long>(m.iterations));
+    }
+
+    std::string              filter_;
+    double                   minSeconds_;
+    bool                     json_{false};
+    std::vector<Measurement> results_;
+};
+
+// ---- Benchmarks ----
+
+struct Movetext {
+    std::string              text;
+    std::optional<std::string> startFen;
+};
+
+void benchSanReplay(Suite& suite, const std::vector<Movetext>& games) {
+    const auto timeline = [&](chess::FenTimelineMode mode) {
+        Work w;
+        for (const auto& g : games) {
+            const auto tl = chess::fenTimelineFromSanMoves(g.text, g.startFen, mode);
+            w.items += static_cast<double>(tl.plies.size());
+            w.bytes += static_cast<double>(g.text.size());
+        }
+        return w;
+    };
+    suite.run("fenTimelineFromSanMoves/eager", [&] { return timeline(chess::FenTimelineMode::Eager); });
+    suite.run("fenTimelineFromSanMoves/lazy", [&] { return timeline(chess::FenTimelineMode::Lazy); });
+
+    suite.run("fenFromSanMoves", [&] {
+        Work w;
+        for (const auto& g : games) {
+            const auto r = chess::fenFromSanMoves(g.text, g.startFen);
+            w.items += r.plyCount;
+            w.bytes += static_cast<double>(g.text.size());
+        }
+        return w;
+    });
+
+    suite.run("SanReplay", [&] {
+        Work w;
+        for (const auto& g : games) {
+            const auto start = g.startFen ? chess::Position::fromFen(*g.startFen)
+                                          : std::optional<chess::Position>(chess::Position::startpos());
+            if (!start) continue;
+            chess::SanReplay replay(g.text, *start);
+            while (replay.next()) {
+            }
+            w.items += replay.plyCount();
+            w.bytes += static_cast<double>(g.text.size());
+        }
+        return w;
+    });
+
+    suite.run("GameTree::fromMovetext", [&] {
+        Work w;
+        for (const auto& g : games) {
+            const auto start = g.startFen ? chess::Position::fromFen(*g.startFen)
+                                          : std::optional<chess::Position>(chess::Position::startpos());
+            if (!start) continue;
+            const auto tree = chess::GameTree::fromMovetext(g.text, *start);
+            w.items += tree ? static_cast<double>(tree->plyCount() - 1) : 0.0;
+            w.bytes += static_cast<double>(g.text.size());
+        }
+        return w;
+    });
+}
+
+void benchPgn(Suite& suite, const std::string& text, const std::string& path) {
+    suite.run("parsePgnText", [&] {
+        const auto r = pgn::parsePgnText(text, static_cast<int>(text.size()));
+        return Work{static_cast<double>(r.games.size()), static_cast<double>(text.size())};
+    });
+
+    suite.run("scanPgnFile", [&] {
+        int games = 0;
+        const auto r = pgn::scanPgnFile(path, [&](const pgn::PgnStreamGame&, std::uint64_t, std::string*) {
+            ++games;
+            return true;
+        });
+        return Work{static_cast<double>(games), static_cast<double>(r.bytesProcessed)};
+    });
+}
+
+void benchMerge(Suite& suite) {
+    // One search report round: ten lines per depth, depths 20..59.
+    std::vector<JobSnapshot> updates;
+    for (int depth = 20; depth < 60; ++depth) {
+        for (int mpv = 1; mpv <= 10; ++mpv) {
+            PvLine line;
+            line.multipv     = mpv;
+            line.depth       = depth;
+            line.selDepth    = depth + 12;
+            line.score.type  = ScoreType::Cp;
+            line.score.value = 30 - mpv * 7;
+            line.nodes       = static_cast<int64_t>(depth) * 1'000'000 + mpv;
+            line.nps         = 2'400'000;
+            line.pv          = chess::MoveLine::fromUci("e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6 c1e3 e7e5");
+
+            JobSnapshot in;
+            if (mpv == 1) {
+                in.depth = line.depth;
+                in.score = line.score;
+                in.pv    = line.pv;
+            }
+            in.lines.push_back(std::move(line));
+            updates.push_back(std::move(in));
+        }
+    }
+
+    suite.run("JobSnapshotMerger::merge/mpv10", [&] {
+        JobSnapshot snap;
+        for (const auto& in : updates) {
+            JobSnapshotMerger::merge(snap, in);
+        }
+        return Work{static_cast<double>(updates.size()), 0};
+    });
+}
+
+void benchDecode(Suite& suite, const std::vector<QByteArray>& lines) {
+    double bytes = 0;
+    for (const auto& line : lines) {
+        bytes += static_cast<double>(line.size());
+    }
+
+    suite.run("decodeJobUpdate", [&] {
+        std::size_t pvLines = 0;
+        for (const auto& line : lines) {
+            const QJsonObject obj = QJsonDocument::fromJson(line).object();
+            pvLines += wire::decodeJobUpdate(obj).snapshot.lines.size();
+        }
+        (void)pvLines;
+        return Work{static_cast<double>(lines.size()), bytes};
+    });
+}
+
+bool startsWith(const char* arg, const char* prefix, const char** value) {
+    const std::size_t n = std::strlen(prefix);
+    if (std::strncmp(arg, prefix, n) != 0) {
+        return false;
+    }
+    *value = arg + n;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool        json = false;
+    std::string filter;
+    double      minSeconds = 0.5;
+    std::string pgnPath;
+    std::string updatesPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* v = nullptr;
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (startsWith(argv[i], "--filter=", &v)) {
+            filter = v;
+        } else if (startsWith(argv[i], "--min-time=", &v)) {
+            minSeconds = std::max(0.0, std::atof(v));
+        } else if (startsWith(argv[i], "--pgn=", &v)) {
+            pgnPath = v;
+        } else if (startsWith(argv[i], "--updates=", &v)) {
+            updatesPath = v;
+        } else {
+            std::fprintf(stderr, "usage: %s [--json] [--filter=TEXT] [--min-time=SECONDS] "
+                                 "[--pgn=FILE] [--updates=FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // PGN text in memory, and on disk for the file scanner.
+    std::string pgnText;
+    std::filesystem::path scanPath;
+    bool removeScanFile = false;
+    if (!pgnPath.empty()) {
+        if (!readFile(pgnPath, pgnText)) {
+            std::fprintf(stderr, "%s: cannot read\n", pgnPath.c_str());
+            return 1;
+        }
+        scanPath = pgnPath;
+    } else {
+        pgnText = makeSyntheticPgn(8u << 20);
+        scanPath = std::filesystem::temp_directory_path() / "corrchess_bench.pgn";
+        std::ofstream(scanPath, std::ios::binary | std::ios::trunc).write(pgnText.data(),
+                                                                           static_cast<std::streamsize>(pgnText.size()));
+        removeScanFile = true;
+    }
+
+    // Movetexts for SAN replay: the distinct games, not the whole file, so
+    // these numbers do not depend on the PGN size.
+    std::vector<Movetext> games;
+    for (const auto& g : pgn::parsePgnText(pgnText, 64).games) {
+        Movetext m;
+        m.text = g.movetext;
+        if (const auto it = g.tags.find("FEN"); it != g.tags.end()) {
+            m.startFen = it->second;
+        }
+        games.push_back(std::move(m));
+    }
+
+    QByteArray updates;
+    if (!updatesPath.empty()) {
+        std::string raw;
+        if (!readFile(updatesPath, raw)) {
+            std::fprintf(stderr, "%s: cannot read\n", updatesPath.c_str());
+            return 1;
+        }
+        updates = QByteArray::fromStdString(raw);
+    } else {
+        updates = makeSyntheticUpdates(4 << 20);
+    }
+    const auto updateLines = splitLines(updates);
+
+    Suite suite(filter, minSeconds);
+    suite.setJson(json);
+    if (!json) {
+        std::printf("PGN %zu bytes (%zu games for SAN replay), %zu job_update lines\n",
+                    pgnText.size(), games.size(), updateLines.size());
+    }
+
+    benchSanReplay(suite, games);
+    benchPgn(suite, pgnText, scanPath.string());
+    benchMerge(suite);
+    benchDecode(suite, updateLines);
+
+    if (json) {
+        suite.printJson(argv[0]);
+    }
+
+    if (removeScanFile) {
+        std::error_code ec;
+        std::filesystem::remove(scanPath, ec);
+    }
+    return 0;
+}
@@ -0,0 +1,416 @@
+// Move generator correctness and speed check.
+//
+//   corrchess_perft [--deep] [--depth=N] [--fen=FEN] [--divide]
+//   corrchess_perft --san-roundtrip FILE.pgn [--max-games=N]
+//   corrchess_perft --san-fuzz=GAMES [--seed=N]
+//
+// perft mode counts the leaf nodes of the legal move tree (generateLegalMoves
+// + makeMove/unmakeMove) and compares them with the published counts for the
+// standard test positions (start position, Kiwipete and positions 3-6 of the
+// Chess Programming Wiki suite). It also verifies that makeMove/unmakeMove
+// restore the position and keep the incremental Zobrist key equal to
+// computeKey(). By default each position runs to the deepest known depth
+// under about 5M nodes; --deep runs every known depth, --depth=N caps it.
+// --fen runs one position (no expected counts) and --divide prints the
+// per-root-move counts, for bisecting a mismatch against another engine.
+//
+// san-roundtrip mode replays every game of a PGN and checks, at each ply,
+// that the SAN in the file resolves (sanToMove, the movetext replay path),
+// that its UCI form finds the same legal move (findLegalUci), and that
+// moveToSan of that move resolves back to it. The same check runs for
+// every legal move of every position reached, which exercises disambiguation,
+// promotions and castling far beyond what the games themselves play.
+// --san-fuzz does the same along seeded random games from the perft
+// positions, which reach underpromotions and en passant pins quickly.
+//
+// Exit status is 0 only if every count matched and no round trip failed.
+
+#include "domain/chess/Position.hpp"
+#include "domain/chess_san_to_fen.hpp"
+#include "domain/pgn/PgnStreamScanner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace chess = sf::client::domain::chess;
+namespace pgn = sf::client::domain::pgn;
+
+using chess::Move;
+using chess::MoveList;
+using chess::Position;
+using chess::UndoInfo;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// ---- Perft ----
+
+struct PerftCase {
+    const char*                name;
+    const char*                fen;
+    std::vector<std::uint64_t> nodes;    // nodes[d - 1] = perft(d)
+    int                        quickDepth; // default depth (≤ ~5M nodes)
+};
+
+const std::vector<PerftCase>& perftSuite() {
+    static const std::vector<PerftCase> suite = {
+        {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+         {20, 400, 8902, 197281, 4865609, 119060324}, 5},
+        {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+         {48, 2039, 97862, 4085603, 193690690}, 4},
+        {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+         {14, 191, 2812, 43238, 674624, 11030083}, 5},
+        {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+         {6, 264, 9467, 422333, 15833292}, 4},
+        {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+         {44, 1486, 62379, 2103487, 89941194}, 4},
+        {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+         {46, 2079, 89890, 3894594, 164075551}, 4},
+    };
+    return suite;
+}
+
+struct PerftStats {
+    std::uint64_t nodes{0};
+    std::uint64_t keyErrors{0};    // incremental key != computeKey()
+    std::uint64_t unmakeErrors{0}; // position not restored by unmakeMove
+};
+
+void perft(Position& pos, int depth, PerftStats& stats) {
+    MoveList moves;
+    pos.generateLegalMoves(moves);
+    if (depth == 1) {
+        stats.nodes += static_cast<std::uint64_t>(moves.size);
+        return;
+    }
+    for (const Move& m : moves) {
+        const std::uint64_t keyBefore = pos.key();
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        if (pos.key() != pos.computeKey()) {
+            ++stats.keyErrors;
+        }
+        perft(pos, depth - 1, stats);
+        pos.unmakeMove(m, undo);
+        if (pos.key() != keyBefore) {
+            ++stats.unmakeErrors;
+        }
+    }
+}
+
+// Per-root-move counts, sorted by UCI like Stockfish's "go perft".
+void divide(Position& pos, int depth) {
+    MoveList moves;
+    pos.generateLegalMoves(moves);
+    std::vector<std::pair<std::string, std::uint64_t>> rows;
+    for (const Move& m : moves) {
+        PerftStats stats;
+        UndoInfo undo;
+        pos.makeMove(m, undo);
+        if (depth > 1) {
+            perft(pos, depth - 1, stats);
+        } else {
+            stats.nodes = 1;
+        }
+        pos.unmakeMove(m, undo);
+        rows.emplace_back(chess::moveToUci(m), stats.nodes);
+    }
+    std::sort(rows.begin(), rows.end());
+    for (const auto& [uci, n] : rows) {
+        std::printf("  %s: %llu\n", uci.c_str(), static_cast<unsigned long long>(n));
+    }
+}
+
+// Returns false on a wrong count or a make/unmake inconsistency.
+bool runPerft(const char* name, const std::string& fen, int depth,
+              std::optional<std::uint64_t> expected, bool withDivide) {
+    auto start = Position::fromFen(fen);
+    if (!start) {
+        std::printf("%-10s invalid FEN: %s\n", name, fen.c_str());
+        return false;
+    }
+    Position pos = *start;
+    const std::string fenBefore = pos.toFen();
+
+    PerftStats stats;
+    const auto t0 = Clock::now();
+    if (depth > 0) {
+        perft(pos, depth, stats);
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    const bool countOk = !expected || stats.nodes == *expected;
+    const bool restored = pos.toFen() == fenBefore;
+    const bool ok = countOk && restored && stats.keyErrors == 0 && stats.unmakeErrors == 0;
+
+    std::printf("%-10s depth %d %12llu nodes %8.3f s %8.2f Mnps  %s",
+                name, depth, static_cast<unsigned long long>(stats.nodes), secs,
+                secs > 0 ? static_cast<double>(stats.nodes) / secs / 1e6 : 0.0,
+                !expected ? "-" : (countOk ? "ok" : "MISMATCH"));
+    if (expected && !countOk) {
+        std::printf(" (expected %llu)", static_cast<unsigned long long>(*expected));
+    }
+    if (stats.keyErrors || stats.unmakeErrors || !restored) {
+        std::printf(" key errors %llu, unmake errors %llu%s",
+                    static_cast<unsigned long long>(stats.keyErrors),
+                    static_cast<unsigned long long>(stats.unmakeErrors),
+                    restored ? "" : ", position not restored");
+    }
+    std::printf("\n");
+
+    if (withDivide) {
+        divide(pos, depth);
+    }
+    return ok;
+}
+
+// ---- SAN round trip ----
+
+bool sameMove(const Move& a, const Move& b) {
+    return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+}
+
+struct RoundTripStats {
+    std::uint64_t games{0};
+    std::uint64_t gamesSkipped{0}; // start FEN or movetext does not replay
+    std::uint64_t plies{0};
+    std::uint64_t movesChecked{0};
+    std::uint64_t failures{0};
+    std::uint64_t nonCanonical{0}; // file SAN differs from moveToSan (extra disambiguation etc.)
+};
+
+constexpr int kMaxReportedFailures = 20;
+
+void reportFailure(RoundTripStats& stats, const std::string& where, const Position& pos, const std::string& what) {
+    if (stats.failures++ < kMaxReportedFailures) {
+        std::printf("FAIL %s: %s\n     fen %s\n", where.c_str(), what.c_str(), pos.toFen().c_str());
+    }
+}
+
+// moveToSan -> sanToMove for every legal move of pos.
+void checkAllMoves(const Position& pos, const std::string& where, RoundTripStats& stats) {
+    MoveList moves;
+    pos.generateLegalMoves(moves);
+    for (const Move& m : moves) {
+        ++stats.movesChecked;
+        const std::string san = chess::moveToSan(pos, m);
+        std::string err;
+        const auto back = chess::sanToMove(pos, san, &err);
+        if (!back || !sameMove(*back, m)) {
+            reportFailure(stats, where, pos,
+                          chess::moveToUci(m) + " -> " + san + " -> " + (back ? chess::moveToUci(*back) : err));
+        }
+    }
+}
+
+// Strips the decorations moveToSan adds or files carry ("+", "#", "!?").
+std::string bareSan(std::string s) {
+    while (!s.empty() && std::strchr("+#!?", s.back())) s.pop_back();
+    return s;
+}
+
+void roundTripGame(const pgn::PgnStreamGame& game, RoundTripStats& stats) {
+    std::optional<std::string> startFen;
+    if (const auto it = game.tags.find("FEN"); it != game.tags.end()) {
+        startFen = it->second;
+    }
+
+    // The timeline is the movetext parser's view of the game: its tokens,
+    // minus numbers, comments and variations, are what we round-trip.
+    const auto timeline = chess::fenTimelineFromSanMoves(game.movetext, startFen, chess::FenTimelineMode::Lazy);
+    if (!timeline.ok) {
+        ++stats.gamesSkipped;
+        return;
+    }
+    auto start = Position::fromFen(timeline.startFen);
+    if (!start) {
+        ++stats.gamesSkipped;
+        return;
+    }
+    Position pos = *start;
+    ++stats.games;
+
+    for (const auto& ply : timeline.plies) {
+        const std::string where = "game at byte " + std::to_string(game.offsetStart) +
+                                  ", ply " + std::to_string(ply.plyIndex + 1) + " '" + ply.san + "'";
+        ++stats.plies;
+        checkAllMoves(pos, where, stats);
+
+        std::string err;
+        const auto fromSan = chess::sanToMove(pos, ply.san, &err);
+        if (!fromSan) {
+            reportFailure(stats, where, pos, "sanToMove: " + err);
+            return;
+        }
+        const auto fromUci = pos.findLegalUci(chess::moveToUci(*fromSan));
+        if (!fromUci || !sameMove(*fromUci, *fromSan)) {
+            reportFailure(stats, where, pos, "UCI " + chess::moveToUci(*fromSan) + " does not find the move");
+            return;
+        }
+        const std::string san = chess::moveToSan(pos, *fromUci);
+        if (bareSan(san) != bareSan(ply.san)) {
+            ++stats.nonCanonical;
+        }
+        const auto back = chess::sanToMove(pos, san, &err);
+        if (!back || !sameMove(*back, *fromUci)) {
+            reportFailure(stats, where, pos, "moveToSan gives '" + san + "', which does not resolve back");
+            return;
+        }
+        if (!pos.applyMove(*fromUci)) {
+            reportFailure(stats, where, pos, "applyMove failed");
+            return;
+        }
+    }
+    checkAllMoves(pos, "final position", stats);
+}
+
+void printRoundTripStats(const RoundTripStats& stats, double secs) {
+    std::printf("%llu games (%llu skipped), %llu plies, %llu moves round-tripped in %.2f s; "
+                "%llu non-canonical SAN in the file, %llu failures\n",
+                static_cast<unsigned long long>(stats.games),
+                static_cast<unsigned long long>(stats.gamesSkipped),
+                static_cast<unsigned long long>(stats.plies),
+                static_cast<unsigned long long>(stats.movesChecked), secs,
+                static_cast<unsigned long long>(stats.nonCanonical),
+                static_cast<unsigned long long>(stats.failures));
+}
+
+int runSanRoundTrip(const std::string& path, int maxGames) {
+    RoundTripStats stats;
+    const auto t0 = Clock::now();
+    const auto scan = pgn::scanPgnFile(path, [&](const pgn::PgnStreamGame& game, std::uint64_t, std::string*) {
+        roundTripGame(game, stats);
+        return true;
+    }, maxGames);
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    if (!scan.ok) {
+        std::printf("%s: %s\n", path.c_str(), scan.error.c_str());
+        return 1;
+    }
+    printRoundTripStats(stats, secs);
+    return stats.failures == 0 ? 0 : 1;
+}
+
+int runSanFuzz(int games, std::uint32_t seed) {
+    constexpr int kMaxPlies = 300;
+    RoundTripStats stats;
+    std::mt19937 rng(seed);
+    const auto& suite = perftSuite();
+
+    const auto t0 = Clock::now();
+    for (int g = 0; g < games; ++g) {
+        Position pos = *Position::fromFen(suite[static_cast<std::size_t>(g) % suite.size()].fen);
+        ++stats.games;
+        for (int ply = 0; ply < kMaxPlies; ++ply) {
+            const std::string where = "random game " + std::to_string(g) + ", ply " + std::to_string(ply + 1);
+            checkAllMoves(pos, where, stats);
+
+            MoveList moves;
+            pos.generateLegalMoves(moves);
+            if (moves.empty()) {
+                break;
+            }
+            ++stats.plies;
+            const Move& m = moves.moves[static_cast<std::size_t>(rng() % static_cast<std::uint32_t>(moves.size))];
+            pos.applyMove(m);
+        }
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    printRoundTripStats(stats, secs);
+    return stats.failures == 0 ? 0 : 1;
+}
+
+bool startsWith(const char* arg, const char* prefix, const char** value) {
+    const std::size_t n = std::strlen(prefix);
+    if (std::strncmp(arg, prefix, n) != 0) {
+        return false;
+    }
+    *value = arg + n;
+    return true;
+}
+
+int usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--deep] [--depth=N] [--fen=FEN] [--divide]\n"
+                 "       %s --san-roundtrip FILE.pgn [--max-games=N]\n"
+                 "       %s --san-fuzz=GAMES [--seed=N]\n",
+                 argv0, argv0, argv0);
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool        deep = false;
+    bool        withDivide = false;
+    int         depthCap = 0;
+    std::string fen;
+    std::string roundTripPath;
+    int         maxGames = -1;
+    int         fuzzGames = 0;
+    std::uint32_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* v = nullptr;
+        if (std::strcmp(argv[i], "--deep") == 0) {
+            deep = true;
+        } else if (std::strcmp(argv[i], "--divide") == 0) {
+            withDivide = true;
+        } else if (startsWith(argv[i], "--depth=", &v)) {
+            depthCap = std::max(1, std::atoi(v));
+        } else if (startsWith(argv[i], "--fen=", &v)) {
+            fen = v;
+        } else if (std::strcmp(argv[i], "--san-roundtrip") == 0 && i + 1 < argc) {
+            roundTripPath = argv[++i];
+        } else if (startsWith(argv[i], "--max-games=", &v)) {
+            maxGames = std::atoi(v);
+        } else if (startsWith(argv[i], "--san-fuzz=", &v)) {
+            fuzzGames = std::max(1, std::atoi(v));
+        } else if (startsWith(argv[i], "--seed=", &v)) {
+            seed = static_cast<std::uint32_t>(std::strtoul(v, nullptr, 10));
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (!roundTripPath.empty()) {
+        return runSanRoundTrip(roundTripPath, maxGames);
+    }
+    if (fuzzGames > 0) {
+        return runSanFuzz(fuzzGames, seed);
+    }
+
+    if (!fen.empty()) {
+        return runPerft("fen", fen, depthCap > 0 ? depthCap : 4, std::nullopt, withDivide) ? 0 : 1;
+    }
+
+    bool allOk = true;
+    std::uint64_t totalNodes = 0;
+    const auto t0 = Clock::now();
+    for (const auto& c : perftSuite()) {
+        int depth = deep ? static_cast<int>(c.nodes.size()) : c.quickDepth;
+        if (depthCap > 0) {
+            depth = std::min(depthCap, static_cast<int>(c.nodes.size()));
+        }
+        const std::uint64_t expected = c.nodes[static_cast<std::size_t>(depth - 1)];
+        allOk = runPerft(c.name, c.fen, depth, expected, withDivide) && allOk;
+        totalNodes += expected;
+    }
+    const double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::printf("total %llu nodes in %.3f s, %.2f Mnps: %s\n",
+                static_cast<unsigned long long>(totalNodes), secs,
+                secs > 0 ? static_cast<double>(totalNodes) / secs / 1e6 : 0.0,
+                allOk ? "all ok" : "FAILED");
+    return allOk ? 0 : 1;
+}
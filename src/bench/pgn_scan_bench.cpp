@@ -0,0 +1,155 @@
+// PGN scanning microbenchmark: SIMD block classifier vs the scalar path.
+//
+//   pgn_scan_bench [file.pgn] [repeats]
+//
+// Without a file a synthetic PGN (~64 MiB) is generated in memory. Each
+// variant splits the buffer into lines and counts games the way
+// scanPgnBuffer() does (a tag line after movetext starts a new game):
+//
+//   bytewise      memchr for '\n' + std::isspace per byte (pre-SIMD scanner)
+//   blocks-scalar BlockCursor driven by classifyBlockScalar()
+//   blocks-simd   BlockCursor driven by classifyBlock()
+//   scanPgnBuffer full scanner (tag parsing + callback) on the SIMD path
+
+#include "domain/pgn/MappedFile.hpp"
+#include "domain/pgn/PgnSimd.hpp"
+#include "domain/pgn/PgnStreamScanner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace pgn = sf::client::domain::pgn;
+namespace simd = sf::client::domain::pgn::simd;
+
+namespace {
+
+std::string makeSyntheticPgn(std::size_t targetBytes) {
+    static const char* kGame =
+        "[Event \"ICCF corr\"]\n"
+        "[Site \"ICCF\"]\n"
+        "[Date \"2019.03.14\"]\n"
+        "[White \"Player, White\"]\n"
+        "[Black \"Player, Black\"]\n"
+        "[Result \"1/2-1/2\"]\n"
+        "[WhiteElo \"2412\"]\n"
+        "[BlackElo \"2398\"]\n"
+        "\n"
+        "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be3 e5 7. Nb3 Be6\n"
+        "8. f3 Be7 9. Qd2 O-O 10. O-O-O Nbd7 11. g4 b5 12. g5 b4 13. Ne2 Ne8\n"
+        "14. f4 a5 15. f5 a4 16. Nbd4 exd4 17. Nxd4 b3 18. Kb1 bxc2+ 19. Nxc2 Bb3\n"
+        "20. axb3 axb3 21. Na3 Ne5 22. h4 Ra5 1/2-1/2\n"
+        "\n";
+    std::string out;
+    out.reserve(targetBytes + 1024);
+    while (out.size() < targetBytes) out += kGame;
+    return out;
+}
+
+template <typename Cursor>
+int countGamesBlocks(std::string_view data) {
+    Cursor cursor(data.data(), data.size());
+    int games = 0;
+    bool inGame = false;
+    bool haveMovetext = false;
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        std::size_t lineEnd = cursor.nextNewline(pos);
+        const std::size_t lineStart = pos;
+        pos = (lineEnd < data.size()) ? lineEnd + 1 : data.size();
+        if (lineEnd > lineStart && data[lineEnd - 1] == '\r') --lineEnd;
+
+        const std::size_t first = cursor.firstNonSpace(lineStart, lineEnd);
+        if (first == lineEnd) continue;
+        if (cursor.isBracket(first)) {
+            if (inGame && haveMovetext) ++games;
+            inGame = true;
+            haveMovetext = false;
+        } else if (inGame) {
+            haveMovetext = true;
+        }
+    }
+    return games + (inGame ? 1 : 0);
+}
+
+int countGamesBytewise(std::string_view data) {
+    int games = 0;
+    bool inGame = false;
+    bool haveMovetext = false;
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        const void* nl = std::memchr(data.data() + pos, '\n', data.size() - pos);
+        std::size_t lineEnd = nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - data.data())
+                                 : data.size();
+        const std::size_t lineStart = pos;
+        pos = nl ? lineEnd + 1 : data.size();
+        if (lineEnd > lineStart && data[lineEnd - 1] == '\r') --lineEnd;
+
+        std::size_t first = lineStart;
+        while (first < lineEnd && std::isspace(static_cast<unsigned char>(data[first]))) ++first;
+        if (first == lineEnd) continue;
+        if (data[first] == '[') {
+            if (inGame && haveMovetext) ++games;
+            inGame = true;
+            haveMovetext = false;
+        } else if (inGame) {
+            haveMovetext = true;
+        }
+    }
+    return games + (inGame ? 1 : 0);
+}
+
+template <typename Fn>
+void run(const char* name, std::string_view data, int repeats, Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    double best = 1e100;
+    int games = 0;
+    for (int i = 0; i < repeats; ++i) {
+        const auto t0 = Clock::now();
+        games = fn(data);
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+    const double mbps = static_cast<double>(data.size()) / (1024.0 * 1024.0) / best;
+    std::printf("%-14s %10.1f MiB/s  %8.3f s  games=%d\n", name, mbps, best, games);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    pgn::MappedFile file;
+    std::string synthetic;
+    std::string_view data;
+
+    if (argc > 1) {
+        std::string err;
+        if (!file.open(argv[1], &err)) {
+            std::fprintf(stderr, "%s: %s\n", argv[1], err.c_str());
+            return 1;
+        }
+        data = file.view();
+    } else {
+        synthetic = makeSyntheticPgn(64u << 20);
+        data = synthetic;
+    }
+    const int repeats = (argc > 2) ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::printf("kernel: %s, %zu bytes, best of %d\n", simd::kernelName(), data.size(), repeats);
+
+    run("bytewise", data, repeats, countGamesBytewise);
+    run("blocks-scalar", data, repeats, countGamesBlocks<simd::ScalarBlockCursor>);
+    run("blocks-simd", data, repeats, countGamesBlocks<simd::BlockCursor>);
+    run("scanPgnBuffer", data, repeats, [](std::string_view d) {
+        std::size_t tags = 0;
+        const auto res = pgn::scanPgnBuffer(d, [&](const pgn::PgnGameView& g, std::uint64_t, std::string*) {
+            tags += g.tags.size();
+            return true;
+        });
+        return res.games;
+    });
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Receive-path microbenchmark: replays a server byte stream through the
+// message splitter the way JobConnection::onReadyRead() sees it.
+//
+//   wire_replay_bench [capture.bin] [chunk-bytes] [repeats]
+//
+// A capture is the raw stream recorded with CORRCHESS_CAPTURE_DIR set. Without
+// one a synthetic high-rate session is generated: MultiPV 5 job_update lines
+// for a few jobs, interleaved with compact CBOR job_update frames. The stream
+// is fed in chunk-bytes pieces (default 64 KiB, one readyRead each):
+//
+//   remove-front  copy each message out and erase it from the buffer front
+//                 (pre-cursor JobConnection)
+//   framer        MessageFramer: read cursor, views, one compaction per chunk
+//   framer+parse  framer plus JSON / CBOR parsing from the views
+
+#include "net/MessageFramer.hpp"
+#include "net/WireProtocol.hpp"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace net = sf::client::net;
+namespace wire = sf::client::net::wire;
+
+namespace {
+
+QByteArray makeSyntheticSession(qsizetype targetBytes) {
+    QByteArray out;
+    out.reserve(targetBytes + 4096);
+    const QByteArray pv = QByteArrayLiteral("e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3 a7a6 c1e3 e7e5");
+    qint64 nodes = 0;
+    int depth = 20;
+    while (out.size() < targetBytes) {
+        for (int job = 0; job < 4; ++job) {
+            const QByteArray jobId = QByteArrayLiteral("job-") + QByteArray::number(job);
+            for (int mpv = 1; mpv <= 5; ++mpv) {
+                nodes += 150000;
+                out += QByteArrayLiteral("{\"type\":\"job_update\",\"job_id\":\"") + jobId +
+                       QByteArrayLiteral("\",\"status\":2,\"multipv\":") + QByteArray::number(mpv) +
+                       QByteArrayLiteral(",\"depth\":") + QByteArray::number(depth) +
+                       QByteArrayLiteral(",\"seldepth\":") + QByteArray::number(depth + 12) +
+                       QByteArrayLiteral(",\"score_cp\":") + QByteArray::number(30 - mpv * 7) +
+                       QByteArrayLiteral(",\"nodes\":") + QByteArray::number(nodes) +
+                       QByteArrayLiteral(",\"nps\":2400000,\"pv\":\"") + pv + QByteArrayLiteral("\"}\n");
+
+                QCborMap compact;
+                compact.insert(wire::kJobId, QString::fromLatin1(jobId));
+                compact.insert(wire::kJobStatus, 2);
+                compact.insert(wire::kJobPresent, 0x7F);
+                compact.insert(wire::kJobMultipv, mpv);
+                compact.insert(wire::kJobNodes, nodes);
+                out += wire::encodeFrame(wire::FrameKind::JobUpdate, compact.toCborValue().toCbor());
+            }
+        }
+        ++depth;
+    }
+    return out;
+}
+
+struct Counts {
+    qint64 messages{0};
+    qint64 parsed{0};
+};
+
+// The splitter JobConnection used before the read cursor.
+Counts replayRemoveFront(const QByteArray& stream, qsizetype chunk) {
+    Counts c;
+    QByteArray buffer;
+    for (qsizetype off = 0; off < stream.size(); off += chunk) {
+        buffer.append(stream.constData() + off, std::min(chunk, stream.size() - off));
+        while (!buffer.isEmpty()) {
+            if (buffer.at(0) == wire::kFrameMarker) {
+                if (buffer.size() < wire::kFrameHeaderSize) break;
+                const auto len = qFromBigEndian<quint32>(buffer.constData() + 2);
+                const qsizetype total = wire::kFrameHeaderSize + static_cast<qsizetype>(len);
+                if (buffer.size() < total) break;
+                const QByteArray payload = buffer.mid(wire::kFrameHeaderSize, len);
+                buffer.remove(0, total);
+                ++c.messages;
+                continue;
+            }
+            const qsizetype nl = buffer.indexOf('\n');
+            if (nl < 0) break;
+            const QByteArray line = buffer.left(nl);
+            buffer.remove(0, nl + 1);
+            if (!line.trimmed().isEmpty()) ++c.messages;
+        }
+    }
+    return c;
+}
+
+template <bool Parse>
+Counts replayFramer(const QByteArray& stream, qsizetype chunk) {
+    Counts c;
+    net::MessageFramer framer;
+    for (qsizetype off = 0; off < stream.size(); off += chunk) {
+        framer.append(QByteArray::fromRawData(stream.constData() + off, std::min(chunk, stream.size() - off)));
+        framer.drain([&](const net::MessageFramer::Item& item) {
+            ++c.messages;
+            if constexpr (Parse) {
+                if (item.type == net::MessageFramer::ItemType::Frame) {
+                    c.parsed += QCborValue::fromCbor(item.bytes.data(), item.bytes.size()).isMap() ? 1 : 0;
+                } else {
+                    const auto doc = QJsonDocument::fromJson(
+                        QByteArray::fromRawData(item.bytes.data(), item.bytes.size()));
+                    c.parsed += doc.isObject() ? 1 : 0;
+                }
+            }
+        });
+    }
+    return c;
+}
+
+template <typename Fn>
+void run(const char* name, const QByteArray& stream, qsizetype chunk, int repeats, Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    double best = 1e100;
+    Counts c;
+    for (int i = 0; i < repeats; ++i) {
+        const auto t0 = Clock::now();
+        c = fn(stream, chunk);
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+    const double mbps = static_cast<double>(stream.size()) / (1024.0 * 1024.0) / best;
+    const double mps = static_cast<double>(c.messages) / best / 1e6;
+    std::printf("%-14s %9.1f MiB/s  %7.2f Mmsg/s  %8.3f s  msgs=%lld parsed=%lld\n",
+                name, mbps, mps, best,
+                static_cast<long long>(c.messages), static_cast<long long>(c.parsed));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QByteArray stream;
+    if (argc > 1 && argv[1][0] != '\0') {
+        QFile f(QString::fromLocal8Bit(argv[1]));
+        if (!f.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "%s: %s\n", argv[1], qPrintable(f.errorString()));
+            return 1;
+        }
+        stream = f.readAll();
+    } else {
+        stream = makeSyntheticSession(32 << 20);
+    }
+    const qsizetype chunk = (argc > 2) ? std::max(1, std::atoi(argv[2])) : (64 << 10);
+    const int repeats = (argc > 3) ? std::max(1, std::atoi(argv[3])) : 5;
+
+    std::printf("%lld bytes, %lld-byte reads, best of %d\n",
+                static_cast<long long>(stream.size()), static_cast<long long>(chunk), repeats);
+
+    run("remove-front", stream, chunk, repeats, replayRemoveFront);
+    run("framer", stream, chunk, repeats, replayFramer<false>);
+    run("framer+parse", stream, chunk, repeats, replayFramer<true>);
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "domain/chess/Bitboard.hpp"
+
+#include <array>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace sf::client::domain::chess {
+
+namespace {
+
+// ---- Magic lookup ----
+
+struct Magic {
+    Bitboard mask{0};
+    Bitboard magic{0};
+    Bitboard* attacks{nullptr};
+    unsigned shift{0};
+
+    unsigned index(Bitboard occupied) const {
+#if defined(__BMI2__)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// xorshift64* generator; only used to search magics deterministically.
+class MagicRng {
+public:
+    explicit MagicRng(std::uint64_t seed) : s_(seed) {}
+
+    std::uint64_t next() {
+        s_ ^= s_ >> 12;
+        s_ ^= s_ << 25;
+        s_ ^= s_ >> 27;
+        return s_ * 2685821657736338717ull;
+    }
+
+    // Few bits set: candidates like this are found much faster.
+    std::uint64_t sparse() { return next() & next() & next(); }
+
+private:
+    std::uint64_t s_;
+};
+
+Bitboard slidingAttack(const int (&dirs)[4][2], int sq, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (const auto& d : dirs) {
+        int f = fileOf(sq) + d[0];
+        int r = rankOf(sq) + d[1];
+        while (onBoard(f, r)) {
+            const Bitboard b = squareBb(sqOf(f, r));
+            attacks |= b;
+            if (occupied & b) break;
+            f += d[0];
+            r += d[1];
+        }
+    }
+    return attacks;
+}
+
+constexpr int kRookDirs[4][2]   = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+constexpr int kBishopDirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+Bitboard stepAttacks(int sq, const int (*steps)[2], int count) {
+    Bitboard b = 0;
+    for (int i = 0; i < count; ++i) {
+        const int f = fileOf(sq) + steps[i][0];
+        const int r = rankOf(sq) + steps[i][1];
+        if (onBoard(f, r)) b |= squareBb(sqOf(f, r));
+    }
+    return b;
+}
+
+struct AttackTables {
+    std::array<std::array<Bitboard, 64>, kColorCount> pawn{};
+    std::array<Bitboard, 64> knight{};
+    std::array<Bitboard, 64> king{};
+
+    std::array<Magic, 64> rookMagics{};
+    std::array<Magic, 64> bishopMagics{};
+    std::vector<Bitboard> rookTable;   // 0x19000 entries
+    std::vector<Bitboard> bishopTable; // 0x1480 entries
+
+    AttackTables()
+        : rookTable(0x19000, 0)
+        , bishopTable(0x1480, 0) {
+        static const int kKnight[8][2] = {
+            {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+        };
+        static const int kKing[8][2] = {
+            {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}
+        };
+        static const int kWhitePawn[2][2] = {{-1, 1}, {1, 1}};
+        static const int kBlackPawn[2][2] = {{-1, -1}, {1, -1}};
+
+        for (int sq = 0; sq < 64; ++sq) {
+            knight[sq] = stepAttacks(sq, kKnight, 8);
+            king[sq] = stepAttacks(sq, kKing, 8);
+            pawn[index(Color::White)][sq] = stepAttacks(sq, kWhitePawn, 2);
+            pawn[index(Color::Black)][sq] = stepAttacks(sq, kBlackPawn, 2);
+        }
+
+        initMagics(kRookDirs, rookTable.data(), rookMagics);
+        initMagics(kBishopDirs, bishopTable.data(), bishopMagics);
+    }
+
+    // Fancy magic bitboards: every square gets its own slice of the shared
+    // table, sized 2^(relevant occupancy bits). With BMI2 the PEXT index is
+    // a perfect hash and no magic search is needed.
+    static void initMagics(const int (&dirs)[4][2], Bitboard* table, std::array<Magic, 64>& magics) {
+        // Per-rank seeds that are known to find magics quickly.
+        static const std::uint64_t kSeeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+        std::vector<Bitboard> occupancy(4096);
+        std::vector<Bitboard> reference(4096);
+        std::vector<int> epoch(4096, 0);
+        int attempt = 0;
+        int size = 0;
+
+        for (int sq = 0; sq < 64; ++sq) {
+            const Bitboard edges = ((kRank1 | kRank8) & ~rankBb(rankOf(sq)))
+                                 | ((kFileA | kFileH) & ~fileBb(fileOf(sq)));
+
+            Magic& m = magics[sq];
+            m.mask = slidingAttack(dirs, sq, 0) & ~edges;
+            m.shift = static_cast<unsigned>(64 - popCount(m.mask));
+            m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + size;
+
+            // Carry-Rippler enumeration of all subsets of the mask.
+            Bitboard b = 0;
+            size = 0;
+            do {
+                occupancy[size] = b;
+                reference[size] = slidingAttack(dirs, sq, b);
+#if defined(__BMI2__)
+                m.attacks[m.index(b)] = reference[size];
+#endif
+                ++size;
+                b = (b - m.mask) & m.mask;
+            } while (b);
+
+#if !defined(__BMI2__)
+            MagicRng rng(kSeeds[rankOf(sq)]);
+            for (int i = 0; i < size;) {
+                for (m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6;) {
+                    m.magic = rng.sparse();
+                }
+                // Verify the candidate maps every occupancy to a slot that is
+                // empty (this attempt) or already holds the same attack set.
+                for (++attempt, i = 0; i < size; ++i) {
+                    const unsigned idx = m.index(occupancy[i]);
+                    if (epoch[idx] < attempt) {
+                        epoch[idx] = attempt;
+                        m.attacks[idx] = reference[i];
+                    } else if (m.attacks[idx] != reference[i]) {
+                        break;
+                    }
+                }
+            }
+#else
+            (void)kSeeds;
+            (void)attempt;
+            (void)epoch;
+#endif
+        }
+    }
+};
+
+const AttackTables& tables() {
+    static const AttackTables t;
+    return t;
+}
+
+} // namespace
+
+Bitboard pawnAttacks(Color c, int sq) {
+    return tables().pawn[index(c)][sq];
+}
+
+Bitboard knightAttacks(int sq) {
+    return tables().knight[sq];
+}
+
+Bitboard kingAttacks(int sq) {
+    return tables().king[sq];
+}
+
+Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = tables().bishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = tables().rookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+} // namespace sf::client::domain::chess
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "domain/chess/ChessTypes.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace sf::client::domain::chess {
+
+// One bit per square, bit index = square index (a1 = bit 0).
+using Bitboard = std::uint64_t;
+
+inline constexpr Bitboard kFileA = 0x0101010101010101ull;
+inline constexpr Bitboard kFileH = kFileA << 7;
+inline constexpr Bitboard kRank1 = 0xFFull;
+inline constexpr Bitboard kRank8 = kRank1 << 56;
+
+inline constexpr Bitboard squareBb(int sq) { return Bitboard{1} << sq; }
+inline constexpr Bitboard fileBb(int f) { return kFileA << f; }
+inline constexpr Bitboard rankBb(int r) { return kRank1 << (8 * r); }
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit. b must be non-zero.
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, b);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// Returns and clears the least significant set bit. b must be non-zero.
+inline int popLsb(Bitboard& b) {
+    const int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// ---- Attack tables (built once on first use, thread-safe) ----
+// Slider lookups use PEXT when compiled with BMI2, fancy magics otherwise.
+
+Bitboard pawnAttacks(Color c, int sq);
+Bitboard knightAttacks(int sq);
+Bitboard kingAttacks(int sq);
+Bitboard bishopAttacks(int sq, Bitboard occupied);
+Bitboard rookAttacks(int sq, Bitboard occupied);
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+} // namespace sf::client::domain::chess
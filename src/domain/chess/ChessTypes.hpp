@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sf::client::domain::chess {
+
+// ------------------------------- Pieces -------------------------------------
+
+enum class Color : std::uint8_t { White, Black };
+
+enum class PieceType : std::uint8_t { Pawn, Knight, Bishop, Rook, Queen, King };
+
+// Order matters: Piece = 1 + color * 6 + type (see makePiece()).
+enum class Piece : std::uint8_t {
+    Empty,
+    WP, WN, WB, WR, WQ, WK,
+    BP, BN, BB, BR, BQ, BK
+};
+
+inline constexpr int kColorCount = 2;
+inline constexpr int kPieceTypeCount = 6;
+
+inline constexpr Color opposite(Color c) {
+    return (c == Color::White) ? Color::Black : Color::White;
+}
+
+inline constexpr int index(Color c) { return static_cast<int>(c); }
+inline constexpr int index(PieceType t) { return static_cast<int>(t); }
+
+inline constexpr Piece makePiece(Color c, PieceType t) {
+    return static_cast<Piece>(1 + index(c) * kPieceTypeCount + index(t));
+}
+
+inline constexpr bool isEmpty(Piece p) { return p == Piece::Empty; }
+
+// Only meaningful for non-empty pieces.
+inline constexpr Color colorOf(Piece p) {
+    return (static_cast<int>(p) >= static_cast<int>(Piece::BP)) ? Color::Black : Color::White;
+}
+
+// Only meaningful for non-empty pieces.
+inline constexpr PieceType typeOf(Piece p) {
+    return static_cast<PieceType>((static_cast<int>(p) - 1) % kPieceTypeCount);
+}
+
+inline char pieceToFenChar(Piece p) {
+    static constexpr char kChars[] = " PNBRQKpnbrqk";
+    return isEmpty(p) ? 0 : kChars[static_cast<int>(p)];
+}
+
+inline std::optional<Piece> fenCharToPiece(char c) {
+    switch (c) {
+        case 'P': return Piece::WP;
+        case 'N': return Piece::WN;
+        case 'B': return Piece::WB;
+        case 'R': return Piece::WR;
+        case 'Q': return Piece::WQ;
+        case 'K': return Piece::WK;
+        case 'p': return Piece::BP;
+        case 'n': return Piece::BN;
+        case 'b': return Piece::BB;
+        case 'r': return Piece::BR;
+        case 'q': return Piece::BQ;
+        case 'k': return Piece::BK;
+        default: return std::nullopt;
+    }
+}
+
+// ------------------------------- Squares ------------------------------------
+// Square index = rank * 8 + file, a1 = 0, h8 = 63.
+
+inline constexpr int fileOf(int sq) { return sq & 7; }
+inline constexpr int rankOf(int sq) { return sq >> 3; }
+inline constexpr bool onBoard(int f, int r) { return f >= 0 && f < 8 && r >= 0 && r < 8; }
+inline constexpr int sqOf(int f, int r) { return (r << 3) | f; }
+
+inline constexpr char fileChar(int f) { return static_cast<char>('a' + f); }
+inline constexpr char rankChar(int r) { return static_cast<char>('1' + r); }
+
+inline std::string sqToAlg(int sq) {
+    std::string s;
+    s.push_back(fileChar(fileOf(sq)));
+    s.push_back(rankChar(rankOf(sq)));
+    return s;
+}
+
+inline std::optional<int> algToSq(std::string_view sv) {
+    if (sv.size() != 2) return std::nullopt;
+    const char f = sv[0];
+    const char r = sv[1];
+    if (f < 'a' || f > 'h') return std::nullopt;
+    if (r < '1' || r > '8') return std::nullopt;
+    return sqOf(f - 'a', r - '1');
+}
+
+// ------------------------------ Castling ------------------------------------
+
+enum CastlingRight : std::uint8_t {
+    NoCastling    = 0,
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+    AllCastling   = 15
+};
+
+// -------------------------------- Moves -------------------------------------
+
+struct Move {
+    int from{-1};
+    int to{-1};
+    Piece promotion{Piece::Empty};
+    bool isCapture{false};
+    bool isEnPassant{false};
+    bool isCastleKing{false};
+    bool isCastleQueen{false};
+};
+
+inline std::string moveToUci(const Move& m) {
+    std::string s;
+    s.reserve(5);
+    s += sqToAlg(m.from);
+    s += sqToAlg(m.to);
+    if (!isEmpty(m.promotion)) {
+        static constexpr char kPromo[] = "pnbrqk";
+        s.push_back(kPromo[index(typeOf(m.promotion))]);
+    }
+    return s;
+}
+
+} // namespace sf::client::domain::chess
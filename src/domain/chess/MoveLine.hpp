@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+#include "domain/chess/PackedMove.hpp"
+
+namespace sf::client::domain::chess {
+
+// A move sequence (engine PV) as packed 16-bit moves.
+//
+// Up to kInlineCapacity moves live inside the object (32 bytes in all,
+// the size of a std::string whose small buffer holds three UCI moves);
+// longer lines spill to the heap. Text only appears at the edges: fromUci()
+// when a PV arrives from the wire or history, toUci() when it is shown or
+// sent on. Comparing two lines is a memcmp, hash() a pass over 2 bytes a
+// move, so unchanged PVs and transpositions are cheap to spot.
+class MoveLine {
+public:
+    static constexpr std::size_t kInlineCapacity = 12;
+    static constexpr std::size_t kMaxSize        = 0xFFFF;
+
+    MoveLine() noexcept {}
+
+    MoveLine(std::initializer_list<PackedMove> moves) {
+        assign(moves.begin(), moves.size());
+    }
+
+    MoveLine(const MoveLine& other) {
+        assign(other.data(), other.size());
+    }
+
+    MoveLine(MoveLine&& other) noexcept {
+        steal(other);
+    }
+
+    MoveLine& operator=(const MoveLine& other) {
+        if (this != &other) {
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    MoveLine& operator=(MoveLine&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~MoveLine() { release(); }
+
+    // Space-separated UCI moves ("e2e4 e7e5 g1f3"). Parsing stops at the
+    // first token that is not a UCI move; the moves before it are kept.
+    static MoveLine fromUci(std::string_view text) {
+        MoveLine line;
+        std::size_t i = 0;
+        while (i < text.size()) {
+            while (i < text.size() && isSpace(text[i])) ++i;
+            std::size_t end = i;
+            while (end < text.size() && !isSpace(text[end])) ++end;
+            if (end == i) break;
+            const auto move = packUci(text.substr(i, end - i));
+            if (!move || line.size_ == kMaxSize) break;
+            line.push_back(*move);
+            i = end;
+        }
+        return line;
+    }
+
+    std::string toUci() const {
+        std::string out;
+        out.reserve(size_ * 5);
+        for (const PackedMove m : *this) {
+            if (!out.empty()) out.push_back(' ');
+            out += packedToUci(m);
+        }
+        return out;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    // Heap block of a spilled line; 0 while the moves fit inline.
+    std::size_t heapBytes() const noexcept { return isInline() ? 0 : std::size_t{cap_} * sizeof(PackedMove); }
+
+    const PackedMove* data() const noexcept { return isInline() ? inline_ : heap_; }
+    const PackedMove* begin() const noexcept { return data(); }
+    const PackedMove* end() const noexcept { return data() + size_; }
+
+    PackedMove operator[](std::size_t i) const noexcept { return data()[i]; }
+    PackedMove front() const noexcept { return data()[0]; }
+
+    void push_back(PackedMove m) {
+        if (size_ == cap_) {
+            if (size_ == kMaxSize) return;
+            reserve(std::min<std::size_t>(kMaxSize, std::size_t{cap_} * 2));
+        }
+        mutableData()[size_++] = m;
+    }
+
+    void clear() noexcept { size_ = 0; }
+
+    void reserve(std::size_t n) {
+        n = std::min(n, kMaxSize);
+        if (n <= cap_) return;
+        auto* moves = new PackedMove[n];
+        if (size_ > 0) {
+            std::memcpy(moves, data(), size_ * sizeof(PackedMove));
+        }
+        if (!isInline()) {
+            delete[] heap_;
+        }
+        heap_ = moves;
+        cap_  = static_cast<std::uint16_t>(n);
+    }
+
+    bool startsWith(const MoveLine& prefix) const noexcept {
+        return prefix.size_ <= size_
+            && std::memcmp(data(), prefix.data(), prefix.size_ * sizeof(PackedMove)) == 0;
+    }
+
+    // FNV-1a over the moves; equal lines hash equal.
+    std::uint64_t hash() const noexcept {
+        std::uint64_t h = 14695981039346656037ull;
+        for (const PackedMove m : *this) {
+            h = (h ^ (m & 0xFF)) * 1099511628211ull;
+            h = (h ^ (m >> 8)) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    friend bool operator==(const MoveLine& a, const MoveLine& b) noexcept {
+        return a.size_ == b.size_
+            && std::memcmp(a.data(), b.data(), a.size_ * sizeof(PackedMove)) == 0;
+    }
+    friend bool operator!=(const MoveLine& a, const MoveLine& b) noexcept { return !(a == b); }
+
+private:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    bool isInline() const noexcept { return cap_ <= kInlineCapacity; }
+    PackedMove* mutableData() noexcept { return isInline() ? inline_ : heap_; }
+
+    void assign(const PackedMove* moves, std::size_t n) {
+        n = std::min(n, kMaxSize);
+        size_ = 0;
+        reserve(n);
+        if (n > 0) {
+            std::memcpy(mutableData(), moves, n * sizeof(PackedMove));
+        }
+        size_ = static_cast<std::uint16_t>(n);
+    }
+
+    void steal(MoveLine& other) noexcept {
+        if (other.isInline()) {
+            std::memcpy(inline_, other.inline_, other.size_ * sizeof(PackedMove));
+            cap_ = static_cast<std::uint16_t>(kInlineCapacity);
+        } else {
+            heap_ = other.heap_;
+            cap_  = other.cap_;
+        }
+        size_       = other.size_;
+        other.cap_  = static_cast<std::uint16_t>(kInlineCapacity);
+        other.size_ = 0;
+    }
+
+    void release() noexcept {
+        if (!isInline()) {
+            delete[] heap_;
+        }
+        cap_  = static_cast<std::uint16_t>(kInlineCapacity);
+        size_ = 0;
+    }
+
+    union {
+        PackedMove  inline_[kInlineCapacity];
+        PackedMove* heap_;
+    };
+    std::uint16_t size_{0};
+    std::uint16_t cap_{static_cast<std::uint16_t>(kInlineCapacity)};
+};
+
+} // namespace sf::client::domain::chess
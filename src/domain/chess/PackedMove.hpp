@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "domain/chess/ChessTypes.hpp"
+
+namespace sf::client::domain::chess {
+
+// 16-bit move encoding used by on-disk formats and compact move lines:
+//
+//   bits  0..5   from square
+//   bits  6..11  to square
+//   bits 12..14  promotion: 0 none, 1 knight, 2 bishop, 3 rook, 4 queen
+//
+// Castling is stored as the king's two-square move (e1g1), as in UCI.
+// It carries no capture/ep flags; those follow from the position.
+using PackedMove = std::uint16_t;
+
+inline constexpr PackedMove kNullPackedMove = 0; // a1a1, never a legal move
+
+inline constexpr int packedFrom(PackedMove m) { return m & 0x3F; }
+inline constexpr int packedTo(PackedMove m) { return (m >> 6) & 0x3F; }
+inline constexpr int packedPromo(PackedMove m) { return (m >> 12) & 0x7; }
+
+inline PackedMove packMove(const Move& m) {
+    int promo = 0;
+    if (!isEmpty(m.promotion)) {
+        switch (typeOf(m.promotion)) {
+            case PieceType::Knight: promo = 1; break;
+            case PieceType::Bishop: promo = 2; break;
+            case PieceType::Rook:   promo = 3; break;
+            case PieceType::Queen:  promo = 4; break;
+            default: break;
+        }
+    }
+    return static_cast<PackedMove>((m.from & 0x3F) | ((m.to & 0x3F) << 6) | (promo << 12));
+}
+
+inline std::optional<PackedMove> packUci(std::string_view uci) {
+    if (uci.size() != 4 && uci.size() != 5) return std::nullopt;
+    const auto from = algToSq(uci.substr(0, 2));
+    const auto to = algToSq(uci.substr(2, 2));
+    if (!from || !to) return std::nullopt;
+
+    int promo = 0;
+    if (uci.size() == 5) {
+        switch (uci[4]) {
+            case 'n': promo = 1; break;
+            case 'b': promo = 2; break;
+            case 'r': promo = 3; break;
+            case 'q': promo = 4; break;
+            default: return std::nullopt;
+        }
+    }
+    return static_cast<PackedMove>(*from | (*to << 6) | (promo << 12));
+}
+
+inline std::string packedToUci(PackedMove m) {
+    std::string s = sqToAlg(packedFrom(m)) + sqToAlg(packedTo(m));
+    static constexpr char kPromo[] = " nbrq";
+    const int promo = packedPromo(m);
+    if (promo >= 1 && promo <= 4) s.push_back(kPromo[promo]);
+    return s;
+}
+
+} // namespace sf::client::domain::chess
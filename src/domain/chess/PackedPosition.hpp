@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace sf::client::domain::chess {
+
+// Compact, trivially copyable position snapshot (40 bytes).
+// Used where many positions are kept around but only a few are ever turned
+// back into FEN (see FenTimelineMode::Lazy).
+struct PackedPosition {
+    std::array<std::uint8_t, 32> squares{}; // Piece per square, 4 bits each (low nibble = even square)
+    std::uint8_t sideToMove{0};             // 0 = white, 1 = black
+    std::uint8_t castling{0};               // CastlingRight bit set
+    std::int8_t epSquare{-1};
+    std::uint8_t reserved{0};
+    std::uint16_t halfmove{0};
+    std::uint16_t fullmove{1};
+};
+
+static_assert(sizeof(PackedPosition) == 40, "PackedPosition layout changed");
+
+} // namespace sf::client::domain::chess
@@ -0,0 +1,573 @@
+#include "domain/chess/Position.hpp"
+
+#include "domain/chess/Zobrist.hpp"
+
+#include <cctype>
+#include <sstream>
+
+namespace sf::client::domain::chess {
+
+namespace {
+
+constexpr CastlingRight kingSideRight(Color c) {
+    return (c == Color::White) ? WhiteKingSide : BlackKingSide;
+}
+
+constexpr CastlingRight queenSideRight(Color c) {
+    return (c == Color::White) ? WhiteQueenSide : BlackQueenSide;
+}
+
+constexpr int homeRank(Color c) {
+    return (c == Color::White) ? 0 : 7;
+}
+
+// Castling right lost when a rook leaves / is captured on this corner.
+constexpr std::uint8_t cornerRight(int sq) {
+    switch (sq) {
+        case sqOf(0, 0): return WhiteQueenSide;
+        case sqOf(7, 0): return WhiteKingSide;
+        case sqOf(0, 7): return BlackQueenSide;
+        case sqOf(7, 7): return BlackKingSide;
+        default: return NoCastling;
+    }
+}
+
+// Square of the pawn removed by an en-passant capture landing on `to`.
+constexpr int epCaptureSquare(Color mover, int to) {
+    return (mover == Color::White) ? (to - 8) : (to + 8);
+}
+
+} // namespace
+
+// ---- Construction / FEN ----
+
+Position Position::startpos() {
+    static const Position start = *fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    return start;
+}
+
+std::optional<Position> Position::fromFen(const std::string& fen) {
+    std::istringstream in(fen);
+    std::string placement, active, castling, ep;
+    int half = 0, full = 1;
+    if (!(in >> placement >> active >> castling >> ep >> half >> full)) {
+        return std::nullopt;
+    }
+
+    Position p;
+    p.board_.fill(Piece::Empty);
+
+    int r = 7;
+    int f = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            --r;
+            f = 0;
+            continue;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            f += (c - '0');
+            continue;
+        }
+        auto pc = fenCharToPiece(c);
+        if (!pc) return std::nullopt;
+        if (!onBoard(f, r)) return std::nullopt;
+        p.putPiece(sqOf(f, r), *pc);
+        ++f;
+    }
+
+    if (active == "w") p.stm_ = Color::White;
+    else if (active == "b") p.stm_ = Color::Black;
+    else return std::nullopt;
+
+    p.castling_ = NoCastling;
+    if (castling != "-") {
+        for (char c : castling) {
+            if (c == 'K') p.castling_ |= WhiteKingSide;
+            else if (c == 'Q') p.castling_ |= WhiteQueenSide;
+            else if (c == 'k') p.castling_ |= BlackKingSide;
+            else if (c == 'q') p.castling_ |= BlackQueenSide;
+            else return std::nullopt;
+        }
+    }
+
+    if (ep == "-") {
+        p.epSquare_ = -1;
+    } else {
+        auto sq = algToSq(ep);
+        if (!sq) return std::nullopt;
+        p.epSquare_ = *sq;
+    }
+
+    p.halfmove_ = half;
+    p.fullmove_ = full;
+    p.key_ = p.computeKey();
+    return p;
+}
+
+std::string Position::toFen() const {
+    std::string out;
+    out.reserve(90);
+    for (int r = 7; r >= 0; --r) {
+        int emptyRun = 0;
+        for (int f = 0; f < 8; ++f) {
+            const Piece p = pieceAt(sqOf(f, r));
+            if (isEmpty(p)) {
+                ++emptyRun;
+            } else {
+                if (emptyRun > 0) {
+                    out.push_back(static_cast<char>('0' + emptyRun));
+                    emptyRun = 0;
+                }
+                out.push_back(pieceToFenChar(p));
+            }
+        }
+        if (emptyRun > 0) {
+            out.push_back(static_cast<char>('0' + emptyRun));
+        }
+        if (r != 0) out.push_back('/');
+    }
+
+    out.push_back(' ');
+    out.push_back((stm_ == Color::White) ? 'w' : 'b');
+    out.push_back(' ');
+
+    if (castling_ == NoCastling) {
+        out.push_back('-');
+    } else {
+        if (castling_ & WhiteKingSide) out.push_back('K');
+        if (castling_ & WhiteQueenSide) out.push_back('Q');
+        if (castling_ & BlackKingSide) out.push_back('k');
+        if (castling_ & BlackQueenSide) out.push_back('q');
+    }
+
+    out.push_back(' ');
+    out += (epSquare_ >= 0) ? sqToAlg(epSquare_) : std::string("-");
+    out.push_back(' ');
+    out += std::to_string(halfmove_);
+    out.push_back(' ');
+    out += std::to_string(fullmove_);
+    return out;
+}
+
+PackedPosition Position::pack() const {
+    PackedPosition out;
+    for (int sq = 0; sq < 64; ++sq) {
+        const auto v = static_cast<std::uint8_t>(pieceAt(sq));
+        out.squares[static_cast<std::size_t>(sq >> 1)] |= static_cast<std::uint8_t>((sq & 1) ? (v << 4) : v);
+    }
+    out.sideToMove = static_cast<std::uint8_t>(index(stm_));
+    out.castling = castling_;
+    out.epSquare = static_cast<std::int8_t>(epSquare_);
+    out.halfmove = static_cast<std::uint16_t>(halfmove_);
+    out.fullmove = static_cast<std::uint16_t>(fullmove_);
+    return out;
+}
+
+Position Position::unpack(const PackedPosition& packed) {
+    Position p;
+    p.board_.fill(Piece::Empty);
+    for (int sq = 0; sq < 64; ++sq) {
+        const std::uint8_t byte = packed.squares[static_cast<std::size_t>(sq >> 1)];
+        const auto v = static_cast<std::uint8_t>((sq & 1) ? (byte >> 4) : (byte & 0x0F));
+        if (v != 0) p.putPiece(sq, static_cast<Piece>(v));
+    }
+    p.stm_ = packed.sideToMove ? Color::Black : Color::White;
+    p.castling_ = packed.castling;
+    p.epSquare_ = packed.epSquare;
+    p.halfmove_ = packed.halfmove;
+    p.fullmove_ = packed.fullmove;
+    p.key_ = p.computeKey();
+    return p;
+}
+
+std::uint64_t Position::computeKey() const {
+    std::uint64_t k = 0;
+    for (Bitboard b = occupied(); b;) {
+        const int sq = popLsb(b);
+        k ^= zobrist::piece(pieceAt(sq), sq);
+    }
+    k ^= zobrist::castling(castling_);
+    if (epSquare_ >= 0) k ^= zobrist::epFile(fileOf(epSquare_));
+    if (stm_ == Color::Black) k ^= zobrist::sideToMove();
+    return k;
+}
+
+// ---- Board mutation helpers (keep bitboards, mailbox and key in sync) ----
+
+void Position::putPiece(int sq, Piece p) {
+    const Bitboard b = squareBb(sq);
+    board_[static_cast<std::size_t>(sq)] = p;
+    byType_[index(typeOf(p))] |= b;
+    byColor_[index(colorOf(p))] |= b;
+    key_ ^= zobrist::piece(p, sq);
+}
+
+void Position::removePiece(int sq) {
+    const Piece p = board_[static_cast<std::size_t>(sq)];
+    const Bitboard b = squareBb(sq);
+    byType_[index(typeOf(p))] &= ~b;
+    byColor_[index(colorOf(p))] &= ~b;
+    board_[static_cast<std::size_t>(sq)] = Piece::Empty;
+    key_ ^= zobrist::piece(p, sq);
+}
+
+void Position::movePiece(int from, int to) {
+    const Piece p = board_[static_cast<std::size_t>(from)];
+    const Bitboard fromTo = squareBb(from) | squareBb(to);
+    byType_[index(typeOf(p))] ^= fromTo;
+    byColor_[index(colorOf(p))] ^= fromTo;
+    board_[static_cast<std::size_t>(from)] = Piece::Empty;
+    board_[static_cast<std::size_t>(to)] = p;
+    key_ ^= zobrist::piece(p, from) ^ zobrist::piece(p, to);
+}
+
+// ---- Attacks / legality ----
+
+int Position::kingSquare(Color c) const {
+    const Bitboard k = pieces(c, PieceType::King);
+    return k ? lsb(k) : -1;
+}
+
+Bitboard Position::attackersTo(int sq, Color by, Bitboard occupied) const {
+    const Bitboard diag = pieces(by, PieceType::Bishop) | pieces(by, PieceType::Queen);
+    const Bitboard orth = pieces(by, PieceType::Rook) | pieces(by, PieceType::Queen);
+    return (pawnAttacks(opposite(by), sq) & pieces(by, PieceType::Pawn))
+         | (knightAttacks(sq) & pieces(by, PieceType::Knight))
+         | (kingAttacks(sq) & pieces(by, PieceType::King))
+         | (bishopAttacks(sq, occupied) & diag)
+         | (rookAttacks(sq, occupied) & orth);
+}
+
+bool Position::squareAttackedBy(int sq, Color by) const {
+    return attackersTo(sq, by, occupied()) != 0;
+}
+
+bool Position::inCheck(Color c) const {
+    const int ks = kingSquare(c);
+    if (ks < 0) return true; // invalid position treated as "in check"
+    return squareAttackedBy(ks, opposite(c));
+}
+
+bool Position::castlePathLegal(Color mover, bool kingSide) const {
+    // Attacks are checked in the *current* position (before the move).
+    const int rank = homeRank(mover);
+    if (inCheck(mover)) return false;
+    const Color them = opposite(mover);
+    if (kingSide) {
+        // e1->f1->g1 or e8->f8->g8
+        if (squareAttackedBy(sqOf(5, rank), them)) return false;
+        if (squareAttackedBy(sqOf(6, rank), them)) return false;
+    } else {
+        // e1->d1->c1 or e8->d8->c8
+        if (squareAttackedBy(sqOf(3, rank), them)) return false;
+        if (squareAttackedBy(sqOf(2, rank), them)) return false;
+    }
+    return true;
+}
+
+bool Position::isLegal(const Move& m) const {
+    const Color us = stm_;
+    const Color them = opposite(us);
+
+    if (m.isCastleKing || m.isCastleQueen) {
+        return castlePathLegal(us, m.isCastleKing);
+    }
+
+    const int ks = kingSquare(us);
+    if (ks < 0) return false;
+
+    // Occupancy and enemy set as they would be after the move; attacks on
+    // our king are then recomputed against that board without making it.
+    const int capSq = m.isEnPassant ? epCaptureSquare(us, m.to) : m.to;
+    const Bitboard occ = (occupied() & ~squareBb(m.from) & ~squareBb(capSq)) | squareBb(m.to);
+    const Bitboard theirs = pieces(them) & ~squareBb(capSq);
+
+    const int kingAt = (pieceAt(m.from) == makePiece(us, PieceType::King)) ? m.to : ks;
+
+    const Bitboard diag = (pieces(PieceType::Bishop) | pieces(PieceType::Queen)) & theirs;
+    const Bitboard orth = (pieces(PieceType::Rook) | pieces(PieceType::Queen)) & theirs;
+
+    if (pawnAttacks(us, kingAt) & pieces(PieceType::Pawn) & theirs) return false;
+    if (knightAttacks(kingAt) & pieces(PieceType::Knight) & theirs) return false;
+    if (kingAttacks(kingAt) & pieces(PieceType::King) & theirs) return false;
+    if (bishopAttacks(kingAt, occ) & diag) return false;
+    if (rookAttacks(kingAt, occ) & orth) return false;
+    return true;
+}
+
+// ---- Move generation ----
+
+void Position::addPawnMoves(MoveList& out, int from, int to, bool capture, bool ep) const {
+    Move m;
+    m.from = from;
+    m.to = to;
+    m.isCapture = capture;
+    m.isEnPassant = ep;
+
+    const int promoRank = (stm_ == Color::White) ? 7 : 0;
+    if (rankOf(to) != promoRank) {
+        out.push(m);
+        return;
+    }
+    for (PieceType t : {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight}) {
+        m.promotion = makePiece(stm_, t);
+        out.push(m);
+    }
+}
+
+std::optional<Move> Position::castleMove(bool kingSide) const {
+    const Color us = stm_;
+    const int rank = homeRank(us);
+    const int kingFrom = sqOf(4, rank);
+    if (pieceAt(kingFrom) != makePiece(us, PieceType::King)) return std::nullopt;
+
+    const Piece rook = makePiece(us, PieceType::Rook);
+    const Bitboard occ = occupied();
+
+    Move m;
+    m.from = kingFrom;
+    if (kingSide) {
+        if (!hasCastlingRight(kingSideRight(us))) return std::nullopt;
+        if (occ & (squareBb(sqOf(5, rank)) | squareBb(sqOf(6, rank)))) return std::nullopt;
+        if (pieceAt(sqOf(7, rank)) != rook) return std::nullopt;
+        m.to = sqOf(6, rank);
+        m.isCastleKing = true;
+    } else {
+        if (!hasCastlingRight(queenSideRight(us))) return std::nullopt;
+        if (occ & (squareBb(sqOf(1, rank)) | squareBb(sqOf(2, rank)) | squareBb(sqOf(3, rank)))) return std::nullopt;
+        if (pieceAt(sqOf(0, rank)) != rook) return std::nullopt;
+        m.to = sqOf(2, rank);
+        m.isCastleQueen = true;
+    }
+    return m;
+}
+
+void Position::generatePseudoMoves(MoveList& out) const {
+    const Color us = stm_;
+    const Color them = opposite(us);
+    const Bitboard own = pieces(us);
+    const Bitboard enemy = pieces(them);
+    const Bitboard occ = occupied();
+
+    // Pawns
+    {
+        const int push = (us == Color::White) ? 8 : -8;
+        const int startRank = (us == Color::White) ? 1 : 6;
+        const Bitboard epBb = (epSquare_ >= 0) ? squareBb(epSquare_) : 0;
+
+        Bitboard pawns = pieces(us, PieceType::Pawn);
+        while (pawns) {
+            const int from = popLsb(pawns);
+            const int one = from + push;
+            if (one >= 0 && one < 64 && !(occ & squareBb(one))) {
+                addPawnMoves(out, from, one, false, false);
+                const int two = one + push;
+                if (rankOf(from) == startRank && !(occ & squareBb(two))) {
+                    addPawnMoves(out, from, two, false, false);
+                }
+            }
+
+            Bitboard caps = pawnAttacks(us, from) & (enemy | epBb);
+            while (caps) {
+                const int to = popLsb(caps);
+                const bool ep = (to == epSquare_) && isEmpty(pieceAt(to));
+                addPawnMoves(out, from, to, true, ep);
+            }
+        }
+    }
+
+    auto addTargets = [&](int from, Bitboard targets) {
+        targets &= ~own;
+        while (targets) {
+            const int to = popLsb(targets);
+            Move m;
+            m.from = from;
+            m.to = to;
+            m.isCapture = !isEmpty(pieceAt(to));
+            out.push(m);
+        }
+    };
+
+    for (Bitboard b = pieces(us, PieceType::Knight); b;) {
+        const int from = popLsb(b);
+        addTargets(from, knightAttacks(from));
+    }
+    for (Bitboard b = pieces(us, PieceType::Bishop); b;) {
+        const int from = popLsb(b);
+        addTargets(from, bishopAttacks(from, occ));
+    }
+    for (Bitboard b = pieces(us, PieceType::Rook); b;) {
+        const int from = popLsb(b);
+        addTargets(from, rookAttacks(from, occ));
+    }
+    for (Bitboard b = pieces(us, PieceType::Queen); b;) {
+        const int from = popLsb(b);
+        addTargets(from, queenAttacks(from, occ));
+    }
+    for (Bitboard b = pieces(us, PieceType::King); b;) {
+        const int from = popLsb(b);
+        addTargets(from, kingAttacks(from));
+    }
+
+    if (auto m = castleMove(true)) out.push(*m);
+    if (auto m = castleMove(false)) out.push(*m);
+}
+
+void Position::generateLegalMoves(MoveList& out) const {
+    MoveList pseudo;
+    generatePseudoMoves(pseudo);
+    for (const Move& m : pseudo) {
+        if (isLegal(m)) out.push(m);
+    }
+}
+
+std::optional<Move> Position::findLegalUci(const std::string& uci) const {
+    if (uci.size() < 4 || uci.size() > 5) return std::nullopt;
+    const auto from = algToSq(std::string_view(uci).substr(0, 2));
+    const auto to = algToSq(std::string_view(uci).substr(2, 2));
+    if (!from || !to) return std::nullopt;
+
+    MoveList moves;
+    generateLegalMoves(moves);
+    for (const Move& m : moves) {
+        if (m.from == *from && m.to == *to && moveToUci(m) == uci) return m;
+    }
+    return std::nullopt;
+}
+
+std::optional<Move> Position::findLegalPacked(PackedMove packed) const {
+    MoveList moves;
+    generateLegalMoves(moves);
+    for (const Move& m : moves) {
+        if (packMove(m) == packed) return m;
+    }
+    return std::nullopt;
+}
+
+// ---- Make / unmake ----
+
+void Position::setEpIfCapturable(int epTarget, Color capturer) {
+    if (pawnAttacks(opposite(capturer), epTarget) & pieces(capturer, PieceType::Pawn)) {
+        epSquare_ = epTarget;
+    }
+}
+
+void Position::makeMove(const Move& m, UndoInfo& undo) {
+    const Color us = stm_;
+    const Piece moving = pieceAt(m.from);
+
+    undo.captured = Piece::Empty;
+    undo.castling = castling_;
+    undo.epSquare = static_cast<std::int8_t>(epSquare_);
+    undo.halfmove = halfmove_;
+    undo.fullmove = fullmove_;
+    undo.key = key_;
+
+    // Castling/ep contributions are re-added once the move is done.
+    key_ ^= zobrist::castling(castling_);
+    if (epSquare_ >= 0) key_ ^= zobrist::epFile(fileOf(epSquare_));
+
+    // Clear en-passant by default.
+    epSquare_ = -1;
+
+    if (m.isCastleKing || m.isCastleQueen) {
+        const int rank = homeRank(us);
+        const int rookFrom = m.isCastleKing ? sqOf(7, rank) : sqOf(0, rank);
+        const int rookTo   = m.isCastleKing ? sqOf(5, rank) : sqOf(3, rank);
+        movePiece(m.from, m.to);
+        movePiece(rookFrom, rookTo);
+
+        castling_ &= static_cast<std::uint8_t>(~(kingSideRight(us) | queenSideRight(us)));
+
+        // Castling is neither pawn move nor capture.
+        halfmove_ += 1;
+    } else {
+        const PieceType movingType = typeOf(moving);
+
+        if (m.isEnPassant) {
+            const int capSq = epCaptureSquare(us, m.to);
+            undo.captured = pieceAt(capSq);
+            removePiece(capSq);
+        } else if (!isEmpty(pieceAt(m.to))) {
+            undo.captured = pieceAt(m.to);
+            removePiece(m.to);
+            // A rook captured on its corner loses that side's right.
+            castling_ &= static_cast<std::uint8_t>(~cornerRight(m.to));
+        }
+
+        if (movingType == PieceType::King) {
+            castling_ &= static_cast<std::uint8_t>(~(kingSideRight(us) | queenSideRight(us)));
+        } else if (movingType == PieceType::Rook) {
+            castling_ &= static_cast<std::uint8_t>(~cornerRight(m.from));
+        }
+
+        movePiece(m.from, m.to);
+
+        if (!isEmpty(m.promotion)) {
+            removePiece(m.to);
+            putPiece(m.to, m.promotion);
+        }
+
+        if (movingType == PieceType::Pawn && (m.to - m.from == 16 || m.from - m.to == 16)) {
+            setEpIfCapturable((m.from + m.to) / 2, opposite(us));
+        }
+
+        if (movingType == PieceType::Pawn || !isEmpty(undo.captured)) halfmove_ = 0;
+        else halfmove_ += 1;
+    }
+
+    if (us == Color::Black) fullmove_ += 1;
+    stm_ = opposite(us);
+
+    key_ ^= zobrist::castling(castling_);
+    if (epSquare_ >= 0) key_ ^= zobrist::epFile(fileOf(epSquare_));
+    key_ ^= zobrist::sideToMove();
+}
+
+void Position::unmakeMove(const Move& m, const UndoInfo& undo) {
+    stm_ = opposite(stm_);
+    const Color us = stm_;
+
+    if (m.isCastleKing || m.isCastleQueen) {
+        const int rank = homeRank(us);
+        const int rookFrom = m.isCastleKing ? sqOf(7, rank) : sqOf(0, rank);
+        const int rookTo   = m.isCastleKing ? sqOf(5, rank) : sqOf(3, rank);
+        movePiece(m.to, m.from);
+        movePiece(rookTo, rookFrom);
+    } else {
+        if (!isEmpty(m.promotion)) {
+            removePiece(m.to);
+            putPiece(m.to, makePiece(us, PieceType::Pawn));
+        }
+        movePiece(m.to, m.from);
+        if (!isEmpty(undo.captured)) {
+            putPiece(m.isEnPassant ? epCaptureSquare(us, m.to) : m.to, undo.captured);
+        }
+    }
+
+    castling_ = undo.castling;
+    epSquare_ = undo.epSquare;
+    halfmove_ = undo.halfmove;
+    fullmove_ = undo.fullmove;
+    key_ = undo.key;
+}
+
+bool Position::applyMove(const Move& m) {
+    const Piece moving = pieceAt(m.from);
+    if (isEmpty(moving)) return false;
+    if (colorOf(moving) != stm_) return false;
+
+    if (m.isCastleKing || m.isCastleQueen) {
+        const int rank = homeRank(stm_);
+        if (m.from != sqOf(4, rank)) return false;
+        const int rookFrom = m.isCastleKing ? sqOf(7, rank) : sqOf(0, rank);
+        if (pieceAt(rookFrom) != makePiece(stm_, PieceType::Rook)) return false;
+    }
+
+    UndoInfo undo;
+    makeMove(m, undo);
+    return true;
+}
+
+} // namespace sf::client::domain::chess
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "domain/chess/Bitboard.hpp"
+#include "domain/chess/ChessTypes.hpp"
+#include "domain/chess/PackedMove.hpp"
+#include "domain/chess/PackedPosition.hpp"
+
+namespace sf::client::domain::chess {
+
+// Fixed-capacity move buffer (no heap allocation during generation).
+struct MoveList {
+    std::array<Move, 256> moves{};
+    int size{0};
+
+    void push(const Move& m) { moves[static_cast<std::size_t>(size++)] = m; }
+    const Move* begin() const { return moves.data(); }
+    const Move* end() const { return moves.data() + size; }
+    bool empty() const { return size == 0; }
+};
+
+// State needed to take a move back (see Position::makeMove / unmakeMove).
+struct UndoInfo {
+    Piece captured{Piece::Empty};
+    std::uint8_t castling{NoCastling};
+    std::int8_t epSquare{-1};
+    int halfmove{0};
+    int fullmove{1};
+    std::uint64_t key{0};
+};
+
+// Bitboard position with a mailbox mirror for O(1) piece lookup.
+//
+// En-passant semantics match the historic mailbox implementation: the
+// ep square is recorded only if an enemy pawn could actually capture
+// (pseudo-legally). This keeps FEN output and position keys stable.
+class Position {
+public:
+    static Position startpos();
+    static std::optional<Position> fromFen(const std::string& fen);
+
+    std::string toFen() const;
+
+    PackedPosition pack() const;
+    static Position unpack(const PackedPosition& packed);
+
+    // ---- Accessors ----
+    Piece pieceAt(int sq) const { return board_[static_cast<std::size_t>(sq)]; }
+    Color sideToMove() const { return stm_; }
+    std::uint8_t castlingRights() const { return castling_; }
+    bool hasCastlingRight(CastlingRight r) const { return (castling_ & r) != 0; }
+    int epSquare() const { return epSquare_; } // -1 if none
+    int halfmoveClock() const { return halfmove_; }
+    int fullmoveNumber() const { return fullmove_; }
+
+    // Zobrist key (pieces, side to move, castling, en-passant file),
+    // maintained incrementally by makeMove()/unmakeMove().
+    std::uint64_t key() const { return key_; }
+    std::uint64_t computeKey() const; // from scratch, for verification
+
+    Bitboard occupied() const { return byColor_[0] | byColor_[1]; }
+    Bitboard pieces(Color c) const { return byColor_[index(c)]; }
+    Bitboard pieces(Color c, PieceType t) const { return byColor_[index(c)] & byType_[index(t)]; }
+    Bitboard pieces(PieceType t) const { return byType_[index(t)]; }
+
+    // Least significant king square of that color, -1 if the side has no king.
+    int kingSquare(Color c) const;
+
+    // ---- Attacks / legality ----
+    Bitboard attackersTo(int sq, Color by, Bitboard occupied) const;
+    bool squareAttackedBy(int sq, Color by) const;
+    bool inCheck(Color c) const;
+
+    // King not in check and does not pass through attacked squares.
+    bool castlePathLegal(Color mover, bool kingSide) const;
+
+    // Full legality test for a pseudo-legal move of the side to move.
+    bool isLegal(const Move& m) const;
+
+    // ---- Move generation ----
+    void generatePseudoMoves(MoveList& out) const;
+    void generateLegalMoves(MoveList& out) const;
+
+    // Builds the castling move if its rights/empties/rook preconditions hold.
+    std::optional<Move> castleMove(bool kingSide) const;
+
+    // Legal move whose UCI string (e2e4, e7e8q, e1g1) equals uci.
+    std::optional<Move> findLegalUci(const std::string& uci) const;
+    // Same for a packed move (PackedMove.hpp).
+    std::optional<Move> findLegalPacked(PackedMove packed) const;
+
+    // ---- Make / unmake ----
+    // makeMove() expects a pseudo-legal move from the generator or SAN
+    // resolution; it does not validate.
+    void makeMove(const Move& m, UndoInfo& undo);
+    void unmakeMove(const Move& m, const UndoInfo& undo);
+
+    // Validating wrapper: rejects moves from an empty/foreign square and
+    // castling without king/rook on their home squares.
+    bool applyMove(const Move& m);
+
+private:
+    void putPiece(int sq, Piece p);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
+
+    void addPawnMoves(MoveList& out, int from, int to, bool capture, bool ep) const;
+    void setEpIfCapturable(int epTarget, Color capturer);
+
+    std::array<Piece, 64> board_{};
+    std::array<Bitboard, kPieceTypeCount> byType_{};
+    std::array<Bitboard, kColorCount> byColor_{};
+
+    Color stm_{Color::White};
+    std::uint8_t castling_{NoCastling};
+    int epSquare_{-1};
+    int halfmove_{0};
+    int fullmove_{1};
+    std::uint64_t key_{0};
+};
+
+} // namespace sf::client::domain::chess
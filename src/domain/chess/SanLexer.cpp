@@ -0,0 +1,286 @@
+#include "domain/chess/SanLexer.hpp"
+
+#include "domain/chess/ChessTypes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace sf::client::domain::chess {
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Characters that start a skipped group and so also end a token.
+inline bool isGroupStart(char c) {
+    return c == '{' || c == '(' || c == '[' || c == ';';
+}
+
+inline bool isResult(std::string_view t) {
+    return t == "1-0" || t == "0-1" || t == "1/2-1/2" || t == "*";
+}
+
+// ---- SAN state machine ----
+//
+//   [piece] [file] [rank] [x] file rank [=promo]
+//
+// Every file or rank goes into a pending square; another file or an 'x'
+// turns the pending part into disambiguation, so what is pending at the
+// end (or at '=') is the destination.
+
+enum CharClass : std::uint8_t { kOther, kPiece, kKing, kFile, kRank, kCapture, kEquals, kClassCount };
+
+enum State : std::uint8_t {
+    kStart,
+    kAfterPiece,
+    kFromFile,       // "N b" / "e" (pawn destination file or origin file)
+    kFromSquare,     // "e4", "Nf3": may already be complete
+    kFromRank,       // "N1"
+    kAfterCapture,
+    kToFile,
+    kToSquare,       // complete
+    kAfterEquals,
+    kPromoted,       // complete
+    kFail,
+    kStateCount
+};
+
+constexpr std::array<std::uint8_t, 256> makeClassTable() {
+    std::array<std::uint8_t, 256> t{};
+    for (char c = 'a'; c <= 'h'; ++c) t[static_cast<unsigned char>(c)] = kFile;
+    for (char c = '1'; c <= '8'; ++c) t[static_cast<unsigned char>(c)] = kRank;
+    t['N'] = t['B'] = t['R'] = t['Q'] = kPiece;
+    t['K'] = kKing;
+    t['x'] = kCapture;
+    t['='] = kEquals;
+    return t;
+}
+
+constexpr std::array<std::uint8_t, 256> kClass = makeClassTable();
+
+constexpr std::uint8_t F = kFail;
+// kNext[state][class]; columns: other, piece, king, file, rank, x, '='.
+constexpr std::uint8_t kNext[kStateCount][kClassCount] = {
+    /* kStart        */ {F, kAfterPiece, kAfterPiece, kFromFile, F, F, F},
+    /* kAfterPiece   */ {F, F, F, kFromFile, kFromRank, kAfterCapture, F},
+    /* kFromFile     */ {F, F, F, kToFile, kFromSquare, kAfterCapture, F},
+    /* kFromSquare   */ {F, F, F, kToFile, F, kAfterCapture, kAfterEquals},
+    /* kFromRank     */ {F, F, F, kToFile, F, kAfterCapture, F},
+    /* kAfterCapture */ {F, F, F, kToFile, F, F, F},
+    /* kToFile       */ {F, F, F, F, kToSquare, F, F},
+    /* kToSquare     */ {F, F, F, F, F, F, kAfterEquals},
+    /* kAfterEquals  */ {F, kPromoted, F, F, F, F, F},
+    /* kPromoted     */ {F, F, F, F, F, F, F},
+    /* kFail         */ {F, F, F, F, F, F, F},
+};
+
+constexpr bool kAccepting[kStateCount] = {
+    false, false, false, true, false, false, false, true, false, true, false,
+};
+
+PieceKind pieceKindFor(char c) {
+    switch (c) {
+        case 'N': return PieceKind::Knight;
+        case 'B': return PieceKind::Bishop;
+        case 'R': return PieceKind::Rook;
+        case 'Q': return PieceKind::Queen;
+        default:  return PieceKind::King;
+    }
+}
+
+// "O-O" / "O-O-O", also spelled with '0' or 'o' throughout.
+bool parseCastle(std::string_view t, MoveSpec& out) {
+    if (t.size() != 3 && t.size() != 5) return false;
+    const char o = t[0];
+    if (o != 'O' && o != '0' && o != 'o') return false;
+    for (std::size_t i = 0; i < t.size(); ++i) {
+        if (t[i] != (i % 2 == 0 ? o : '-')) return false;
+    }
+    out = MoveSpec{};
+    out.kind = t.size() == 3 ? PieceKind::CastleK : PieceKind::CastleQ;
+    return true;
+}
+
+} // namespace
+
+void SanLexer::skipGroup(char open, char close) noexcept {
+    // pos_ is on the opening character; nested groups of the same kind count.
+    int depth = 0;
+    for (; pos_ < text_.size(); ++pos_) {
+        const char c = text_[pos_];
+        if (c == open) {
+            ++depth;
+        } else if (c == close && --depth == 0) {
+            ++pos_;
+            return;
+        }
+    }
+}
+
+std::string_view SanLexer::readWord(bool structured) noexcept {
+    // pos_ is on the word's first character.
+    const std::size_t n = text_.size();
+    const std::size_t begin = pos_;
+    while (pos_ < n) {
+        const char c = text_[pos_];
+        if (isSpace(c) || isGroupStart(c) || (structured && (c == ')' || c == '$'))) break;
+        ++pos_;
+    }
+    std::string_view t = text_.substr(begin, pos_ - begin);
+
+    // "12." / "12...Nf6": drop the number when dots follow it.
+    std::size_t digits = 0;
+    while (digits < t.size() && isDigit(t[digits])) ++digits;
+    if (digits > 0 && digits < t.size() && t[digits] == '.') {
+        while (digits < t.size() && t[digits] == '.') ++digits;
+        t.remove_prefix(digits);
+    }
+    return t;
+}
+
+bool SanLexer::next(std::string_view& token) noexcept {
+    const std::size_t n = text_.size();
+    while (pos_ < n) {
+        const char c = text_[pos_];
+        if (isSpace(c)) {
+            ++pos_;
+            continue;
+        }
+        switch (c) {
+            case '{': skipGroup('{', '}'); continue;
+            case '(': skipGroup('(', ')'); continue;
+            case '[': skipGroup('[', ']'); continue;
+            case ';':
+                while (pos_ < n && text_[pos_] != '\n' && text_[pos_] != '\r') ++pos_;
+                continue;
+            default:
+                break;
+        }
+
+        const std::string_view t = trimSanSuffix(readWord(false));
+        if (t.empty() || t.front() == '$' || isResult(t)) continue;
+
+        ++count_;
+        token = t;
+        return true;
+    }
+    return false;
+}
+
+bool SanLexer::next(SanToken& token) noexcept {
+    const std::size_t n = text_.size();
+    while (pos_ < n) {
+        const char c = text_[pos_];
+        if (isSpace(c)) {
+            ++pos_;
+            continue;
+        }
+        switch (c) {
+            case '{': {
+                // PGN comments do not nest; an unclosed one runs to the end.
+                const std::size_t begin = pos_ + 1;
+                const std::size_t end = std::min(text_.find('}', begin), n);
+                pos_ = end < n ? end + 1 : n;
+                token = {SanTokenKind::Comment, text_.substr(begin, end - begin)};
+                return true;
+            }
+            case ';': {
+                const std::size_t begin = pos_ + 1;
+                while (pos_ < n && text_[pos_] != '\n' && text_[pos_] != '\r') ++pos_;
+                token = {SanTokenKind::Comment, text_.substr(begin, pos_ - begin)};
+                return true;
+            }
+            case '(':
+            case ')':
+                token = {c == '(' ? SanTokenKind::VariationStart : SanTokenKind::VariationEnd,
+                         text_.substr(pos_++, 1)};
+                return true;
+            case '[':
+                skipGroup('[', ']');
+                continue;
+            case '$': {
+                const std::size_t begin = ++pos_;
+                while (pos_ < n && isDigit(text_[pos_])) ++pos_;
+                token = {SanTokenKind::Nag, text_.substr(begin, pos_ - begin)};
+                return true;
+            }
+            default:
+                break;
+        }
+
+        const std::string_view t = readWord(true);
+        const std::string_view bare = trimSanSuffix(t);
+        if (bare.empty() || isResult(bare)) continue;
+
+        ++count_;
+        token = {SanTokenKind::Move, t};
+        return true;
+    }
+    return false;
+}
+
+std::string_view trimSanSuffix(std::string_view san) noexcept {
+    while (!san.empty()) {
+        const char c = san.back();
+        if (c != '+' && c != '#' && c != '!' && c != '?') break;
+        san.remove_suffix(1);
+    }
+    return san;
+}
+
+bool parseSan(std::string_view token, MoveSpec& out) noexcept {
+    if (token.empty()) return false;
+    if (parseCastle(token, out)) return true;
+
+    out = MoveSpec{};
+    int file = -1;
+    int rank = -1;
+    auto disambiguateWithPending = [&] {
+        if (file >= 0) out.disFile = file;
+        if (rank >= 0) out.disRank = rank;
+        file = rank = -1;
+    };
+
+    std::uint8_t state = kStart;
+    for (const char c : token) {
+        const std::uint8_t cls = kClass[static_cast<unsigned char>(c)];
+        const std::uint8_t nextState = kNext[state][cls];
+        if (nextState == kFail) return false;
+
+        switch (cls) {
+            case kPiece:
+            case kKing:
+                if (state == kStart) out.kind = pieceKindFor(c);
+                else out.promo = c;
+                break;
+            case kFile:
+                disambiguateWithPending();
+                file = c - 'a';
+                break;
+            case kRank:
+                rank = c - '1';
+                break;
+            case kCapture:
+                out.capture = true;
+                disambiguateWithPending();
+                break;
+            default:
+                break;
+        }
+        state = nextState;
+    }
+    if (!kAccepting[state]) return false;
+
+    out.to = sqOf(file, rank);
+    // A pawn names at most its origin file ("exd5").
+    return out.kind != PieceKind::Pawn || !out.disRank;
+}
+
+} // namespace sf::client::domain::chess
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace sf::client::domain::chess {
+
+enum class PieceKind { Pawn, Knight, Bishop, Rook, Queen, King, CastleK, CastleQ };
+
+// What a SAN token says, before it is matched against a position.
+struct MoveSpec {
+    PieceKind kind{PieceKind::Pawn};
+    int to{-1};
+    bool capture{false};
+    std::optional<int> disFile; // 0..7
+    std::optional<int> disRank; // 0..7
+    std::optional<char> promo;  // 'Q','R','B','N'
+};
+
+// What SanLexer::next(SanToken&) yields besides moves.
+enum class SanTokenKind : std::uint8_t {
+    Move,           // text as written, move number dropped ("Nf3+!?")
+    Comment,        // text inside {...} or after ';'
+    Nag,            // digits after '$'
+    VariationStart, // '('
+    VariationEnd    // ')'
+};
+
+struct SanToken {
+    SanTokenKind     kind{SanTokenKind::Move};
+    std::string_view text;
+};
+
+// Walks PGN movetext once and yields the move tokens as views into it:
+// {...} and ';' comments, (...) variations, [...] tags, NAGs ($1),
+// results and move numbers ("12." / "12...") are skipped, and the
+// check/annotation suffix ("+", "#", "!", "?") is cut off. Comments and
+// variations also end a token. Nothing is copied or allocated; the text
+// must outlive the lexer.
+class SanLexer {
+public:
+    explicit SanLexer(std::string_view movetext) noexcept
+        : text_(movetext) {}
+
+    // False when the movetext is exhausted.
+    bool next(std::string_view& token) noexcept;
+
+    // Same walk, but comments, NAGs and variations come out as tokens
+    // instead of being skipped (tags and results still are); a ')' also
+    // ends a move. Move tokens keep their suffix. Use one form per lexer.
+    bool next(SanToken& token) noexcept;
+
+    // 1-based number of the token last returned (for error messages).
+    int tokenNumber() const noexcept { return count_; }
+
+private:
+    void skipGroup(char open, char close) noexcept;
+    std::string_view readWord(bool structured) noexcept;
+
+    std::string_view text_;
+    std::size_t      pos_{0};
+    int              count_{0};
+};
+
+// "Nf3+" -> "Nf3", "e4!?" -> "e4".
+std::string_view trimSanSuffix(std::string_view san) noexcept;
+
+// Decodes one SAN token without decorations ("Nbd7", "exd6", "O-O", "e8=Q")
+// in a single left-to-right pass over a character-class state machine.
+// False if it is not well-formed SAN; out is then unspecified.
+bool parseSan(std::string_view token, MoveSpec& out) noexcept;
+
+} // namespace sf::client::domain::chess
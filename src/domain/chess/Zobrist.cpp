@@ -0,0 +1,78 @@
+#include "domain/chess/Zobrist.hpp"
+
+#include <array>
+
+namespace sf::client::domain::chess::zobrist {
+
+namespace {
+
+// splitmix64: tiny, well-distributed and trivially reproducible.
+class SplitMix64 {
+public:
+    explicit SplitMix64(std::uint64_t seed) : s_(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (s_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    std::uint64_t s_;
+};
+
+struct Keys {
+    // Indexed by static_cast<int>(Piece); row 0 (Empty) stays zero.
+    std::array<std::array<std::uint64_t, 64>, 13> pieces{};
+    std::array<std::uint64_t, 16> castling{};
+    std::array<std::uint64_t, 8> epFile{};
+    std::uint64_t side{0};
+
+    Keys() {
+        SplitMix64 rng(0x436F727243686573ull); // "CorrChes"
+        for (int p = 1; p < 13; ++p) {
+            for (auto& k : pieces[static_cast<std::size_t>(p)]) k = rng.next();
+        }
+
+        // One key per right; combinations are xor-composed so that
+        // castling(a | b) == castling(a) ^ castling(b).
+        std::array<std::uint64_t, 4> rightKeys{};
+        for (auto& k : rightKeys) k = rng.next();
+        for (std::size_t mask = 0; mask < castling.size(); ++mask) {
+            std::uint64_t k = 0;
+            for (std::size_t bit = 0; bit < rightKeys.size(); ++bit) {
+                if (mask & (std::size_t{1} << bit)) k ^= rightKeys[bit];
+            }
+            castling[mask] = k;
+        }
+
+        for (auto& k : epFile) k = rng.next();
+        side = rng.next();
+    }
+};
+
+const Keys& keys() {
+    static const Keys k;
+    return k;
+}
+
+} // namespace
+
+std::uint64_t piece(Piece p, int sq) {
+    return keys().pieces[static_cast<std::size_t>(p)][static_cast<std::size_t>(sq)];
+}
+
+std::uint64_t castling(std::uint8_t rights) {
+    return keys().castling[rights & 15u];
+}
+
+std::uint64_t epFile(int file) {
+    return keys().epFile[static_cast<std::size_t>(file)];
+}
+
+std::uint64_t sideToMove() {
+    return keys().side;
+}
+
+} // namespace sf::client::domain::chess::zobrist
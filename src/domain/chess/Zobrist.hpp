@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "domain/chess/ChessTypes.hpp"
+
+namespace sf::client::domain::chess::zobrist {
+
+// Zobrist keys for position hashing (move counters are not part of the key).
+//
+// The tables are generated from a fixed seed: keys are persisted in the
+// reference DB (move_agg.pos_hash / occurrences.pos_hash), so changing the
+// seed or the generator invalidates every existing index.
+
+std::uint64_t piece(Piece p, int sq);
+std::uint64_t castling(std::uint8_t rights); // CastlingRight bit set, 0..15
+std::uint64_t epFile(int file);
+std::uint64_t sideToMove(); // xor-ed in when Black is to move
+
+} // namespace sf::client::domain::chess::zobrist
@@ -3,8 +3,13 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "domain/chess/PackedPosition.hpp"
+#include "domain/chess/Position.hpp"
+#include "domain/chess/SanLexer.hpp"
+
 namespace sf::client::domain::chess {
 
 struct FenFromSanResult {
@@ -18,8 +23,13 @@ struct FenTimelinePly {
     int plyIndex{0};                // 0-based ply number
     std::string san;                // normalized SAN token (as parsed)
     std::string uci;                // UCI move (e2e4, e7e8q, etc.)
-    std::string fenAfter;           // full FEN after the move (includes counters)
-    std::uint64_t posHashBefore{0}; // hash of the position before the move (counters excluded)
+    std::string fenAfter;           // full FEN after the move (includes counters); empty in Lazy mode
+    std::uint64_t posHashBefore{0}; // Zobrist key of the position before the move (counters excluded)
+};
+
+enum class FenTimelineMode {
+    Eager, // FenTimelinePly::fenAfter filled for every ply
+    Lazy   // 40-byte snapshot per ply; FEN built on demand by fenAt()
 };
 
 struct FenTimelineResult {
@@ -27,6 +37,57 @@ struct FenTimelineResult {
     std::string error;
     std::string startFen; // full FEN of the starting position (includes counters)
     std::vector<FenTimelinePly> plies;
+    std::vector<PackedPosition> packedAfter; // Lazy mode only, parallel to plies
+
+    // Full FEN after ply `ply` (0-based); -1 returns startFen.
+    // Works in both modes; returns an empty string when out of range.
+    std::string fenAt(int ply) const;
+};
+
+// Replays SAN movetext one ply at a time straight from the text (see
+// SanLexer): no token list and no per-move strings. The functions below are
+// built on it; callers that only need keys or moves (the reference DB
+// importer) use it directly.
+//
+//   SanReplay replay(movetext, Position::startpos());
+//   while (replay.next()) {
+//       use(replay.keyBefore(), replay.move());
+//   }
+//   if (!replay.ok()) fail(replay.error());
+class SanReplay {
+public:
+    SanReplay(std::string_view movetext, const Position& start)
+        : lexer_(movetext)
+        , pos_(start) {}
+
+    // Plays the next move. False at the end of the movetext or on an error
+    // (ok() tells them apart); the position then stays before the bad move.
+    bool next();
+
+    bool ok() const noexcept { return error_.empty(); }
+    const std::string& error() const noexcept { return error_; }
+
+    // After the last move played.
+    const Position& position() const noexcept { return pos_; }
+    const Move& move() const noexcept { return move_; }
+    // The token as written, without move number or "+" / "!" suffix.
+    std::string_view san() const noexcept { return san_; }
+    // Zobrist key of the position before the last move (counters excluded).
+    std::uint64_t keyBefore() const noexcept { return keyBefore_; }
+    int plyCount() const noexcept { return plies_; }
+    // Move tokens read so far, including a failed one.
+    int tokenCount() const noexcept { return lexer_.tokenNumber(); }
+
+private:
+    bool fail(std::string what);
+
+    SanLexer         lexer_;
+    Position         pos_;
+    Move             move_;
+    std::string_view san_;
+    std::uint64_t    keyBefore_{0};
+    int              plies_{0};
+    std::string      error_;
 };
 
 // Converts a PGN/SAN move sequence like:
@@ -40,6 +101,7 @@ struct FenTimelineResult {
 // - castling: "O-O", "O-O-O" (also accepts "0-0" / "0-0-0")
 // - check/mate suffix: "+" / "#" (ignored)
 // - promotions: "e8=Q", "fxg8=N+"
+// - comments, variations, NAGs and results are skipped (see SanLexer)
 //
 // By default starts from the standard initial position.
 // If startFen is provided, moves are applied from that position instead.
@@ -48,7 +110,28 @@ FenFromSanResult fenFromSanMoves(const std::string& sanMoves,
 
 // Builds a ply-by-ply timeline for a SAN/PGN movetext.
 // Unlike fenFromSanMoves(), an empty move string is allowed: ok=true with plies empty.
+// Use FenTimelineMode::Lazy when only a few plies will be displayed, or only
+// hashes and UCI moves are needed.
 FenTimelineResult fenTimelineFromSanMoves(const std::string& sanMoves,
-                                         const std::optional<std::string>& startFen = std::nullopt);
+                                         const std::optional<std::string>& startFen = std::nullopt,
+                                         FenTimelineMode mode = FenTimelineMode::Eager);
+
+// The legal move a single SAN token ("Nbd7", "exd6", "O-O", "e8=Q+")
+// denotes in pos, resolved the way the functions above replay movetext.
+// nullopt if it cannot be parsed, matches no legal move or is ambiguous;
+// error (if given) then says why.
+std::optional<Move> sanToMove(const Position& pos, const std::string& san, std::string* error = nullptr);
+
+// SAN for a legal move of the side to move in pos: piece letter, minimal
+// disambiguation, "x", "=Q", "O-O" / "O-O-O" and a "+" / "#" suffix.
+std::string moveToSan(const Position& pos, const Move& move);
+
+// Builds a ply-by-ply timeline for a UCI move list such as an engine PV
+// ("e2e4 e7e5 g1f3"), with FenTimelinePly::san filled in.
+// Stops at the first move that is not legal: ok=false, with the plies
+// before it kept.
+FenTimelineResult fenTimelineFromUciMoves(const std::string& uciMoves,
+                                         const std::optional<std::string>& startFen = std::nullopt,
+                                         FenTimelineMode mode = FenTimelineMode::Lazy);
 
 } // namespace sf::client::domain::chess
@@ -6,6 +6,9 @@
 #include <string>
 #include <vector>
 
+#include "domain/chess/MoveLine.hpp"
+#include "domain/job_log.hpp"
+
 namespace sf::client::domain {
 
 using Clock     = std::chrono::system_clock;
@@ -57,7 +60,7 @@ struct PvLine {
     Score                  score;
     std::optional<int64_t> nodes;
     std::optional<int64_t> nps;
-    std::string            pv;
+    chess::MoveLine        pv;
 };
 
 
@@ -68,7 +71,7 @@ struct JobSnapshot {
     std::optional<int64_t>  nodes;
     std::optional<int64_t>  nps;
     std::string            bestMove;
-    std::string            pv;
+    chess::MoveLine        pv;
 
     // MultiPV support: per-line PVs keyed by 'multipv' (1..N).
     std::vector<PvLine>     lines;
@@ -88,15 +91,38 @@ enum class JobStatus {
 
 // --- Job --------------------------------------------------------------------
 
+// Batch jobs: counts over the batch's positions (each a job of its own).
+struct BatchProgress {
+    int total{0};
+    int running{0};
+    int finished{0};
+    int failed{0}; // Error, Cancelled or Stopped
+
+    int done() const noexcept { return finished + failed; }
+};
+
 struct Job {
     JobId                      id;
     std::string                opponent;
     std::string                fen;
     SearchLimit                limit;
     int                        multiPv{1}; // requested MultiPV (1..N)
+    int                        priority{0}; // dispatch order of Pending jobs; higher first
     JobStatus                  status{JobStatus::Pending};
     std::optional<std::string> assignedServer;
 
+    // Root moves the engine may search (UCI, "go ... searchmoves"); empty = all.
+    std::vector<std::string>   searchMoves;
+
+    // Cluster jobs: the parent runs nowhere itself and lists its sub-jobs,
+    // each sub-job searches a share of the root moves and names its parent.
+    std::vector<JobId>         subJobIds;
+    std::optional<JobId>       parentJobId;
+
+    // Set on a batch job, whose sub-jobs are whole positions that are
+    // tracked here instead of being listed one by one.
+    std::optional<BatchProgress> batch;
+
     TimePoint                 createdAt{Clock::now()};
     std::optional<TimePoint>  startedAt;
     std::optional<TimePoint>  finishedAt;
@@ -105,7 +131,7 @@ struct Job {
     TimePoint lastUpdateAt{Clock::now()};
 
     JobSnapshot               snapshot;
-    std::vector<std::string>  logLines;
+    JobLog                    logLines; // bounded; see job_log.hpp
 };
 
 // --- Servers ----------------------------------------------------------------
@@ -117,12 +143,50 @@ enum class ServerStatus {
     Offline  = 3
 };
 
+// Connection metrics measured on the network thread (see NetworkWorker),
+// refreshed with every ping. Rates cover the last ping interval.
+struct ServerTelemetry {
+    double       rttMs{-1.0};              // ping -> pong round trip; < 0 = not measured
+    double       messagesPerSecond{0.0};
+    double       bytesPerSecond{0.0};
+    double       parseMicrosPerMessage{0.0}; // JSON/CBOR decoding on the client
+    std::int64_t messagesReceived{0};      // totals since the connection was created
+    std::int64_t bytesReceived{0};
+    std::int64_t aggregateNps{0};          // latest NPS summed over the server's running jobs
+    int          reportingJobs{0};         // jobs contributing to aggregateNps
+};
+
 struct ServerRuntimeState {
     ServerStatus status{ServerStatus::Unknown};
     int          runningJobs{0};
     int          maxJobs{0};
     double       loadPercent{0.0};
     TimePoint    lastSeen{Clock::now()};
+
+    // Smoothed NPS of one job on this server, from job snapshots (0 = none yet).
+    double       measuredNps{0.0};
+
+    // Warm engine pool as reported by server_status (size 0 = not pooled / unknown).
+    int          enginePoolSize{0};
+    int          enginePoolIdle{0};
+    int          enginePoolBusy{0};
+
+    // CPU pinning (server --pin-cores; numaNodes 0 = not pinned / unknown):
+    // CPUs of the slots no job is using, and the threads the next job gets.
+    int          numaNodes{0};
+    int          freeCpus{0};
+    int          nextJobThreads{0};
+
+    // The server's hello listed job_extend (see JobManager::extendJob).
+    bool         canExtendJobs{false};
+
+    ServerTelemetry telemetry;
+};
+
+// How ServerManager picks a server for a new job.
+enum class SchedulingPolicy {
+    LeastLoaded        = 0, // lowest runningJobs / maxJobs
+    ExpectedCompletion = 1, // lowest estimated time to finish (cost model)
 };
 
 struct ServerInfo {
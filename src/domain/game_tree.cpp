@@ -0,0 +1,283 @@
+#include "domain/game_tree.hpp"
+
+#include "domain/chess/SanLexer.hpp"
+#include "domain/chess_san_to_fen.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace sf::client::domain::chess {
+
+namespace {
+
+std::string_view trimmed(std::string_view s) {
+    const auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+std::uint16_t clampU16(int v) {
+    return static_cast<std::uint16_t>(std::clamp(v, 0, 0xFFFF));
+}
+
+} // namespace
+
+GameTree::GameTree(const Position& start)
+    : startFullmove_(start.fullmoveNumber())
+    , startBlack_(start.sideToMove() == Color::Black) {
+    PlyRecord root;
+    root.position = internPosition(start);
+    root.halfmove = clampU16(start.halfmoveClock());
+    positions_[root.position].firstPly = kRoot;
+    plies_.push_back(root);
+}
+
+std::optional<GameTree> GameTree::fromMovetext(std::string_view movetext,
+                                               const Position& start,
+                                               std::string* error) {
+    const auto fail = [&](std::string what) -> std::optional<GameTree> {
+        if (error) *error = std::move(what);
+        return std::nullopt;
+    };
+
+    GameTree tree(start);
+    SanLexer lexer(movetext);
+    SanToken token;
+    std::vector<PlyId> resumeAt; // per open variation: the ply it branched off after
+    PlyId cur = kRoot;
+    Position pos = start;
+    // A move right after another one continues its line; the first move
+    // of a variation is an alternative. (A variation may repeat the move
+    // it replaces, so its continuation can arrive before the main one.)
+    bool continuesLine = true;
+
+    while (lexer.next(token)) {
+        switch (token.kind) {
+            case SanTokenKind::Move: {
+                std::string err;
+                const auto mv = sanToMove(pos, std::string(token.text), &err);
+                if (!mv) {
+                    return fail(err + " (move #" + std::to_string(lexer.tokenNumber()) + ": '"
+                                + std::string(token.text) + "')");
+                }
+                if (!pos.applyMove(*mv)) {
+                    return fail("Failed to apply move '" + std::string(token.text) + "'");
+                }
+                const PackedMove packed = packMove(*mv);
+                const PlyId existing = tree.findChild(cur, packed);
+                if (existing == kNone) {
+                    cur = tree.appendPly(cur, pos, packed, token.text, continuesLine);
+                } else {
+                    if (continuesLine) tree.makeMainContinuation(existing);
+                    cur = existing;
+                }
+                continuesLine = true;
+                break;
+            }
+            case SanTokenKind::Comment:
+                tree.appendComment(cur, trimmed(token.text));
+                break;
+            case SanTokenKind::Nag: {
+                int nag = 0;
+                for (const char c : token.text) nag = std::min(nag * 10 + (c - '0'), 255);
+                if (tree.plies_[cur].nag == 0) tree.plies_[cur].nag = static_cast<std::uint8_t>(nag);
+                break;
+            }
+            case SanTokenKind::VariationStart:
+                // The variation replaces the move just played.
+                if (cur == kRoot) {
+                    return fail("Variation before the first move");
+                }
+                resumeAt.push_back(cur);
+                cur = tree.parent(cur);
+                pos = tree.position(cur);
+                continuesLine = false;
+                break;
+            case SanTokenKind::VariationEnd:
+                if (resumeAt.empty()) {
+                    return fail("Unbalanced ')' after move #" + std::to_string(lexer.tokenNumber()));
+                }
+                cur = resumeAt.back();
+                resumeAt.pop_back();
+                pos = tree.position(cur);
+                continuesLine = true;
+                break;
+        }
+    }
+    // Variations left open at the end (truncated text) are kept as they are.
+    return tree;
+}
+
+GameTree::PlyId GameTree::findChild(PlyId ply, PackedMove move) const noexcept {
+    for (PlyId c = plies_[ply].firstChild; c != kNone; c = plies_[c].nextSibling) {
+        if (plies_[c].move == move) return c;
+    }
+    return kNone;
+}
+
+GameTree::PlyId GameTree::lineEnd(PlyId ply) const noexcept {
+    while (plies_[ply].firstChild != kNone) ply = plies_[ply].firstChild;
+    return ply;
+}
+
+bool GameTree::isMainLine(PlyId ply) const noexcept {
+    for (; ply != kRoot; ply = plies_[ply].parent) {
+        if (plies_[plies_[ply].parent].firstChild != ply) return false;
+    }
+    return true;
+}
+
+int GameTree::moveNumber(PlyId ply) const noexcept {
+    const int halfMoves = std::max(0, depth(ply) - 1) + (startBlack_ ? 1 : 0);
+    return startFullmove_ + halfMoves / 2;
+}
+
+bool GameTree::isWhiteMove(PlyId ply) const noexcept {
+    const int halfMoves = std::max(0, depth(ply) - 1) + (startBlack_ ? 1 : 0);
+    return halfMoves % 2 == 0;
+}
+
+std::string_view GameTree::san(PlyId ply) const noexcept {
+    const PlyRecord& r = plies_[ply];
+    return std::string_view(text_).substr(r.sanOffset, r.sanSize);
+}
+
+std::string_view GameTree::comment(PlyId ply) const noexcept {
+    const PlyRecord& r = plies_[ply];
+    return std::string_view(text_).substr(r.commentOffset, r.commentSize);
+}
+
+Position GameTree::position(PlyId ply) const {
+    const PlyRecord& r = plies_[ply];
+    PackedPosition packed = positions_[r.position].packed;
+    packed.halfmove = r.halfmove;
+    packed.fullmove = clampU16(startFullmove_ + (r.depth + (startBlack_ ? 1 : 0)) / 2);
+    return Position::unpack(packed);
+}
+
+std::optional<GameTree::PositionId> GameTree::findPosition(std::uint64_t key) const {
+    const auto it = byKey_.find(key);
+    if (it == byKey_.end()) return std::nullopt;
+    return it->second;
+}
+
+GameTree::PlyId GameTree::addMove(PlyId ply, PackedMove move) {
+    if (const PlyId existing = findChild(ply, move); existing != kNone) {
+        return existing;
+    }
+    Position pos = position(ply);
+    const auto mv = pos.findLegalPacked(move);
+    if (!mv) return kNone;
+    const std::string san = moveToSan(pos, *mv);
+    if (!pos.applyMove(*mv)) return kNone;
+    return appendPly(ply, pos, move, san, false);
+}
+
+GameTree::PlyId GameTree::addLine(PlyId ply, const MoveLine& line) {
+    for (const PackedMove m : line) {
+        const PlyId next = addMove(ply, m);
+        if (next == kNone) break;
+        ply = next;
+    }
+    return ply;
+}
+
+bool GameTree::mergeEval(std::uint64_t key, const JobSnapshot& snapshot) {
+    const auto it = byKey_.find(key);
+    if (it == byKey_.end() || snapshot.score.type == ScoreType::None) {
+        return false;
+    }
+    const int depth = snapshot.depth.value_or(0);
+    PositionRecord& r = positions_[it->second];
+    if (r.eval == kNone) {
+        r.eval = static_cast<std::uint32_t>(evals_.size());
+        evals_.emplace_back();
+    } else if (evals_[r.eval].depth > depth) {
+        return false;
+    }
+    Eval& e = evals_[r.eval];
+    e.depth = depth;
+    e.score = snapshot.score;
+    e.nodes = snapshot.nodes;
+    e.pv    = snapshot.pv;
+    return true;
+}
+
+const GameTree::Eval* GameTree::eval(PlyId ply) const noexcept {
+    const std::uint32_t i = positions_[plies_[ply].position].eval;
+    return i == kNone ? nullptr : &evals_[i];
+}
+
+GameTree::PlyId GameTree::appendPly(PlyId ply, const Position& after, PackedMove move, std::string_view san,
+                                    bool asMain) {
+    const PlyId id = static_cast<PlyId>(plies_.size());
+    san = san.substr(0, std::numeric_limits<std::uint8_t>::max());
+
+    PlyRecord r;
+    r.parent    = ply;
+    r.position  = internPosition(after);
+    r.sanOffset = static_cast<std::uint32_t>(text_.size());
+    r.sanSize   = static_cast<std::uint8_t>(san.size());
+    r.move      = move;
+    r.depth     = clampU16(plies_[ply].depth + 1);
+    r.halfmove  = clampU16(after.halfmoveClock());
+    r.nextAtPosition = positions_[r.position].firstPly;
+    text_.append(san);
+    plies_.push_back(r);
+
+    positions_[r.position].firstPly = id;
+    PlyRecord& parent = plies_[ply];
+    if (parent.lastChild == kNone) {
+        parent.firstChild = id;
+    } else {
+        plies_[parent.lastChild].nextSibling = id;
+    }
+    parent.lastChild = id;
+    if (asMain) {
+        makeMainContinuation(id);
+    }
+    return id;
+}
+
+void GameTree::makeMainContinuation(PlyId child) {
+    PlyRecord& parent = plies_[plies_[child].parent];
+    if (parent.firstChild == child) return;
+    PlyId prev = parent.firstChild;
+    while (plies_[prev].nextSibling != child) prev = plies_[prev].nextSibling;
+    plies_[prev].nextSibling = plies_[child].nextSibling;
+    if (parent.lastChild == child) parent.lastChild = prev;
+    plies_[child].nextSibling = parent.firstChild;
+    parent.firstChild = child;
+}
+
+GameTree::PositionId GameTree::internPosition(const Position& pos) {
+    const auto [it, inserted] = byKey_.try_emplace(pos.key(), static_cast<PositionId>(positions_.size()));
+    if (inserted) {
+        PositionRecord r;
+        r.packed = pos.pack();
+        r.key    = pos.key();
+        positions_.push_back(r);
+    }
+    return it->second;
+}
+
+void GameTree::appendComment(PlyId ply, std::string_view text) {
+    if (text.empty()) return;
+    PlyRecord& r = plies_[ply];
+    if (r.commentSize == 0) {
+        r.commentOffset = static_cast<std::uint32_t>(text_.size());
+    } else if (r.commentOffset + r.commentSize != text_.size()) {
+        // Not the last slice: move it to the end so it can grow.
+        const std::string old = text_.substr(r.commentOffset, r.commentSize);
+        r.commentOffset = static_cast<std::uint32_t>(text_.size());
+        text_.append(old);
+    }
+    if (r.commentSize > 0) {
+        text_.push_back(' ');
+    }
+    text_.append(text);
+    r.commentSize = static_cast<std::uint32_t>(text_.size() - r.commentOffset);
+}
+
+} // namespace sf::client::domain::chess
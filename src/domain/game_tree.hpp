@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/chess/MoveLine.hpp"
+#include "domain/chess/PackedMove.hpp"
+#include "domain/chess/PackedPosition.hpp"
+#include "domain/chess/Position.hpp"
+#include "domain/domain_model.hpp"
+
+namespace sf::client::domain::chess {
+
+// A game with its variations, comments and NAGs, plus the engine results
+// gathered for its positions.
+//
+// Everything lives in two arenas of fixed-size records addressed by 32-bit
+// index, so nothing points into them and they grow by plain reallocation:
+//  - plies: the move tree (move, parent, first child, next sibling, SAN and
+//    comment as slices of one text buffer);
+//  - positions: one packed position per Zobrist key. Plies that reach the
+//    same position by transposition share it, and with it the evaluation
+//    merged from any job that searched that position.
+//
+// Parent, child and sibling steps, adding a move and the FEN and key of a
+// ply are O(1) in the size of the tree. The first child of a ply is its
+// main continuation; later children are variations. Not thread-safe.
+class GameTree {
+public:
+    using PlyId      = std::uint32_t;
+    using PositionId = std::uint32_t;
+
+    static constexpr PlyId kNone = 0xFFFFFFFFu;
+    static constexpr PlyId kRoot = 0; // the start position; has no move
+
+    // Deepest result merged for a position (see mergeEval()).
+    struct Eval {
+        int                    depth{0};
+        Score                  score;
+        std::optional<int64_t> nodes;
+        MoveLine               pv;
+    };
+
+    explicit GameTree(const Position& start = Position::startpos());
+
+    // Parses movetext with nested variations "(...)", comments and NAGs.
+    // A comment or NAG belongs to the move before it (comments before the
+    // first move to the root); a variation that repeats the move it
+    // replaces merges into it. nullopt on a move that does not parse or is
+    // not legal in its line; error (if given) then says which.
+    static std::optional<GameTree> fromMovetext(std::string_view movetext,
+                                                const Position& start,
+                                                std::string* error = nullptr);
+
+    // ---- Navigation ----
+    PlyId parent(PlyId ply) const noexcept { return plies_[ply].parent; }
+    PlyId firstChild(PlyId ply) const noexcept { return plies_[ply].firstChild; }
+    PlyId nextSibling(PlyId ply) const noexcept { return plies_[ply].nextSibling; }
+    // Child of ply playing move, kNone if there is none yet.
+    PlyId findChild(PlyId ply, PackedMove move) const noexcept;
+    // Last ply of the main continuation from ply (ply itself if it has none).
+    PlyId lineEnd(PlyId ply) const noexcept;
+
+    // True on the game's main line (the root included); O(depth).
+    bool isMainLine(PlyId ply) const noexcept;
+    // Plies from the start position: 0 for the root, 1 for the first move.
+    int depth(PlyId ply) const noexcept { return plies_[ply].depth; }
+    // PGN move number of the move at ply ("12" in "12... Nf6").
+    int moveNumber(PlyId ply) const noexcept;
+    bool isWhiteMove(PlyId ply) const noexcept;
+
+    // ---- Per ply ----
+    PackedMove move(PlyId ply) const noexcept { return plies_[ply].move; }
+    // As written in the movetext, or generated for added moves.
+    std::string_view san(PlyId ply) const noexcept;
+    std::string_view comment(PlyId ply) const noexcept;
+    int nag(PlyId ply) const noexcept { return plies_[ply].nag; } // 0 = none
+
+    PositionId positionOf(PlyId ply) const noexcept { return plies_[ply].position; }
+    // Zobrist key after the move (counters excluded).
+    std::uint64_t key(PlyId ply) const noexcept { return positions_[plies_[ply].position].key; }
+    // The position after the move, with this line's move counters.
+    Position position(PlyId ply) const;
+    std::string fen(PlyId ply) const { return position(ply).toFen(); }
+
+    // Plies in the tree, the root included; ids run from 0 to plyCount()-1.
+    std::size_t plyCount() const noexcept { return plies_.size(); }
+    std::size_t positionCount() const noexcept { return positions_.size(); }
+
+    // Other plies that reach the same position; iterate until kNone.
+    PlyId firstPlyAt(PositionId position) const noexcept { return positions_[position].firstPly; }
+    PlyId nextPlyAtSamePosition(PlyId ply) const noexcept { return plies_[ply].nextAtPosition; }
+
+    // Position with that key, if any ply reaches it.
+    std::optional<PositionId> findPosition(std::uint64_t key) const;
+
+    // ---- Editing ----
+    // Plays move after ply, as a new last variation unless that move is
+    // already there (then returns the existing child). kNone if the move is
+    // not legal there.
+    PlyId addMove(PlyId ply, PackedMove move);
+    // Adds the moves of line (an engine PV) one after the other; returns the
+    // last ply reached, stopping before the first illegal move.
+    PlyId addLine(PlyId ply, const MoveLine& line);
+
+    // ---- Engine results ----
+    // Keeps the snapshot's depth, score and PV for the position with key
+    // if it is at least as deep as what is there. False if no ply reaches
+    // that position, the snapshot has no score, or it is shallower.
+    bool mergeEval(std::uint64_t key, const JobSnapshot& snapshot);
+    const Eval* eval(PlyId ply) const noexcept;
+
+private:
+    struct PlyRecord {
+        PlyId         parent{kNone};
+        PlyId         firstChild{kNone};
+        PlyId         lastChild{kNone};
+        PlyId         nextSibling{kNone};
+        PlyId         nextAtPosition{kNone};
+        PositionId    position{0};
+        std::uint32_t sanOffset{0};
+        std::uint32_t commentOffset{0};
+        std::uint32_t commentSize{0};
+        PackedMove    move{kNullPackedMove};
+        std::uint16_t depth{0};
+        std::uint16_t halfmove{0}; // this line's clock; positions keep the first
+        std::uint8_t  sanSize{0};
+        std::uint8_t  nag{0};
+    };
+
+    struct PositionRecord {
+        PackedPosition packed;
+        std::uint64_t  key{0};
+        PlyId          firstPly{kNone};
+        std::uint32_t  eval{kNone}; // index into evals_
+    };
+
+    // after is the position once move has been played from ply's position.
+    // The new ply becomes ply's main continuation if asMain, else its last
+    // variation.
+    PlyId appendPly(PlyId ply, const Position& after, PackedMove move, std::string_view san, bool asMain);
+    void makeMainContinuation(PlyId child);
+    PositionId internPosition(const Position& pos);
+    void appendComment(PlyId ply, std::string_view text);
+
+    std::vector<PlyRecord>                       plies_;
+    std::vector<PositionRecord>                  positions_;
+    std::vector<Eval>                            evals_;
+    std::string                                  text_; // SAN and comments
+    std::unordered_map<std::uint64_t, PositionId> byKey_;
+    int                                          startFullmove_{1};
+    bool                                         startBlack_{false};
+};
+
+} // namespace sf::client::domain::chess
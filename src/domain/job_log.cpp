@@ -0,0 +1,135 @@
+#include "domain/job_log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace sf::client::domain {
+
+namespace {
+
+// Evicted lines are written in batches of about this size.
+constexpr std::size_t kSpillBatchBytes = 64 * 1024;
+
+const std::deque<std::string>& emptyLines() {
+    static const std::deque<std::string> empty;
+    return empty;
+}
+
+} // namespace
+
+JobLog::State::~State() {
+    writeSpill();
+}
+
+void JobLog::State::evictOverflow() {
+    const std::size_t cap = std::max<std::size_t>(1, options.capacity);
+    while (lines.size() > cap) {
+        if (!options.spillPath.empty()) {
+            spillBuffer += lines.front();
+            spillBuffer += '\n';
+        }
+        textBytes -= lines.front().size();
+        lines.pop_front();
+        ++firstSeq;
+    }
+    if (spillBuffer.size() >= kSpillBatchBytes) {
+        writeSpill();
+    }
+}
+
+void JobLog::State::writeSpill() {
+    if (spillBuffer.empty() || options.spillPath.empty()) {
+        spillBuffer.clear();
+        return;
+    }
+    // Opened per batch: finished jobs must not pin file handles.
+    if (std::FILE* f = std::fopen(options.spillPath.c_str(), "ab")) {
+        std::fwrite(spillBuffer.data(), 1, spillBuffer.size(), f);
+        std::fclose(f);
+    }
+    spillBuffer.clear();
+}
+
+JobLog::State& JobLog::state() {
+    if (!state_) {
+        state_ = std::make_shared<State>();
+    }
+    return *state_;
+}
+
+void JobLog::configure(JobLogOptions options) {
+    State& s = state();
+    if (s.options.spillPath != options.spillPath) {
+        s.writeSpill();
+    }
+    s.options = std::move(options);
+    s.evictOverflow();
+}
+
+void JobLog::push_back(std::string line) {
+    State& s = state();
+    s.textBytes += line.size();
+    s.lines.push_back(std::move(line));
+    s.evictOverflow();
+}
+
+void JobLog::append(const std::vector<std::string>& lines) {
+    if (lines.empty()) {
+        return;
+    }
+    State& s = state();
+    for (const auto& line : lines) {
+        s.textBytes += line.size();
+    }
+    s.lines.insert(s.lines.end(), lines.begin(), lines.end());
+    s.evictOverflow();
+}
+
+void JobLog::assign(const std::vector<std::string>& lines) {
+    State& s = state();
+    s.firstSeq += s.lines.size(); // old lines are gone; numbering continues
+    s.lines.clear();
+    s.textBytes = 0;
+    ++s.epoch;
+    append(lines);
+}
+
+void JobLog::clear() {
+    assign({});
+}
+
+JobLog::const_iterator JobLog::begin() const {
+    return state_ ? state_->lines.begin() : emptyLines().begin();
+}
+
+JobLog::const_iterator JobLog::end() const {
+    return state_ ? state_->lines.end() : emptyLines().end();
+}
+
+JobLog::const_iterator JobLog::fromSeq(std::uint64_t seq) const {
+    if (!state_ || seq <= state_->firstSeq) {
+        return begin();
+    }
+    if (seq >= endSeq()) {
+        return end();
+    }
+    return state_->lines.begin() + static_cast<std::ptrdiff_t>(seq - state_->firstSeq);
+}
+
+std::size_t JobLog::byteSize() const {
+    if (!state_) {
+        return 0;
+    }
+    // Short lines live in the string's own buffer; counting every
+    // character over-estimates those a little, which is fine for a budget.
+    return sizeof(State) + state_->lines.size() * sizeof(std::string) + state_->textBytes
+         + state_->spillBuffer.capacity();
+}
+
+void JobLog::flushSpill() const {
+    if (state_) {
+        state_->writeSpill();
+    }
+}
+
+} // namespace sf::client::domain
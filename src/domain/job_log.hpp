@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sf::client::domain {
+
+struct JobLogOptions {
+    static constexpr std::size_t kDefaultCapacity = 5000;
+
+    std::size_t capacity{kDefaultCapacity};
+    std::string spillPath; // evicted lines are appended here; empty = discard them
+};
+
+// Per-job engine log: a fixed-capacity ring of the newest lines.
+//
+// Every line gets a sequence number (monotonic for the lifetime of the log),
+// so views can append only what they have not shown yet; see firstSeq(),
+// endSeq() and epoch(). Lines evicted from the ring are optionally written
+// to a spill file in batches.
+//
+// JobLog is a handle: copies of a Job share one log, which makes the Job
+// copies handed to models and callbacks cheap. Not thread-safe.
+class JobLog {
+public:
+    using const_iterator = std::deque<std::string>::const_iterator;
+
+    JobLog() = default;
+
+    // Applies to this log (and every copy sharing it); keeps the newest lines.
+    void configure(JobLogOptions options);
+
+    void push_back(std::string line);
+    void append(const std::vector<std::string>& lines);
+
+    // Replaces the content (e.g. with a server-side tail) and bumps epoch().
+    void assign(const std::vector<std::string>& lines);
+    void clear();
+
+    bool empty() const { return size() == 0; }
+    std::size_t size() const { return state_ ? state_->lines.size() : 0; }
+    // Approximate heap use of the retained lines and the spill buffer.
+    std::size_t byteSize() const;
+
+    std::uint64_t firstSeq() const { return state_ ? state_->firstSeq : 0; } // oldest retained line
+    std::uint64_t endSeq() const { return firstSeq() + size(); }            // next line's number
+    std::uint64_t epoch() const { return state_ ? state_->epoch : 0; }      // bumped by assign()/clear()
+
+    // True if both handles refer to the same underlying log.
+    bool sharesStateWith(const JobLog& other) const { return state_ && state_ == other.state_; }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    // First retained line with sequence number >= seq.
+    const_iterator fromSeq(std::uint64_t seq) const;
+
+    // Writes buffered evicted lines to the spill file now. Const because
+    // it changes no visible content.
+    void flushSpill() const;
+
+private:
+    struct State {
+        ~State();
+
+        JobLogOptions           options;
+        std::deque<std::string> lines;
+        std::uint64_t           firstSeq{0};
+        std::uint64_t           epoch{0};
+        std::size_t             textBytes{0}; // characters in lines
+        std::string             spillBuffer;
+
+        void evictOverflow();
+        void writeSpill();
+    };
+
+    State& state();
+
+    std::shared_ptr<State> state_; // allocated on first write
+};
+
+} // namespace sf::client::domain
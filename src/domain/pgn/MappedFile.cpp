@@ -0,0 +1,153 @@
+#include "domain/pgn/MappedFile.hpp"
+
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sf::client::domain::pgn {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        open_ = std::exchange(other.open_, false);
+#if defined(_WIN32)
+        file_ = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& filePath, std::string* errorOut, Access access) {
+    close();
+
+    const int wlen = MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, nullptr, 0);
+    std::wstring wpath(static_cast<std::size_t>(wlen > 0 ? wlen : 1), L'\0');
+    if (wlen > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, wpath.data(), wlen);
+    }
+
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING,
+                              access == Access::Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        if (errorOut) *errorOut = "Cannot open PGN file";
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        if (errorOut) *errorOut = "Cannot stat PGN file";
+        return false;
+    }
+
+    file_ = file;
+    open_ = true;
+    if (size.QuadPart == 0) {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        if (errorOut) *errorOut = "Cannot map PGN file";
+        return false;
+    }
+    const void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!p) {
+        CloseHandle(mapping);
+        close();
+        if (errorOut) *errorOut = "Cannot map PGN file";
+        return false;
+    }
+
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(p);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(static_cast<HANDLE>(mapping_));
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    file_ = nullptr;
+    mapping_ = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filePath, std::string* errorOut, Access access) {
+    close();
+
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errorOut) *errorOut = "Cannot open PGN file";
+        return false;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        if (errorOut) *errorOut = "Cannot stat PGN file";
+        return false;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size > 0) {
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            if (errorOut) *errorOut = "Cannot map PGN file";
+            return false;
+        }
+        ::madvise(p, size, access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+        size_ = size;
+    }
+
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
+
+} // namespace sf::client::domain::pgn
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace sf::client::domain::pgn {
+
+// Read-only memory mapping of a whole file (POSIX mmap / Win32 file mapping).
+//
+// By default the mapping is advised for sequential access so the kernel
+// reads ahead aggressively; lookup structures ask for Random instead. Pages
+// are shared with the page cache, nothing is copied. An empty file maps
+// successfully to an empty view.
+class MappedFile {
+public:
+    enum class Access { Sequential, Random };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& filePath, std::string* errorOut = nullptr, Access access = Access::Sequential);
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    bool open_{false};
+#if defined(_WIN32)
+    void* file_{nullptr};
+    void* mapping_{nullptr};
+#endif
+};
+
+} // namespace sf::client::domain::pgn
@@ -0,0 +1,121 @@
+#include "domain/pgn/PgnSimd.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SF_PGN_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SF_PGN_SIMD_SSE2 1
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SF_PGN_SIMD_NEON 1
+#endif
+
+namespace sf::client::domain::pgn::simd {
+
+namespace {
+
+#if defined(SF_PGN_SIMD_AVX2)
+
+inline void classify32(const char* p, std::uint32_t& nl, std::uint32_t& sp, std::uint32_t& br) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    // Whitespace: ' ' or '\t'..'\r' (unsigned (c - 9) <= 4).
+    const __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    const __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    const __m256i space = _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    nl = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+    sp = static_cast<std::uint32_t>(_mm256_movemask_epi8(space));
+    br = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('['))));
+}
+
+#elif defined(SF_PGN_SIMD_SSE2)
+
+inline void classify16(const char* p, std::uint32_t& nl, std::uint32_t& sp, std::uint32_t& br) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    const __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    const __m128i space = _mm_or_si128(ctrl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    nl = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    sp = static_cast<std::uint32_t>(_mm_movemask_epi8(space));
+    br = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('['))));
+}
+
+#elif defined(SF_PGN_SIMD_NEON)
+
+// NEON has no movemask: weight each lane by its bit and add pairwise
+// (vpaddq_u8 is AArch64-only, hence the __aarch64__ guard above).
+inline std::uint32_t movemask16(uint8x16_t m) {
+    static const uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(m, vld1q_u8(kWeights));
+    uint8x16_t sum = vpaddq_u8(bits, bits);
+    sum = vpaddq_u8(sum, sum);
+    sum = vpaddq_u8(sum, sum);
+    return static_cast<std::uint32_t>(vgetq_lane_u8(sum, 0)) |
+           (static_cast<std::uint32_t>(vgetq_lane_u8(sum, 1)) << 8);
+}
+
+inline void classify16(const char* p, std::uint32_t& nl, std::uint32_t& sp, std::uint32_t& br) {
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    const uint8x16_t ctrl = vcleq_u8(vsubq_u8(v, vdupq_n_u8('\t')), vdupq_n_u8(4));
+    const uint8x16_t space = vorrq_u8(ctrl, vceqq_u8(v, vdupq_n_u8(' ')));
+    nl = movemask16(vceqq_u8(v, vdupq_n_u8('\n')));
+    sp = movemask16(space);
+    br = movemask16(vceqq_u8(v, vdupq_n_u8('[')));
+}
+
+#endif
+
+} // namespace
+
+BlockMasks classifyBlockScalar(const char* p) {
+    BlockMasks m;
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+        const unsigned char c = static_cast<unsigned char>(p[i]);
+        const std::uint64_t bit = 1ull << i;
+        if (c == '\n') m.newline |= bit;
+        if (!isSpaceByte(static_cast<char>(c))) m.nonSpace |= bit;
+        if (c == '[') m.bracket |= bit;
+    }
+    return m;
+}
+
+BlockMasks classifyBlock(const char* p) {
+#if defined(SF_PGN_SIMD_AVX2)
+    std::uint32_t nl0, sp0, br0, nl1, sp1, br1;
+    classify32(p, nl0, sp0, br0);
+    classify32(p + 32, nl1, sp1, br1);
+    BlockMasks m;
+    m.newline = nl0 | (static_cast<std::uint64_t>(nl1) << 32);
+    m.nonSpace = ~(sp0 | (static_cast<std::uint64_t>(sp1) << 32));
+    m.bracket = br0 | (static_cast<std::uint64_t>(br1) << 32);
+    return m;
+#elif defined(SF_PGN_SIMD_SSE2) || defined(SF_PGN_SIMD_NEON)
+    BlockMasks m;
+    std::uint64_t sp = 0;
+    for (int i = 0; i < 4; ++i) {
+        std::uint32_t nl16, sp16, br16;
+        classify16(p + 16 * i, nl16, sp16, br16);
+        m.newline |= static_cast<std::uint64_t>(nl16) << (16 * i);
+        sp |= static_cast<std::uint64_t>(sp16) << (16 * i);
+        m.bracket |= static_cast<std::uint64_t>(br16) << (16 * i);
+    }
+    m.nonSpace = ~sp;
+    return m;
+#else
+    return classifyBlockScalar(p);
+#endif
+}
+
+const char* kernelName() {
+#if defined(SF_PGN_SIMD_AVX2)
+    return "avx2";
+#elif defined(SF_PGN_SIMD_SSE2)
+    return "sse2";
+#elif defined(SF_PGN_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace sf::client::domain::pgn::simd
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace sf::client::domain::pgn::simd {
+
+// Per-byte classification of one 64-byte block; bit i describes byte i.
+struct BlockMasks {
+    std::uint64_t newline{0};  // '\n'
+    std::uint64_t nonSpace{0}; // not isspace() in the "C" locale (' ', \t \n \v \f \r)
+    std::uint64_t bracket{0};  // '[' (a tag line starts at a line's first non-space '[')
+};
+
+constexpr std::size_t kBlockSize = 64;
+
+// isspace() of the "C" locale, the definition the kernels implement.
+inline bool isSpaceByte(char c) {
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u == ' ' || static_cast<unsigned char>(u - '\t') <= ('\r' - '\t');
+}
+
+// Vector kernel selected at compile time (AVX2, SSE2 or NEON); falls back
+// to classifyBlockScalar() on other targets. Reads exactly 64 bytes.
+BlockMasks classifyBlock(const char* p);
+BlockMasks classifyBlockScalar(const char* p);
+
+// "avx2", "sse2", "neon" or "scalar".
+const char* kernelName();
+
+inline int countTrailingZeros(std::uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, x);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Walks a buffer block by block, caching the masks of the current block.
+// The tail (< 64 bytes) is classified from a zero-padded copy and masked to
+// the valid length, so no byte past the end is ever read.
+template <BlockMasks (*Classify)(const char*)>
+class BasicBlockCursor {
+public:
+    BasicBlockCursor(const char* data, std::size_t size) : data_(data), size_(size) {}
+
+    // First byte in [pos, end) whose bit in `field` is set, or end.
+    std::size_t find(std::size_t pos, std::size_t end, std::uint64_t BlockMasks::*field) {
+        while (pos < end) {
+            const std::size_t blk = pos & ~(kBlockSize - 1);
+            load(blk);
+            const std::uint64_t bits = (masks_.*field) >> (pos - blk);
+            if (bits) {
+                const std::size_t hit = pos + static_cast<std::size_t>(countTrailingZeros(bits));
+                return (hit < end) ? hit : end;
+            }
+            pos = blk + kBlockSize;
+        }
+        return end;
+    }
+
+    std::size_t nextNewline(std::size_t pos) { return find(pos, size_, &BlockMasks::newline); }
+    std::size_t firstNonSpace(std::size_t pos, std::size_t end) { return find(pos, end, &BlockMasks::nonSpace); }
+
+    bool isBracket(std::size_t pos) {
+        const std::size_t blk = pos & ~(kBlockSize - 1);
+        load(blk);
+        return ((masks_.bracket >> (pos - blk)) & 1u) != 0;
+    }
+
+private:
+    void load(std::size_t blk) {
+        if (blk == loaded_) return;
+        loaded_ = blk;
+        if (blk + kBlockSize <= size_) {
+            masks_ = Classify(data_ + blk);
+            return;
+        }
+        char tail[kBlockSize] = {};
+        const std::size_t n = size_ - blk;
+        for (std::size_t i = 0; i < n; ++i) tail[i] = data_[blk + i];
+        masks_ = Classify(tail);
+        const std::uint64_t valid = (n >= 64) ? ~0ull : ((1ull << n) - 1);
+        masks_.newline &= valid;
+        masks_.nonSpace &= valid;
+        masks_.bracket &= valid;
+    }
+
+    const char* data_;
+    std::size_t size_;
+    std::size_t loaded_{~std::size_t{0}};
+    BlockMasks masks_{};
+};
+
+using BlockCursor = BasicBlockCursor<&classifyBlock>;
+using ScalarBlockCursor = BasicBlockCursor<&classifyBlockScalar>;
+
+} // namespace sf::client::domain::pgn::simd
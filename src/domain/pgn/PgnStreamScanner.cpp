@@ -1,50 +1,60 @@
 #include "domain/pgn/PgnStreamScanner.hpp"
 
-#include <cctype>
-#include <fstream>
-#include <string_view>
+#include "domain/pgn/MappedFile.hpp"
+#include "domain/pgn/PgnSimd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 
 namespace sf::client::domain::pgn {
 
 namespace {
 
-static inline bool isBlankLine(const std::string& s) {
-    for (unsigned char c : s) {
-        if (!std::isspace(c)) return false;
+// Same whitespace definition as the block kernels, independent of the
+// process locale.
+static inline bool isSpace(char c) {
+    return simd::isSpaceByte(c);
+}
+
+static inline bool isBlankLine(std::string_view s) {
+    for (char c : s) {
+        if (!isSpace(c)) return false;
     }
     return true;
 }
 
-static inline void rstripCr(std::string& s) {
-    if (!s.empty() && s.back() == '\r') s.pop_back();
+static inline void rstripCr(std::string_view& s) {
+    if (!s.empty() && s.back() == '\r') s.remove_suffix(1);
 }
 
-static inline std::string ltrimCopy(std::string_view s) {
-    size_t i = 0;
-    while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
-    return std::string(s.substr(i));
+static inline std::size_t leadingSpaces(std::string_view s) {
+    std::size_t i = 0;
+    while (i < s.size() && isSpace(s[i])) ++i;
+    return i;
 }
 
-static bool parseTagLine(const std::string& line, std::string& outKey, std::string& outVal) {
+static bool parseTagLine(std::string_view line, PgnTagView& out) {
     // Minimal PGN tag parser: [Key "Value"]  (supports \" escapes)
     if (line.size() < 4) return false;
     if (line.front() != '[' || line.back() != ']') return false;
 
-    std::string_view mid(line.data() + 1, line.size() - 2);
+    const std::string_view mid = line.substr(1, line.size() - 2);
 
     // key until first whitespace
-    size_t sp = 0;
-    while (sp < mid.size() && !std::isspace(static_cast<unsigned char>(mid[sp]))) ++sp;
+    std::size_t sp = 0;
+    while (sp < mid.size() && !isSpace(mid[sp])) ++sp;
     if (sp == 0 || sp >= mid.size()) return false;
 
-    outKey = std::string(mid.substr(0, sp));
-
     // find first quote after key
-    size_t q1 = mid.find('"', sp);
+    const std::size_t q1 = mid.find('"', sp);
     if (q1 == std::string_view::npos) return false;
 
     // find closing quote, respecting escapes
-    size_t q2 = q1 + 1;
+    std::size_t q2 = q1 + 1;
     bool escaped = false;
     while (q2 < mid.size()) {
         const char c = mid[q2];
@@ -59,188 +69,417 @@ static bool parseTagLine(const std::string& line, std::string& outKey, std::stri
     }
     if (q2 >= mid.size() || mid[q2] != '"') return false;
 
-    std::string raw(mid.substr(q1 + 1, q2 - (q1 + 1)));
-
-    std::string unescaped;
-    unescaped.reserve(raw.size());
-    escaped = false;
-    for (char c : raw) {
-        if (escaped) {
-            unescaped.push_back(c);
-            escaped = false;
-        } else if (c == '\\') {
-            escaped = true;
-        } else {
-            unescaped.push_back(c);
-        }
-    }
-
-    outVal = std::move(unescaped);
+    out.key = mid.substr(0, sp);
+    out.rawValue = mid.substr(q1 + 1, q2 - (q1 + 1));
     return true;
 }
 
-static inline void appendMovetext(std::string& dst, const std::string& line) {
-    if (dst.empty()) {
-        dst = line;
-    } else {
-        dst.push_back(' ');
-        dst += line;
-    }
-}
-
-static inline void finalizeGame(PgnStreamGame& g) {
-    // Trim trailing spaces in movetext.
-    while (!g.movetext.empty() && std::isspace(static_cast<unsigned char>(g.movetext.back()))) {
-        g.movetext.pop_back();
-    }
+static inline std::string_view trimTrailingSpace(std::string_view s) {
+    while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+    return s;
 }
 
-} // namespace
-
-PgnStreamScanResult scanPgnFile(
-    const std::string& filePath,
-    const std::function<bool(const PgnStreamGame&, std::uint64_t, std::string*)>& onGame,
-    int maxGames) {
-
+// Scans data; all reported offsets are shifted by baseOffset (the position
+// of data within the file). games == 0 is not an error here.
+PgnStreamScanResult scanRange(std::string_view data,
+                              std::uint64_t baseOffset,
+                              const PgnGameViewFn& onGame,
+                              int maxGames,
+                              PgnGameView& cur) {
     PgnStreamScanResult res;
+    res.ok = true;
 
-    std::ifstream in(filePath, std::ios::binary);
-    if (!in.is_open()) {
-        res.ok = false;
-        res.error = "Cannot open PGN file";
-        return res;
-    }
+    const char* const base = data.data();
+    const std::size_t size = data.size();
 
-    // file size
-    in.seekg(0, std::ios::end);
-    const std::uint64_t fileSize = static_cast<std::uint64_t>(in.tellg());
-    in.seekg(0, std::ios::beg);
-
-    PgnStreamGame cur;
     bool inGame = false;
     bool haveMovetext = false;
+    std::size_t movetextBegin = 0;
+    std::size_t movetextEnd = 0;
 
-    std::string line;
-    bool firstLine = true;
-
-    std::uint64_t lastAfter = 0;
+    // Emits the collected game; sets *stop when scanning must end.
+    auto emit = [&](std::uint64_t offsetEnd, bool* stop) {
+        cur.offsetEnd = baseOffset + offsetEnd;
+        cur.movetext = haveMovetext
+            ? trimTrailingSpace(std::string_view(base + movetextBegin, movetextEnd - movetextBegin))
+            : std::string_view{};
 
-    while (true) {
-        const auto startPos = in.tellg();
-        if (startPos < 0) break;
-
-        const std::uint64_t lineStart = static_cast<std::uint64_t>(startPos);
-
-        if (!std::getline(in, line)) {
-            break;
+        std::string cbErr;
+        const bool cont = onGame(cur, res.bytesProcessed, &cbErr);
+        if (!cbErr.empty()) {
+            res.ok = false;
+            res.error = cbErr;
+            *stop = true;
+            return;
         }
-
-        auto afterPos = in.tellg();
-        if (afterPos < 0) {
-            // likely EOF without trailing newline
-            lastAfter = fileSize;
-        } else {
-            lastAfter = static_cast<std::uint64_t>(afterPos);
+        ++res.games;
+        if (!cont || (maxGames > 0 && res.games >= maxGames)) {
+            *stop = true;
         }
-
-        if (firstLine) {
-            firstLine = false;
+    };
+
+    // Line splitting and whitespace trimming run on 64-byte block masks
+    // (see PgnSimd.hpp) instead of per-byte memchr/isspace calls.
+    simd::BlockCursor cursor(base, size);
+
+    std::size_t pos = 0;
+    while (pos < size) {
+        const std::size_t lineStart = pos;
+        std::size_t lineEnd = cursor.nextNewline(pos);
+        pos = (lineEnd < size) ? lineEnd + 1 : size;
+
+        std::size_t contentStart = lineStart;
+        if (baseOffset == 0 && lineStart == 0 && lineEnd >= 3 &&
+            static_cast<unsigned char>(base[0]) == 0xEF &&
+            static_cast<unsigned char>(base[1]) == 0xBB &&
+            static_cast<unsigned char>(base[2]) == 0xBF) {
             // Strip UTF-8 BOM if present.
-            if (line.size() >= 3 &&
-                static_cast<unsigned char>(line[0]) == 0xEF &&
-                static_cast<unsigned char>(line[1]) == 0xBB &&
-                static_cast<unsigned char>(line[2]) == 0xBF) {
-                line.erase(0, 3);
-            }
+            contentStart = 3;
         }
+        if (lineEnd > contentStart && base[lineEnd - 1] == '\r') --lineEnd;
 
-        rstripCr(line);
-
-        if (isBlankLine(line)) {
+        const std::size_t first = cursor.firstNonSpace(contentStart, lineEnd);
+        if (first == lineEnd) {
             // Blank line: may separate tags and movetext. Ignore.
-            res.bytesProcessed = lastAfter;
+            res.bytesProcessed = baseOffset + pos;
             continue;
         }
 
-        const std::string trimmed = ltrimCopy(line);
-        if (!trimmed.empty() && trimmed.front() == '[') {
-            std::string key, val;
-            if (!parseTagLine(trimmed, key, val)) {
+        const std::string_view trimmed(base + first, lineEnd - first);
+        if (cursor.isBracket(first)) {
+            PgnTagView tag;
+            if (!parseTagLine(trimmed, tag)) {
                 // Non-standard tag line; ignore.
-                res.bytesProcessed = lastAfter;
+                res.bytesProcessed = baseOffset + pos;
                 continue;
             }
 
+            if (inGame && haveMovetext) {
+                // New game's tag after movetext -> emit the current one.
+                bool stop = false;
+                emit(lineStart, &stop);
+                if (stop) return res;
+                inGame = false;
+            }
             if (!inGame) {
                 inGame = true;
                 haveMovetext = false;
-                cur = PgnStreamGame{};
-                cur.offsetStart = lineStart;
-            } else if (haveMovetext) {
-                // New game's tag after movetext -> finalize current and emit it.
-                cur.offsetEnd = lineStart;
-                finalizeGame(cur);
-
-                std::string cbErr;
-                const bool cont = onGame(cur, res.bytesProcessed, &cbErr);
-                if (!cbErr.empty()) {
-                    res.ok = false;
-                    res.error = cbErr;
-                    return res;
-                }
-                ++res.games;
-                if (!cont) {
-                    res.ok = true;
-                    return res;
-                }
-                if (maxGames > 0 && res.games >= maxGames) {
-                    res.ok = true;
-                    return res;
-                }
-
-                // Start new game with current line.
-                inGame = true;
-                haveMovetext = false;
-                cur = PgnStreamGame{};
-                cur.offsetStart = lineStart;
+                cur.tags.clear();
+                cur.offsetStart = baseOffset + lineStart;
             }
 
-            cur.tags[key] = val;
-            res.bytesProcessed = lastAfter;
+            cur.tags.push_back(tag);
+            res.bytesProcessed = baseOffset + pos;
             continue;
         }
 
         // Movetext line.
         if (!inGame) {
             // Ignore preamble noise before first tag.
-            res.bytesProcessed = lastAfter;
+            res.bytesProcessed = baseOffset + pos;
             continue;
         }
 
-        appendMovetext(cur.movetext, trimmed);
-        haveMovetext = true;
-        res.bytesProcessed = lastAfter;
+        if (!haveMovetext) {
+            movetextBegin = first;
+            haveMovetext = true;
+        }
+        movetextEnd = lineEnd;
+        res.bytesProcessed = baseOffset + pos;
     }
 
     // EOF: flush last game if any.
     if (inGame) {
-        cur.offsetEnd = fileSize;
-        finalizeGame(cur);
+        bool stop = false;
+        emit(size, &stop);
+    }
+    return res;
+}
 
-        std::string cbErr;
-        const bool cont = onGame(cur, res.bytesProcessed, &cbErr);
-        if (!cbErr.empty()) {
-            res.ok = false;
-            res.error = cbErr;
-            return res;
+
+} // namespace
+
+std::string PgnTagView::value() const {
+    std::string out;
+    out.reserve(rawValue.size());
+    bool escaped = false;
+    for (char c : rawValue) {
+        if (escaped) {
+            out.push_back(c);
+            escaped = false;
+        } else if (c == '\\') {
+            escaped = true;
+        } else {
+            out.push_back(c);
         }
-        ++res.games;
-        (void)cont;
     }
+    return out;
+}
+
+const PgnTagView* PgnGameView::findTag(std::string_view key) const {
+    for (auto it = tags.rbegin(); it != tags.rend(); ++it) {
+        if (it->key == key) return &*it;
+    }
+    return nullptr;
+}
+
+void appendNormalizedMovetext(std::string_view raw, std::string& out) {
+    const std::size_t base = out.size();
+    while (!raw.empty()) {
+        const std::size_t nl = raw.find('\n');
+        std::string_view line = raw.substr(0, nl);
+        raw.remove_prefix(nl == std::string_view::npos ? raw.size() : nl + 1);
+
+        rstripCr(line);
+        if (isBlankLine(line)) continue;
+        line.remove_prefix(leadingSpaces(line));
+        if (line.front() == '[') continue; // non-standard tag line, ignored by the scanner
+
+        if (out.size() > base) out.push_back(' ');
+        out.append(line.data(), line.size());
+    }
+    while (out.size() > base && isSpace(out.back())) out.pop_back();
+}
+
+PgnStreamScanResult scanPgnBuffer(std::string_view data, const PgnGameViewFn& onGame, int maxGames) {
+    PgnGameView cur;
+    PgnStreamScanResult res = scanRange(data, 0, onGame, maxGames, cur);
+    if (res.ok && res.games == 0) {
+        res.ok = false;
+        res.error = "No PGN games found";
+    }
+    return res;
+}
+
+PgnStreamScanResult scanPgnFileMapped(const std::string& filePath, const PgnGameViewFn& onGame, int maxGames) {
+    MappedFile file;
+    std::string err;
+    if (!file.open(filePath, &err)) {
+        PgnStreamScanResult res;
+        res.ok = false;
+        res.error = err;
+        return res;
+    }
+    return scanPgnBuffer(file.view(), onGame, maxGames);
+}
+
+namespace {
+
+// First line start >= pos that begins with "[Event ", or data.size().
+std::size_t resyncToEvent(std::string_view data, std::size_t pos) {
+    if (pos == 0) return 0;
+    const std::size_t hit = data.find("\n[Event ", pos - 1);
+    return (hit == std::string_view::npos) ? data.size() : hit + 1;
+}
+
+struct ByteRange {
+    std::size_t begin{0};
+    std::size_t end{0};
+};
+
+std::vector<ByteRange> splitRanges(std::string_view data, int threads, std::uint64_t minChunkBytes) {
+    const std::size_t size = data.size();
+    const std::uint64_t minChunk = std::max<std::uint64_t>(1, minChunkBytes);
+    const std::size_t byMin = static_cast<std::size_t>(std::max<std::uint64_t>(1, size / minChunk));
+    // A few ranges per thread so an unlucky (dense) range does not idle the rest.
+    const std::size_t count = std::max<std::size_t>(1, std::min(byMin, static_cast<std::size_t>(threads) * 4));
+
+    std::vector<ByteRange> ranges;
+    ranges.reserve(count);
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= count; ++i) {
+        const std::size_t end = (i == count)
+            ? size
+            : std::max(begin, resyncToEvent(data, static_cast<std::size_t>(
+                                                        static_cast<std::uint64_t>(size) * i / count)));
+        if (end > begin) ranges.push_back(ByteRange{begin, end});
+        begin = end;
+    }
+    return ranges;
+}
 
+// Views of one range, buffered for ordered delivery. Tags of all games are kept
+// in one flat vector to avoid a per-game allocation.
+struct BufferedGame {
+    std::uint64_t offsetStart{0};
+    std::uint64_t offsetEnd{0};
+    std::size_t tagBegin{0};
+    std::size_t tagCount{0};
+    std::string_view movetext;
+};
+
+struct BufferedRange {
+    std::vector<BufferedGame> games;
+    std::vector<PgnTagView> tags;
+    bool done{false};
+};
+
+} // namespace
+
+PgnStreamScanResult scanPgnFileParallel(const std::string& filePath,
+                                        const PgnGameViewFn& onGame,
+                                        const PgnParallelScanOptions& options) {
+    PgnStreamScanResult res;
+
+    MappedFile file;
+    if (!file.open(filePath, &res.error)) {
+        res.ok = false;
+        return res;
+    }
+    const std::string_view data = file.view();
+
+    const int threads = (options.threads > 0)
+        ? options.threads
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const std::vector<ByteRange> ranges = splitRanges(data, threads, options.minChunkBytes);
+
+    std::atomic<std::size_t> nextRange{0};
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> bytesDone{0};
+    std::atomic<int> games{0};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string firstError;
+
+    auto fail = [&](const std::string& err) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (firstError.empty()) firstError = err;
+        stop.store(true);
+        cv.notify_all();
+    };
+
+    // Ordered delivery state (guarded by mutex).
+    std::vector<BufferedRange> buffered(options.ordered ? ranges.size() : 0);
+    std::size_t nextDeliver = 0;
+    bool delivering = false;
+    const std::size_t maxAhead = static_cast<std::size_t>(threads) * 2;
+
+    auto deliverReady = [&](std::unique_lock<std::mutex>& lock) {
+        if (delivering) return; // the current deliverer will pick our range up
+        delivering = true;
+        PgnGameView view;
+        while (nextDeliver < buffered.size() && buffered[nextDeliver].done && !stop.load()) {
+            BufferedRange range = std::move(buffered[nextDeliver]);
+            buffered[nextDeliver].done = true;
+            lock.unlock();
+
+            for (const auto& g : range.games) {
+                if (stop.load(std::memory_order_relaxed)) break;
+                view.offsetStart = g.offsetStart;
+                view.offsetEnd = g.offsetEnd;
+                view.movetext = g.movetext;
+                view.tags.assign(range.tags.begin() + static_cast<std::ptrdiff_t>(g.tagBegin),
+                                 range.tags.begin() + static_cast<std::ptrdiff_t>(g.tagBegin + g.tagCount));
+                std::string cbErr;
+                const bool cont = onGame(view, g.offsetEnd, &cbErr);
+                if (!cbErr.empty()) {
+                    fail(cbErr);
+                    break;
+                }
+                games.fetch_add(1, std::memory_order_relaxed);
+                if (!cont) stop.store(true);
+            }
+
+            lock.lock();
+            ++nextDeliver;
+            cv.notify_all();
+        }
+        delivering = false;
+    };
+
+    auto worker = [&]() {
+        PgnGameView cur;
+        while (!stop.load(std::memory_order_relaxed)) {
+            const std::size_t idx = nextRange.fetch_add(1);
+            if (idx >= ranges.size()) break;
+            const ByteRange r = ranges[idx];
+            const std::string_view slice = data.substr(r.begin, r.end - r.begin);
+
+            if (!options.ordered) {
+                std::uint64_t reported = r.begin;
+                const auto sub = scanRange(slice, r.begin,
+                    [&](const PgnGameView& g, std::uint64_t, std::string* errorOut) {
+                        if (stop.load(std::memory_order_relaxed)) return false;
+                        const std::uint64_t total =
+                            bytesDone.fetch_add(g.offsetEnd - reported) + (g.offsetEnd - reported);
+                        reported = g.offsetEnd;
+                        const bool cont = onGame(g, total, errorOut);
+                        if (errorOut->empty()) games.fetch_add(1, std::memory_order_relaxed);
+                        if (!cont) stop.store(true);
+                        return cont;
+                    },
+                    -1, cur);
+                bytesDone.fetch_add(r.end - reported);
+                if (!sub.ok) fail(sub.error);
+                continue;
+            }
+
+            {
+                // Back-pressure: don't run too far ahead of the deliverer.
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop.load() || idx < nextDeliver + maxAhead; });
+                if (stop.load()) break;
+            }
+
+            BufferedRange out;
+            scanRange(slice, r.begin,
+                [&](const PgnGameView& g, std::uint64_t, std::string*) {
+                    out.games.push_back(BufferedGame{g.offsetStart, g.offsetEnd, out.tags.size(),
+                                                     g.tags.size(), g.movetext});
+                    out.tags.insert(out.tags.end(), g.tags.begin(), g.tags.end());
+                    return !stop.load(std::memory_order_relaxed);
+                },
+                -1, cur);
+            out.done = true;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            buffered[idx] = std::move(out);
+            deliverReady(lock);
+        }
+        cv.notify_all();
+    };
+
+    std::vector<std::thread> pool;
+    const int spawned = std::min<int>(threads, static_cast<int>(ranges.size())) - 1;
+    for (int i = 0; i < spawned; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    res.games = games.load();
+    if (!firstError.empty()) {
+        res.ok = false;
+        res.error = firstError;
+        return res;
+    }
+    res.bytesProcessed = options.ordered
+        ? (nextDeliver == ranges.size() ? data.size() : (nextDeliver ? ranges[nextDeliver - 1].end : 0))
+        : bytesDone.load();
     res.ok = (res.games > 0);
     if (!res.ok) res.error = "No PGN games found";
     return res;
 }
 
+PgnStreamScanResult scanPgnFile(
+    const std::string& filePath,
+    const std::function<bool(const PgnStreamGame&, std::uint64_t, std::string*)>& onGame,
+    int maxGames) {
+
+    PgnStreamGame game;
+    return scanPgnFileMapped(
+        filePath,
+        [&](const PgnGameView& view, std::uint64_t bytesProcessed, std::string* errorOut) {
+            game.offsetStart = view.offsetStart;
+            game.offsetEnd = view.offsetEnd;
+            game.tags.clear();
+            for (const auto& t : view.tags) {
+                game.tags[std::string(t.key)] = t.value();
+            }
+            game.movetext.clear();
+            appendNormalizedMovetext(view.movetext, game.movetext);
+            return onGame(game, bytesProcessed, errorOut);
+        },
+        maxGames);
+}
+
 } // namespace sf::client::domain::pgn
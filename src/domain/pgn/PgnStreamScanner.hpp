@@ -4,6 +4,8 @@
 #include <functional>
 #include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace sf::client::domain::pgn {
 
@@ -23,12 +25,93 @@ struct PgnStreamScanResult {
     std::uint64_t bytesProcessed{0};
 };
 
+// ---- Zero-copy views ----
+//
+// Views point into the scanned buffer (usually a MappedFile) and are only
+// valid inside the onGame callback.
+
+struct PgnTagView {
+    std::string_view key;
+    std::string_view rawValue; // between the quotes, \" escapes still in place
+
+    std::string value() const; // unescaped copy
+};
+
+struct PgnGameView {
+    std::uint64_t offsetStart{0};
+    std::uint64_t offsetEnd{0};
+
+    // Tags in file order. The vector is reused between games, so after the
+    // first few games no allocation happens here.
+    std::vector<PgnTagView> tags;
+
+    // Raw movetext bytes: from the first movetext character to the end of the
+    // last movetext line, newlines included. Use appendNormalizedMovetext()
+    // for the space-joined form PgnStreamGame::movetext carries.
+    std::string_view movetext;
+
+    // Last occurrence wins (same as the std::map in PgnStreamGame).
+    const PgnTagView* findTag(std::string_view key) const;
+};
+
+using PgnGameViewFn = std::function<bool(const PgnGameView&,
+                                         std::uint64_t bytesProcessed,
+                                         std::string* errorOut)>;
+
+// Appends the movetext lines of a raw slice joined with single spaces,
+// leading whitespace and '\r' stripped, skipping blank lines and stray
+// '[' lines. The result equals PgnStreamGame::movetext.
+void appendNormalizedMovetext(std::string_view rawMovetext, std::string& out);
+
+// Scans an in-memory PGN buffer. Offsets are relative to data.data().
+PgnStreamScanResult scanPgnBuffer(std::string_view data,
+                                  const PgnGameViewFn& onGame,
+                                  int maxGames = -1);
+
+// Memory-maps filePath and scans it with scanPgnBuffer(). Per game it only
+// touches the reused tag vector, so throughput is bound by the page cache /
+// disk rather than by allocation.
+PgnStreamScanResult scanPgnFileMapped(const std::string& filePath,
+                                      const PgnGameViewFn& onGame,
+                                      int maxGames = -1);
+
+// ---- Parallel scan ----
+
+struct PgnParallelScanOptions {
+    int threads{0};                        // 0 = hardware threads
+    bool ordered{true};                    // deliver games in file order
+    std::uint64_t minChunkBytes{4u << 20}; // never split into smaller ranges
+};
+
+// Memory-maps filePath, splits it into byte ranges and scans them on a
+// thread pool. Every range except the first is resynced forward to the next
+// line starting with "[Event ", so games are never cut in half.
+//
+//   ordered = true   ranges are scanned in parallel, but onGame is called on
+//                    one thread at a time, in file order (a finished range
+//                    is buffered until all earlier ones were delivered).
+//   ordered = false  onGame is called concurrently from the workers as games
+//                    are found and must be thread-safe; use the offsets to
+//                    identify games.
+//
+// bytesProcessed is a file-wide, monotonic counter. Returning false from
+// onGame or setting errorOut stops all workers. maxGames is not supported
+// here. Results match scanPgnFileMapped() except for a tags-only game
+// immediately before a range boundary (sequentially it would absorb the
+// following game's tags).
+PgnStreamScanResult scanPgnFileParallel(const std::string& filePath,
+                                        const PgnGameViewFn& onGame,
+                                        const PgnParallelScanOptions& options = {});
+
 // Streaming PGN file scanner.
 //
 // It reads the file line-by-line, extracts tag pairs and concatenates movetext lines with spaces.
 // For each fully collected game it calls onGame(game, bytesProcessed, errorOut).
 //
 // onGame should return true to continue scanning, or false to stop early (treated as ok=true).
+//
+// Compatibility wrapper over scanPgnFileMapped(): materializes each view
+// into an owning PgnStreamGame.
 PgnStreamScanResult scanPgnFile(const std::string& filePath,
                                 const std::function<bool(const PgnStreamGame&,
                                                          std::uint64_t bytesProcessed,
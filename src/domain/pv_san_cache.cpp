@@ -0,0 +1,76 @@
+#include "domain/pv_san_cache.hpp"
+
+#include "domain/chess/Position.hpp"
+#include "domain/chess_san_to_fen.hpp"
+
+#include <optional>
+
+namespace sf::client::domain::chess {
+
+PvSanCache::PvSanCache(std::size_t maxEntries)
+    : maxEntries_(maxEntries) {
+}
+
+namespace {
+
+void appendMove(std::string& key, PackedMove m) {
+    key.push_back(static_cast<char>(m & 0xFF));
+    key.push_back(static_cast<char>(m >> 8));
+}
+
+} // namespace
+
+std::vector<std::string> PvSanCache::sanMoves(const std::string& fen, const MoveLine& pv) {
+    std::vector<std::string> san;
+    san.reserve(pv.size());
+
+    // Walk the cached prefixes as far as they go.
+    std::string key = fen;
+    key.push_back('\n');
+    const Entry* last = nullptr;
+    std::size_t i = 0;
+    for (; i < pv.size(); ++i) {
+        appendMove(key, pv[i]);
+        const auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            key.resize(key.size() - 2);
+            break;
+        }
+        san.push_back(it->second.san);
+        last = &it->second;
+    }
+    if (i == pv.size()) {
+        return san;
+    }
+
+    std::optional<Position> pos;
+    if (last) {
+        pos = Position::unpack(last->after);
+    } else {
+        pos = Position::fromFen(fen);
+    }
+    if (!pos) {
+        return san;
+    }
+
+    if (entries_.size() + (pv.size() - i) > maxEntries_) {
+        entries_.clear();
+    }
+
+    for (; i < pv.size(); ++i) {
+        const auto move = pos->findLegalPacked(pv[i]);
+        if (!move) {
+            break;
+        }
+        std::string moveSan = moveToSan(*pos, *move);
+        UndoInfo undo;
+        pos->makeMove(*move, undo);
+
+        appendMove(key, pv[i]);
+        entries_[key] = Entry{moveSan, pos->pack()};
+        san.push_back(std::move(moveSan));
+    }
+    return san;
+}
+
+} // namespace sf::client::domain::chess
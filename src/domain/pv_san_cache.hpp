@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/chess/MoveLine.hpp"
+#include "domain/chess/PackedPosition.hpp"
+
+namespace sf::client::domain::chess {
+
+// SAN for engine PVs, cached per (start FEN, move prefix).
+//
+// Between two updates of a live search a PV usually keeps its first moves
+// and changes or extends the tail, so only the moves after the longest
+// cached prefix are resolved (see moveToSan()). The cache is dropped as a
+// whole once it holds maxEntries prefixes. Not thread-safe.
+class PvSanCache {
+public:
+    static constexpr std::size_t kDefaultMaxEntries = 50000;
+
+    explicit PvSanCache(std::size_t maxEntries = kDefaultMaxEntries);
+
+    // SAN of the moves of pv played from fen, up to the first move that is
+    // not legal there (the result is then shorter than the PV).
+    std::vector<std::string> sanMoves(const std::string& fen, const MoveLine& pv);
+
+    std::size_t size() const noexcept { return entries_.size(); }
+    void clear() { entries_.clear(); }
+
+private:
+    struct Entry {
+        std::string    san;   // SAN of the prefix's last move
+        PackedPosition after; // position after it
+    };
+
+    std::size_t                            maxEntries_;
+    // Key: fen + '\n' + the prefix's packed moves, 2 bytes each.
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+} // namespace sf::client::domain::chess
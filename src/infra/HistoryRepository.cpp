@@ -1,21 +1,32 @@
 #include "infra/HistoryRepository.hpp"
 
+#include "infra/HistoryWriter.hpp"
+#include "infra/trace/Trace.hpp"
+
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMetaObject>
 #include <QVariant>
 #include <QtSql/QSqlError>
 #include <QtSql/QSqlQuery>
 #include <QDebug>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <string_view>
 
 namespace sf::client::infra {
 
 using sf::client::domain::Clock;
 using sf::client::domain::Job;
+using sf::client::domain::JobId;
 using sf::client::domain::JobSnapshot;
 using sf::client::domain::LimitType;
+using sf::client::domain::PvLine;
 using sf::client::domain::ScoreType;
 using sf::client::domain::TimePoint;
+using sf::client::domain::chess::MoveLine;
 
 namespace {
 
@@ -37,22 +48,58 @@ TimePoint fromUnixMs(qint64 ms) {
     return TimePoint(std::chrono::milliseconds(ms));
 }
 
+void insertScore(QJsonObject& o, const sf::client::domain::Score& score) {
+    if (score.type == ScoreType::Cp) {
+        o.insert(QStringLiteral("score_cp"), score.value);
+    } else if (score.type == ScoreType::Mate) {
+        o.insert(QStringLiteral("score_mate"), score.value);
+    }
+}
+
+sf::client::domain::Score readScore(const QJsonObject& o) {
+    sf::client::domain::Score score;
+    if (o.contains(QStringLiteral("score_cp"))) {
+        score.type = ScoreType::Cp;
+        score.value = o.value(QStringLiteral("score_cp")).toInt();
+    } else if (o.contains(QStringLiteral("score_mate"))) {
+        score.type = ScoreType::Mate;
+        score.value = o.value(QStringLiteral("score_mate")).toInt();
+    }
+    return score;
+}
+
+// PVs stay UCI text in the snapshot JSON, so older history rows still load.
+MoveLine readPv(const QJsonObject& o) {
+    const QByteArray text = o.value(QStringLiteral("pv")).toString().toLatin1();
+    return MoveLine::fromUci(std::string_view(text.constData(), static_cast<std::size_t>(text.size())));
+}
+
 QString snapshotToJson(const JobSnapshot& s) {
     QJsonObject o;
     if (s.depth)    o.insert(QStringLiteral("depth"), *s.depth);
     if (s.selDepth) o.insert(QStringLiteral("seldepth"), *s.selDepth);
 
-    if (s.score.type == ScoreType::Cp) {
-        o.insert(QStringLiteral("score_cp"), s.score.value);
-    } else if (s.score.type == ScoreType::Mate) {
-        o.insert(QStringLiteral("score_mate"), s.score.value);
-    }
+    insertScore(o, s.score);
 
     if (s.nodes) o.insert(QStringLiteral("nodes"), static_cast<qint64>(*s.nodes));
     if (s.nps)   o.insert(QStringLiteral("nps"), static_cast<qint64>(*s.nps));
 
     if (!s.bestMove.empty()) o.insert(QStringLiteral("bestmove"), QString::fromStdString(s.bestMove));
-    if (!s.pv.empty())       o.insert(QStringLiteral("pv"), QString::fromStdString(s.pv));
+    if (!s.pv.empty())       o.insert(QStringLiteral("pv"), QString::fromStdString(s.pv.toUci()));
+
+    // MultiPV lines: needed to answer cached MultiPV requests.
+    if (!s.lines.empty()) {
+        QJsonArray lines;
+        for (const PvLine& line : s.lines) {
+            QJsonObject lo;
+            lo.insert(QStringLiteral("multipv"), line.multipv);
+            if (line.depth) lo.insert(QStringLiteral("depth"), *line.depth);
+            insertScore(lo, line.score);
+            lo.insert(QStringLiteral("pv"), QString::fromStdString(line.pv.toUci()));
+            lines.append(lo);
+        }
+        o.insert(QStringLiteral("lines"), lines);
+    }
 
     return QString::fromUtf8(QJsonDocument(o).toJson(QJsonDocument::Compact));
 }
@@ -73,26 +120,31 @@ JobSnapshot snapshotFromJson(const QString& json) {
     if (o.contains(QStringLiteral("depth")))    s.depth    = o.value(QStringLiteral("depth")).toInt();
     if (o.contains(QStringLiteral("seldepth"))) s.selDepth = o.value(QStringLiteral("seldepth")).toInt();
 
-    if (o.contains(QStringLiteral("score_cp"))) {
-        s.score.type = ScoreType::Cp;
-        s.score.value = o.value(QStringLiteral("score_cp")).toInt();
-    } else if (o.contains(QStringLiteral("score_mate"))) {
-        s.score.type = ScoreType::Mate;
-        s.score.value = o.value(QStringLiteral("score_mate")).toInt();
-    }
+    s.score = readScore(o);
 
     if (o.contains(QStringLiteral("nodes"))) s.nodes = static_cast<std::int64_t>(o.value(QStringLiteral("nodes")).toVariant().toLongLong());
     if (o.contains(QStringLiteral("nps")))   s.nps   = static_cast<std::int64_t>(o.value(QStringLiteral("nps")).toVariant().toLongLong());
 
     if (o.contains(QStringLiteral("bestmove"))) s.bestMove = o.value(QStringLiteral("bestmove")).toString().toStdString();
-    if (o.contains(QStringLiteral("pv")))       s.pv       = o.value(QStringLiteral("pv")).toString().toStdString();
+    if (o.contains(QStringLiteral("pv")))       s.pv       = readPv(o);
+
+    for (const auto& lv : o.value(QStringLiteral("lines")).toArray()) {
+        const auto lo = lv.toObject();
+        PvLine line;
+        line.multipv = lo.value(QStringLiteral("multipv")).toInt(1);
+        if (lo.contains(QStringLiteral("depth"))) line.depth = lo.value(QStringLiteral("depth")).toInt();
+        line.score = readScore(lo);
+        line.pv = readPv(lo);
+        s.lines.push_back(std::move(line));
+    }
 
     return s;
 }
 
 } // namespace
 
-HistoryRepository::HistoryRepository(const QString& dbPath) {
+HistoryRepository::HistoryRepository(const QString& dbPath)
+    : dbPath_(dbPath) {
     const auto connName = QStringLiteral("history");
 
     if (QSqlDatabase::contains(connName)) {
@@ -108,6 +160,23 @@ HistoryRepository::HistoryRepository(const QString& dbPath) {
     }
 
     initSchema();
+
+    // The schema exists before the writer connection opens.
+    writer_ = new HistoryWriter(dbPath);
+    writer_->moveToThread(&writerThread_);
+    QObject::connect(&writerThread_, &QThread::finished, writer_, &QObject::deleteLater);
+    writerThread_.setObjectName(QStringLiteral("history-writer"));
+    writerThread_.start();
+    QMetaObject::invokeMethod(writer_, [w = writer_]() { w->open(); }, Qt::QueuedConnection);
+}
+
+HistoryRepository::~HistoryRepository() {
+    if (writer_) {
+        // Runs after everything posted before it.
+        QMetaObject::invokeMethod(writer_, [w = writer_]() { w->close(); }, Qt::BlockingQueuedConnection);
+        writerThread_.quit();
+        writerThread_.wait();
+    }
 }
 
 void HistoryRepository::initSchema() const {
@@ -116,6 +185,7 @@ void HistoryRepository::initSchema() const {
     }
 
     QSqlQuery q(db_);
+    q.exec("PRAGMA journal_mode=WAL");
     q.exec(
         "CREATE TABLE IF NOT EXISTS jobs ("
         "id TEXT PRIMARY KEY,"
@@ -136,85 +206,114 @@ void HistoryRepository::initSchema() const {
         "job_id TEXT,"
         "ts INTEGER,"
         "line TEXT)");
-}
+    q.exec("CREATE INDEX IF NOT EXISTS idx_job_logs_job ON job_logs(job_id, id)");
+    // Keyset paging walks this index backwards (see loadJobsPage).
+    q.exec("CREATE INDEX IF NOT EXISTS idx_jobs_created ON jobs(created_at, id)");
 
-static bool saveJobRow(QSqlDatabase& db, const Job& job) {
-    QSqlQuery q(db);
-    q.prepare(
-        "INSERT OR REPLACE INTO jobs "
-        "(id, opponent, fen, limit_type, limit_value, server_id, status,"
-        " created_at, started_at, finished_at, result_json)"
-        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    // pos_key holds the unsigned Zobrist key bit-cast to SQLite's int64.
+    q.exec(
+        "CREATE TABLE IF NOT EXISTS analysis_cache ("
+        "pos_key INTEGER,"
+        "limit_type INTEGER,"
+        "multipv INTEGER,"
+        "limit_value INTEGER,"
+        "job_id TEXT,"
+        "result_json TEXT,"
+        "PRIMARY KEY (pos_key, limit_type, multipv))");
+}
 
-    q.addBindValue(QString::fromStdString(job.id));
-    q.addBindValue(QString::fromStdString(job.opponent));
-    q.addBindValue(QString::fromStdString(job.fen));
-    q.addBindValue(static_cast<int>(job.limit.type));
-    q.addBindValue(job.limit.value);
+void HistoryRepository::saveJob(const Job& job) {
+    CORRCHESS_TRACE_SCOPE("history.saveJob");
+    if (!writer_) {
+        return;
+    }
 
+    HistoryJobWrite w;
+    w.id         = QString::fromStdString(job.id);
+    w.opponent   = QString::fromStdString(job.opponent);
+    w.fen        = QString::fromStdString(job.fen);
+    w.limitType  = static_cast<int>(job.limit.type);
+    w.limitValue = job.limit.value;
     if (job.assignedServer) {
-        q.addBindValue(QString::fromStdString(*job.assignedServer));
+        w.serverId = QString::fromStdString(*job.assignedServer);
+    }
+    w.status     = static_cast<int>(job.status);
+    w.createdAt  = toUnixMs(job.createdAt);
+    w.startedAt  = toUnixMsOrNull(job.startedAt);
+    w.finishedAt = toUnixMsOrNull(job.finishedAt);
+    w.resultJson = snapshotToJson(job.snapshot);
+    w.logTs      = toUnixMs(job.finishedAt.value_or(job.createdAt));
+
+    // Append from the high-water mark. The first save in this session (the
+    // job may be in the DB from an earlier run) and a replaced log
+    // (assign() bumps the epoch) rewrite the job's lines instead.
+    const auto& log = job.logLines;
+    auto mark = logMarks_.find(job.id);
+    std::uint64_t from = log.firstSeq();
+    if (mark == logMarks_.end() || mark->second.epoch != log.epoch() || mark->second.endSeq > log.endSeq()) {
+        w.replaceLogs = true;
     } else {
-        q.addBindValue(QVariant());
+        from = std::max(from, mark->second.endSeq);
     }
-
-    q.addBindValue(static_cast<int>(job.status));
-    q.addBindValue(QVariant(toUnixMs(job.createdAt)));
-    q.addBindValue(toUnixMsOrNull(job.startedAt));
-    q.addBindValue(toUnixMsOrNull(job.finishedAt));
-    q.addBindValue(snapshotToJson(job.snapshot));
-
-    if (!q.exec()) {
-        qWarning() << "Failed to save job:" << q.lastError().text();
-        return false;
+    for (auto it = log.fromSeq(from); it != log.end(); ++it) {
+        w.logLines.push_back(QString::fromStdString(*it));
     }
-    return true;
+    logMarks_[job.id] = LogMark{log.epoch(), log.endSeq()};
+
+    QMetaObject::invokeMethod(writer_, [wr = writer_, w = std::move(w)]() { wr->writeJob(w); },
+                              Qt::QueuedConnection);
 }
 
-static void replaceJobLogs(QSqlDatabase& db, const Job& job) {
-    // Remove old logs
-    {
-        QSqlQuery qDel(db);
-        qDel.prepare("DELETE FROM job_logs WHERE job_id = ?");
-        qDel.addBindValue(QString::fromStdString(job.id));
-        if (!qDel.exec()) {
-            qWarning() << "Failed to clear job logs:" << qDel.lastError().text();
-            return;
-        }
-    }
+void HistoryRepository::forgetJob(const JobId& id) {
+    logMarks_.erase(id);
+}
 
-    if (job.logLines.empty()) {
+void HistoryRepository::saveCachedAnalysis(std::uint64_t positionKey, const Job& job) {
+    if (!writer_) {
         return;
     }
 
-    QSqlQuery qIns(db);
-    qIns.prepare("INSERT INTO job_logs (job_id, ts, line) VALUES (?, ?, ?)");
+    AnalysisCacheWrite w;
+    w.posKey     = static_cast<qint64>(positionKey);
+    w.limitType  = static_cast<int>(job.limit.type);
+    w.multiPv    = job.multiPv;
+    w.limitValue = job.limit.value;
+    w.jobId      = QString::fromStdString(job.id);
+    w.resultJson = snapshotToJson(job.snapshot);
 
-    const auto baseTp = job.finishedAt.value_or(job.createdAt);
-    const qint64 baseMs = toUnixMs(baseTp);
-
-    for (const auto& line : job.logLines) {
-        qIns.addBindValue(QString::fromStdString(job.id));
-        qIns.addBindValue(QVariant(baseMs));
-        qIns.addBindValue(QString::fromStdString(line));
-        if (!qIns.exec()) {
-            qWarning() << "Failed to save job log:" << qIns.lastError().text();
-            break;
-        }
-        qIns.finish();
-    }
+    QMetaObject::invokeMethod(writer_, [wr = writer_, w = std::move(w)]() { wr->writeCache(w); },
+                              Qt::QueuedConnection);
 }
 
-void HistoryRepository::saveJob(const Job& job) {
+std::optional<sf::client::app::CachedAnalysis> HistoryRepository::findCachedAnalysis(
+    std::uint64_t positionKey, LimitType type, int multiPv) const {
     if (!db_.isOpen()) {
-        return;
+        return std::nullopt;
     }
 
-    if (!saveJobRow(db_, job)) {
-        return;
+    QSqlQuery q(db_);
+    q.prepare(
+        "SELECT job_id, limit_value, multipv, result_json FROM analysis_cache"
+        " WHERE pos_key = ? AND limit_type = ? AND multipv >= ?"
+        " ORDER BY limit_value DESC LIMIT 1");
+    q.addBindValue(static_cast<qint64>(positionKey));
+    q.addBindValue(static_cast<int>(type));
+    q.addBindValue(multiPv);
+
+    if (!q.exec()) {
+        qWarning() << "Failed to read analysis cache:" << q.lastError().text();
+        return std::nullopt;
+    }
+    if (!q.next()) {
+        return std::nullopt;
     }
 
-    replaceJobLogs(db_, job);
+    sf::client::app::CachedAnalysis hit;
+    hit.jobId      = q.value(0).toString().toStdString();
+    hit.limitValue = q.value(1).toInt();
+    hit.multiPv    = q.value(2).toInt();
+    hit.snapshot   = snapshotFromJson(q.value(3).toString());
+    return hit;
 }
 
 static void loadLogsIntoJob(const QSqlDatabase& db, Job& job) {
@@ -232,6 +331,56 @@ static void loadLogsIntoJob(const QSqlDatabase& db, Job& job) {
     }
 }
 
+// Columns read by jobFromRow(); result_json is replaced by NULL when the
+// snapshot is not wanted.
+static QString jobColumns(bool withSnapshot) {
+    return QStringLiteral("id, opponent, fen, limit_type, limit_value, server_id, status,"
+                          " created_at, started_at, finished_at, ") +
+           (withSnapshot ? QStringLiteral("result_json") : QStringLiteral("NULL"));
+}
+
+static Job jobFromRow(const QSqlQuery& q) {
+    Job job;
+
+    job.id = q.value(0).toString().toStdString();
+    job.opponent = q.value(1).toString().toStdString();
+    job.fen = q.value(2).toString().toStdString();
+
+    job.limit.type  = static_cast<LimitType>(q.value(3).toInt());
+    job.limit.value = q.value(4).toInt();
+
+    const auto serverId = q.value(5).toString();
+    if (!serverId.isEmpty()) {
+        job.assignedServer = serverId.toStdString();
+    }
+
+    job.status = static_cast<sf::client::domain::JobStatus>(q.value(6).toInt());
+
+    const qint64 createdMs = q.value(7).toLongLong();
+    job.createdAt = fromUnixMs(createdMs);
+
+    if (!q.value(8).isNull()) {
+        job.startedAt = fromUnixMs(q.value(8).toLongLong());
+    }
+    if (!q.value(9).isNull()) {
+        job.finishedAt = fromUnixMs(q.value(9).toLongLong());
+    }
+
+    if (!q.value(10).isNull()) {
+        job.snapshot = snapshotFromJson(q.value(10).toString());
+    }
+
+    // Last update: finished > started > created
+    if (job.finishedAt) {
+        job.lastUpdateAt = *job.finishedAt;
+    } else if (job.startedAt) {
+        job.lastUpdateAt = *job.startedAt;
+    } else {
+        job.lastUpdateAt = job.createdAt;
+    }
+    return job;
+}
+
 std::vector<Job> HistoryRepository::loadAllJobs() const {
     std::vector<Job> out;
 
@@ -240,10 +389,7 @@ std::vector<Job> HistoryRepository::loadAllJobs() const {
     }
 
     QSqlQuery q(db_);
-    q.prepare(
-        "SELECT id, opponent, fen, limit_type, limit_value, server_id, status,"
-        " created_at, started_at, finished_at, result_json"
-        " FROM jobs ORDER BY created_at DESC");
+    q.prepare(QStringLiteral("SELECT ") + jobColumns(true) + QStringLiteral(" FROM jobs ORDER BY created_at DESC"));
 
     if (!q.exec()) {
         qWarning() << "Failed to load jobs:" << q.lastError().text();
@@ -251,48 +397,131 @@ std::vector<Job> HistoryRepository::loadAllJobs() const {
     }
 
     while (q.next()) {
-        Job job;
+        Job job = jobFromRow(q);
+        loadLogsIntoJob(db_, job);
+        out.push_back(std::move(job));
+    }
 
-        job.id = q.value(0).toString().toStdString();
-        job.opponent = q.value(1).toString().toStdString();
-        job.fen = q.value(2).toString().toStdString();
+    return out;
+}
 
-        job.limit.type  = static_cast<LimitType>(q.value(3).toInt());
-        job.limit.value = q.value(4).toInt();
+sf::client::app::HistoryPage HistoryRepository::loadJobsPage(
+    const std::optional<sf::client::app::HistoryCursor>& after, int limit, bool withSnapshots) const {
+    sf::client::app::HistoryPage page;
 
-        const auto serverId = q.value(5).toString();
-        if (!serverId.isEmpty()) {
-            job.assignedServer = serverId.toStdString();
-        }
+    if (!db_.isOpen() || limit <= 0) {
+        return page;
+    }
+
+    // (created_at, id) strictly below the cursor: stable even when several
+    // jobs share a millisecond, and an index seek instead of an OFFSET scan.
+    QString sql = QStringLiteral("SELECT ") + jobColumns(withSnapshots) + QStringLiteral(" FROM jobs");
+    if (after) {
+        sql += QStringLiteral(" WHERE (created_at, id) < (?, ?)");
+    }
+    sql += QStringLiteral(" ORDER BY created_at DESC, id DESC LIMIT ?");
+
+    QSqlQuery q(db_);
+    q.setForwardOnly(true);
+    q.prepare(sql);
+    if (after) {
+        q.addBindValue(QVariant(static_cast<qint64>(after->createdAtMs)));
+        q.addBindValue(QString::fromStdString(after->id));
+    }
+    q.addBindValue(limit);
+
+    if (!q.exec()) {
+        qWarning() << "Failed to load jobs page:" << q.lastError().text();
+        return page;
+    }
 
-        job.status = static_cast<sf::client::domain::JobStatus>(q.value(6).toInt());
+    page.jobs.reserve(static_cast<std::size_t>(limit));
+    while (q.next()) {
+        page.jobs.push_back(jobFromRow(q));
+    }
 
-        const qint64 createdMs = q.value(7).toLongLong();
-        job.createdAt = fromUnixMs(createdMs);
+    if (static_cast<int>(page.jobs.size()) == limit) {
+        const Job& last = page.jobs.back();
+        page.next = sf::client::app::HistoryCursor{toUnixMs(last.createdAt), last.id};
+    }
+    return page;
+}
 
-        if (!q.value(8).isNull()) {
-            job.startedAt = fromUnixMs(q.value(8).toLongLong());
+std::optional<Job> HistoryRepository::loadJobDetails(const sf::client::domain::JobId& id) const {
+    if (!db_.isOpen()) {
+        return std::nullopt;
+    }
+
+    QSqlQuery q(db_);
+    q.prepare(QStringLiteral("SELECT ") + jobColumns(true) + QStringLiteral(" FROM jobs WHERE id = ?"));
+    q.addBindValue(QString::fromStdString(id));
+
+    if (!q.exec()) {
+        qWarning() << "Failed to load job:" << q.lastError().text();
+        return std::nullopt;
+    }
+    if (!q.next()) {
+        return std::nullopt;
+    }
+
+    Job job = jobFromRow(q);
+    loadLogsIntoJob(db_, job);
+    return job;
+}
+
+static bool scanJobsOn(const QSqlDatabase& db, bool withLogs,
+                       const sf::client::app::IHistoryRepository::JobVisitor& visit) {
+    QSqlQuery count(db);
+    if (!count.exec(QStringLiteral("SELECT COUNT(*) FROM jobs")) || !count.next()) {
+        qWarning() << "Failed to count jobs:" << count.lastError().text();
+        return false;
+    }
+    const int total = count.value(0).toInt();
+
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    q.prepare(QStringLiteral("SELECT ") + jobColumns(true) +
+              QStringLiteral(" FROM jobs ORDER BY created_at DESC, id DESC"));
+    if (!q.exec()) {
+        qWarning() << "Failed to scan jobs:" << q.lastError().text();
+        return false;
+    }
+
+    while (q.next()) {
+        Job job = jobFromRow(q);
+        if (withLogs) {
+            loadLogsIntoJob(db, job);
         }
-        if (!q.value(9).isNull()) {
-            job.finishedAt = fromUnixMs(q.value(9).toLongLong());
+        if (!visit(job, total)) {
+            break;
         }
+    }
+    return true;
+}
 
-        job.snapshot = snapshotFromJson(q.value(10).toString());
+bool HistoryRepository::scanJobs(bool withLogs, const JobVisitor& visit) const {
+    if (dbPath_.isEmpty()) {
+        return false;
+    }
+
+    // QSqlDatabase connections belong to the thread that opened them.
+    static std::atomic<int> scanSeq{0};
+    const QString connName = QStringLiteral("history-scan-%1").arg(scanSeq.fetch_add(1));
 
-        // Last update: finished > started > created
-        if (job.finishedAt) {
-            job.lastUpdateAt = *job.finishedAt;
-        } else if (job.startedAt) {
-            job.lastUpdateAt = *job.startedAt;
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connName);
+        db.setDatabaseName(dbPath_);
+        db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+        if (db.open()) {
+            ok = scanJobsOn(db, withLogs, visit);
+            db.close();
         } else {
-            job.lastUpdateAt = job.createdAt;
+            qWarning() << "Failed to open history DB for scan:" << db.lastError().text();
         }
-
-        loadLogsIntoJob(db_, job);
-        out.push_back(std::move(job));
     }
-
-    return out;
+    QSqlDatabase::removeDatabase(connName);
+    return ok;
 }
 
 } // namespace sf::client::infra
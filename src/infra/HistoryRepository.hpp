@@ -1,7 +1,11 @@
 #pragma once
 
 #include <QString>
+#include <QThread>
 #include <QtSql/QSqlDatabase>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "domain/domain_model.hpp"
@@ -9,21 +13,53 @@
 
 namespace sf::client::infra {
 
+class HistoryWriter;
+
 // Very simple history storage using SQLite.
 // We store terminal jobs in table `jobs` and all log lines in `job_logs`.
+//
+// Reads use this (GUI thread) connection; writes are posted to a
+// HistoryWriter thread. saveJob() appends only the log lines added since
+// the job's previous save, so saving a job again is cheap.
 class HistoryRepository : public sf::client::app::IHistoryRepository {
 public:
     explicit HistoryRepository(const QString& dbPath);
+    // Waits for queued writes.
+    ~HistoryRepository() override;
 
     void saveJob(const sf::client::domain::Job& job) override;
+    // Drops the job's log mark; a later save would rewrite its lines.
+    void forgetJob(const sf::client::domain::JobId& id) override;
 
     // Load all saved jobs (terminal history).
     std::vector<sf::client::domain::Job> loadAllJobs() const override;
 
+    sf::client::app::HistoryPage loadJobsPage(const std::optional<sf::client::app::HistoryCursor>& after,
+                                              int limit,
+                                              bool withSnapshots = false) const override;
+    std::optional<sf::client::domain::Job> loadJobDetails(const sf::client::domain::JobId& id) const override;
+    // Opens a read-only connection of its own for the calling thread.
+    bool scanJobs(bool withLogs, const JobVisitor& visit) const override;
+
+    void saveCachedAnalysis(std::uint64_t positionKey, const sf::client::domain::Job& job) override;
+    std::optional<sf::client::app::CachedAnalysis> findCachedAnalysis(std::uint64_t positionKey,
+                                                                      sf::client::domain::LimitType type,
+                                                                      int multiPv) const override;
+
 private:
     void initSchema() const;
 
+    // Log position already handed to the writer, per job.
+    struct LogMark {
+        std::uint64_t epoch{0};  // JobLog::epoch() at that save
+        std::uint64_t endSeq{0}; // JobLog::endSeq() at that save
+    };
+
+    QString      dbPath_;
     QSqlDatabase db_;
+    QThread      writerThread_;
+    HistoryWriter* writer_{nullptr};
+    std::unordered_map<std::string, LogMark> logMarks_; // live jobs only (forgetJob)
 };
 
 } // namespace sf::client::infra
@@ -0,0 +1,138 @@
+#include "infra/HistoryWriter.hpp"
+
+#include "infra/trace/Trace.hpp"
+
+#include <QDebug>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+namespace sf::client::infra {
+
+namespace {
+
+constexpr auto kWriterConnName = "history-writer";
+
+} // namespace
+
+HistoryWriter::HistoryWriter(QString dbPath)
+    : dbPath_(std::move(dbPath)) {
+}
+
+HistoryWriter::~HistoryWriter() {
+    close();
+}
+
+void HistoryWriter::open() {
+    CORRCHESS_TRACE_THREAD_NAME("history-writer");
+    const auto connName = QString::fromLatin1(kWriterConnName);
+    db_ = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connName);
+    db_.setDatabaseName(dbPath_);
+    if (!db_.open()) {
+        qWarning() << "Failed to open history DB for writing:" << db_.lastError().text();
+        return;
+    }
+
+    // The GUI connection keeps reading while we write.
+    QSqlQuery q(db_);
+    q.exec(QStringLiteral("PRAGMA journal_mode=WAL"));
+    q.exec(QStringLiteral("PRAGMA busy_timeout=5000"));
+}
+
+void HistoryWriter::close() {
+    if (!db_.isValid()) {
+        return;
+    }
+    db_.close();
+    db_ = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QString::fromLatin1(kWriterConnName));
+}
+
+bool HistoryWriter::commitOrRollback(bool ok, const char* what) {
+    if (ok && db_.commit()) {
+        return true;
+    }
+    qWarning() << "Failed to" << what << ":" << db_.lastError().text();
+    db_.rollback();
+    return false;
+}
+
+void HistoryWriter::writeJob(const HistoryJobWrite& w) {
+    CORRCHESS_TRACE_SCOPE("history.writeJob");
+    if (!db_.isOpen() || !db_.transaction()) {
+        return;
+    }
+
+    bool ok = true;
+    {
+        QSqlQuery q(db_);
+        q.prepare(
+            "INSERT OR REPLACE INTO jobs "
+            "(id, opponent, fen, limit_type, limit_value, server_id, status,"
+            " created_at, started_at, finished_at, result_json)"
+            " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        q.addBindValue(w.id);
+        q.addBindValue(w.opponent);
+        q.addBindValue(w.fen);
+        q.addBindValue(w.limitType);
+        q.addBindValue(w.limitValue);
+        q.addBindValue(w.serverId);
+        q.addBindValue(w.status);
+        q.addBindValue(QVariant(w.createdAt));
+        q.addBindValue(w.startedAt);
+        q.addBindValue(w.finishedAt);
+        q.addBindValue(w.resultJson);
+        ok = q.exec();
+    }
+
+    if (ok && w.replaceLogs) {
+        QSqlQuery qDel(db_);
+        qDel.prepare("DELETE FROM job_logs WHERE job_id = ?");
+        qDel.addBindValue(w.id);
+        ok = qDel.exec();
+    }
+
+    if (ok && !w.logLines.empty()) {
+        // One prepared statement, executed per line, inside the transaction.
+        QSqlQuery qIns(db_);
+        ok = qIns.prepare("INSERT INTO job_logs (job_id, ts, line) VALUES (?, ?, ?)");
+        for (const auto& line : w.logLines) {
+            if (!ok) {
+                break;
+            }
+            qIns.bindValue(0, w.id);
+            qIns.bindValue(1, QVariant(w.logTs));
+            qIns.bindValue(2, line);
+            ok = qIns.exec();
+        }
+    }
+
+    commitOrRollback(ok, "save job");
+}
+
+void HistoryWriter::writeCache(const AnalysisCacheWrite& w) {
+    CORRCHESS_TRACE_SCOPE("history.writeCache");
+    if (!db_.isOpen() || !db_.transaction()) {
+        return;
+    }
+
+    QSqlQuery q(db_);
+    q.prepare(
+        "INSERT INTO analysis_cache"
+        " (pos_key, limit_type, multipv, limit_value, job_id, result_json)"
+        " VALUES (?, ?, ?, ?, ?, ?)"
+        " ON CONFLICT(pos_key, limit_type, multipv) DO UPDATE SET"
+        " limit_value = excluded.limit_value,"
+        " job_id = excluded.job_id,"
+        " result_json = excluded.result_json"
+        " WHERE excluded.limit_value >= analysis_cache.limit_value");
+    q.addBindValue(w.posKey);
+    q.addBindValue(w.limitType);
+    q.addBindValue(w.multiPv);
+    q.addBindValue(w.limitValue);
+    q.addBindValue(w.jobId);
+    q.addBindValue(w.resultJson);
+
+    commitOrRollback(q.exec(), "cache analysis");
+}
+
+} // namespace sf::client::infra
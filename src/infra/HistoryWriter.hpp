@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QtSql/QSqlDatabase>
+
+#include <vector>
+
+namespace sf::client::infra {
+
+// One HistoryRepository::saveJob() as plain values, so it can cross threads
+// (a Job's log is a shared, non-thread-safe handle).
+struct HistoryJobWrite {
+    QString  id;
+    QString  opponent;
+    QString  fen;
+    int      limitType{0};
+    int      limitValue{0};
+    QVariant serverId;
+    int      status{0};
+    qint64   createdAt{0};
+    QVariant startedAt;
+    QVariant finishedAt;
+    QString  resultJson;
+
+    bool                 replaceLogs{false}; // drop the stored lines first
+    qint64               logTs{0};
+    std::vector<QString> logLines;           // lines to append
+};
+
+struct AnalysisCacheWrite {
+    qint64  posKey{0};
+    int     limitType{0};
+    int     multiPv{1};
+    int     limitValue{0};
+    QString jobId;
+    QString resultJson;
+};
+
+// Owns a second connection to the history DB and lives on its own thread,
+// so saving a job with a long log never blocks the GUI. Each request is one
+// transaction; requests run in the order they were posted.
+class HistoryWriter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit HistoryWriter(QString dbPath);
+    ~HistoryWriter() override;
+
+    // All of these run on the writer thread.
+    void open();
+    void writeJob(const HistoryJobWrite& w);
+    void writeCache(const AnalysisCacheWrite& w);
+    void close();
+
+private:
+    bool commitOrRollback(bool ok, const char* what);
+
+    QString      dbPath_;
+    QSqlDatabase db_;
+};
+
+} // namespace sf::client::infra
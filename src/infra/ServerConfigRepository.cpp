@@ -117,6 +117,53 @@ std::vector<ServerInfo> ServerConfigRepository::load() const {
     return servers;
 }
 
+sf::client::domain::SchedulingPolicy ServerConfigRepository::loadSchedulingPolicy() const {
+    using sf::client::domain::SchedulingPolicy;
+
+    QFile file(QString::fromStdString(path_));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return SchedulingPolicy::ExpectedCompletion;
+    }
+    const auto doc = QJsonDocument::fromJson(file.readAll());
+    const auto value = doc.object().value(QStringLiteral("scheduling")).toString();
+    if (value == QStringLiteral("least_loaded")) {
+        return SchedulingPolicy::LeastLoaded;
+    }
+    if (!value.isEmpty() && value != QStringLiteral("expected_completion")) {
+        qWarning() << "Unknown scheduling policy" << value << "in servers config, using expected_completion";
+    }
+    return SchedulingPolicy::ExpectedCompletion;
+}
+
+int ServerConfigRepository::loadNonNegativeInt(const QString& key, int fallback) const {
+    QFile file(QString::fromStdString(path_));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return fallback;
+    }
+    const auto doc = QJsonDocument::fromJson(file.readAll());
+    const auto value = doc.object().value(key);
+    if (value.isUndefined()) {
+        return fallback;
+    }
+    if (!value.isDouble() || value.toDouble() < 0) {
+        qWarning() << "Invalid" << key << "in servers config, using" << fallback;
+        return fallback;
+    }
+    return value.toInt();
+}
+
+int ServerConfigRepository::loadFailoverGraceSeconds() const {
+    return loadNonNegativeInt(QStringLiteral("failover_grace_s"), kDefaultFailoverGraceSeconds);
+}
+
+int ServerConfigRepository::loadEvictJobsAfterMinutes() const {
+    return loadNonNegativeInt(QStringLiteral("evict_jobs_after_min"), kDefaultEvictJobsAfterMinutes);
+}
+
+int ServerConfigRepository::loadJobMemoryBudgetMb() const {
+    return loadNonNegativeInt(QStringLiteral("job_memory_budget_mb"), kDefaultJobMemoryBudgetMb);
+}
+
 void ServerConfigRepository::save(const std::vector<ServerInfo>& servers) const {
     QJsonArray arr;
     for (const auto& s : servers) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <QString>
+
 #include <string>
 #include <vector>
 
@@ -17,11 +19,32 @@ public:
     // (127.0.0.1:9000) and logs a warning.
     std::vector<sf::client::domain::ServerInfo> load() const override;
 
+    // Top-level "scheduling": "least_loaded" | "expected_completion"
+    // (default; also used when the key or file is missing).
+    sf::client::domain::SchedulingPolicy loadSchedulingPolicy() const;
+
+    // Top-level "failover_grace_s": seconds a server may stay offline before
+    // its unfinished jobs move to other servers; 0 disables failover.
+    // kDefaultFailoverGraceSeconds when the key or file is missing.
+    static constexpr int kDefaultFailoverGraceSeconds = 120;
+    int loadFailoverGraceSeconds() const;
+
+    // Top-level "evict_jobs_after_min": minutes a finished job stays in
+    // memory before only its summary row is kept (see MemoryBudget), and
+    // "job_memory_budget_mb": live jobs above that size evict the oldest
+    // finished ones early.
+    static constexpr int kDefaultEvictJobsAfterMinutes = 120;
+    static constexpr int kDefaultJobMemoryBudgetMb     = 256;
+    int loadEvictJobsAfterMinutes() const;
+    int loadJobMemoryBudgetMb() const;
+
     // Save current server list back to JSON (for future editing UI).
     void save(const std::vector<sf::client::domain::ServerInfo>& servers) const override;
 
 private:
     std::vector<sf::client::domain::ServerInfo> defaultServers() const;
+    // Top-level non-negative integer; fallback when missing or invalid.
+    int loadNonNegativeInt(const QString& key, int fallback) const;
 
     std::string path_;
 };
@@ -0,0 +1,197 @@
+#include "infra/refdb/OpeningTreeFile.hpp"
+
+#include "domain/chess/PackedMove.hpp"
+#include "infra/refdb/ReferenceDbRepository.hpp"
+
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include <algorithm>
+#include <cstring>
+
+namespace sf::client::infra::refdb {
+
+// ---- Writer ----
+
+OpeningTreeWriter::~OpeningTreeWriter() {
+    if (f_) std::fclose(f_);
+}
+
+bool OpeningTreeWriter::open(const std::string& path, std::string* errorOut) {
+    f_ = std::fopen(path.c_str(), "wb");
+    if (!f_) {
+        if (errorOut) *errorOut = "Cannot create opening tree file";
+        return false;
+    }
+    // Large sequential writes; the default buffer is a few KiB.
+    std::setvbuf(f_, nullptr, _IOFBF, 1 << 20);
+
+    const OpeningTreeHeader header;
+    if (std::fwrite(&header, sizeof(header), 1, f_) != 1) {
+        if (errorOut) *errorOut = "Cannot write opening tree header";
+        return false;
+    }
+    count_ = 0;
+    lastHash_ = 0;
+    return true;
+}
+
+bool OpeningTreeWriter::add(const OpeningTreeRecord& rec, std::string* errorOut) {
+    if (count_ > 0 && rec.posHash < lastHash_) {
+        if (errorOut) *errorOut = "Opening tree records out of order";
+        return false;
+    }
+    if (std::fwrite(&rec, sizeof(rec), 1, f_) != 1) {
+        if (errorOut) *errorOut = "Cannot write opening tree record";
+        return false;
+    }
+    lastHash_ = rec.posHash;
+    ++count_;
+    return true;
+}
+
+bool OpeningTreeWriter::finish(std::string* errorOut) {
+    if (!f_) return false;
+    OpeningTreeHeader header;
+    header.recordCount = count_;
+    const bool ok = std::fseek(f_, 0, SEEK_SET) == 0 &&
+                    std::fwrite(&header, sizeof(header), 1, f_) == 1;
+    const bool closed = std::fclose(f_) == 0;
+    f_ = nullptr;
+    if (!ok || !closed) {
+        if (errorOut) *errorOut = "Cannot finalize opening tree file";
+        return false;
+    }
+    return true;
+}
+
+// ---- Reader ----
+
+bool OpeningTreeFile::open(const std::string& path, std::string* errorOut) {
+    close();
+    if (!file_.open(path, errorOut, sf::client::domain::pgn::MappedFile::Access::Random)) return false;
+
+    OpeningTreeHeader expected;
+    OpeningTreeHeader header;
+    if (file_.size() < sizeof(header)) {
+        if (errorOut) *errorOut = "Not an opening tree file";
+        close();
+        return false;
+    }
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        header.byteOrderMark != expected.byteOrderMark ||
+        header.version != expected.version ||
+        header.recordSize != sizeof(OpeningTreeRecord) ||
+        file_.size() < sizeof(header) + header.recordCount * sizeof(OpeningTreeRecord)) {
+        if (errorOut) *errorOut = "Not an opening tree file (or written on a different byte order)";
+        close();
+        return false;
+    }
+
+    count_ = header.recordCount;
+    // The header is 32 bytes, so records stay 8-byte aligned inside the mapping.
+    records_ = count_ ? reinterpret_cast<const OpeningTreeRecord*>(file_.data() + sizeof(header)) : nullptr;
+    return true;
+}
+
+void OpeningTreeFile::close() {
+    file_.close();
+    records_ = nullptr;
+    count_ = 0;
+}
+
+std::pair<const OpeningTreeRecord*, const OpeningTreeRecord*>
+OpeningTreeFile::equalRange(std::uint64_t key) const {
+    if (!records_) return {nullptr, nullptr};
+    const OpeningTreeRecord* rec = records_;
+
+    // Invariant: the lower bound of key lies in [lo, hi].
+    std::size_t lo = 0;
+    std::size_t hi = static_cast<std::size_t>(count_);
+    for (int iter = 0; hi - lo > 16 && iter < 32; ++iter) {
+        const std::uint64_t a = rec[lo].posHash;
+        const std::uint64_t b = rec[hi - 1].posHash;
+        if (key <= a) {
+            hi = lo;
+            break;
+        }
+        if (key > b) {
+            lo = hi;
+            break;
+        }
+        const double f = static_cast<double>(key - a) / static_cast<double>(b - a);
+        std::size_t pos = lo + static_cast<std::size_t>(f * static_cast<double>(hi - 1 - lo));
+        pos = std::min(pos, hi - 1);
+        if (rec[pos].posHash < key) {
+            lo = pos + 1;
+        } else {
+            hi = pos;
+        }
+    }
+
+    const auto byHash = [](const OpeningTreeRecord& r, std::uint64_t k) { return r.posHash < k; };
+    const OpeningTreeRecord* first = std::lower_bound(rec + lo, rec + hi, key, byHash);
+    const OpeningTreeRecord* end = rec + count_;
+    const OpeningTreeRecord* last = first;
+    while (last != end && last->posHash == key) ++last;
+    return {first, last};
+}
+
+// ---- Export from move_agg ----
+
+bool exportOpeningTree(QSqlDatabase& db, const QString& treePath, QString* errorOut, std::int64_t* recordsOut) {
+    namespace chess = sf::client::domain::chess;
+
+    OpeningTreeWriter writer;
+    std::string err;
+    if (!writer.open(treePath.toStdString(), &err)) {
+        if (errorOut) *errorOut = QString::fromStdString(err);
+        return false;
+    }
+
+    static const char* kPasses[] = {
+        "SELECT pos_hash, move_uci, games, w, d, l, year_min, year_max FROM move_agg "
+        "WHERE pos_hash >= 0 ORDER BY pos_hash, games DESC;",
+        "SELECT pos_hash, move_uci, games, w, d, l, year_min, year_max FROM move_agg "
+        "WHERE pos_hash < 0 ORDER BY pos_hash, games DESC;",
+    };
+
+    for (const char* sql : kPasses) {
+        QSqlQuery q(db);
+        q.setForwardOnly(true);
+        if (!q.exec(QString::fromLatin1(sql))) {
+            if (errorOut) *errorOut = q.lastError().text();
+            return false;
+        }
+        while (q.next()) {
+            const auto move = chess::packUci(q.value(1).toString().toStdString());
+            if (!move) continue;
+
+            OpeningTreeRecord rec;
+            rec.posHash = ReferenceDbRepository::fromDbKey(q.value(0).toLongLong());
+            rec.setCount(0, q.value(2).toLongLong());
+            rec.setCount(1, q.value(3).toLongLong());
+            rec.setCount(2, q.value(4).toLongLong());
+            rec.setCount(3, q.value(5).toLongLong());
+            rec.move = *move;
+            rec.yearMin = OpeningTreeRecord::encodeYear(q.value(6).toInt());
+            rec.yearMax = OpeningTreeRecord::encodeYear(q.value(7).toInt());
+            if (!writer.add(rec, &err)) {
+                if (errorOut) *errorOut = QString::fromStdString(err);
+                return false;
+            }
+        }
+    }
+
+    const std::int64_t written = static_cast<std::int64_t>(writer.count());
+    if (!writer.finish(&err)) {
+        if (errorOut) *errorOut = QString::fromStdString(err);
+        return false;
+    }
+    if (recordsOut) *recordsOut = written;
+    return true;
+}
+
+} // namespace sf::client::infra::refdb
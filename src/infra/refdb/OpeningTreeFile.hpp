@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "domain/pgn/MappedFile.hpp"
+
+namespace sf::client::infra::refdb {
+
+// Compact, memory-mapped alternative to the move_agg table.
+//
+// File layout (host byte order, checked through a byte-order mark):
+//   OpeningTreeHeader   32 bytes
+//   OpeningTreeRecord   24 bytes each, sorted by (unsigned pos_hash, games desc)
+//
+// A move_agg row costs tens of bytes in SQLite (8-byte key, TEXT move, six
+// integers, plus the primary-key and pos_hash indexes); here it costs 24.
+
+struct OpeningTreeHeader {
+    char magic[8]{'C', 'C', 'O', 'T', 'R', 'E', 'E', '1'};
+    std::uint32_t version{1};
+    std::uint32_t recordSize{24};
+    std::uint64_t recordCount{0};
+    std::uint32_t byteOrderMark{0x01020304};
+    std::uint32_t reserved{0};
+};
+static_assert(sizeof(OpeningTreeHeader) == 32, "OpeningTreeHeader must stay 32 bytes");
+
+struct OpeningTreeRecord {
+    static constexpr std::uint32_t kMaxCount = 0xFFFFFF; // counters saturate
+    static constexpr int kYearBase = 1800;               // year byte = year - 1800, 0 = unknown
+
+    std::uint64_t posHash{0};
+    std::uint8_t counts[12]{}; // games, w, d, l: 24-bit little-endian each, side-to-move view
+    std::uint16_t move{0};     // domain::chess::PackedMove
+    std::uint8_t yearMin{0};
+    std::uint8_t yearMax{0};
+
+    std::uint32_t count(int i) const {
+        const std::uint8_t* p = counts + 3 * i;
+        return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+               (static_cast<std::uint32_t>(p[2]) << 16);
+    }
+    void setCount(int i, std::int64_t v) {
+        const std::uint32_t c = static_cast<std::uint32_t>(
+            v <= 0 ? 0 : (v > kMaxCount ? kMaxCount : v));
+        std::uint8_t* p = counts + 3 * i;
+        p[0] = static_cast<std::uint8_t>(c);
+        p[1] = static_cast<std::uint8_t>(c >> 8);
+        p[2] = static_cast<std::uint8_t>(c >> 16);
+    }
+
+    std::uint32_t games() const { return count(0); }
+    std::uint32_t w() const { return count(1); }
+    std::uint32_t d() const { return count(2); }
+    std::uint32_t l() const { return count(3); }
+
+    static std::uint8_t encodeYear(int year) {
+        if (year <= kYearBase) return 0;
+        return static_cast<std::uint8_t>(year - kYearBase > 255 ? 255 : year - kYearBase);
+    }
+    static int decodeYear(std::uint8_t v) { return v ? kYearBase + v : 0; }
+};
+static_assert(sizeof(OpeningTreeRecord) == 24, "OpeningTreeRecord must stay 24 bytes");
+
+inline constexpr const char* kOpeningTreeSuffix = ".cctree";
+
+// Streams records to disk; they must arrive in non-decreasing unsigned hash order.
+class OpeningTreeWriter final {
+public:
+    OpeningTreeWriter() = default;
+    ~OpeningTreeWriter();
+
+    OpeningTreeWriter(const OpeningTreeWriter&) = delete;
+    OpeningTreeWriter& operator=(const OpeningTreeWriter&) = delete;
+
+    bool open(const std::string& path, std::string* errorOut);
+    bool add(const OpeningTreeRecord& rec, std::string* errorOut);
+    bool finish(std::string* errorOut); // patches the header, closes the file
+
+    std::uint64_t count() const { return count_; }
+
+private:
+    std::FILE* f_{nullptr};
+    std::uint64_t count_{0};
+    std::uint64_t lastHash_{0};
+};
+
+// Read-only view over a mapped tree file.
+class OpeningTreeFile final {
+public:
+    bool open(const std::string& path, std::string* errorOut);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+    std::uint64_t size() const { return count_; }
+
+    // Records of one position, most played first. Interpolation search
+    // (Zobrist keys are uniform), finished by a short binary search.
+    std::pair<const OpeningTreeRecord*, const OpeningTreeRecord*> equalRange(std::uint64_t posHash) const;
+
+private:
+    sf::client::domain::pgn::MappedFile file_;
+    const OpeningTreeRecord* records_{nullptr};
+    std::uint64_t count_{0};
+};
+
+// Writes all of move_agg into a tree file. Rows are read in two passes
+// (non-negative, then negative pos_hash) so that SQLite's signed ordering
+// yields unsigned hash order without a sort in memory.
+bool exportOpeningTree(QSqlDatabase& db,
+                       const QString& treePath,
+                       QString* errorOut,
+                       std::int64_t* recordsOut = nullptr);
+
+} // namespace sf::client::infra::refdb
@@ -0,0 +1,103 @@
+#include "infra/refdb/PositionFilter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sf::client::infra::refdb {
+
+namespace {
+
+constexpr char kMagic[4] = {'C', 'C', 'B', 'F'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderSize = 16; // magic, version, block count
+
+// Odd multipliers from the Parquet split-block Bloom filter: one per word.
+constexpr std::uint32_t kSalt[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+// splitmix64 finalizer: the filter must not depend on how well the caller's
+// keys are distributed.
+std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+std::uint64_t bitFor(std::uint32_t lo, int word) {
+    return 1ULL << ((lo * kSalt[word]) >> 26);
+}
+
+void putLe(std::string& out, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+std::uint64_t getLe(const char* p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+PositionFilter::PositionFilter(std::size_t expectedKeys, int bitsPerKey) {
+    const std::size_t bits = std::max<std::size_t>(1, expectedKeys) * static_cast<std::size_t>(std::max(1, bitsPerKey));
+    blocks_.resize((bits + 511) / 512);
+}
+
+void PositionFilter::insert(std::uint64_t key) {
+    if (blocks_.empty()) return;
+    const std::uint64_t h = mix(key);
+    Block& b = blocks_[blockIndex(h)];
+    const auto lo = static_cast<std::uint32_t>(h);
+    for (int i = 0; i < 8; ++i) b.words[i] |= bitFor(lo, i);
+}
+
+bool PositionFilter::mayContain(std::uint64_t key) const {
+    if (blocks_.empty()) return true; // no filter: everything may be present
+    const std::uint64_t h = mix(key);
+    const Block& b = blocks_[blockIndex(h)];
+    const auto lo = static_cast<std::uint32_t>(h);
+    std::uint64_t miss = 0;
+    for (int i = 0; i < 8; ++i) miss |= bitFor(lo, i) & ~b.words[i];
+    return miss == 0;
+}
+
+std::string PositionFilter::serialize() const {
+    std::string out;
+    out.reserve(kHeaderSize + byteSize());
+    out.append(kMagic, sizeof(kMagic));
+    putLe(out, kVersion, 4);
+    putLe(out, blocks_.size(), 8);
+    for (const Block& b : blocks_) {
+        for (const std::uint64_t w : b.words) putLe(out, w, 8);
+    }
+    return out;
+}
+
+std::optional<PositionFilter> PositionFilter::deserialize(const char* data, std::size_t size) {
+    if (!data || size < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) return std::nullopt;
+    if (getLe(data + 4, 4) != kVersion) return std::nullopt;
+    const std::uint64_t count = getLe(data + 8, 8);
+    if (count == 0 || count > (size - kHeaderSize) / sizeof(Block) ||
+        size != kHeaderSize + count * sizeof(Block)) {
+        return std::nullopt;
+    }
+
+    PositionFilter f;
+    f.blocks_.resize(static_cast<std::size_t>(count));
+    const char* p = data + kHeaderSize;
+    for (Block& b : f.blocks_) {
+        for (std::uint64_t& w : b.words) {
+            w = getLe(p, 8);
+            p += 8;
+        }
+    }
+    return f;
+}
+
+} // namespace sf::client::infra::refdb
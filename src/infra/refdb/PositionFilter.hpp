@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sf::client::infra::refdb {
+
+// Blocked Bloom filter over position keys ("is this pos_hash in move_agg?").
+//
+// Every key maps to one 64-byte block (a single cache line) and sets one bit
+// in each of its eight 64-bit words, so a probe touches exactly one line.
+// At the default 12 bits per key the false-positive rate is about 0.5%;
+// there are no false negatives.
+class PositionFilter final {
+public:
+    static constexpr int kDefaultBitsPerKey = 12;
+
+    PositionFilter() = default;
+    explicit PositionFilter(std::size_t expectedKeys, int bitsPerKey = kDefaultBitsPerKey);
+
+    bool empty() const { return blocks_.empty(); }
+    std::size_t byteSize() const { return blocks_.size() * sizeof(Block); }
+
+    void insert(std::uint64_t key);
+    bool mayContain(std::uint64_t key) const;
+
+    // Portable (little-endian) byte image, suitable for a BLOB column.
+    std::string serialize() const;
+    static std::optional<PositionFilter> deserialize(const char* data, std::size_t size);
+
+private:
+    struct alignas(64) Block {
+        std::uint64_t words[8]{};
+    };
+
+    std::size_t blockIndex(std::uint64_t h) const {
+        // Multiply-shift range reduction of the high half.
+        return static_cast<std::size_t>(((h >> 32) * blocks_.size()) >> 32);
+    }
+
+    std::vector<Block> blocks_;
+};
+
+} // namespace sf::client::infra::refdb
@@ -0,0 +1,52 @@
+#include "infra/refdb/PostingList.hpp"
+
+namespace sf::client::infra::refdb {
+
+namespace {
+
+void putVarint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool getVarint(const char*& p, const char* end, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p != end; shift += 7) {
+        const auto b = static_cast<unsigned char>(*p++);
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void encodePostings(const std::vector<Posting>& postings, std::int64_t baseGameId, std::string& out) {
+    out.reserve(out.size() + postings.size() * 2);
+    std::int64_t prev = baseGameId;
+    for (const Posting& p : postings) {
+        putVarint(out, static_cast<std::uint64_t>(p.gameId - prev));
+        putVarint(out, static_cast<std::uint64_t>(p.ply));
+        prev = p.gameId;
+    }
+}
+
+bool decodePostings(const char* data, std::size_t size, std::int64_t baseGameId,
+                    std::vector<Posting>& out, std::size_t maxCount) {
+    const char* p = data;
+    const char* const end = data + size;
+    std::int64_t gameId = baseGameId;
+    for (std::size_t n = 0; n < maxCount && p != end; ++n) {
+        std::uint64_t delta = 0;
+        std::uint64_t ply = 0;
+        if (!getVarint(p, end, delta) || !getVarint(p, end, ply)) return false;
+        gameId += static_cast<std::int64_t>(delta);
+        out.push_back(Posting{gameId, static_cast<std::int32_t>(ply)});
+    }
+    return true;
+}
+
+} // namespace sf::client::infra::refdb
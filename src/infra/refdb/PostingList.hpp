@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace sf::client::infra::refdb {
+
+// One ply of one game that reaches a position.
+struct Posting {
+    std::int64_t gameId{0};
+    std::int32_t ply{0};
+
+    bool operator<(const Posting& o) const {
+        return gameId != o.gameId ? gameId < o.gameId : ply < o.ply;
+    }
+};
+
+// Compressed occurrence list of a position (a row of occ_postings).
+//
+// Postings are sorted by (game id, ply) and stored as LEB128 varint pairs:
+// the game id as a delta to the previous posting (to baseGameId for the
+// first one), then the ply. A delta of 0 means the same game reached the
+// position again. Frequent positions cost about two bytes per game, rare
+// ones a handful of bytes per row instead of a four-column row with two
+// indexes.
+void encodePostings(const std::vector<Posting>& postings, std::int64_t baseGameId, std::string& out);
+
+// Appends up to maxCount postings of data to out. False (out keeps what was
+// decoded) if the list is truncated or a varint overflows.
+bool decodePostings(const char* data, std::size_t size, std::int64_t baseGameId,
+                    std::vector<Posting>& out,
+                    std::size_t maxCount = std::numeric_limits<std::size_t>::max());
+
+} // namespace sf::client::infra::refdb
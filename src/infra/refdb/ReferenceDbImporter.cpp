@@ -0,0 +1,562 @@
+#include "infra/refdb/ReferenceDbImporter.hpp"
+
+#include "domain/chess_san_to_fen.hpp"
+#include "domain/pgn/PgnStreamScanner.hpp"
+#include "infra/refdb/OpeningTreeFile.hpp"
+#include "infra/refdb/PostingList.hpp"
+#include "infra/refdb/ReferenceDbRepository.hpp"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sf::client::infra::refdb {
+
+namespace chess = sf::client::domain::chess;
+namespace pgn = sf::client::domain::pgn;
+
+namespace {
+
+// ---- Bounded MPMC queue ----
+// push() blocks while full, pop() while empty. close() wakes everyone:
+// push() then fails and pop() drains what is left before returning nullopt.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(value));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return std::nullopt;
+        T value = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return value;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_{false};
+};
+
+// ---- Pipeline records ----
+
+struct IndexedPly {
+    std::uint64_t posHash{0};
+    std::string uci;
+};
+
+struct IndexedGame {
+    std::uint64_t offsetStart{0};
+    std::uint64_t offsetEnd{0};
+    std::string white;
+    std::string black;
+    std::optional<int> whiteElo;
+    std::optional<int> blackElo;
+    std::string result;
+    int dateInt{0};
+    int year{0};
+    bool whiteToMoveFirst{true};
+    std::vector<IndexedPly> plies;
+};
+
+std::string tagOrEmpty(const pgn::PgnGameView& g, std::string_view key) {
+    const pgn::PgnTagView* t = g.findTag(key);
+    return t ? t->value() : std::string{};
+}
+
+std::optional<int> parseElo(const std::string& s) {
+    if (s.empty()) return std::nullopt;
+    int v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return std::nullopt;
+        v = v * 10 + (c - '0');
+    }
+    return (v > 0) ? std::optional<int>(v) : std::nullopt;
+}
+
+// "YYYY.MM.DD" with "??" for unknown parts -> YYYYMMDD (unknown parts = 0).
+int parseDigits(const std::string& s, std::size_t pos, std::size_t len) {
+    if (pos + len > s.size()) return 0;
+    int v = 0;
+    for (std::size_t i = pos; i < pos + len; ++i) {
+        if (s[i] < '0' || s[i] > '9') return 0;
+        v = v * 10 + (s[i] - '0');
+    }
+    return v;
+}
+
+// Runs on the scan threads; movetext is a per-thread scratch buffer.
+IndexedGame replayGame(const pgn::PgnGameView& view, int maxPlies, std::string& movetext, bool* ok) {
+    IndexedGame g;
+    g.offsetStart = view.offsetStart;
+    g.offsetEnd = view.offsetEnd;
+    g.white = tagOrEmpty(view, "White");
+    g.black = tagOrEmpty(view, "Black");
+    g.whiteElo = parseElo(tagOrEmpty(view, "WhiteElo"));
+    g.blackElo = parseElo(tagOrEmpty(view, "BlackElo"));
+    g.result = tagOrEmpty(view, "Result");
+
+    const std::string date = tagOrEmpty(view, "Date");
+    g.year = parseDigits(date, 0, 4);
+    g.dateInt = (g.year > 0)
+        ? g.year * 10000 + parseDigits(date, 5, 2) * 100 + parseDigits(date, 8, 2)
+        : 0;
+
+    std::optional<chess::Position> start = chess::Position::startpos();
+    if (const pgn::PgnTagView* fen = view.findTag("FEN")) start = chess::Position::fromFen(fen->value());
+    if (!start) {
+        *ok = false;
+        return g;
+    }
+    g.whiteToMoveFirst = start->sideToMove() == chess::Color::White;
+
+    movetext.clear();
+    pgn::appendNormalizedMovetext(view.movetext, movetext);
+
+    // Replayed straight off the movetext: no timeline or FEN strings, the
+    // UCI moves fit the small-string buffer.
+    chess::SanReplay replay(movetext, *start);
+    while (replay.next()) {
+        if (maxPlies <= 0 || replay.plyCount() <= maxPlies) {
+            g.plies.push_back(IndexedPly{replay.keyBefore(), chess::moveToUci(replay.move())});
+        }
+    }
+    *ok = replay.ok();
+    if (!*ok) g.plies.clear();
+    return g;
+}
+
+// ---- move_agg pre-aggregation (one flush per batch) ----
+
+struct AggKey {
+    std::uint64_t posHash{0};
+    std::string uci;
+    bool operator==(const AggKey& o) const { return posHash == o.posHash && uci == o.uci; }
+};
+
+struct AggKeyHash {
+    std::size_t operator()(const AggKey& k) const {
+        return static_cast<std::size_t>(k.posHash ^ (std::hash<std::string>{}(k.uci) * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+struct AggValue {
+    int games{0};
+    int w{0};
+    int d{0};
+    int l{0};
+    int yearMin{0};
+    int yearMax{0};
+    int lastDateInt{0};
+};
+
+class Writer {
+public:
+    Writer(QSqlDatabase& db, bool storeOccurrences, OccurrenceFormat format)
+        : db_(db)
+        , storeRows_(storeOccurrences && format == OccurrenceFormat::Rows)
+        , storePostings_(storeOccurrences && format == OccurrenceFormat::PostingLists)
+        , insGame_(db)
+        , insOcc_(db)
+        , insPostings_(db)
+        , upsertAgg_(db) {}
+
+    bool prepare(QString* err) {
+        const bool ok =
+            insGame_.prepare(R"SQL(
+                INSERT INTO games(source_file_id, offset_start, offset_end, white, black,
+                                  white_elo, black_elo, result, date_int, year)
+                VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?);
+            )SQL") &&
+            insOcc_.prepare(R"SQL(
+                INSERT OR IGNORE INTO occurrences(pos_hash, game_id, ply, move_uci)
+                VALUES(?, ?, ?, ?);
+            )SQL") &&
+            insPostings_.prepare(R"SQL(
+                INSERT OR REPLACE INTO occ_postings(pos_hash, first_game_id, count, data)
+                VALUES(?, ?, ?, ?);
+            )SQL") &&
+            upsertAgg_.prepare(R"SQL(
+                INSERT INTO move_agg(pos_hash, move_uci, games, w, d, l, year_min, year_max, last_date_int)
+                VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)
+                ON CONFLICT(pos_hash, move_uci) DO UPDATE SET
+                    games = games + excluded.games,
+                    w = w + excluded.w,
+                    d = d + excluded.d,
+                    l = l + excluded.l,
+                    year_min = CASE
+                        WHEN excluded.year_min > 0 AND (year_min = 0 OR excluded.year_min < year_min)
+                        THEN excluded.year_min ELSE year_min END,
+                    year_max = MAX(year_max, excluded.year_max),
+                    last_date_int = MAX(last_date_int, excluded.last_date_int);
+            )SQL");
+        if (!ok && err) {
+            *err = db_.lastError().text();
+        }
+        return ok;
+    }
+
+    void setSourceFileId(qint64 id) { sourceFileId_ = id; }
+
+    bool begin(QString* err) {
+        if (!db_.transaction()) {
+            if (err) *err = db_.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    bool add(const IndexedGame& g, QString* err) {
+        insGame_.bindValue(0, sourceFileId_);
+        insGame_.bindValue(1, static_cast<qint64>(g.offsetStart));
+        insGame_.bindValue(2, static_cast<qint64>(g.offsetEnd));
+        insGame_.bindValue(3, QString::fromStdString(g.white));
+        insGame_.bindValue(4, QString::fromStdString(g.black));
+        insGame_.bindValue(5, g.whiteElo ? QVariant(*g.whiteElo) : QVariant());
+        insGame_.bindValue(6, g.blackElo ? QVariant(*g.blackElo) : QVariant());
+        insGame_.bindValue(7, QString::fromStdString(g.result));
+        insGame_.bindValue(8, g.dateInt);
+        insGame_.bindValue(9, g.year);
+        if (!insGame_.exec()) {
+            if (err) *err = insGame_.lastError().text();
+            return false;
+        }
+        const qint64 gameId = insGame_.lastInsertId().toLongLong();
+
+        const bool whiteWon = (g.result == "1-0");
+        const bool blackWon = (g.result == "0-1");
+        const bool draw = (g.result == "1/2-1/2");
+
+        for (std::size_t i = 0; i < g.plies.size(); ++i) {
+            const auto& p = g.plies[i];
+            const bool whiteToMove = ((i % 2) == 0) == g.whiteToMoveFirst;
+
+            AggValue& a = agg_[AggKey{p.posHash, p.uci}];
+            a.games += 1;
+            if (draw) a.d += 1;
+            else if ((whiteWon && whiteToMove) || (blackWon && !whiteToMove)) a.w += 1;
+            else if (whiteWon || blackWon) a.l += 1;
+            if (g.year > 0) {
+                a.yearMin = (a.yearMin == 0) ? g.year : std::min(a.yearMin, g.year);
+                a.yearMax = std::max(a.yearMax, g.year);
+            }
+            a.lastDateInt = std::max(a.lastDateInt, g.dateInt);
+
+            if (storePostings_) {
+                // Games arrive in id order, so each list is sorted already.
+                postings_[p.posHash].push_back(Posting{gameId, static_cast<std::int32_t>(i)});
+            } else if (storeRows_) {
+                insOcc_.bindValue(0, ReferenceDbRepository::toDbKey(p.posHash));
+                insOcc_.bindValue(1, gameId);
+                insOcc_.bindValue(2, static_cast<int>(i));
+                insOcc_.bindValue(3, QString::fromStdString(p.uci));
+                if (!insOcc_.exec()) {
+                    if (err) *err = insOcc_.lastError().text();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool commit(QString* err) {
+        for (const auto& [key, a] : agg_) {
+            upsertAgg_.bindValue(0, ReferenceDbRepository::toDbKey(key.posHash));
+            upsertAgg_.bindValue(1, QString::fromStdString(key.uci));
+            upsertAgg_.bindValue(2, a.games);
+            upsertAgg_.bindValue(3, a.w);
+            upsertAgg_.bindValue(4, a.d);
+            upsertAgg_.bindValue(5, a.l);
+            upsertAgg_.bindValue(6, a.yearMin);
+            upsertAgg_.bindValue(7, a.yearMax);
+            upsertAgg_.bindValue(8, a.lastDateInt);
+            if (!upsertAgg_.exec()) {
+                if (err) *err = upsertAgg_.lastError().text();
+                db_.rollback();
+                agg_.clear();
+                postings_.clear();
+                return false;
+            }
+        }
+        agg_.clear();
+
+        if (!flushPostings(err)) {
+            db_.rollback();
+            return false;
+        }
+
+        if (!db_.commit()) {
+            if (err) *err = db_.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    void rollback() {
+        agg_.clear();
+        postings_.clear();
+        db_.rollback();
+    }
+
+private:
+    // One chunk per position seen in the batch, inserted in pos_hash order
+    // so the B-tree is appended to page by page rather than split at random.
+    bool flushPostings(QString* err) {
+        std::vector<std::uint64_t> keys;
+        keys.reserve(postings_.size());
+        for (const auto& entry : postings_) keys.push_back(entry.first);
+        std::sort(keys.begin(), keys.end(), [](std::uint64_t a, std::uint64_t b) {
+            return ReferenceDbRepository::toDbKey(a) < ReferenceDbRepository::toDbKey(b);
+        });
+
+        std::string blob;
+        for (const std::uint64_t key : keys) {
+            const std::vector<Posting>& list = postings_[key];
+            blob.clear();
+            encodePostings(list, list.front().gameId, blob);
+            insPostings_.bindValue(0, ReferenceDbRepository::toDbKey(key));
+            insPostings_.bindValue(1, static_cast<qint64>(list.front().gameId));
+            insPostings_.bindValue(2, static_cast<int>(list.size()));
+            insPostings_.bindValue(3, QByteArray(blob.data(), static_cast<int>(blob.size())));
+            if (!insPostings_.exec()) {
+                if (err) *err = insPostings_.lastError().text();
+                postings_.clear();
+                return false;
+            }
+        }
+        postings_.clear();
+        return true;
+    }
+
+    QSqlDatabase& db_;
+    bool storeRows_{false};
+    bool storePostings_{false};
+    qint64 sourceFileId_{0};
+
+    QSqlQuery insGame_;
+    QSqlQuery insOcc_;
+    QSqlQuery insPostings_;
+    QSqlQuery upsertAgg_;
+
+    std::unordered_map<AggKey, AggValue, AggKeyHash> agg_;
+    std::unordered_map<std::uint64_t, std::vector<Posting>> postings_;
+};
+
+bool registerSource(QSqlDatabase& db, const QString& pgnPath, qint64* outId, QString* err) {
+    const QFileInfo fi(pgnPath);
+    QSqlQuery q(db);
+    q.prepare("INSERT INTO source_files(path, size_bytes, mtime_unix, created_at_unix) VALUES(?, ?, ?, ?);");
+    q.bindValue(0, fi.absoluteFilePath());
+    q.bindValue(1, fi.size());
+    q.bindValue(2, fi.lastModified().toSecsSinceEpoch());
+    q.bindValue(3, QDateTime::currentSecsSinceEpoch());
+    if (!q.exec()) {
+        if (err) *err = q.lastError().text();
+        return false;
+    }
+    *outId = q.lastInsertId().toLongLong();
+    return true;
+}
+
+QString uniqueConnectionName() {
+    static std::atomic<int> seq{0};
+    return QStringLiteral("refdb-import-%1").arg(seq.fetch_add(1));
+}
+
+} // namespace
+
+ImportResult ReferenceDbImporter::run(const ImportOptions& options,
+                                      const std::atomic<bool>& cancel,
+                                      const ProgressFn& onProgress) {
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+
+    ImportResult result;
+
+    const QFileInfo fi(options.pgnPath);
+    if (!fi.exists()) {
+        result.error = QStringLiteral("PGN file not found: %1").arg(options.pgnPath);
+        return result;
+    }
+    const std::uint64_t totalBytes = static_cast<std::uint64_t>(fi.size());
+
+    const QString connName = uniqueConnectionName();
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connName);
+        db.setDatabaseName(options.dbPath);
+        if (!db.open()) {
+            result.error = db.lastError().text();
+        } else if (ReferenceDbRepository::createOrMigrate(db, &result.error)) {
+            QSqlQuery pragma(db);
+            // Bulk import: durability of the last batch is not worth an fsync per commit.
+            pragma.exec("PRAGMA synchronous=OFF;");
+            pragma.exec("PRAGMA cache_size=-262144;"); // 256 MiB
+
+            Writer writer(db, options.storeOccurrences, options.occurrenceFormat);
+            qint64 sourceId = 0;
+            // A filter from an earlier import would hide the positions added now.
+            if (ReferenceDbRepository::dropPositionFilter(db, &result.error) &&
+                writer.prepare(&result.error) &&
+                registerSource(db, options.pgnPath, &sourceId, &result.error)) {
+                writer.setSourceFileId(sourceId);
+
+                const unsigned hw = std::max(2u, std::thread::hardware_concurrency());
+                const int workers = (options.workerThreads > 0)
+                    ? options.workerThreads
+                    : static_cast<int>(hw - 1);
+
+                BoundedQueue<IndexedGame> indexedQueue(4096);
+                std::atomic<std::uint64_t> bytesRead{0};
+                std::atomic<std::int64_t> skipped{0};
+                std::string scanError;
+
+                // Byte ranges are scanned and replayed in parallel from the
+                // first byte; only the writer below is sequential.
+                std::thread scanner([&] {
+                    pgn::PgnParallelScanOptions scanOptions;
+                    scanOptions.threads = workers;
+                    scanOptions.ordered = false;
+
+                    const auto scan = pgn::scanPgnFileParallel(
+                        options.pgnPath.toStdString(),
+                        [&](const pgn::PgnGameView& view, std::uint64_t bytes, std::string*) {
+                            std::uint64_t seen = bytesRead.load(std::memory_order_relaxed);
+                            while (seen < bytes && !bytesRead.compare_exchange_weak(seen, bytes)) {}
+                            if (cancel.load(std::memory_order_relaxed)) return false;
+
+                            thread_local std::string movetext;
+                            bool ok = false;
+                            IndexedGame g = replayGame(view, options.maxPlies, movetext, &ok);
+                            if (!ok) {
+                                skipped.fetch_add(1, std::memory_order_relaxed);
+                                return true;
+                            }
+                            return indexedQueue.push(std::move(g));
+                        },
+                        scanOptions);
+                    if (!scan.ok) scanError = scan.error;
+                    bytesRead.store(totalBytes, std::memory_order_relaxed);
+                    indexedQueue.close();
+                });
+
+                // ---- Writer loop (this thread) ----
+                const int batchGames = std::max(1, options.batchGames);
+                int inBatch = 0;
+                bool failed = false;
+                auto lastReport = Clock::now();
+
+                auto report = [&](bool force) {
+                    if (!onProgress) return;
+                    const auto now = Clock::now();
+                    if (!force && now - lastReport < std::chrono::milliseconds(250)) return;
+                    lastReport = now;
+                    const double secs = std::chrono::duration<double>(now - t0).count();
+                    ImportProgress p;
+                    p.bytesProcessed = bytesRead.load(std::memory_order_relaxed);
+                    p.totalBytes = totalBytes;
+                    p.gamesImported = result.gamesImported;
+                    p.gamesSkipped = skipped.load(std::memory_order_relaxed);
+                    p.bytesPerSecond = (secs > 0) ? static_cast<double>(p.bytesProcessed) / secs : 0.0;
+                    p.gamesPerSecond = (secs > 0) ? static_cast<double>(p.gamesImported) / secs : 0.0;
+                    onProgress(p);
+                };
+
+                while (auto g = indexedQueue.pop()) {
+                    if (cancel.load(std::memory_order_relaxed)) break;
+                    if (inBatch == 0 && !writer.begin(&result.error)) {
+                        failed = true;
+                        break;
+                    }
+                    if (!writer.add(*g, &result.error)) {
+                        writer.rollback();
+                        inBatch = 0;
+                        failed = true;
+                        break;
+                    }
+                    ++result.gamesImported;
+                    result.pliesIndexed += static_cast<std::int64_t>(g->plies.size());
+                    if (++inBatch >= batchGames) {
+                        inBatch = 0;
+                        if (!writer.commit(&result.error)) {
+                            failed = true;
+                            break;
+                        }
+                    }
+                    report(false);
+                }
+
+                if (inBatch > 0 && !failed) {
+                    if (!writer.commit(&result.error)) failed = true;
+                }
+
+                // Unblock the scan threads on cancel / error, then join.
+                indexedQueue.close();
+                scanner.join();
+
+                result.gamesSkipped = skipped.load();
+                result.cancelled = cancel.load();
+                if (!failed && !scanError.empty()) {
+                    result.error = QString::fromStdString(scanError);
+                    failed = true;
+                }
+                result.ok = !failed && !result.cancelled;
+                if (result.ok) {
+                    ReferenceDbRepository::clearNeedsReindex(db, nullptr);
+                    if (!ReferenceDbRepository::rebuildPositionFilter(db, &result.error)) {
+                        result.ok = false;
+                    } else if (!options.openingTreePath.isEmpty() &&
+                        !exportOpeningTree(db, options.openingTreePath, &result.error)) {
+                        result.ok = false;
+                    }
+                }
+                report(true);
+            }
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connName);
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    return result;
+}
+
+} // namespace sf::client::infra::refdb
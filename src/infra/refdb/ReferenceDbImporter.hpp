@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace sf::client::infra::refdb {
+
+// How per-game position occurrences are stored (ImportOptions::storeOccurrences).
+enum class OccurrenceFormat {
+    Rows,         // occurrences: one row per ply, with the move played
+    PostingLists, // occ_postings: per position, compressed (game id, ply) lists
+};
+
+struct ImportOptions {
+    QString pgnPath;
+    QString dbPath;             // sidecar SQLite file (created / migrated if needed)
+
+    int workerThreads{0};       // scan + SAN replay threads; 0 = hardware threads minus the writer
+    int batchGames{2000};       // games per writer transaction
+    int maxPlies{0};            // index only the first N plies of each game; 0 = all
+    bool storeOccurrences{true};
+    OccurrenceFormat occurrenceFormat{OccurrenceFormat::PostingLists};
+    QString openingTreePath;    // also export move_agg as a .cctree file; empty = skip
+};
+
+struct ImportProgress {
+    std::uint64_t bytesProcessed{0};
+    std::uint64_t totalBytes{0};
+    std::int64_t gamesImported{0};
+    std::int64_t gamesSkipped{0}; // movetext that failed SAN replay
+    double bytesPerSecond{0.0};
+    double gamesPerSecond{0.0};
+};
+
+struct ImportResult {
+    bool ok{false};
+    bool cancelled{false};
+    QString error;
+
+    std::int64_t gamesImported{0};
+    std::int64_t gamesSkipped{0};
+    std::int64_t pliesIndexed{0};
+    double seconds{0.0};
+};
+
+// PGN -> reference DB import pipeline:
+//
+//   N scan threads  scanPgnFileParallel() over byte ranges (unordered);
+//                   each game is replayed in place (Lazy timeline) into
+//                   Zobrist keys + UCI moves and queued (bounded queue)
+//   writer          the calling thread; prepared statements, one transaction
+//                   per batch, move_agg (and posting lists) gathered in
+//                   memory per batch and written in key order on commit
+//
+// run() blocks; call it from a worker thread (the writer opens its own
+// QSqlDatabase connection in that thread). onProgress is invoked from the
+// calling thread a few times per second. Cancellation is cooperative and
+// leaves every committed batch in place.
+class ReferenceDbImporter final {
+public:
+    using ProgressFn = std::function<void(const ImportProgress&)>;
+
+    static ImportResult run(const ImportOptions& options,
+                            const std::atomic<bool>& cancel,
+                            const ProgressFn& onProgress = {});
+};
+
+} // namespace sf::client::infra::refdb
@@ -0,0 +1,418 @@
+#include "infra/refdb/ReferenceDbQuery.hpp"
+
+#include "domain/chess/PackedMove.hpp"
+#include "domain/chess/Position.hpp"
+#include "infra/refdb/OpeningTreeFile.hpp"
+#include "infra/refdb/PostingList.hpp"
+#include "infra/refdb/ReferenceDbRepository.hpp"
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVariant>
+
+#include <algorithm>
+#include <optional>
+
+namespace sf::client::infra::refdb {
+
+namespace chess = sf::client::domain::chess;
+
+namespace {
+
+// Children fetched per prefetch round (most played moves first).
+constexpr std::size_t kMaxChildPrefetch = 12;
+
+QString uniqueConnectionName() {
+    static std::atomic<int> seq{0};
+    return QStringLiteral("refdb-query-%1").arg(seq.fetch_add(1));
+}
+
+} // namespace
+
+// Owns the SQLite connection (or the mapped opening tree); every method
+// runs on the query thread.
+class ReferenceDbQuery::Worker final : public QObject {
+public:
+    ~Worker() override { closeDb(); }
+
+    bool openDb(const QString& path, QString* err) {
+        closeDb();
+        if (path.endsWith(QLatin1String(kOpeningTreeSuffix), Qt::CaseInsensitive)) {
+            std::string e;
+            if (!tree_.open(path.toStdString(), &e)) {
+                if (err) *err = QString::fromStdString(e);
+                return false;
+            }
+            return true;
+        }
+        connName_ = uniqueConnectionName();
+
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connName_);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            if (err) *err = db.lastError().text();
+            closeDb();
+            return false;
+        }
+        if (!ReferenceDbRepository::createOrMigrate(db, err)) {
+            closeDb();
+            return false;
+        }
+        if (ReferenceDbRepository::needsReindex(db)) {
+            if (err) *err = QStringLiteral("Reference index uses an old position key format; rebuild it");
+            closeDb();
+            return false;
+        }
+
+        filter_ = ReferenceDbRepository::loadPositionFilter(db);
+
+        byPos_ = std::make_unique<QSqlQuery>(db);
+        if (!byPos_->prepare(R"SQL(
+                SELECT move_uci, games, w, d, l, year_min, year_max, last_date_int
+                FROM move_agg
+                WHERE pos_hash = ?
+                ORDER BY games DESC;
+            )SQL")) {
+            if (err) *err = byPos_->lastError().text();
+            closeDb();
+            return false;
+        }
+
+        postingsByPos_ = std::make_unique<QSqlQuery>(db);
+        occRowsByPos_ = std::make_unique<QSqlQuery>(db);
+        occCountByPos_ = std::make_unique<QSqlQuery>(db);
+        gameById_ = std::make_unique<QSqlQuery>(db);
+        for (const auto& [stmt, sql] : {
+                 std::pair{postingsByPos_.get(), "SELECT first_game_id, count, data FROM occ_postings "
+                                                 "WHERE pos_hash = ? ORDER BY first_game_id;"},
+                 std::pair{occRowsByPos_.get(), "SELECT game_id, ply FROM occurrences "
+                                                "WHERE pos_hash = ? ORDER BY game_id, ply LIMIT ?;"},
+                 std::pair{occCountByPos_.get(), "SELECT COUNT(*) FROM occurrences WHERE pos_hash = ?;"},
+                 std::pair{gameById_.get(), "SELECT white, black, result, date_int FROM games WHERE id = ?;"}}) {
+            stmt->setForwardOnly(true);
+            if (!stmt->prepare(QString::fromLatin1(sql))) {
+                if (err) *err = stmt->lastError().text();
+                closeDb();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void closeDb() {
+        tree_.close();
+        filter_.reset();
+        byPos_.reset();
+        postingsByPos_.reset();
+        occRowsByPos_.reset();
+        occCountByPos_.reset();
+        gameById_.reset();
+        if (connName_.isEmpty()) return;
+        {
+            QSqlDatabase db = QSqlDatabase::database(connName_, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connName_);
+        connName_.clear();
+    }
+
+    bool isReady() const { return byPos_ != nullptr || tree_.isOpen(); }
+
+    std::shared_ptr<const PositionStats> fetch(std::uint64_t posHash) {
+        if (tree_.isOpen()) return fetchTree(posHash);
+        if (!byPos_) return nullptr;
+        if (filter_ && !filter_->mayContain(posHash)) {
+            // Definitely not indexed: skip the B-tree probe.
+            auto empty = std::make_shared<PositionStats>();
+            empty->posHash = posHash;
+            return empty;
+        }
+        byPos_->bindValue(0, ReferenceDbRepository::toDbKey(posHash));
+        if (!byPos_->exec()) return nullptr;
+
+        auto stats = std::make_shared<PositionStats>();
+        stats->posHash = posHash;
+        while (byPos_->next()) {
+            MoveStats m;
+            m.uci = byPos_->value(0).toString();
+            m.games = byPos_->value(1).toInt();
+            m.w = byPos_->value(2).toInt();
+            m.d = byPos_->value(3).toInt();
+            m.l = byPos_->value(4).toInt();
+            m.yearMin = byPos_->value(5).toInt();
+            m.yearMax = byPos_->value(6).toInt();
+            m.lastDateInt = byPos_->value(7).toInt();
+            stats->games += m.games;
+            stats->moves.push_back(std::move(m));
+        }
+        byPos_->finish();
+        return stats;
+    }
+
+    std::shared_ptr<const PositionGames> fetchGames(std::uint64_t posHash, int limit) {
+        auto result = std::make_shared<PositionGames>();
+        result->posHash = posHash;
+        // Every occurrence is also counted in move_agg, so the filter holds.
+        if (tree_.isOpen() || !postingsByPos_ || (filter_ && !filter_->mayContain(posHash))) {
+            return result;
+        }
+        const std::size_t wanted = static_cast<std::size_t>(std::max(1, limit));
+        const qint64 key = ReferenceDbRepository::toDbKey(posHash);
+
+        std::vector<Posting> found;
+        postingsByPos_->bindValue(0, key);
+        if (!postingsByPos_->exec()) return nullptr;
+        while (postingsByPos_->next()) {
+            result->occurrences += postingsByPos_->value(1).toLongLong();
+            if (found.size() >= wanted) continue; // later chunks are only counted
+            const QByteArray data = postingsByPos_->value(2).toByteArray();
+            decodePostings(data.constData(), static_cast<std::size_t>(data.size()),
+                           postingsByPos_->value(0).toLongLong(), found, wanted - found.size());
+        }
+        postingsByPos_->finish();
+
+        occCountByPos_->bindValue(0, key);
+        if (occCountByPos_->exec() && occCountByPos_->next()) {
+            const qint64 rows = occCountByPos_->value(0).toLongLong();
+            occCountByPos_->finish();
+            result->occurrences += rows;
+            if (rows > 0) {
+                occRowsByPos_->bindValue(0, key);
+                occRowsByPos_->bindValue(1, static_cast<qint64>(wanted));
+                if (occRowsByPos_->exec()) {
+                    while (occRowsByPos_->next()) {
+                        found.push_back(Posting{occRowsByPos_->value(0).toLongLong(),
+                                                occRowsByPos_->value(1).toInt()});
+                    }
+                    occRowsByPos_->finish();
+                }
+            }
+        }
+
+        // First ply per game, in import order.
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end(),
+                                [](const Posting& a, const Posting& b) { return a.gameId == b.gameId; }),
+                    found.end());
+        if (found.size() > wanted) found.resize(wanted);
+
+        result->games.reserve(found.size());
+        for (const Posting& p : found) {
+            GameRef g;
+            g.gameId = p.gameId;
+            g.ply = p.ply;
+            gameById_->bindValue(0, p.gameId);
+            if (gameById_->exec() && gameById_->next()) {
+                g.white = gameById_->value(0).toString();
+                g.black = gameById_->value(1).toString();
+                g.result = gameById_->value(2).toString();
+                g.dateInt = gameById_->value(3).toInt();
+            }
+            gameById_->finish();
+            result->games.push_back(std::move(g));
+        }
+        return result;
+    }
+
+private:
+    std::shared_ptr<const PositionStats> fetchTree(std::uint64_t posHash) const {
+        auto stats = std::make_shared<PositionStats>();
+        stats->posHash = posHash;
+        const auto [first, last] = tree_.equalRange(posHash);
+        for (const OpeningTreeRecord* r = first; r != last; ++r) {
+            MoveStats m;
+            m.uci = QString::fromStdString(chess::packedToUci(r->move));
+            m.games = static_cast<int>(r->games());
+            m.w = static_cast<int>(r->w());
+            m.d = static_cast<int>(r->d());
+            m.l = static_cast<int>(r->l());
+            m.yearMin = OpeningTreeRecord::decodeYear(r->yearMin);
+            m.yearMax = OpeningTreeRecord::decodeYear(r->yearMax);
+            stats->games += m.games;
+            stats->moves.push_back(std::move(m));
+        }
+        return stats;
+    }
+
+    QString connName_;
+    std::unique_ptr<QSqlQuery> byPos_;
+    std::unique_ptr<QSqlQuery> postingsByPos_;
+    std::unique_ptr<QSqlQuery> occRowsByPos_;
+    std::unique_ptr<QSqlQuery> occCountByPos_;
+    std::unique_ptr<QSqlQuery> gameById_;
+    std::optional<PositionFilter> filter_; // absent for sidecars imported before the filter existed
+    OpeningTreeFile tree_;
+};
+
+ReferenceDbQuery::ReferenceDbQuery(QObject* parent, std::size_t cacheCapacity)
+    : QObject(parent)
+    , capacity_(std::max<std::size_t>(1, cacheCapacity)) {
+    thread_ = new QThread(this);
+    thread_->setObjectName(QStringLiteral("refdb-query"));
+    worker_ = new Worker();
+    worker_->moveToThread(thread_);
+    thread_->start();
+}
+
+ReferenceDbQuery::~ReferenceDbQuery() {
+    epoch_.fetch_add(1);
+    // The connection must be closed on the thread that opened it.
+    QMetaObject::invokeMethod(worker_, [w = worker_]() { w->closeDb(); }, Qt::BlockingQueuedConnection);
+    thread_->quit();
+    thread_->wait();
+    delete worker_;
+}
+
+QString ReferenceDbQuery::dbPath() const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return dbPath_;
+}
+
+void ReferenceDbQuery::open(const QString& dbPath) {
+    const int epoch = epoch_.fetch_add(1) + 1;
+    open_.store(false);
+    clearCache();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        dbPath_ = dbPath;
+    }
+
+    QMetaObject::invokeMethod(worker_, [this, dbPath, epoch]() {
+        QString err;
+        if (!worker_->openDb(dbPath, &err)) {
+            emit failed(err);
+            return;
+        }
+        if (epoch != epoch_.load()) return; // superseded by another open()/close()
+        open_.store(true);
+        emit opened(dbPath);
+    }, Qt::QueuedConnection);
+}
+
+void ReferenceDbQuery::close() {
+    epoch_.fetch_add(1);
+    open_.store(false);
+    clearCache();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        dbPath_.clear();
+    }
+    QMetaObject::invokeMethod(worker_, [this]() { worker_->closeDb(); }, Qt::QueuedConnection);
+}
+
+std::shared_ptr<const PositionStats> ReferenceDbQuery::cached(std::uint64_t posHash) const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    const auto it = index_.find(posHash);
+    if (it == index_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second); // most recently used first
+    return it->second->second;
+}
+
+void ReferenceDbQuery::insert(std::uint64_t posHash, std::shared_ptr<const PositionStats> stats, int epoch) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (epoch != epoch_.load()) return;
+        const auto it = index_.find(posHash);
+        if (it != index_.end()) {
+            it->second->second = std::move(stats);
+            lru_.splice(lru_.begin(), lru_, it->second);
+        } else {
+            lru_.emplace_front(posHash, std::move(stats));
+            index_.emplace(posHash, lru_.begin());
+            if (lru_.size() > capacity_) {
+                index_.erase(lru_.back().first);
+                lru_.pop_back();
+            }
+        }
+    }
+    emit positionReady(static_cast<quint64>(posHash));
+}
+
+void ReferenceDbQuery::clearCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    lru_.clear();
+    index_.clear();
+    games_.reset();
+}
+
+std::shared_ptr<const PositionGames> ReferenceDbQuery::games(std::uint64_t posHash) const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return (games_ && games_->posHash == posHash) ? games_ : nullptr;
+}
+
+void ReferenceDbQuery::requestGames(std::uint64_t posHash, int limit) {
+    latestGames_.store(posHash);
+    const int epoch = epoch_.load();
+
+    QMetaObject::invokeMethod(worker_, [this, posHash, limit, epoch]() {
+        // Skipped when the user has already moved on.
+        if (epoch != epoch_.load() || !worker_->isReady() || latestGames_.load() != posHash) return;
+        auto result = worker_->fetchGames(posHash, limit);
+        if (!result) return;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex_);
+            if (epoch != epoch_.load()) return;
+            games_ = std::move(result);
+        }
+        emit gamesReady(static_cast<quint64>(posHash));
+    }, Qt::QueuedConnection);
+}
+
+void ReferenceDbQuery::lookup(std::uint64_t posHash) {
+    const int epoch = epoch_.load();
+
+    QMetaObject::invokeMethod(worker_, [this, posHash, epoch]() {
+        if (epoch != epoch_.load() || !worker_->isReady()) return;
+        if (cached(posHash)) {
+            emit positionReady(static_cast<quint64>(posHash));
+            return;
+        }
+        if (auto stats = worker_->fetch(posHash)) insert(posHash, std::move(stats), epoch);
+    }, Qt::QueuedConnection);
+}
+
+void ReferenceDbQuery::request(std::uint64_t posHash, const QString& fen, std::vector<std::uint64_t> prefetch) {
+    latest_.store(posHash);
+    const int epoch = epoch_.load();
+
+    QMetaObject::invokeMethod(worker_, [this, posHash, fen, prefetch = std::move(prefetch), epoch]() {
+        if (epoch != epoch_.load() || !worker_->isReady()) return;
+
+        auto fetchIfMissing = [&](std::uint64_t h) -> std::shared_ptr<const PositionStats> {
+            if (auto hit = cached(h)) return hit;
+            auto stats = worker_->fetch(h);
+            if (stats) insert(h, stats, epoch);
+            return stats;
+        };
+
+        const auto stats = fetchIfMissing(posHash);
+
+        // Prefetch only while the user is still on this position; a newer
+        // request() is already queued otherwise.
+        if (!stats || latest_.load() != posHash) return;
+
+        if (!fen.isEmpty()) {
+            if (const auto pos = chess::Position::fromFen(fen.toStdString())) {
+                std::size_t n = 0;
+                for (const auto& m : stats->moves) {
+                    if (n++ >= kMaxChildPrefetch || latest_.load() != posHash) break;
+                    const auto mv = pos->findLegalUci(m.uci.toStdString());
+                    if (!mv) continue;
+                    chess::Position child = *pos;
+                    chess::UndoInfo undo;
+                    child.makeMove(*mv, undo);
+                    fetchIfMissing(child.key());
+                }
+            }
+        }
+        for (const std::uint64_t h : prefetch) {
+            if (latest_.load() != posHash) break;
+            fetchIfMissing(h);
+        }
+    }, Qt::QueuedConnection);
+}
+
+} // namespace sf::client::infra::refdb
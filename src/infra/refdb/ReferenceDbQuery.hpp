@@ -0,0 +1,137 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class QThread;
+
+namespace sf::client::infra::refdb {
+
+// One row of move_agg. W/D/L are from the perspective of the side to move.
+struct MoveStats {
+    QString uci;
+    int games{0};
+    int w{0};
+    int d{0};
+    int l{0};
+    int yearMin{0};
+    int yearMax{0};
+    int lastDateInt{0};
+
+    double scorePercent() const { return games > 0 ? 100.0 * (w + 0.5 * d) / games : 0.0; }
+};
+
+struct PositionStats {
+    std::uint64_t posHash{0};
+    qint64 games{0};
+    std::vector<MoveStats> moves; // most played first
+};
+
+// A game that reaches a position, with the headers the games list shows.
+struct GameRef {
+    qint64 gameId{0};
+    int ply{0}; // plies played before the position is reached
+    QString white;
+    QString black;
+    QString result;
+    int dateInt{0};
+};
+
+struct PositionGames {
+    std::uint64_t posHash{0};
+    qint64 occurrences{0};      // all of them; a game reaching it twice counts twice
+    std::vector<GameRef> games; // the first ones in import order, one per game
+};
+
+// Opening-explorer lookups over move_agg, or over an exported opening tree
+// file (see OpeningTreeFile.hpp) when the path ends in ".cctree".
+//
+// Queries run on a private thread with its own SQLite connection and a
+// prepared statement keyed on pos_hash. The sidecar's position filter is
+// checked first, so positions absent from the index never reach SQLite.
+// Results land in an LRU cache that the UI probes synchronously with
+// cached(). request() never blocks: on a miss the caller shows a
+// placeholder and repaints on positionReady().
+//
+// Prefetch: when request() gets the position's FEN, the children reached by
+// the moves found are fetched as well (only while that position is still
+// the latest one requested), plus any extra hashes the caller passes, e.g.
+// the next plies of the game being viewed.
+//
+// Games lists come from occ_postings (decoded posting lists) and/or the
+// occurrences rows, whichever the import wrote; only the answer to the
+// latest requestGames() is kept.
+class ReferenceDbQuery final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultGamesLimit = 200;
+
+    explicit ReferenceDbQuery(QObject* parent = nullptr, std::size_t cacheCapacity = 4096);
+    ~ReferenceDbQuery() override;
+
+    // Asynchronous; reports opened() or failed(). Clears the cache.
+    void open(const QString& dbPath);
+    void close();
+
+    bool isOpen() const { return open_.load(); }
+    QString dbPath() const;
+
+    // Cache probe; nullptr on a miss. Safe to call from any thread.
+    std::shared_ptr<const PositionStats> cached(std::uint64_t posHash) const;
+
+    void request(std::uint64_t posHash,
+                 const QString& fen = QString(),
+                 std::vector<std::uint64_t> prefetch = {});
+
+    // Background fetch for callers other than the viewer (e.g. the ICCF
+    // pipeline): leaves the latest position and its prefetch alone, and
+    // reports positionReady() for a cache hit too.
+    void lookup(std::uint64_t posHash);
+
+    // Games reaching posHash; reports gamesReady(). Empty for opening tree
+    // files and indexes imported without occurrences.
+    void requestGames(std::uint64_t posHash, int limit = kDefaultGamesLimit);
+    // Result of the latest requestGames() if it was for posHash, else nullptr.
+    std::shared_ptr<const PositionGames> games(std::uint64_t posHash) const;
+
+signals:
+    void opened(const QString& dbPath);
+    void failed(const QString& message);
+    void positionReady(quint64 posHash);
+    void gamesReady(quint64 posHash);
+
+private:
+    class Worker;
+
+    void insert(std::uint64_t posHash, std::shared_ptr<const PositionStats> stats, int epoch);
+    void clearCache();
+
+    QThread* thread_{nullptr};
+    Worker* worker_{nullptr};
+
+    std::atomic<bool> open_{false};
+    std::atomic<int> epoch_{0};            // bumped by open()/close(); stale results are dropped
+    std::atomic<std::uint64_t> latest_{0}; // last position passed to request()
+    std::atomic<std::uint64_t> latestGames_{0}; // ... and to requestGames()
+
+    // ---- LRU cache (guarded by cacheMutex_) ----
+    using LruList = std::list<std::pair<std::uint64_t, std::shared_ptr<const PositionStats>>>;
+
+    mutable std::mutex cacheMutex_;
+    mutable LruList lru_;
+    std::unordered_map<std::uint64_t, LruList::iterator> index_;
+    std::shared_ptr<const PositionGames> games_;
+    std::size_t capacity_;
+    QString dbPath_;
+};
+
+} // namespace sf::client::infra::refdb
@@ -1,7 +1,9 @@
 #include "ReferenceDbRepository.hpp"
 
+#include <QByteArray>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QVariant>
 
 namespace sf::client::infra::refdb {
 
@@ -15,6 +17,44 @@ bool execOrFail(QSqlQuery& q, const QString& sql, QString* err) {
     return true;
 }
 
+// Returns 0 for a fresh database (no meta row yet).
+int readSchemaVersion(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!q.exec("SELECT value FROM meta WHERE key='schema_version';")) return 0;
+    if (!q.next()) return 0;
+    return q.value(0).toString().toInt();
+}
+
+// v1 -> v2: position keys changed from FNV-1a(FEN) to Zobrist. Old rows can't be
+// converted without replaying every game, so position data is dropped and
+// the sidecar is flagged for a rebuild from its PGN.
+bool migrateV1ToV2(QSqlDatabase& db, QString* err) {
+    if (!db.transaction()) {
+        if (err) *err = db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery q(db);
+    const bool ok =
+        execOrFail(q, "DELETE FROM occurrences;", err) &&
+        execOrFail(q, "DELETE FROM occ_postings;", err) &&
+        execOrFail(q, "DELETE FROM move_agg;", err) &&
+        execOrFail(q, "DELETE FROM games;", err) &&
+        execOrFail(q, "DELETE FROM source_files;", err) &&
+        execOrFail(q, "DELETE FROM meta WHERE key='pos_filter';", err) &&
+        execOrFail(q, "INSERT OR REPLACE INTO meta(key, value) VALUES('needs_reindex', '1');", err);
+
+    if (!ok) {
+        db.rollback();
+        return false;
+    }
+    if (!db.commit()) {
+        if (err) *err = db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
 } // namespace
 
 bool ReferenceDbRepository::createOrMigrate(QSqlDatabase& db, QString* errorOut) {
@@ -113,10 +153,81 @@ bool ReferenceDbRepository::createOrMigrate(QSqlDatabase& db, QString* errorOut)
     if (!execOrFail(q, "CREATE INDEX IF NOT EXISTS idx_occ_pos ON occurrences(pos_hash);", errorOut)) return false;
     if (!execOrFail(q, "CREATE INDEX IF NOT EXISTS idx_occ_pos_move ON occurrences(pos_hash, move_uci);", errorOut)) return false;
 
+    // The same occurrences as posting lists (PostingList.hpp): one chunk per
+    // position per import batch, keyed by the chunk's first game id so a
+    // position's chunks are adjacent and in game order.
+    if (!execOrFail(q, R"SQL(
+        CREATE TABLE IF NOT EXISTS occ_postings (
+            pos_hash INTEGER NOT NULL,
+            first_game_id INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            data BLOB NOT NULL,
+            PRIMARY KEY(pos_hash, first_game_id)
+        ) WITHOUT ROWID;
+    )SQL", errorOut)) return false;
+
+    // 2 -> 3 only adds occ_postings, created above.
+    const int fromVersion = readSchemaVersion(db);
+    if (fromVersion == 1) {
+        if (!migrateV1ToV2(db, errorOut)) return false;
+    }
+
     // Bump schema version in meta for future migrations.
-    if (!execOrFail(q, "INSERT OR REPLACE INTO meta(key, value) VALUES('schema_version', '1');", errorOut)) return false;
+    if (!execOrFail(q, QString("INSERT OR REPLACE INTO meta(key, value) VALUES('schema_version', '%1');")
+                           .arg(kSchemaVersion), errorOut)) return false;
+    if (!execOrFail(q, "INSERT OR REPLACE INTO meta(key, value) VALUES('pos_hash', 'zobrist64');", errorOut)) return false;
 
     return true;
 }
 
+bool ReferenceDbRepository::needsReindex(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!q.exec("SELECT value FROM meta WHERE key='needs_reindex';")) return false;
+    return q.next() && q.value(0).toString() == "1";
+}
+
+bool ReferenceDbRepository::clearNeedsReindex(QSqlDatabase& db, QString* errorOut) {
+    QSqlQuery q(db);
+    return execOrFail(q, "DELETE FROM meta WHERE key='needs_reindex';", errorOut);
+}
+
+bool ReferenceDbRepository::rebuildPositionFilter(QSqlDatabase& db, QString* errorOut) {
+    QSqlQuery q(db);
+    q.setForwardOnly(true);
+    if (!q.exec("SELECT COUNT(*) FROM move_agg;") || !q.next()) {
+        if (errorOut) *errorOut = q.lastError().text();
+        return false;
+    }
+    // Rows per position are usually few, so the row count is a fair upper bound.
+    PositionFilter filter(static_cast<std::size_t>(q.value(0).toLongLong()));
+
+    if (!q.exec("SELECT DISTINCT pos_hash FROM move_agg;")) {
+        if (errorOut) *errorOut = q.lastError().text();
+        return false;
+    }
+    while (q.next()) filter.insert(fromDbKey(q.value(0).toLongLong()));
+
+    const std::string blob = filter.serialize();
+    QSqlQuery ins(db);
+    ins.prepare("INSERT OR REPLACE INTO meta(key, value) VALUES('pos_filter', ?);");
+    ins.addBindValue(QByteArray(blob.data(), static_cast<int>(blob.size())));
+    if (!ins.exec()) {
+        if (errorOut) *errorOut = ins.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool ReferenceDbRepository::dropPositionFilter(QSqlDatabase& db, QString* errorOut) {
+    QSqlQuery q(db);
+    return execOrFail(q, "DELETE FROM meta WHERE key='pos_filter';", errorOut);
+}
+
+std::optional<PositionFilter> ReferenceDbRepository::loadPositionFilter(QSqlDatabase& db) {
+    QSqlQuery q(db);
+    if (!q.exec("SELECT value FROM meta WHERE key='pos_filter';") || !q.next()) return std::nullopt;
+    const QByteArray blob = q.value(0).toByteArray();
+    return PositionFilter::deserialize(blob.constData(), static_cast<std::size_t>(blob.size()));
+}
+
 } // namespace sf::client::infra::refdb
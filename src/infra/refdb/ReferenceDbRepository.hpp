@@ -3,13 +3,40 @@
 #include <QSqlDatabase>
 #include <QString>
 
+#include <cstdint>
+#include <optional>
+
+#include "infra/refdb/PositionFilter.hpp"
+
 namespace sf::client::infra::refdb {
 
 // Sidecar SQLite index for a large PGN file (ChessBase-like reference database).
 // This repository only contains schema creation / migration helpers.
+//
+// Schema history:
+//   1 - pos_hash = FNV-1a over the counter-less FEN
+//   2 - pos_hash = 64-bit Zobrist key (domain/chess/Zobrist.hpp)
+//   3 - occ_postings: occurrences as compressed posting lists
 class ReferenceDbRepository final {
 public:
+    static constexpr int kSchemaVersion = 3;
+
     static bool createOrMigrate(QSqlDatabase& db, QString* errorOut);
+
+    // True if a migration dropped position data and the PGN must be re-imported.
+    static bool needsReindex(QSqlDatabase& db);
+    static bool clearNeedsReindex(QSqlDatabase& db, QString* errorOut);
+
+    // Membership filter over move_agg.pos_hash, kept in meta('pos_filter').
+    // Importers drop it before writing and rebuild it once they finish, so a
+    // stored filter never misses a position that is in the table.
+    static bool rebuildPositionFilter(QSqlDatabase& db, QString* errorOut);
+    static bool dropPositionFilter(QSqlDatabase& db, QString* errorOut);
+    static std::optional<PositionFilter> loadPositionFilter(QSqlDatabase& db);
+
+    // SQLite integers are signed: 64-bit position keys are stored bit-for-bit.
+    static qint64 toDbKey(std::uint64_t key) { return static_cast<qint64>(key); }
+    static std::uint64_t fromDbKey(qint64 v) { return static_cast<std::uint64_t>(v); }
 };
 
 } // namespace sf::client::infra::refdb
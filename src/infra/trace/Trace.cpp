@@ -0,0 +1,194 @@
+#include "infra/trace/Trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sf::client::infra::trace {
+
+namespace {
+
+// Fields are atomics so a dump can read a slot the owner thread is
+// overwriting without a data race (it may still see a mix of two spans).
+struct Slot {
+    std::atomic<const char*>  name{nullptr};
+    std::atomic<std::int64_t> startNs{0};
+    std::atomic<std::int64_t> endNs{0};
+};
+
+struct ThreadBuffer {
+    int         tid{0};
+    std::string name; // guarded by Registry::mutex
+
+    std::unique_ptr<Slot[]>    slots{new Slot[kRingCapacity]};
+    std::atomic<std::uint64_t> head{0}; // spans ever written; owner thread stores
+};
+
+// Buffers outlive their threads so short-lived workers still show up.
+struct Registry {
+    std::mutex                                 mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+std::atomic<std::int64_t> g_recordingStartNs{0};
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& threadBuffer() {
+    if (!t_buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        Registry& r = registry();
+        const std::lock_guard<std::mutex> lock(r.mutex);
+        buffer->tid  = static_cast<int>(r.buffers.size()) + 1;
+        buffer->name = "thread " + std::to_string(buffer->tid);
+        r.buffers.push_back(buffer);
+        t_buffer = buffer.get();
+    }
+    return *t_buffer;
+}
+
+void writeJsonString(std::FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; *s; ++s) {
+        const auto c = static_cast<unsigned char>(*s);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', f);
+            std::fputc(c, f);
+        } else if (c < 0x20) {
+            std::fprintf(f, "\\u%04x", c);
+        } else {
+            std::fputc(c, f);
+        }
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+void setRecording(bool on) {
+    if (on) {
+        g_recordingStartNs.store(nowNs(), std::memory_order_relaxed);
+    }
+    detail::recording.store(on, std::memory_order_relaxed);
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    const std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+std::int64_t nowNs() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void record(const char* name, std::int64_t startNs, std::int64_t endNs) noexcept {
+    ThreadBuffer& buffer = threadBuffer();
+    const std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Slot& slot = buffer.slots[head % kRingCapacity];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::size_t bufferedSpanCount() {
+    const std::int64_t since = g_recordingStartNs.load(std::memory_order_relaxed);
+    Registry& r = registry();
+    const std::lock_guard<std::mutex> lock(r.mutex);
+    std::size_t count = 0;
+    for (const auto& buffer : r.buffers) {
+        const std::uint64_t head  = buffer->head.load(std::memory_order_acquire);
+        const std::uint64_t first = head > kRingCapacity ? head - kRingCapacity : 0;
+        for (std::uint64_t i = first; i < head; ++i) {
+            if (buffer->slots[i % kRingCapacity].startNs.load(std::memory_order_relaxed) >= since) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+bool writeChromeTrace(const std::string& path, std::string* error) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        if (error) {
+            *error = "cannot open " + path + " for writing";
+        }
+        return false;
+    }
+
+    const std::int64_t since = g_recordingStartNs.load(std::memory_order_relaxed);
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string>                   names;
+    {
+        Registry& r = registry();
+        const std::lock_guard<std::mutex> lock(r.mutex);
+        buffers = r.buffers;
+        for (const auto& buffer : buffers) {
+            names.push_back(buffer->name);
+        }
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    bool first = true;
+    auto separator = [&] {
+        if (!first) {
+            std::fputs(",\n", f);
+        }
+        first = false;
+    };
+
+    for (std::size_t b = 0; b < buffers.size(); ++b) {
+        const ThreadBuffer& buffer = *buffers[b];
+
+        separator();
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                     buffer.tid);
+        writeJsonString(f, names[b].c_str());
+        std::fputs("}}", f);
+
+        const std::uint64_t head  = buffer.head.load(std::memory_order_acquire);
+        const std::uint64_t begin = head > kRingCapacity ? head - kRingCapacity : 0;
+        for (std::uint64_t i = begin; i < head; ++i) {
+            const Slot& slot = buffer.slots[i % kRingCapacity];
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            const std::int64_t start = slot.startNs.load(std::memory_order_relaxed);
+            const std::int64_t end   = slot.endNs.load(std::memory_order_relaxed);
+            if (!name || start < since || end < start) {
+                continue;
+            }
+            separator();
+            std::fputs("{\"name\":", f);
+            writeJsonString(f, name);
+            // Chrome expects microseconds; keep ns precision as decimals.
+            std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         buffer.tid,
+                         static_cast<double>(start - since) / 1000.0,
+                         static_cast<double>(end - start) / 1000.0);
+        }
+    }
+    std::fputs("\n]}\n", f);
+
+    const bool ok = std::ferror(f) == 0;
+    if (std::fclose(f) != 0 || !ok) {
+        if (error) {
+            *error = "write to " + path + " failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace sf::client::infra::trace
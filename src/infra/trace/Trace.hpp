@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped timers for hot paths, exported as a Chrome trace_event JSON file
+// (chrome://tracing, https://ui.perfetto.dev).
+//
+//   void JobConnection::handleJsonLine(QByteArrayView line) {
+//       CORRCHESS_TRACE_SCOPE("net.parseJsonLine");
+//       ...
+//
+// Spans land in a per-thread ring buffer (the newest kRingCapacity per
+// thread are kept); after a thread's first span nothing is locked or
+// allocated on the recording path.
+// Recording is off until setRecording(true); while off a span costs one
+// relaxed atomic load.
+//
+// The macros compile to nothing unless CORRCHESS_TRACE is defined (Debug
+// builds and -DCORRCHESS_ENABLE_TRACING=ON, see CMakeLists.txt). Names must
+// be string literals or otherwise outlive the process' last dump.
+
+namespace sf::client::infra::trace {
+
+inline constexpr std::size_t kRingCapacity = 1 << 16; // spans per thread
+
+#if defined(CORRCHESS_TRACE)
+inline constexpr bool kCompiledIn = true;
+#else
+inline constexpr bool kCompiledIn = false;
+#endif
+
+namespace detail {
+inline std::atomic<bool> recording{false};
+} // namespace detail
+
+inline bool isRecording() noexcept {
+    return detail::recording.load(std::memory_order_relaxed);
+}
+// Starting a recording drops spans from earlier ones.
+void setRecording(bool on);
+
+// Label for the calling thread in the trace viewer (default "thread N").
+void setThreadName(const char* name);
+
+std::int64_t nowNs() noexcept;
+void record(const char* name, std::int64_t startNs, std::int64_t endNs) noexcept;
+
+// Writes every buffered span as {"traceEvents":[...]}. Threads may keep
+// recording meanwhile; spans overwritten during the dump can come out
+// with mismatched times, so stop recording first for a clean file.
+bool writeChromeTrace(const std::string& path, std::string* error = nullptr);
+
+// Spans currently held in all ring buffers.
+std::size_t bufferedSpanCount();
+
+class Scope final {
+public:
+    explicit Scope(const char* name) noexcept
+        : name_(isRecording() ? name : nullptr)
+        , startNs_(name_ ? nowNs() : 0) {}
+
+    ~Scope() {
+        if (name_) {
+            record(name_, startNs_, nowNs());
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char*  name_;
+    std::int64_t startNs_;
+};
+
+} // namespace sf::client::infra::trace
+
+#if defined(CORRCHESS_TRACE)
+#define CORRCHESS_TRACE_CONCAT_(a, b) a##b
+#define CORRCHESS_TRACE_CONCAT(a, b) CORRCHESS_TRACE_CONCAT_(a, b)
+#define CORRCHESS_TRACE_SCOPE(name) \
+    const ::sf::client::infra::trace::Scope CORRCHESS_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define CORRCHESS_TRACE_THREAD_NAME(name) ::sf::client::infra::trace::setThreadName(name)
+#else
+#define CORRCHESS_TRACE_SCOPE(name) ((void)0)
+#define CORRCHESS_TRACE_THREAD_NAME(name) ((void)0)
+#endif
@@ -1,20 +1,30 @@
 #include <QApplication>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
 #include <QString>
 #include <QTimer>
 
 #include "infra/ServerConfigRepository.hpp"
 #include "infra/HistoryRepository.hpp"
+#include "infra/trace/Trace.hpp"
 #include "app/ServerManager.hpp"
 #include "app/JobManager.hpp"
 #include "app/IccfSyncManager.hpp"   // <-- ADD
+#include "app/IccfAnalysisPipeline.hpp"
+#include "app/MemoryBudget.hpp"
 #include "net/JobNetworkController.hpp"
 #include "ui/MainWindow.hpp"
 
 int main(int argc, char* argv[]) {
     QApplication app(argc, argv);
 
+    // Trace builds: CORRCHESS_TRACE_RECORD=1 records from startup (Tools menu otherwise).
+    CORRCHESS_TRACE_THREAD_NAME("gui");
+    if (sf::client::infra::trace::kCompiledIn && qEnvironmentVariableIntValue("CORRCHESS_TRACE_RECORD") != 0) {
+        sf::client::infra::trace::setRecording(true);
+    }
+
     const QString appDir = QCoreApplication::applicationDirPath();
     qDebug() << "Application dir:" << appDir;
 
@@ -33,29 +43,63 @@ int main(int argc, char* argv[]) {
     const auto servers = configRepo.load();
 
     sf::client::app::ServerManager serverManager(servers);
+    serverManager.setSchedulingPolicy(configRepo.loadSchedulingPolicy());
 
     sf::client::infra::HistoryRepository historyRepo(dbPath);
+    // Recent jobs give the cost-based scheduler NPS figures before the first
+    // update arrives (snapshots only; logs stay on disk).
+    serverManager.seedThroughput(historyRepo.loadJobsPage(std::nullopt, 500, /*withSnapshots*/ true).jobs);
     sf::client::app::JobManager jobManager(serverManager, &historyRepo);
 
+    // Per-job logs keep the newest lines in memory; older ones go to job_logs/<id>.log.
+    const QString jobLogDir = appDir + "/job_logs";
+    QDir().mkpath(jobLogDir);
+    jobManager.setLogLimits(sf::client::domain::JobLogOptions::kDefaultCapacity,
+                            jobLogDir.toStdString());
+
     sf::client::net::JobNetworkController netController(jobManager, serverManager);
+    netController.setFailoverGraceMs(configRepo.loadFailoverGraceSeconds() * 1000);
     netController.initializeConnections(serverManager.servers());
 
     // ICCF sync manager (GetMyGames, read-only for now).
     sf::client::app::IccfSyncManager iccfSync(&app);
 
+    // Submits my-turn positions (and likely replies) as syncs report moves;
+    // off until switched on in the ICCF tab.
+    sf::client::app::IccfAnalysisPipeline iccfPipeline(jobManager, &app);
+    QObject::connect(&iccfSync, &sf::client::app::IccfSyncManager::gamesChanged,
+                     &iccfPipeline, &sf::client::app::IccfAnalysisPipeline::onGamesChanged);
+
     // Use NEW MainWindow overload with ICCF wiring:
     sf::client::ui::MainWindow w(jobManager, serverManager, &historyRepo, &iccfSync);
+    w.setIccfAnalysisPipeline(&iccfPipeline);
+
+    // Long sessions: finished jobs drop to their summary rows after a while
+    // (details reload from history), see Tools > Memory usage.
+    sf::client::app::MemoryBudgetOptions budgetOptions;
+    budgetOptions.evictAfter = std::chrono::minutes(configRepo.loadEvictJobsAfterMinutes());
+    budgetOptions.jobBytes   = static_cast<std::size_t>(configRepo.loadJobMemoryBudgetMb()) << 20;
+    sf::client::app::MemoryBudget memoryBudget(jobManager, budgetOptions);
+    memoryBudget.addProbe([&iccfSync]() {
+        const auto& games = iccfSync.games();
+        return sf::client::app::SubsystemMemory{
+            "ICCF games", static_cast<std::size_t>(games.size()), games.byteSize(),
+            "last GetMyGames poll; the games table shares its strings"};
+    });
+    w.setMemoryBudget(&memoryBudget);
     w.show();
 
     sf::client::app::JobManagerCallbacks cb;
     cb.onJobAdded = [&](const sf::client::domain::Job& job) {
         w.notifyJobAddedOrUpdated(job);
         netController.handleJobAddedOrUpdated(job);
+        iccfPipeline.onJobUpdated(job);
     };
 
     cb.onJobUpdated = [&](const sf::client::domain::Job& job) {
         // UI must update on every change, including remote progress updates.
         w.notifyJobAddedOrUpdated(job);
+        iccfPipeline.onJobUpdated(job);
 
         // IMPORTANT:
         // We must submit job when it transitions from Pending -> Queued (server became available).
@@ -72,6 +116,11 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    cb.onJobExtended = [&](const sf::client::domain::Job& job) {
+        w.notifyJobAddedOrUpdated(job);
+        netController.handleJobExtended(job); // sends job_extend
+    };
+
     cb.onJobRemoved = [&](const sf::client::domain::Job& job) {
         w.notifyJobRemoved(job);
         netController.handleJobRemoved(job);
@@ -87,5 +136,12 @@ int main(int argc, char* argv[]) {
     });
     dispatchTimer.start();
 
+    QTimer memoryTimer;
+    memoryTimer.setInterval(60 * 1000);
+    QObject::connect(&memoryTimer, &QTimer::timeout, [&]() {
+        memoryBudget.enforce();
+    });
+    memoryTimer.start();
+
     return app.exec();
 }
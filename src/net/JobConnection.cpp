@@ -1,16 +1,26 @@
 #include "net/JobConnection.hpp"
 
+#include "infra/trace/Trace.hpp"
+
 #include <QCoreApplication>
 #include <QFile>
+#include <QCborArray>
+#include <QCborValue>
 #include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
+#include <QRandomGenerator>
 #include <QSslConfiguration>
 #include <QDebug>
 
+#include <algorithm>
+
 namespace sf::client::net {
 
 namespace {
 
+constexpr qint64 kNsPerMs = 1000000;
+
 bool readFileBytes(const QString& path, QByteArray& out) {
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly)) {
@@ -42,6 +52,22 @@ JobConnection::JobConnection(const QString& serverId,
     , tlsClientKeyFile_(tlsClientKeyFile) {
 
     socket_.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    socket_.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    clock_.start();
+
+    retryTimer_.setSingleShot(true);
+    connect(&retryTimer_, &QTimer::timeout, this, &JobConnection::connectToHost);
+
+    // CORRCHESS_CAPTURE_DIR=<dir> records the raw receive stream to
+    // <dir>/<serverId>.bin, e.g. as input for bench/wire_replay_bench.
+    const QString captureDir = qEnvironmentVariable("CORRCHESS_CAPTURE_DIR");
+    if (!captureDir.isEmpty()) {
+        capture_ = std::make_unique<QFile>(captureDir + QLatin1Char('/') + serverId_ + QStringLiteral(".bin"));
+        if (!capture_->open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "Cannot open capture file" << capture_->fileName();
+            capture_.reset();
+        }
+    }
 
     connect(&socket_, &QSslSocket::readyRead, this, &JobConnection::onReadyRead);
     connect(&socket_, &QSslSocket::connected, this, &JobConnection::onConnected);
@@ -49,6 +75,8 @@ JobConnection::JobConnection(const QString& serverId,
     connect(&socket_, &QSslSocket::encrypted, this, &JobConnection::onEncrypted);
     connect(&socket_, &QSslSocket::sslErrors, this, &JobConnection::onSslErrors);
     connect(&socket_, &QSslSocket::errorOccurred, this, &JobConnection::onSocketError);
+    connect(&socket_, &QSslSocket::stateChanged, this, &JobConnection::onStateChanged);
+    connect(&socket_, &QSslSocket::newSessionTicketReceived, this, &JobConnection::rememberSessionTicket);
 }
 
 void JobConnection::connectToHost() {
@@ -56,79 +84,268 @@ void JobConnection::connectToHost() {
     if (socket_.state() != QAbstractSocket::UnconnectedState) {
         return;
     }
+    // Backing off after a failure; retryTimer_ calls again when it is due.
+    if (clock_.nsecsElapsed() < nextAttemptNs_) {
+        return;
+    }
 
     if (tlsEnabled_) {
         if (!configureTls()) {
             qWarning() << "TLS configuration failed for" << serverId_ << ", refusing to connect.";
+            ++failedAttempts_;
+            scheduleRetry(); // the files may be fixed meanwhile
             return;
         }
+    }
+
+    attemptStartedNs_ = clock_.nsecsElapsed();
+    ++stats_.connectAttempts;
+    if (tlsEnabled_) {
         socket_.connectToHostEncrypted(host_, port_);
     } else {
         socket_.connectToHost(host_, port_);
     }
 }
 
+void JobConnection::onStateChanged(QAbstractSocket::SocketState state) {
+    if (state != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+    // Lost a session or failed to get one. Only a session that held for a
+    // while counts as success; one dropped right after the handshake (e.g.
+    // a server that accepts and then closes) keeps backing off.
+    const qint64 now = clock_.nsecsElapsed();
+    if (sessionStartedNs_ >= 0 && now - sessionStartedNs_ >= kStableSessionMs * kNsPerMs) {
+        failedAttempts_ = 0;
+    } else {
+        ++failedAttempts_;
+    }
+    sessionStartedNs_ = -1;
+    scheduleRetry();
+}
+
+void JobConnection::scheduleRetry() {
+    // Half the capped exponential delay plus a random share of the other
+    // half: clients that lost the same server spread out over time.
+    const int     shift  = std::min(failedAttempts_, 16);
+    const qint64  capped = std::min<qint64>(kRetryMaxMs, qint64{kRetryBaseMs} << shift);
+    const int     delay  = static_cast<int>(capped / 2 + QRandomGenerator::global()->bounded(capped / 2 + 1));
+    nextAttemptNs_ = clock_.nsecsElapsed() + delay * kNsPerMs;
+    retryTimer_.start(delay);
+}
+
+void JobConnection::checkLiveness() {
+    const qint64 now = clock_.nsecsElapsed();
+    if (sessionStartedNs_ >= 0) {
+        // Half-open: the link died without a FIN/RST reaching us, so the
+        // socket still looks connected.
+        if (now - lastReceiveNs_ > kHalfOpenTimeoutMs * kNsPerMs) {
+            qWarning() << "Nothing received from" << serverId_ << "for" << kHalfOpenTimeoutMs
+                       << "ms, dropping the connection";
+            socket_.abort();
+        }
+        return;
+    }
+    if (socket_.state() != QAbstractSocket::UnconnectedState
+        && now - attemptStartedNs_ > kConnectTimeoutMs * kNsPerMs) {
+        qWarning() << "Connecting to" << serverId_ << "timed out";
+        socket_.abort();
+    }
+}
+
 void JobConnection::onConnected() {
     // For TLS we only become message-ready after the handshake (onEncrypted).
     if (!tlsEnabled_) {
-        emit connectionReady(serverId_);
+        beginSession();
     }
 }
 
+void JobConnection::beginSession() {
+    sessionStartedNs_ = clock_.nsecsElapsed();
+    lastReceiveNs_    = sessionStartedNs_;
+    serverTimeMs_     = -1;
+    nextAttemptNs_    = 0;
+    retryTimer_.stop();
+
+    framer_.clear();
+    binaryOut_ = false;
+    serverFeatures_.clear();
+    jobUpdates_.reset();
+
+    // Offer binary framing. Servers that do not know "hello" ignore it and
+    // the connection simply stays on JSON.
+    QJsonObject hello;
+    hello.insert(QStringLiteral("type"), QStringLiteral("hello"));
+    hello.insert(QStringLiteral("protocols"),
+                 QJsonArray{QString::fromLatin1(wire::kProtocolCbor), QString::fromLatin1(wire::kProtocolJson)});
+    hello.insert(QStringLiteral("features"), QJsonArray{QString::fromLatin1(wire::kFeatureJobUpdateBatch)});
+    sendJson(hello);
+
+    emit connectionReady(serverId_);
+}
+
 void JobConnection::sendJson(const QJsonObject& obj) {
     if (!isConnected()) {
         return;
     }
+    if (binaryOut_) {
+        socket_.write(wire::encodeMessage(obj));
+        return;
+    }
     const auto payload = QJsonDocument(obj).toJson(QJsonDocument::Compact) + QByteArrayLiteral("\n");
     socket_.write(payload);
 }
 
+void JobConnection::sendPing() {
+    if (!isConnected()) {
+        return;
+    }
+    const std::uint32_t seq = ++pingSeq_;
+    pingSentNs_[seq % pingSentNs_.size()] = clock_.nsecsElapsed();
+
+    QJsonObject msg;
+    msg.insert(QStringLiteral("type"), QStringLiteral("ping"));
+    msg.insert(QStringLiteral("seq"), static_cast<qint64>(seq));
+    sendJson(msg);
+}
+
 void JobConnection::onReadyRead() {
-    buffer_.append(socket_.readAll());
+    const QByteArray data = socket_.readAll();
+    lastReceiveNs_ = clock_.nsecsElapsed();
+    stats_.bytesReceived += data.size();
+    if (capture_) {
+        capture_->write(data);
+    }
+    framer_.append(data);
     processIncomingData();
 }
 
 void JobConnection::processIncomingData() {
-    while (true) {
-        const int newlineIndex = buffer_.indexOf('\n');
-        if (newlineIndex < 0) {
-            break;
+    const bool ok = framer_.drain([this](const MessageFramer::Item& item) {
+        if (item.type == MessageFramer::ItemType::Frame) {
+            handleFrame(item.frameKind, item.bytes);
+        } else {
+            handleJsonLine(item.bytes);
         }
-
-        const QByteArray line = buffer_.left(newlineIndex);
-        buffer_.remove(0, newlineIndex + 1);
-
-        if (line.trimmed().isEmpty()) {
-            continue;
-        }
-        handleJsonLine(line);
+    });
+    if (!ok) {
+        qWarning() << "Oversized frame from server" << serverId_ << ", dropping connection";
+        socket_.abort();
     }
 }
 
-void JobConnection::handleJsonLine(const QByteArray& line) {
+void JobConnection::handleJsonLine(QByteArrayView line) {
+    CORRCHESS_TRACE_SCOPE("net.handleJsonLine");
+    ++stats_.messagesReceived;
+    const qint64 parseStart = clock_.nsecsElapsed();
+    // fromRawData wraps the view without copying; nothing keeps it past this call.
     QJsonParseError err{};
-    const auto      doc = QJsonDocument::fromJson(line, &err);
+    const auto      doc = QJsonDocument::fromJson(QByteArray::fromRawData(line.data(), line.size()), &err);
+    stats_.parseNanos += clock_.nsecsElapsed() - parseStart;
     if (err.error != QJsonParseError::NoError || !doc.isObject()) {
         qWarning() << "Failed to parse JSON from server" << serverId_ << ":" << err.errorString()
-                   << "line:" << QString::fromUtf8(line.left(200));
+                   << "line:" << QString::fromUtf8(line.first(qMin<qsizetype>(line.size(), 200)));
+        return;
+    }
+    handleMessage(doc.object());
+}
+
+void JobConnection::handleFrame(wire::FrameKind kind, QByteArrayView payload) {
+    CORRCHESS_TRACE_SCOPE("net.handleFrame");
+    ++stats_.messagesReceived;
+    qint64 parseStart = clock_.nsecsElapsed();
+    QCborParserError err{};
+    const auto value = QCborValue::fromCbor(payload.data(), payload.size(), &err);
+    stats_.parseNanos += clock_.nsecsElapsed() - parseStart;
+    const bool shapeOk = kind == wire::FrameKind::JobUpdateBatch ? value.isArray() : value.isMap();
+    if (err.error != QCborError::NoError || !shapeOk) {
+        qWarning() << "Failed to parse CBOR frame from server" << serverId_ << ":" << err.errorString();
         return;
     }
-    emit jsonReceived(serverId_, doc.object());
+
+    switch (kind) {
+        case wire::FrameKind::Message:
+            handleMessage(value.toMap().toJsonObject());
+            break;
+        case wire::FrameKind::JobUpdate: {
+            parseStart = clock_.nsecsElapsed();
+            QJsonObject update = jobUpdates_.expand(value.toMap());
+            stats_.parseNanos += clock_.nsecsElapsed() - parseStart;
+            emit jsonReceived(serverId_, update);
+            break;
+        }
+        case wire::FrameKind::JobUpdateBatch: {
+            // Expand in order (deltas build on each other) into the JSON shape.
+            parseStart = clock_.nsecsElapsed();
+            QJsonArray updates;
+            for (const auto& item : value.toArray()) {
+                updates.append(jobUpdates_.expand(item.toMap()));
+            }
+            QJsonObject batch;
+            batch.insert(QStringLiteral("type"), QStringLiteral("job_update_batch"));
+            batch.insert(QStringLiteral("updates"), updates);
+            stats_.parseNanos += clock_.nsecsElapsed() - parseStart;
+            emit jsonReceived(serverId_, batch);
+            break;
+        }
+        default:
+            qWarning() << "Unknown frame kind" << static_cast<int>(kind) << "from server" << serverId_;
+            break;
+    }
+}
+
+void JobConnection::handleMessage(const QJsonObject& obj) {
+    // Protocol negotiation and ping timing are internal to the connection.
+    const QString type = obj.value(QStringLiteral("type")).toString();
+    if (type == QLatin1String("pong")) {
+        const auto seq = static_cast<std::uint32_t>(obj.value(QStringLiteral("seq")).toInteger(0));
+        // Only the last few pings are remembered; older pongs are ignored.
+        if (seq != 0 && pingSeq_ - seq < pingSentNs_.size()) {
+            stats_.lastRttMs = (clock_.nsecsElapsed() - pingSentNs_[seq % pingSentNs_.size()]) / 1e6;
+        }
+        serverTimeMs_ = obj.value(QStringLiteral("server_time_ms")).toInteger(-1);
+        return;
+    }
+    if (type == QLatin1String("hello")) {
+        binaryOut_ = obj.value(QStringLiteral("protocol")).toString() == QLatin1String(wire::kProtocolCbor);
+        serverFeatures_.clear();
+        for (const auto& f : obj.value(QStringLiteral("features")).toArray()) {
+            serverFeatures_.append(f.toString());
+        }
+        qDebug() << "Server" << serverId_ << "protocol:" << (binaryOut_ ? "cbor" : "json");
+        // Passed on too: the GUI side records which requests the server accepts.
+    }
+    emit jsonReceived(serverId_, obj);
 }
 
 void JobConnection::onDisconnected() {
+    stats_.lastRttMs = -1.0;
     emit disconnected(serverId_);
 }
 
 void JobConnection::onEncrypted() {
     qDebug() << "TLS handshake completed for" << serverId_ << "peer:" << socket_.peerName();
-    emit connectionReady(serverId_);
+    rememberSessionTicket();
+    beginSession();
 }
 
 void JobConnection::onSslErrors(const QList<QSslError>& errors) {
     logSslErrorsAndAbort(errors);
 }
 
+void JobConnection::rememberSessionTicket() {
+    // TLS 1.2 has the ticket once the handshake is done; TLS 1.3 servers
+    // send it afterwards (newSessionTicketReceived). The next connect
+    // offers it from tlsConfig_.
+    if (!tlsConfig_) {
+        return;
+    }
+    const QByteArray ticket = socket_.sslConfiguration().sessionTicket();
+    if (!ticket.isEmpty()) {
+        tlsConfig_->setSessionTicket(ticket);
+    }
+}
+
 void JobConnection::onSocketError(QAbstractSocket::SocketError error) {
     Q_UNUSED(error);
     qWarning() << "Socket error for" << serverId_ << ":" << socket_.errorString();
@@ -217,21 +434,19 @@ bool JobConnection::loadClientKey(const QString& keyPath, QSslKey& out) const {
     return true;
 }
 
-void JobConnection::applyTlsConfiguration(const QList<QSslCertificate>& caCerts,
-                                         const QSslCertificate& clientCert,
-                                         const QSslKey& clientKey) {
-    QSslConfiguration cfg = socket_.sslConfiguration();
+QSslConfiguration JobConnection::buildTlsConfiguration(const QList<QSslCertificate>& caCerts,
+                                                       const QSslCertificate& clientCert,
+                                                       const QSslKey& clientKey) {
+    QSslConfiguration cfg = QSslConfiguration::defaultConfiguration();
     cfg.setProtocol(QSsl::SecureProtocols);
     cfg.setCaCertificates(caCerts);
-    socket_.setSslConfiguration(cfg);
-
-    socket_.setLocalCertificate(clientCert);
-    socket_.setPrivateKey(clientKey);
-    socket_.setPeerVerifyMode(QSslSocket::VerifyPeer);
-
-    const QString verifyName =
-        !tlsServerName_.trimmed().isEmpty() ? tlsServerName_.trimmed() : host_;
-    socket_.setPeerVerifyName(verifyName);
+    cfg.setLocalCertificate(clientCert);
+    cfg.setPrivateKey(clientKey);
+    cfg.setPeerVerifyMode(QSslSocket::VerifyPeer);
+    // Keep the session ticket so reconnects can resume (see rememberSessionTicket()).
+    cfg.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+    cfg.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    return cfg;
 }
 
 bool JobConnection::configureTls() {
@@ -248,22 +463,35 @@ bool JobConnection::configureTls() {
         return false;
     }
 
-    QList<QSslCertificate> caCerts;
-    if (!loadCaCertificates(caPath, caCerts)) {
-        return false;
-    }
+    // Parsed once; read again only when a file changed (e.g. a renewed
+    // certificate), which also drops the session ticket.
+    const std::array<QDateTime, 3> fileTimes{QFileInfo(caPath).lastModified(),
+                                             QFileInfo(certPath).lastModified(),
+                                             QFileInfo(keyPath).lastModified()};
+    if (!tlsConfig_ || fileTimes != tlsFileTimes_) {
+        QList<QSslCertificate> caCerts;
+        if (!loadCaCertificates(caPath, caCerts)) {
+            return false;
+        }
 
-    QSslCertificate clientCert;
-    if (!loadClientCertificate(certPath, clientCert)) {
-        return false;
-    }
+        QSslCertificate clientCert;
+        if (!loadClientCertificate(certPath, clientCert)) {
+            return false;
+        }
 
-    QSslKey clientKey;
-    if (!loadClientKey(keyPath, clientKey)) {
-        return false;
+        QSslKey clientKey;
+        if (!loadClientKey(keyPath, clientKey)) {
+            return false;
+        }
+
+        tlsConfig_    = buildTlsConfiguration(caCerts, clientCert, clientKey);
+        tlsFileTimes_ = fileTimes;
     }
 
-    applyTlsConfiguration(caCerts, clientCert, clientKey);
+    socket_.setSslConfiguration(*tlsConfig_);
+    const QString verifyName =
+        !tlsServerName_.trimmed().isEmpty() ? tlsServerName_.trimmed() : host_;
+    socket_.setPeerVerifyName(verifyName);
     return true;
 }
 
@@ -271,6 +499,10 @@ void JobConnection::logSslErrorsAndAbort(const QList<QSslError>& errors) {
     for (const auto& err : errors) {
         qWarning() << "TLS error for" << serverId_ << ":" << err.errorString();
     }
+    // Start the next attempt with a full handshake.
+    if (tlsConfig_) {
+        tlsConfig_->setSessionTicket(QByteArray());
+    }
     socket_.abort();
 }
 
@@ -1,18 +1,49 @@
 #pragma once
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QObject>
 #include <QJsonObject>
+#include <QSslConfiguration>
 #include <QSslSocket>
 #include <QSslError>
 #include <QSslCertificate>
 #include <QSslKey>
+#include <QStringList>
+#include <QTimer>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "net/MessageFramer.hpp"
+#include "net/WireProtocol.hpp"
 
 namespace sf::client::net {
 
-// Thin wrapper over QTcpSocket for line-delimited JSON messages.
+// Thin wrapper over QTcpSocket for protocol messages: line-delimited JSON,
+// upgraded to length-prefixed CBOR frames when the server accepts the
+// "hello" offer (see WireProtocol.hpp). Callers only ever see QJsonObjects.
+//
+// Reconnects itself after a lost or failed connection, with jittered
+// exponential backoff (kRetryBaseMs doubling up to kRetryMaxMs), so servers
+// coming back after an outage are not hit by every client at once. TLS
+// files are parsed once and the session ticket of the last handshake is
+// offered again, so a reconnect usually resumes the session.
 class JobConnection : public QObject {
     Q_OBJECT
 public:
+    static constexpr int kRetryBaseMs = 1000;
+    static constexpr int kRetryMaxMs  = 60000;
+    // A session that lasted this long resets the backoff.
+    static constexpr int kStableSessionMs = 30000;
+    // checkLiveness(): a connect (TCP plus TLS handshake) taking longer, or
+    // a ready connection receiving nothing for longer, is dropped.
+    static constexpr int kConnectTimeoutMs  = 10000;
+    static constexpr int kHalfOpenTimeoutMs = 15000;
+
     JobConnection(const QString& serverId,
                   const QString& host,
                   quint16 port,
@@ -40,9 +71,43 @@ public:
                st == QAbstractSocket::HostLookupState;
     }
 
+    // Starts connecting unless already connecting/connected or a retry is
+    // still backing off (the retry then happens by itself).
     void connectToHost();
     void sendJson(const QJsonObject& obj);
 
+    // Aborts a connection attempt or a session that exceeded its timeout
+    // above; the usual retry follows. Call periodically (the ping timer):
+    // pings make a live server send something at least once per interval.
+    void checkLiveness();
+
+    // True once the server accepted binary framing on this connection.
+    bool isBinary() const noexcept { return binaryOut_; }
+
+    // True if the server's hello listed the feature (false before the answer).
+    bool hasServerFeature(const char* feature) const {
+        return serverFeatures_.contains(QLatin1String(feature));
+    }
+
+    // Receive-side counters, updated as data arrives.
+    struct Stats {
+        std::int64_t messagesReceived{0}; // JSON lines + frames (a batch frame counts once)
+        std::int64_t bytesReceived{0};
+        std::int64_t parseNanos{0};       // decoding and job_update expansion
+        double       lastRttMs{-1.0};     // < 0 until a pong arrives; reset on disconnect
+        std::int64_t connectAttempts{0};
+    };
+    const Stats& stats() const noexcept { return stats_; }
+
+    // Server clock (epoch ms) from the latest pong of this session, -1
+    // before one arrived.
+    qint64 serverTimeMs() const noexcept { return serverTimeMs_; }
+
+    // {"type":"ping","seq":N}. Servers that answer with a matching "pong"
+    // get a round-trip time; older ones ignore seq and only send
+    // server_status, which is not used for timing (it is broadcast).
+    void sendPing();
+
 signals:
     // Socket is ready to exchange JSON messages.
     // For TLS connections this is emitted after the TLS handshake.
@@ -57,10 +122,16 @@ private slots:
     void onEncrypted();
     void onSslErrors(const QList<QSslError>& errors);
     void onSocketError(QAbstractSocket::SocketError error);
+    void onStateChanged(QAbstractSocket::SocketState state);
 
 private:
     void processIncomingData();
-    void handleJsonLine(const QByteArray& line);
+    void handleJsonLine(QByteArrayView line);
+    void handleFrame(wire::FrameKind kind, QByteArrayView payload);
+    void handleMessage(const QJsonObject& obj);
+    void beginSession();
+    void scheduleRetry();
+    void rememberSessionTicket();
 
     bool configureTls();
     bool validateTlsFilePaths(const QString& caPath,
@@ -69,9 +140,9 @@ private:
     bool loadCaCertificates(const QString& caPath, QList<QSslCertificate>& out) const;
     bool loadClientCertificate(const QString& certPath, QSslCertificate& out) const;
     bool loadClientKey(const QString& keyPath, QSslKey& out) const;
-    void applyTlsConfiguration(const QList<QSslCertificate>& caCerts,
-                               const QSslCertificate& clientCert,
-                               const QSslKey& clientKey);
+    static QSslConfiguration buildTlsConfiguration(const QList<QSslCertificate>& caCerts,
+                                                   const QSslCertificate& clientCert,
+                                                   const QSslKey& clientKey);
     void logSslErrorsAndAbort(const QList<QSslError>& errors);
 
     QString resolvePath(const QString& path) const;
@@ -85,8 +156,32 @@ private:
     QString    tlsClientCertFile_;
     QString    tlsClientKeyFile_;
 
-    QSslSocket socket_;
-    QByteArray buffer_;
+    QSslSocket    socket_;
+    MessageFramer framer_;
+    std::unique_ptr<QFile> capture_; // raw receive stream, see CORRCHESS_CAPTURE_DIR
+
+    Stats         stats_;
+    QElapsedTimer clock_;                      // monotonic; ping send times
+    std::uint32_t pingSeq_{0};
+    std::array<qint64, 8> pingSentNs_{};       // by seq % size; tolerates a few late pongs
+    qint64        serverTimeMs_{-1};
+
+    // Reconnect state (clock_ nanoseconds).
+    QTimer        retryTimer_;
+    int           failedAttempts_{0};
+    qint64        nextAttemptNs_{0};
+    qint64        attemptStartedNs_{0};
+    qint64        sessionStartedNs_{-1};        // >= 0 while a session is ready
+    qint64        lastReceiveNs_{0};
+
+    // Parsed TLS files, reused until one of them changes on disk; carries
+    // the session ticket to resume with.
+    std::optional<QSslConfiguration> tlsConfig_;
+    std::array<QDateTime, 3>         tlsFileTimes_;
+
+    bool                    binaryOut_{false}; // send CBOR frames instead of JSON lines
+    QStringList             serverFeatures_;   // from the server's hello answer
+    wire::JobUpdateExpander jobUpdates_;
 };
 
 } // namespace sf::client::net
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "net/JobNetworkController.hpp"
 
+#include "infra/trace/Trace.hpp"
+#include "net/WireProtocol.hpp"
+
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonDocument>
 
+#include <algorithm>
 #include <cstdint>
 #include <chrono>
 
@@ -74,7 +78,7 @@ static std::vector<PvLine> parsePvLines(const QJsonValue& v) {
             line.selDepth = lo.value(QStringLiteral("seldepth")).toInt();
         }
         line.score = parseScore(lo);
-        line.pv = lo.value(QStringLiteral("pv")).toString().toStdString();
+        line.pv = wire::decodePv(lo.value(QStringLiteral("pv")));
         out.push_back(std::move(line));
     }
 
@@ -106,7 +110,7 @@ static JobSnapshot parseSnapshot(const QJsonValue& v) {
     }
 
     snap.bestMove = so.value(QStringLiteral("bestmove")).toString().toStdString();
-    snap.pv       = so.value(QStringLiteral("pv")).toString().toStdString();
+    snap.pv       = wire::decodePv(so.value(QStringLiteral("pv")));
     snap.lines    = parsePvLines(so.value(QStringLiteral("lines")));
     return snap;
 }
@@ -125,6 +129,9 @@ static std::optional<Job> parseJobsListItem(const QJsonValue& jobVal, const QStr
     job.opponent   = jo.value(QStringLiteral("opponent")).toString().toStdString();
     job.fen        = jo.value(QStringLiteral("fen")).toString().toStdString();
     job.multiPv    = jo.value(QStringLiteral("multipv")).toInt(1);
+    for (const auto& mv : jo.value(QStringLiteral("searchmoves")).toArray()) {
+        job.searchMoves.push_back(mv.toString().toStdString());
+    }
 
     job.status = static_cast<JobStatus>(jo.value(QStringLiteral("status")).toInt(0));
 
@@ -140,7 +147,7 @@ static std::optional<Job> parseJobsListItem(const QJsonValue& jobVal, const QStr
     job.startedAt  = timeFromMs(jo.value(QStringLiteral("started_at_ms")));
     job.finishedAt = timeFromMs(jo.value(QStringLiteral("finished_at_ms")));
     job.snapshot = parseSnapshot(jo.value(QStringLiteral("snapshot")));
-    job.logLines = parseLogTail(jo.value(QStringLiteral("log_tail")));
+    job.logLines.assign(parseLogTail(jo.value(QStringLiteral("log_tail"))));
     return job;
 }
 
@@ -151,53 +158,59 @@ JobNetworkController::JobNetworkController(sf::client::app::JobManager& jobManag
                                            QObject* parent)
     : QObject(parent)
     , jobManager_(jobManager)
-    , serverManager_(serverManager) {
-    pingTimer_.setInterval(3000); // 3 seconds
-    connect(&pingTimer_, &QTimer::timeout,
-            this, &JobNetworkController::onPingTimeout);
-    pingTimer_.start();
+    , serverManager_(serverManager)
+    , updateCoalescer_(jobManager)
+    , worker_(new NetworkWorker) {
+    networkThread_.setObjectName(QStringLiteral("network"));
+    worker_->moveToThread(&networkThread_);
+    connect(&networkThread_, &QThread::finished, worker_, &QObject::deleteLater);
+    connect(worker_, &NetworkWorker::eventsAvailable,
+            this, &JobNetworkController::onEventsAvailable, Qt::QueuedConnection);
+    networkThread_.start();
+}
+
+JobNetworkController::~JobNetworkController() {
+    networkThread_.quit();
+    networkThread_.wait();
 }
 
 void JobNetworkController::initializeConnections(
     const std::vector<ServerInfo>& servers) {
-    for (const auto& s : servers) {
-        const std::string key = s.id;
-        if (connections_.find(key) != connections_.end()) {
-            continue;
-        }
+    QMetaObject::invokeMethod(worker_, [w = worker_, servers]() {
+        w->initializeConnections(servers);
+    }, Qt::QueuedConnection);
+}
 
-        auto conn = std::make_unique<JobConnection>(
-            QString::fromStdString(s.id),
-            QString::fromStdString(s.host),
-            static_cast<quint16>(s.port),
-            s.tlsEnabled,
-            QString::fromStdString(s.tlsServerName),
-            QString::fromStdString(s.tlsCaFile),
-            QString::fromStdString(s.tlsClientCertFile),
-            QString::fromStdString(s.tlsClientKeyFile),
-            this);
-
-        connect(conn.get(), &JobConnection::jsonReceived,
-                this, &JobNetworkController::onJsonReceived);
-        connect(conn.get(), &JobConnection::connectionReady,
-                this, &JobNetworkController::onConnectionReady);
-        connect(conn.get(), &JobConnection::disconnected,
-                this, &JobNetworkController::onConnectionDisconnected);
-
-        conn->connectToHost();
-        connections_.emplace(key, std::move(conn));
-    }
+void JobNetworkController::sendToServer(const std::string& serverId, const QJsonObject& msg) {
+    QMetaObject::invokeMethod(worker_, [w = worker_, id = QString::fromStdString(serverId), msg]() {
+        w->send(id, msg);
+    }, Qt::QueuedConnection);
 }
 
 void JobNetworkController::handleJobAddedOrUpdated(const Job& job) {
     if (!job.assignedServer) {
         return;
     }
-    auto it = connections_.find(*job.assignedServer);
-    if (it == connections_.end()) {
+
+    const QJsonObject jobObj = jobToWire(job);
+    QMetaObject::invokeMethod(worker_, [w = worker_, id = QString::fromStdString(*job.assignedServer), jobObj]() {
+        w->submitJob(id, jobObj);
+    }, Qt::QueuedConnection);
+}
+
+void JobNetworkController::handleJobExtended(const Job& job) {
+    if (!job.assignedServer) {
         return;
     }
 
+    // The whole job goes along: a server that has forgotten it runs it as new.
+    QJsonObject msg;
+    msg.insert(QStringLiteral("type"), QStringLiteral("job_extend"));
+    msg.insert(QStringLiteral("job"), jobToWire(job));
+    sendToServer(*job.assignedServer, msg);
+}
+
+QJsonObject JobNetworkController::jobToWire(const Job& job) {
     QJsonObject jobObj;
     jobObj.insert(QStringLiteral("id"),         QString::fromStdString(job.id));
     jobObj.insert(QStringLiteral("opponent"),   QString::fromStdString(job.opponent));
@@ -205,27 +218,28 @@ void JobNetworkController::handleJobAddedOrUpdated(const Job& job) {
     jobObj.insert(QStringLiteral("limit_type"), static_cast<int>(job.limit.type));
     jobObj.insert(QStringLiteral("limit_value"), job.limit.value);
     jobObj.insert(QStringLiteral("multipv"), job.multiPv);
-
-    QJsonObject msg;
-    msg.insert(QStringLiteral("type"), QStringLiteral("job_submit_or_update"));
-    msg.insert(QStringLiteral("job"), jobObj);
-
-    it->second->sendJson(msg);
+    if (!job.searchMoves.empty()) {
+        QJsonArray moves;
+        for (const auto& mv : job.searchMoves) {
+            moves.append(QString::fromStdString(mv));
+        }
+        jobObj.insert(QStringLiteral("searchmoves"), moves);
+    }
+    return jobObj;
 }
 
 void JobNetworkController::handleJobRemoved(const Job& job) {
+    // Progress still in flight must not resurrect a stopped/removed job.
+    updateCoalescer_.discard(job.id);
+
     if (!job.assignedServer) {
         return;
     }
-    auto it = connections_.find(*job.assignedServer);
-    if (it == connections_.end()) {
-        return;
-    }
 
     QJsonObject msg;
     msg.insert(QStringLiteral("type"), QStringLiteral("job_cancel"));
     msg.insert(QStringLiteral("job_id"), QString::fromStdString(job.id));
-    it->second->sendJson(msg);
+    sendToServer(*job.assignedServer, msg);
 }
 
 QString JobNetworkController::detectMessageType(const QJsonObject& obj) const {
@@ -247,85 +261,6 @@ QString JobNetworkController::detectMessageType(const QJsonObject& obj) const {
     return type;
 }
 
-void JobNetworkController::handleJobUpdateMessage(const QString& serverId,
-                                                 const QJsonObject& obj) {
-    Q_UNUSED(serverId);
-
-    const auto jobId = obj.value(QStringLiteral("job_id")).toString().toStdString();
-    const auto statusInt = obj.value(QStringLiteral("status"))
-                               .toInt(static_cast<int>(JobStatus::Running));
-    const auto status = static_cast<JobStatus>(statusInt);
-
-    JobSnapshot snap;
-
-    // NOTE about "depth jumps": Stockfish emits a lot of "info ... currmove ..." lines
-    // (without score/pv). If we treat those as authoritative, UI depth starts to oscillate
-    // (35 -> 34 -> 35 ...). We only update analysis snapshot from lines that carry
-    // an actual evaluation (score and/or pv).
-
-    const bool hasScore = obj.contains(QStringLiteral("score_cp")) || obj.contains(QStringLiteral("score_mate"));
-    const bool hasPv    = obj.contains(QStringLiteral("pv")) && !obj.value(QStringLiteral("pv")).toString().isEmpty();
-    const bool isEvalUpdate = hasScore || hasPv;
-
-    if (isEvalUpdate) {
-        // MultiPV: server may send updates for different 'multipv' lines.
-        const int multipv = obj.value(QStringLiteral("multipv")).toInt(1);
-
-        PvLine line;
-        line.multipv = multipv;
-
-        if (obj.contains(QStringLiteral("depth"))) {
-            line.depth = obj.value(QStringLiteral("depth")).toInt();
-        }
-        if (obj.contains(QStringLiteral("seldepth"))) {
-            line.selDepth = obj.value(QStringLiteral("seldepth")).toInt();
-        }
-        if (obj.contains(QStringLiteral("score_cp"))) {
-            line.score.type  = ScoreType::Cp;
-            line.score.value = obj.value(QStringLiteral("score_cp")).toInt();
-        } else if (obj.contains(QStringLiteral("score_mate"))) {
-            line.score.type  = ScoreType::Mate;
-            line.score.value = obj.value(QStringLiteral("score_mate")).toInt();
-        }
-        if (obj.contains(QStringLiteral("nodes"))) {
-            line.nodes = static_cast<int64_t>(obj.value(QStringLiteral("nodes")).toVariant().toLongLong());
-        }
-        if (obj.contains(QStringLiteral("nps"))) {
-            line.nps = static_cast<int64_t>(obj.value(QStringLiteral("nps")).toVariant().toLongLong());
-        }
-        if (obj.contains(QStringLiteral("pv"))) {
-            line.pv = obj.value(QStringLiteral("pv")).toString().toStdString();
-        }
-
-        // Preserve single-line fields for the UI (multipv=1 only).
-        if (multipv == 1) {
-            snap.depth    = line.depth;
-            snap.selDepth = line.selDepth;
-            snap.score    = line.score;
-            snap.nodes    = line.nodes;
-            snap.nps      = line.nps;
-            snap.pv       = line.pv;
-        }
-
-        // Attach the per-line update.
-        snap.lines.push_back(std::move(line));
-    }
-
-    if (obj.contains(QStringLiteral("bestmove"))) {
-        snap.bestMove = obj.value(QStringLiteral("bestmove")).toString().toStdString();
-    }
-
-    std::optional<std::string> logLine;
-    if (obj.contains(QStringLiteral("log_line"))) {
-        const auto s = obj.value(QStringLiteral("log_line")).toString();
-        if (!s.isEmpty()) {
-            logLine = s.toStdString();
-        }
-    }
-
-    jobManager_.applyRemoteUpdate(jobId, status, snap, logLine);
-}
-
 void JobNetworkController::handleServerStatusMessage(const QString& serverId,
                                                     const QJsonObject& obj) {
     // IMPORTANT: we map runtime updates to the connection/config id (serverId parameter),
@@ -356,22 +291,68 @@ void JobNetworkController::handleServerStatusMessage(const QString& serverId,
         maxJobs,
         threadsPerJob,
         logicalCores);
+
+    // Servers with a warm engine pool report its occupancy.
+    if (obj.contains(QStringLiteral("pool_size"))) {
+        serverManager_.updateEnginePool(serverId.toStdString(),
+                                        obj.value(QStringLiteral("pool_size")).toInt(0),
+                                        obj.value(QStringLiteral("pool_idle")).toInt(0),
+                                        obj.value(QStringLiteral("pool_busy")).toInt(0));
+    }
+
+    // Pinning servers report their CPU slots; others clear the state.
+    const bool pinned = obj.value(QStringLiteral("cpu_pinning")).toInt(0) != 0;
+    serverManager_.updateCpuAllocation(serverId.toStdString(),
+                                       pinned ? std::max(1, obj.value(QStringLiteral("numa_nodes")).toInt(1)) : 0,
+                                       pinned ? obj.value(QStringLiteral("free_cpus")).toInt(0) : 0,
+                                       pinned ? obj.value(QStringLiteral("next_job_threads")).toInt(0) : 0);
 }
 
-void JobNetworkController::onConnectionReady(const QString& serverId) {
-    // Immediately sync jobs so that reconnect restores ongoing analysis.
-    sendJobsListRequest(serverId);
+void JobNetworkController::onEventsAvailable() {
+    CORRCHESS_TRACE_SCOPE("gui.drainNetworkEvents");
+    // Drain everything the network thread produced since the last wake-up.
+    // Job updates only go into the coalescer here; it applies them per frame.
+    do {
+        NetworkEvent ev;
+        while (worker_->tryPopEvent(ev)) {
+            handleEvent(ev);
+        }
+    } while (worker_->finishDrain());
 }
 
-void JobNetworkController::onJsonReceived(const QString& serverId,
+void JobNetworkController::handleEvent(NetworkEvent& ev) {
+    switch (ev.kind) {
+        case NetworkEvent::Kind::JobUpdate:
+            if (!jobManager_.claimRemoteReport(ev.jobId, ev.serverId.toStdString())) {
+                cancelDuplicate(ev.serverId.toStdString(), ev.jobId);
+                break;
+            }
+            updateCoalescer_.push(ev.jobId, ev.status, ev.snapshot, std::move(ev.logLines));
+            break;
+        case NetworkEvent::Kind::Message:
+            disarmFailover(ev.serverId.toStdString());
+            handleMessage(ev.serverId, ev.message);
+            break;
+        case NetworkEvent::Kind::Disconnected:
+            serverManager_.updateServerRuntime(
+                ev.serverId.toStdString(),
+                ServerStatus::Offline,
+                0,
+                0,
+                0,
+                0);
+            armFailover(ev.serverId.toStdString());
+            break;
+        case NetworkEvent::Kind::Telemetry:
+            serverManager_.updateTelemetry(ev.serverId.toStdString(), ev.telemetry);
+            break;
+    }
+}
+
+void JobNetworkController::handleMessage(const QString& serverId,
                                          const QJsonObject& obj) {
     const QString type = detectMessageType(obj);
 
-    if (type == QStringLiteral("job_update")) {
-        handleJobUpdateMessage(serverId, obj);
-        return;
-    }
-
     if (type == QStringLiteral("server_status")) {
         handleServerStatusMessage(serverId, obj);
         return;
@@ -382,62 +363,28 @@ void JobNetworkController::onJsonReceived(const QString& serverId,
         return;
     }
 
-    qDebug() << "Unknown message type:" << type << "payload:" << QJsonDocument(obj).toJson(QJsonDocument::Compact);
-}
-
-void JobNetworkController::onConnectionDisconnected(
-    const QString& serverId) {
-    serverManager_.updateServerRuntime(
-        serverId.toStdString(),
-        ServerStatus::Offline,
-        0,
-        0,
-        0,
-        0);
-}
-
-void JobNetworkController::onPingTimeout() {
-    sendPing();
-}
-
-void JobNetworkController::sendJobsListRequest(const QString& serverId) {
-	const auto it = connections_.find(serverId.toStdString());
-    if (it == connections_.end()) {
-        return;
-    }
-
-    if (!it->second->isConnected()) {
-        it->second->connectToHost();
-        // We'll request again on connectionReady.
+    if (type == QStringLiteral("hello")) {
+        const QJsonArray features = obj.value(QStringLiteral("features")).toArray();
+        serverManager_.updateServerFeatures(serverId.toStdString(),
+                                            features.contains(QString::fromLatin1(wire::kFeatureJobExtend)));
         return;
     }
 
-    QJsonObject msg;
-    msg.insert(QStringLiteral("type"), QStringLiteral("jobs_list"));
-    msg.insert(QStringLiteral("include_finished"), true);
-    msg.insert(QStringLiteral("limit"), 200);
-    it->second->sendJson(msg);
-}
-
-void JobNetworkController::sendPing() {
-    QJsonObject msg;
-    msg.insert(QStringLiteral("type"), QStringLiteral("ping"));
-
-    for (auto& [id, conn] : connections_) {
-        if (!conn->isConnected()) {
-            conn->connectToHost(); // best-effort reconnect
-        }
-        conn->sendJson(msg);
-    }
+    qDebug() << "Unknown message type:" << type << "payload:" << QJsonDocument(obj).toJson(QJsonDocument::Compact);
 }
 
 void JobNetworkController::handleJobsListMessage(const QString& serverId,
                                                  const QJsonObject& obj) {
+    CORRCHESS_TRACE_SCOPE("gui.applyJobsList");
     const auto jobsVal = obj.value(QStringLiteral("jobs"));
     if (!jobsVal.isArray()) {
         return;
     }
 
+    // The list is authoritative; apply older streamed updates first.
+    updateCoalescer_.flush();
+
+    const std::string server = serverId.toStdString();
     for (const auto& v : jobsVal.toArray()) {
         if (!v.isObject()) {
             continue;
@@ -446,8 +393,61 @@ void JobNetworkController::handleJobsListMessage(const QString& serverId,
         if (!job.has_value()) {
             continue;
         }
+        if (!jobManager_.claimRemoteReport(job->id, server)) {
+            if (job->status != JobStatus::Finished && job->status != JobStatus::Error &&
+                job->status != JobStatus::Cancelled && job->status != JobStatus::Stopped) {
+                cancelDuplicate(server, job->id);
+            }
+            continue;
+        }
         jobManager_.upsertRemoteJob(*job);
     }
 }
 
+void JobNetworkController::armFailover(const std::string& serverId) {
+    if (failoverGraceMs_ <= 0) {
+        return;
+    }
+    auto& timer = failoverTimers_[serverId];
+    if (!timer) {
+        timer = std::make_unique<QTimer>();
+        timer->setSingleShot(true);
+        connect(timer.get(), &QTimer::timeout, this, [this, serverId]() { failOver(serverId); });
+    }
+    if (!timer->isActive()) {
+        timer->start(failoverGraceMs_);
+    }
+}
+
+void JobNetworkController::disarmFailover(const std::string& serverId) {
+    if (failoverTimers_.empty()) {
+        return;
+    }
+    if (const auto it = failoverTimers_.find(serverId); it != failoverTimers_.end()) {
+        it->second->stop();
+    }
+}
+
+void JobNetworkController::failOver(const std::string& serverId) {
+    // Updates it sent before the link died go first.
+    updateCoalescer_.flush();
+    const int moved = jobManager_.failOverServer(serverId);
+    if (moved > 0) {
+        qWarning() << "Server" << QString::fromStdString(serverId) << "offline for" << failoverGraceMs_
+                   << "ms: moved" << moved << "jobs back to the queue";
+    }
+}
+
+void JobNetworkController::cancelDuplicate(const std::string& serverId, const JobId& jobId) {
+    if (!cancelledDuplicates_.insert(serverId + '\n' + jobId).second) {
+        return;
+    }
+    qDebug() << "Cancelling failed-over job" << QString::fromStdString(jobId) << "on"
+             << QString::fromStdString(serverId);
+    QJsonObject msg;
+    msg.insert(QStringLiteral("type"), QStringLiteral("job_cancel"));
+    msg.insert(QStringLiteral("job_id"), QString::fromStdString(jobId));
+    sendToServer(serverId, msg);
+}
+
 } // namespace sf::client::net
@@ -1,57 +1,86 @@
 #pragma once
 
 #include <QObject>
+#include <QThread>
 #include <QTimer>
-#include <memory>
-#include <unordered_map>
 
 #include <QJsonObject>
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "domain/domain_model.hpp"
 #include "app/JobManager.hpp"
+#include "app/JobUpdateCoalescer.hpp"
 #include "app/ServerManager.hpp"
-#include "net/JobConnection.hpp"
+#include "net/NetworkWorker.hpp"
 
 namespace sf::client::net {
 
 // Orchestrates communication between JobManager and remote workers.
+//
+// Connections live on a dedicated network thread (NetworkWorker), which
+// does all socket, TLS and protocol work. This object stays on the GUI
+// thread: it forwards outgoing requests to the worker and drains decoded
+// events from the worker's lock-free queue into JobManager/ServerManager.
 class JobNetworkController : public QObject {
     Q_OBJECT
 public:
     JobNetworkController(sf::client::app::JobManager& jobManager,
                          sf::client::app::ServerManager& serverManager,
                          QObject* parent = nullptr);
+    ~JobNetworkController() override;
 
     // Create JobConnection objects for the given servers and connect.
     void initializeConnections(
         const std::vector<sf::client::domain::ServerInfo>& servers);
 
+    // A server offline this long gets its unfinished jobs moved elsewhere
+    // (JobManager::failOverServer()); 0 = wait for it however long it takes.
+    // Copies it still runs once it is back are cancelled there.
+    void setFailoverGraceMs(int graceMs) { failoverGraceMs_ = graceMs; }
+
     // Called from JobManager callbacks.
     void handleJobAddedOrUpdated(const sf::client::domain::Job& job);
     void handleJobRemoved(const sf::client::domain::Job& job);
+    void handleJobExtended(const sf::client::domain::Job& job);
 
 private slots:
-    void onConnectionReady(const QString& serverId);
-    void onJsonReceived(const QString& serverId, const QJsonObject& obj);
-    void onConnectionDisconnected(const QString& serverId);
-    void onPingTimeout();
+    void onEventsAvailable();
 
 private:
-    void sendPing();
-    void sendJobsListRequest(const QString& serverId);
+    void sendToServer(const std::string& serverId, const QJsonObject& msg);
+    // The "job" object of job_submit_or_update / job_extend.
+    static QJsonObject jobToWire(const sf::client::domain::Job& job);
+    void handleEvent(NetworkEvent& ev);
 
     // Protocol helpers (keep message parsing on one abstraction level)
     QString detectMessageType(const QJsonObject& obj) const;
-    void handleJobUpdateMessage(const QString& serverId, const QJsonObject& obj);
+    void handleMessage(const QString& serverId, const QJsonObject& obj);
     void handleServerStatusMessage(const QString& serverId, const QJsonObject& obj);
     void handleJobsListMessage(const QString& serverId, const QJsonObject& obj);
 
+    // Failover timers: armed on disconnect, disarmed by any message.
+    void armFailover(const std::string& serverId);
+    void disarmFailover(const std::string& serverId);
+    void failOver(const std::string& serverId);
+    // job_cancel for a failed-over job the old server still reports (once).
+    void cancelDuplicate(const std::string& serverId, const sf::client::domain::JobId& jobId);
 
     sf::client::app::JobManager&    jobManager_;
     sf::client::app::ServerManager& serverManager_;
 
-    std::unordered_map<std::string, std::unique_ptr<JobConnection>> connections_;
-    QTimer                                                           pingTimer_;
+    // job_update messages are merged here and applied at frame rate.
+    sf::client::app::JobUpdateCoalescer updateCoalescer_;
+
+    int                                                      failoverGraceMs_{0};
+    std::unordered_map<std::string, std::unique_ptr<QTimer>> failoverTimers_;
+    std::unordered_set<std::string>                          cancelledDuplicates_; // "<server>\n<job>"
+
+    QThread        networkThread_;
+    NetworkWorker* worker_; // lives on networkThread_, deleted when it finishes
 };
 
 } // namespace sf::client::net
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+#include "net/WireProtocol.hpp"
+
+namespace sf::client::net {
+
+// Splits the receive stream into JSON lines and binary frames.
+//
+// Bytes are appended once per readyRead; complete messages are handed out
+// as views into the buffer (no per-message copy) while a read cursor moves
+// forward, and the consumed prefix is dropped in one compaction at the end
+// of drain(). This keeps a burst of N small messages O(N) instead of the
+// O(N^2) memmove of erasing the front of the buffer per message.
+class MessageFramer {
+public:
+    enum class ItemType { JsonLine, Frame };
+
+    struct Item {
+        ItemType        type{ItemType::JsonLine};
+        wire::FrameKind frameKind{wire::FrameKind::Message};
+        QByteArrayView  bytes; // line without '\n', or frame payload
+    };
+
+    void append(const QByteArray& data) { buffer_.append(data); }
+    // Safe to call from inside a drain() callback (e.g. the handler drops
+    // the connection): the rest of the batch is discarded.
+    void clear() {
+        if (draining_) {
+            resetPending_ = true;
+            return;
+        }
+        buffer_.clear();
+        readPos_ = 0;
+    }
+
+    qsizetype buffered() const { return buffer_.size() - readPos_; }
+
+    // Calls onItem(const Item&) for every complete message. Views are only
+    // valid during the callback. Returns false on a framing error (the
+    // caller should drop the connection); the buffer is cleared then.
+    template <typename F>
+    bool drain(F&& onItem);
+
+private:
+    QByteArray buffer_;
+    qsizetype  readPos_{0};
+    bool       draining_{false};
+    bool       resetPending_{false};
+};
+
+template <typename F>
+bool MessageFramer::drain(F&& onItem) {
+    const char* data = buffer_.constData();
+    const qsizetype size = buffer_.size();
+    draining_ = true;
+
+    while (readPos_ < size && !resetPending_) {
+        const char* p = data + readPos_;
+        const qsizetype avail = size - readPos_;
+
+        if (*p == wire::kFrameMarker) {
+            if (avail < wire::kFrameHeaderSize) {
+                break;
+            }
+            const quint32 len = (static_cast<quint32>(static_cast<quint8>(p[2])) << 24) |
+                                (static_cast<quint32>(static_cast<quint8>(p[3])) << 16) |
+                                (static_cast<quint32>(static_cast<quint8>(p[4])) << 8) |
+                                static_cast<quint32>(static_cast<quint8>(p[5]));
+            if (len > wire::kMaxFramePayload) {
+                draining_ = false;
+                resetPending_ = false;
+                clear();
+                return false;
+            }
+            const qsizetype total = wire::kFrameHeaderSize + static_cast<qsizetype>(len);
+            if (avail < total) {
+                break;
+            }
+            Item item;
+            item.type = ItemType::Frame;
+            item.frameKind = static_cast<wire::FrameKind>(static_cast<quint8>(p[1]));
+            item.bytes = QByteArrayView(p + wire::kFrameHeaderSize, len);
+            readPos_ += total;
+            onItem(item);
+            continue;
+        }
+
+        const QByteArrayView rest(p, avail);
+        const qsizetype nl = rest.indexOf('\n');
+        if (nl < 0) {
+            break;
+        }
+        readPos_ += nl + 1;
+        const QByteArrayView line = rest.first(nl).trimmed();
+        if (!line.isEmpty()) {
+            Item item;
+            item.bytes = line;
+            onItem(item);
+        }
+    }
+
+    draining_ = false;
+    if (resetPending_) {
+        resetPending_ = false;
+        clear();
+        return true;
+    }
+
+    // One compaction per drain: keep only the incomplete tail.
+    if (readPos_ > 0) {
+        buffer_.remove(0, readPos_);
+        readPos_ = 0;
+    }
+    return true;
+}
+
+} // namespace sf::client::net
@@ -0,0 +1,411 @@
+#include "net/NetworkWorker.hpp"
+
+#include "infra/trace/Trace.hpp"
+
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QVariant>
+
+#include <algorithm>
+
+namespace sf::client::net {
+
+using namespace sf::client::domain;
+
+namespace {
+
+constexpr int kPingIntervalMs = 3000;
+
+// A job without an update for this long no longer counts towards the
+// server's aggregate NPS (e.g. its final update was lost with the link).
+constexpr qint64 kJobNpsStaleMs = 15000;
+
+// Jobs per jobs_submit_batch message and per jobs_list page.
+constexpr int kSubmitBatchMax   = 500;
+constexpr int kJobsListPageSize = 200;
+
+// An incremental jobs_list reaches back this much before the covered time:
+// updates stamped just before it may still have been in a batch (or in
+// flight) when the connection dropped. Extra jobs only cost bytes.
+constexpr qint64 kJobsListSinceSlackMs = 10000;
+
+// Server log lines per listed job: enough for a job restored on reconnect
+// to show how its search went, without re-sending whole logs per page.
+constexpr int kJobsListLogTail = 50;
+
+// What the client reads from a jobs_list item (see parseJobsListItem).
+const QJsonArray& jobsListFields() {
+    static const QJsonArray fields{
+        QStringLiteral("id"),            QStringLiteral("opponent"),      QStringLiteral("fen"),
+        QStringLiteral("multipv"),       QStringLiteral("searchmoves"),   QStringLiteral("status"),
+        QStringLiteral("limit_type"),    QStringLiteral("limit_value"),   QStringLiteral("created_at_ms"),
+        QStringLiteral("started_at_ms"), QStringLiteral("finished_at_ms"), QStringLiteral("snapshot"),
+        QStringLiteral("log_tail"),
+    };
+    return fields;
+}
+
+// job_update -> event. Runs on the network thread so the GUI thread only
+// merges ready-made snapshots.
+NetworkEvent decodeJobUpdate(const QString& serverId, const QJsonObject& obj) {
+    wire::JobUpdate update = wire::decodeJobUpdate(obj);
+
+    NetworkEvent ev;
+    ev.kind     = NetworkEvent::Kind::JobUpdate;
+    ev.serverId = serverId;
+    ev.jobId    = std::move(update.jobId);
+    ev.status   = update.status;
+    ev.snapshot = std::move(update.snapshot);
+    ev.logLines = std::move(update.logLines);
+    return ev;
+}
+
+} // namespace
+
+NetworkWorker::NetworkWorker(QObject* parent)
+    : QObject(parent)
+    , queue_(kQueueCapacity) {}
+
+NetworkWorker::~NetworkWorker() = default;
+
+void NetworkWorker::initializeConnections(const std::vector<ServerInfo>& servers) {
+    if (!pingTimer_) {
+        CORRCHESS_TRACE_THREAD_NAME("network");
+        // Created here so it lives on (and fires in) the network thread.
+        pingTimer_ = std::make_unique<QTimer>();
+        pingTimer_->setInterval(kPingIntervalMs);
+        connect(pingTimer_.get(), &QTimer::timeout, this, &NetworkWorker::onPingTimeout);
+        pingTimer_->start();
+        telemetryClock_.start();
+    }
+
+    for (const auto& s : servers) {
+        const std::string key = s.id;
+        if (connections_.find(key) != connections_.end()) {
+            continue;
+        }
+
+        auto conn = std::make_unique<JobConnection>(
+            QString::fromStdString(s.id),
+            QString::fromStdString(s.host),
+            static_cast<quint16>(s.port),
+            s.tlsEnabled,
+            QString::fromStdString(s.tlsServerName),
+            QString::fromStdString(s.tlsCaFile),
+            QString::fromStdString(s.tlsClientCertFile),
+            QString::fromStdString(s.tlsClientKeyFile),
+            this);
+
+        connect(conn.get(), &JobConnection::jsonReceived,
+                this, &NetworkWorker::onJsonReceived);
+        // Immediately sync jobs so that reconnect restores ongoing analysis.
+        connect(conn.get(), &JobConnection::connectionReady,
+                this, [this](const QString& serverId) { requestJobsList(serverId); });
+        connect(conn.get(), &JobConnection::disconnected, this, [this](const QString& serverId) {
+            const std::string key = serverId.toStdString();
+            telemetry_[key].jobs.clear();
+
+            JobsListSync& sync = jobsListSync_[key];
+            if (sync.complete) {
+                const auto it = connections_.find(key);
+                const qint64 serverTime = it != connections_.end() ? it->second->serverTimeMs() : -1;
+                sync.coveredMs = std::max(sync.coveredMs, serverTime);
+            }
+            sync.complete = false;
+
+            NetworkEvent ev;
+            ev.kind     = NetworkEvent::Kind::Disconnected;
+            ev.serverId = serverId;
+            enqueue(std::move(ev));
+        });
+
+        conn->connectToHost();
+        connections_.emplace(key, std::move(conn));
+    }
+}
+
+void NetworkWorker::send(const QString& serverId, const QJsonObject& msg) {
+    const std::string key = serverId.toStdString();
+    const auto it = connections_.find(key);
+    if (it == connections_.end()) {
+        return;
+    }
+    // A cancel must not overtake the submit it refers to.
+    flushSubmits(key);
+    it->second->sendJson(msg);
+}
+
+void NetworkWorker::submitJob(const QString& serverId, const QJsonObject& job) {
+    if (connections_.find(serverId.toStdString()) == connections_.end()) {
+        return;
+    }
+
+    PendingSubmits& pending = pendingSubmits_[serverId.toStdString()];
+    const QString id = job.value(QStringLiteral("id")).toString();
+    if (pending.ids.contains(id)) {
+        return;
+    }
+    pending.ids.insert(id);
+    pending.jobs.append(job);
+
+    if (!submitFlushQueued_) {
+        submitFlushQueued_ = true;
+        QMetaObject::invokeMethod(this, qOverload<>(&NetworkWorker::flushSubmits), Qt::QueuedConnection);
+    }
+}
+
+void NetworkWorker::flushSubmits() {
+    submitFlushQueued_ = false;
+    while (!pendingSubmits_.empty()) {
+        flushSubmits(pendingSubmits_.begin()->first);
+    }
+}
+
+void NetworkWorker::flushSubmits(const std::string& serverId) {
+    const auto pit = pendingSubmits_.find(serverId);
+    if (pit == pendingSubmits_.end()) {
+        return;
+    }
+    const QJsonArray jobs = std::move(pit->second.jobs);
+    pendingSubmits_.erase(pit);
+
+    const auto it = connections_.find(serverId);
+    if (it == connections_.end()) {
+        return;
+    }
+    JobConnection& conn = *it->second;
+
+    if (jobs.size() > 1 && conn.hasServerFeature(wire::kFeatureJobsSubmitBatch)) {
+        for (qsizetype first = 0; first < jobs.size(); first += kSubmitBatchMax) {
+            QJsonArray chunk;
+            const qsizetype last = std::min<qsizetype>(jobs.size(), first + kSubmitBatchMax);
+            for (qsizetype i = first; i < last; ++i) {
+                chunk.append(jobs.at(i));
+            }
+            QJsonObject msg;
+            msg.insert(QStringLiteral("type"), QStringLiteral("jobs_submit_batch"));
+            msg.insert(QStringLiteral("jobs"), chunk);
+            conn.sendJson(msg);
+        }
+        return;
+    }
+
+    for (const auto& job : jobs) {
+        QJsonObject msg;
+        msg.insert(QStringLiteral("type"), QStringLiteral("job_submit_or_update"));
+        msg.insert(QStringLiteral("job"), job);
+        conn.sendJson(msg);
+    }
+}
+
+void NetworkWorker::sendToAll(const QJsonObject& msg) {
+    for (auto& [id, conn] : connections_) {
+        if (!conn->isConnected()) {
+            conn->connectToHost(); // best-effort reconnect
+        }
+        conn->sendJson(msg);
+    }
+}
+
+void NetworkWorker::requestJobsList(const QString& serverId, const QString& cursor) {
+    const auto it = connections_.find(serverId.toStdString());
+    if (it == connections_.end()) {
+        return;
+    }
+
+    if (!it->second->isConnected()) {
+        it->second->connectToHost();
+        // We'll request again on connectionReady.
+        return;
+    }
+
+    JobsListSync& sync = jobsListSync_[serverId.toStdString()];
+    if (cursor.isEmpty()) {
+        // A new listing; its pages all use the same "since".
+        sync.sinceMs        = sync.coveredMs >= 0 ? std::max<qint64>(0, sync.coveredMs - kJobsListSinceSlackMs) : -1;
+        sync.listingStartMs = -1;
+    }
+
+    QJsonObject msg;
+    msg.insert(QStringLiteral("type"), QStringLiteral("jobs_list"));
+    msg.insert(QStringLiteral("include_finished"), true);
+    msg.insert(QStringLiteral("limit"), kJobsListPageSize);
+    msg.insert(QStringLiteral("fields"), jobsListFields());
+    msg.insert(QStringLiteral("log_tail"), kJobsListLogTail);
+    if (sync.sinceMs >= 0) {
+        msg.insert(QStringLiteral("since"), sync.sinceMs);
+    }
+    if (!cursor.isEmpty()) {
+        msg.insert(QStringLiteral("cursor"), cursor);
+    }
+    it->second->sendJson(msg);
+}
+
+void NetworkWorker::onPingTimeout() {
+    for (auto& [id, conn] : connections_) {
+        conn->checkLiveness();
+        if (!conn->isConnected()) {
+            conn->connectToHost(); // no-op while backing off
+            continue;
+        }
+        conn->sendPing();
+    }
+    publishTelemetry();
+}
+
+void NetworkWorker::publishTelemetry() {
+    const qint64 nowMs = telemetryClock_.elapsed();
+
+    for (auto& [id, conn] : connections_) {
+        const JobConnection::Stats& stats = conn->stats();
+        TelemetryState& state = telemetry_[id];
+
+        ServerTelemetry t;
+        t.rttMs            = stats.lastRttMs;
+        t.messagesReceived = stats.messagesReceived;
+        t.bytesReceived    = stats.bytesReceived;
+
+        if (state.sampledAtMs >= 0 && nowMs > state.sampledAtMs) {
+            const double seconds = (nowMs - state.sampledAtMs) / 1000.0;
+            const std::int64_t messages = stats.messagesReceived - state.messages;
+            t.messagesPerSecond = messages / seconds;
+            t.bytesPerSecond    = (stats.bytesReceived - state.bytes) / seconds;
+            if (messages > 0) {
+                t.parseMicrosPerMessage = (stats.parseNanos - state.parseNanos) / 1000.0 / messages;
+            }
+        }
+        state.messages    = stats.messagesReceived;
+        state.bytes       = stats.bytesReceived;
+        state.parseNanos  = stats.parseNanos;
+        state.sampledAtMs = nowMs;
+
+        for (auto it = state.jobs.begin(); it != state.jobs.end();) {
+            if (nowMs - it->second.seenAtMs > kJobNpsStaleMs) {
+                it = state.jobs.erase(it);
+                continue;
+            }
+            t.aggregateNps += it->second.nps;
+            ++t.reportingJobs;
+            ++it;
+        }
+
+        NetworkEvent ev;
+        ev.kind      = NetworkEvent::Kind::Telemetry;
+        ev.serverId  = conn->serverId();
+        ev.telemetry = t;
+        enqueue(std::move(ev));
+    }
+}
+
+void NetworkWorker::trackJobNps(const std::string& serverId, const NetworkEvent& ev) {
+    auto& jobs = telemetry_[serverId].jobs;
+    if (ev.status != JobStatus::Running) {
+        jobs.erase(ev.jobId);
+        return;
+    }
+    if (ev.snapshot.nps && *ev.snapshot.nps > 0) {
+        jobs[ev.jobId] = TelemetryState::JobNps{*ev.snapshot.nps, telemetryClock_.elapsed()};
+    }
+}
+
+void NetworkWorker::onJsonReceived(const QString& serverId, const QJsonObject& obj) {
+    CORRCHESS_TRACE_SCOPE("net.decodeMessage");
+    const QString type = obj.value(QStringLiteral("type")).toString();
+
+    if (type == QStringLiteral("job_update")) {
+        NetworkEvent ev = decodeJobUpdate(serverId, obj);
+        trackJobNps(serverId.toStdString(), ev);
+        enqueue(std::move(ev));
+        return;
+    }
+
+    if (type == QStringLiteral("job_update_batch")) {
+        // Updates are ordered (per job, multipv lines first, logs on the last).
+        const std::string key = serverId.toStdString();
+        for (const auto& v : obj.value(QStringLiteral("updates")).toArray()) {
+            if (v.isObject()) {
+                NetworkEvent ev = decodeJobUpdate(serverId, v.toObject());
+                trackJobNps(key, ev);
+                enqueue(std::move(ev));
+            }
+        }
+        return;
+    }
+
+    if (type == QStringLiteral("jobs_list")) {
+        // Ask for the next page right away; it arrives while this one is applied.
+        // Older servers send everything in one reply and no cursor.
+        const QString next = obj.value(QStringLiteral("next_cursor")).toString();
+        JobsListSync& sync = jobsListSync_[serverId.toStdString()];
+        if (sync.listingStartMs < 0) {
+            sync.listingStartMs = obj.value(QStringLiteral("server_time_ms")).toInteger(-1);
+        }
+        if (next.isEmpty()) {
+            // Without server_time_ms (older server) nothing is covered and
+            // the next listing is a full one again.
+            sync.coveredMs = sync.listingStartMs;
+            sync.complete  = sync.listingStartMs >= 0;
+        } else {
+            requestJobsList(serverId, next);
+        }
+    }
+
+    NetworkEvent ev;
+    ev.kind     = NetworkEvent::Kind::Message;
+    ev.serverId = serverId;
+    ev.message  = obj;
+    enqueue(std::move(ev));
+}
+
+// ---- Queue ----
+
+void NetworkWorker::enqueue(NetworkEvent&& ev) {
+    // Keep order: nothing may overtake events already waiting in the backlog.
+    if (!backlog_.empty()) {
+        pushBacklog();
+    }
+    if (backlog_.empty() && queue_.tryPush(ev)) {
+        wake();
+        return;
+    }
+    backlog_.push_back(std::move(ev));
+    backlogged_.store(true, std::memory_order_release);
+    wake();
+}
+
+void NetworkWorker::pushBacklog() {
+    bool pushed = false;
+    while (!backlog_.empty() && queue_.tryPush(backlog_.front())) {
+        backlog_.pop_front();
+        pushed = true;
+    }
+    if (backlog_.empty()) {
+        backlogged_.store(false, std::memory_order_release);
+    }
+    if (pushed) {
+        wake();
+    }
+}
+
+void NetworkWorker::wake() {
+    if (!wakePending_.exchange(true, std::memory_order_acq_rel)) {
+        emit eventsAvailable();
+    }
+}
+
+bool NetworkWorker::finishDrain() {
+    wakePending_.store(false, std::memory_order_release);
+
+    if (backlogged_.load(std::memory_order_acquire)) {
+        // Runs on the network thread (this object's thread).
+        QMetaObject::invokeMethod(this, [this]() { pushBacklog(); }, Qt::QueuedConnection);
+    }
+
+    // A push that saw wakePending_ still set did not signal; pick it up now.
+    if (!queue_.empty() && !wakePending_.exchange(true, std::memory_order_acq_rel)) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace sf::client::net
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+#include "net/JobConnection.hpp"
+#include "net/SpscQueue.hpp"
+
+namespace sf::client::net {
+
+// One inbound item handed from the network thread to the GUI thread.
+// Everything a connection produces goes through the same queue, so the GUI
+// sees job updates, jobs_list replies and connection changes in the order
+// the network thread saw them.
+struct NetworkEvent {
+    enum class Kind {
+        JobUpdate,    // decoded job_update: jobId/status/snapshot/logLines
+        Message,      // any other protocol message, left as JSON
+        Disconnected,
+        Telemetry,    // connection metrics, once per ping interval
+    };
+
+    Kind    kind{Kind::Message};
+    QString serverId;
+
+    sf::client::domain::JobId        jobId;
+    sf::client::domain::JobStatus    status{sf::client::domain::JobStatus::Running};
+    sf::client::domain::JobSnapshot  snapshot;
+    std::vector<std::string>         logLines;
+
+    QJsonObject message;
+
+    sf::client::domain::ServerTelemetry telemetry;
+};
+
+// Owns all JobConnections and runs on a dedicated QThread (see
+// JobNetworkController): sockets, TLS handshakes, framing, JSON/CBOR parsing
+// and job_update decoding never touch the GUI thread.
+//
+// Results are pushed into a lock-free SPSC queue; eventsAvailable() is
+// emitted only when the queue goes from drained to non-empty, so a burst of
+// updates costs the GUI thread one wake-up. When the queue is full, events
+// wait in a worker-side backlog until the consumer has drained the queue.
+class NetworkWorker final : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr std::size_t kQueueCapacity = 8192;
+
+    explicit NetworkWorker(QObject* parent = nullptr);
+    ~NetworkWorker() override;
+
+    // ---- Network thread (invoke via QMetaObject::invokeMethod) ----
+
+    void initializeConnections(const std::vector<sf::client::domain::ServerInfo>& servers);
+    void send(const QString& serverId, const QJsonObject& msg);
+    void sendToAll(const QJsonObject& msg);
+    // Job objects submitted in one event-loop pass go out together: as
+    // jobs_submit_batch messages when the server supports it, otherwise one
+    // job_submit_or_update each. Anything sent later waits for them.
+    void submitJob(const QString& serverId, const QJsonObject& job);
+    // Summaries only (no log lines); follows next_cursor until the last page.
+    // After a complete listing, the next one (on reconnect) only asks for
+    // jobs changed since the last server time known to be covered (see
+    // JobsListSync); servers without "since" simply send everything.
+    void requestJobsList(const QString& serverId, const QString& cursor = QString());
+
+    // ---- GUI thread ----
+
+    // Pops one event; returns false when the queue is empty. Call in a loop
+    // from the eventsAvailable() handler, then finishDrain().
+    bool tryPopEvent(NetworkEvent& out) { return queue_.tryPop(out); }
+
+    // Re-arms eventsAvailable() once the queue looks empty. Returns true if
+    // events slipped in meanwhile (drain again). Also lets a backlogged
+    // worker refill the queue.
+    bool finishDrain();
+
+signals:
+    void eventsAvailable();
+
+private:
+    void onJsonReceived(const QString& serverId, const QJsonObject& obj);
+    void onPingTimeout();
+    void publishTelemetry();
+    void trackJobNps(const std::string& serverId, const NetworkEvent& ev);
+    void flushSubmits();
+    void flushSubmits(const std::string& serverId);
+
+    void enqueue(NetworkEvent&& ev);
+    void pushBacklog();
+    void wake();
+
+    std::unordered_map<std::string, std::unique_ptr<JobConnection>> connections_;
+    std::unique_ptr<QTimer>                                          pingTimer_;
+
+    // Per-server counters at the previous telemetry sample, and the latest
+    // NPS of each running job (job_update decoding feeds it).
+    struct TelemetryState {
+        std::int64_t messages{0};
+        std::int64_t bytes{0};
+        std::int64_t parseNanos{0};
+        qint64       sampledAtMs{-1};
+
+        struct JobNps {
+            std::int64_t nps{0};
+            qint64       seenAtMs{0};
+        };
+        std::unordered_map<sf::client::domain::JobId, JobNps> jobs;
+    };
+    std::unordered_map<std::string, TelemetryState> telemetry_;
+    QElapsedTimer                                   telemetryClock_;
+
+    struct PendingSubmits {
+        QJsonArray    jobs;
+        QSet<QString> ids; // a job updated twice in one pass is sent once
+    };
+    std::unordered_map<std::string, PendingSubmits> pendingSubmits_;
+
+    // Per server, in server clock (epoch ms). Once a listing completed on a
+    // connection, everything later reached us as job updates, so when it
+    // drops, the last pong's server time is covered too.
+    struct JobsListSync {
+        qint64 sinceMs{-1};        // of the listing in progress; < 0: full listing
+        qint64 listingStartMs{-1}; // server_time_ms of its first page
+        qint64 coveredMs{-1};      // changes before this are known; < 0: none
+        bool   complete{false};    // a listing completed on this connection
+    };
+    std::unordered_map<std::string, JobsListSync> jobsListSync_;
+    bool                                            submitFlushQueued_{false};
+
+    SpscQueue<NetworkEvent>  queue_;
+    std::deque<NetworkEvent> backlog_;               // network thread only
+    std::atomic<bool>        wakePending_{false};    // eventsAvailable() in flight
+    std::atomic<bool>        backlogged_{false};
+};
+
+} // namespace sf::client::net
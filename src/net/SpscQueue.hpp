@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace sf::client::net {
+
+// Bounded single-producer / single-consumer ring buffer.
+//
+// One thread calls tryPush(), one other thread calls tryPop(); neither
+// blocks or takes a lock. Capacity is rounded up to a power of two. Head and
+// tail live on separate cache lines and each side caches the other's index,
+// so the shared lines are only touched when the cached view runs out.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : mask_(roundUp(capacity) - 1)
+        , slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    // Producer side. Returns false (and leaves value untouched) when full.
+    bool tryPush(T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ > mask_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool tryPop(T& out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return false;
+            }
+        }
+        T& slot = slots_[head & mask_];
+        out = std::move(slot);
+        slot = T{}; // release what the item held (e.g. shared Qt data) now
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate; exact only when called from a quiescent state.
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const std::size_t    mask_;
+    std::unique_ptr<T[]> slots_;
+
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0}; // consumer
+    std::size_t tailCache_{0};                              // consumer's view of tail_
+
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; // producer
+    std::size_t headCache_{0};                              // producer's view of head_
+};
+
+} // namespace sf::client::net
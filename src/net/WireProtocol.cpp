@@ -0,0 +1,209 @@
+#include "net/WireProtocol.hpp"
+
+#include "domain/domain_model.hpp"
+
+#include <QCborArray>
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QVariant>
+#include <QtEndian>
+
+#include <string_view>
+
+namespace sf::client::net::wire {
+
+using namespace sf::client::domain;
+
+namespace {
+
+struct FieldName {
+    int         key;
+    const char* json;
+};
+
+// Analysis fields covered by the presence mask, in key order.
+constexpr FieldName kAnalysisFields[] = {
+    {kJobMultipv, "multipv"},
+    {kJobDepth, "depth"},
+    {kJobSelDepth, "seldepth"},
+    {kJobScoreCp, "score_cp"},
+    {kJobScoreMate, "score_mate"},
+    {kJobNodes, "nodes"},
+    {kJobNps, "nps"},
+    {kJobPv, "pv"},
+};
+
+bool isTerminalStatus(int status) {
+    using sf::client::domain::JobStatus;
+    const auto s = static_cast<JobStatus>(status);
+    return s == JobStatus::Finished ||
+           s == JobStatus::Error ||
+           s == JobStatus::Cancelled ||
+           s == JobStatus::Stopped;
+}
+
+QJsonValue toJson(const QCborValue& v) {
+    if (v.isInteger()) {
+        return QJsonValue(v.toInteger());
+    }
+    return v.toJsonValue();
+}
+
+} // namespace
+
+QByteArray encodeFrame(FrameKind kind, const QByteArray& payload) {
+    QByteArray out;
+    out.reserve(kFrameHeaderSize + payload.size());
+    out.append(kFrameMarker);
+    out.append(static_cast<char>(kind));
+    char len[4];
+    qToBigEndian(static_cast<quint32>(payload.size()), len);
+    out.append(len, 4);
+    out.append(payload);
+    return out;
+}
+
+QByteArray encodeMessage(const QJsonObject& obj) {
+    return encodeFrame(FrameKind::Message, QCborMap::fromJsonObject(obj).toCborValue().toCbor());
+}
+
+QJsonObject JobUpdateExpander::expand(const QCborMap& compact) {
+    QJsonObject out;
+    out.insert(QStringLiteral("type"), QStringLiteral("job_update"));
+
+    const QString jobId = compact.value(kJobId).toString();
+    const int     status = static_cast<int>(compact.value(kJobStatus).toInteger());
+    out.insert(QStringLiteral("job_id"), jobId);
+    out.insert(QStringLiteral("status"), status);
+
+    const qint64 present = compact.value(kJobPresent).toInteger(0);
+    if (present != 0) {
+        const int mpv = compact.contains(kJobMultipv)
+            ? static_cast<int>(compact.value(kJobMultipv).toInteger(1))
+            : 1;
+        QJsonObject& last = lastByJob_[jobId][mpv];
+
+        for (const auto& f : kAnalysisFields) {
+            if (!(present & (qint64(1) << (f.key - kJobMultipv)))) {
+                continue;
+            }
+            const QString name = QString::fromLatin1(f.json);
+            if (compact.contains(f.key)) {
+                last.insert(name, toJson(compact.value(f.key)));
+            }
+            const auto it = last.constFind(name);
+            if (it != last.constEnd()) {
+                out.insert(name, *it);
+            }
+        }
+    }
+
+    if (compact.contains(kJobBestMove)) {
+        out.insert(QStringLiteral("bestmove"), compact.value(kJobBestMove).toString());
+    }
+    if (compact.contains(kJobLogLine)) {
+        out.insert(QStringLiteral("log_line"), compact.value(kJobLogLine).toString());
+    }
+    if (compact.contains(kJobLogLines)) {
+        out.insert(QStringLiteral("log_lines"), compact.value(kJobLogLines).toArray().toJsonArray());
+    }
+
+    // The server forgets a job's state once it is over; so do we.
+    if (isTerminalStatus(status)) {
+        lastByJob_.remove(jobId);
+    }
+    return out;
+}
+
+chess::MoveLine decodePv(const QJsonValue& v) {
+    if (!v.isString()) {
+        return {};
+    }
+    // UCI moves are ASCII; anything else stops the parse anyway.
+    const QByteArray text = v.toString().toLatin1();
+    return chess::MoveLine::fromUci(std::string_view(text.constData(), static_cast<std::size_t>(text.size())));
+}
+
+JobUpdate decodeJobUpdate(const QJsonObject& obj) {
+    JobUpdate out;
+    out.jobId  = obj.value(QStringLiteral("job_id")).toString().toStdString();
+    out.status = static_cast<JobStatus>(obj.value(QStringLiteral("status"))
+                                            .toInt(static_cast<int>(JobStatus::Running)));
+
+    JobSnapshot& snap = out.snapshot;
+
+    // NOTE about "depth jumps": Stockfish emits a lot of "info ... currmove ..." lines
+    // (without score/pv). If we treat those as authoritative, UI depth starts to oscillate
+    // (35 -> 34 -> 35 ...). We only update analysis snapshot from lines that carry
+    // an actual evaluation (score and/or pv).
+
+    const bool hasScore = obj.contains(QStringLiteral("score_cp")) || obj.contains(QStringLiteral("score_mate"));
+    const bool hasPv    = obj.contains(QStringLiteral("pv")) && !obj.value(QStringLiteral("pv")).toString().isEmpty();
+    const bool isEvalUpdate = hasScore || hasPv;
+
+    if (isEvalUpdate) {
+        // MultiPV: server may send updates for different 'multipv' lines.
+        const int multipv = obj.value(QStringLiteral("multipv")).toInt(1);
+
+        PvLine line;
+        line.multipv = multipv;
+
+        if (obj.contains(QStringLiteral("depth"))) {
+            line.depth = obj.value(QStringLiteral("depth")).toInt();
+        }
+        if (obj.contains(QStringLiteral("seldepth"))) {
+            line.selDepth = obj.value(QStringLiteral("seldepth")).toInt();
+        }
+        if (obj.contains(QStringLiteral("score_cp"))) {
+            line.score.type  = ScoreType::Cp;
+            line.score.value = obj.value(QStringLiteral("score_cp")).toInt();
+        } else if (obj.contains(QStringLiteral("score_mate"))) {
+            line.score.type  = ScoreType::Mate;
+            line.score.value = obj.value(QStringLiteral("score_mate")).toInt();
+        }
+        if (obj.contains(QStringLiteral("nodes"))) {
+            line.nodes = static_cast<int64_t>(obj.value(QStringLiteral("nodes")).toVariant().toLongLong());
+        }
+        if (obj.contains(QStringLiteral("nps"))) {
+            line.nps = static_cast<int64_t>(obj.value(QStringLiteral("nps")).toVariant().toLongLong());
+        }
+        if (obj.contains(QStringLiteral("pv"))) {
+            line.pv = decodePv(obj.value(QStringLiteral("pv")));
+        }
+
+        // Preserve single-line fields for the UI (multipv=1 only).
+        if (multipv == 1) {
+            snap.depth    = line.depth;
+            snap.selDepth = line.selDepth;
+            snap.score    = line.score;
+            snap.nodes    = line.nodes;
+            snap.nps      = line.nps;
+            snap.pv       = line.pv;
+        }
+
+        // Attach the per-line update.
+        snap.lines.push_back(std::move(line));
+    }
+
+    if (obj.contains(QStringLiteral("bestmove"))) {
+        snap.bestMove = obj.value(QStringLiteral("bestmove")).toString().toStdString();
+    }
+
+    // Single updates carry "log_line"; batched ones all lines since the last batch.
+    if (obj.contains(QStringLiteral("log_line"))) {
+        const auto s = obj.value(QStringLiteral("log_line")).toString();
+        if (!s.isEmpty()) {
+            out.logLines.push_back(s.toStdString());
+        }
+    }
+    for (const auto& v : obj.value(QStringLiteral("log_lines")).toArray()) {
+        const auto s = v.toString();
+        if (!s.isEmpty()) {
+            out.logLines.push_back(s.toStdString());
+        }
+    }
+    return out;
+}
+
+} // namespace sf::client::net::wire
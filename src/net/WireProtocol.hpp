@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCborMap>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+
+#include <string>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+
+namespace sf::client::net::wire {
+
+// Binary framing negotiated on top of line-delimited JSON (see server.py).
+//
+// The client sends {"type":"hello","protocols":["cbor1","json"]}; a server
+// that supports it answers {"type":"hello","protocol":"cbor1"} and from then
+// on each side may send frames:
+//
+//   0xB1 | kind (1 byte) | payload length (u32, big-endian) | CBOR payload
+//
+// 0xB1 can never start a JSON line, so readers accept both encodings at any
+// time and the switch needs no synchronisation. Kinds:
+//
+//   Message    any protocol message, as a CBOR map with the JSON keys
+//   JobUpdate  compact job_update: small integer keys, and analysis fields
+//              that did not change since the previous update of the same
+//              (job, multipv) on this connection are left out
+//   JobUpdateBatch
+//              CBOR array of compact job_update maps, sent to clients that
+//              announce kFeatureJobUpdateBatch (the JSON equivalent is a
+//              {"type":"job_update_batch","updates":[...]} message)
+//
+// The server's hello answer also lists the optional requests it accepts in
+// "features"; kFeatureJobsSubmitBatch means many job_submit_or_update
+// payloads may go out as one {"type":"jobs_submit_batch","jobs":[...]}, and
+// kFeatureJobExtend that {"type":"job_extend","job":{...}} searches a
+// finished job again, deeper, under the same id (on its warm engine while
+// the server still holds it).
+inline constexpr char    kFrameMarker = static_cast<char>(0xB1);
+inline constexpr int     kFrameHeaderSize = 6;
+inline constexpr quint32 kMaxFramePayload = 16u << 20;
+
+inline constexpr const char* kProtocolCbor = "cbor1";
+inline constexpr const char* kProtocolJson = "json";
+
+inline constexpr const char* kFeatureJobUpdateBatch = "job_update_batch";
+inline constexpr const char* kFeatureJobsSubmitBatch = "jobs_submit_batch";
+inline constexpr const char* kFeatureJobExtend = "job_extend";
+
+enum class FrameKind : quint8 {
+    Message   = 0,
+    JobUpdate = 1,
+    JobUpdateBatch = 2,
+};
+
+// Compact job_update keys. Bit (key - kJobMultipv) of kJobPresent marks an
+// analysis field as part of the update; when the bit is set but the key is
+// absent, the value is the one last sent for that (job, multipv).
+enum JobUpdateKey : int {
+    kJobId       = 0,
+    kJobStatus   = 1,
+    kJobPresent  = 2,
+    kJobMultipv  = 3,
+    kJobDepth    = 4,
+    kJobSelDepth = 5,
+    kJobScoreCp  = 6,
+    kJobScoreMate = 7,
+    kJobNodes    = 8,
+    kJobNps      = 9,
+    kJobPv       = 10,
+    kJobBestMove = 11,
+    kJobLogLine  = 12,
+    kJobLogLines = 13, // array of lines, used in batches
+};
+
+QByteArray encodeFrame(FrameKind kind, const QByteArray& payload);
+QByteArray encodeMessage(const QJsonObject& obj);
+
+// A job_update message (JSON key shape) as the GUI-side merger consumes it:
+// the snapshot carries one PvLine for an evaluation update, none for
+// currmove-only progress; logLines has log_line / log_lines in order.
+struct JobUpdate {
+    sf::client::domain::JobId       jobId;
+    sf::client::domain::JobStatus   status{sf::client::domain::JobStatus::Running};
+    sf::client::domain::JobSnapshot snapshot;
+    std::vector<std::string>        logLines;
+};
+
+JobUpdate decodeJobUpdate(const QJsonObject& obj);
+
+// A "pv" value (space-separated UCI moves) as packed moves; anything that is
+// not a string decodes as an empty line.
+sf::client::domain::chess::MoveLine decodePv(const QJsonValue& v);
+
+// Expands compact job_update frames back into the JSON message shape the
+// controller understands. Holds the per-(job, multipv) state of one
+// connection; reset() it whenever the connection is re-established.
+class JobUpdateExpander {
+public:
+    QJsonObject expand(const QCborMap& compact);
+    void reset() { lastByJob_.clear(); }
+
+private:
+    QHash<QString, QHash<int, QJsonObject>> lastByJob_;
+};
+
+} // namespace sf::client::net::wire
@@ -4,30 +4,101 @@ sf_cluster_server.py (asyncio TCP)
 
 Protocol:
 - Client -> server:
-  {"type":"ping"}
-  {"type":"jobs_list","include_finished":true,"limit":200}
+  {"type":"ping","seq":17}
+  {"type":"jobs_list","include_finished":true,"limit":200,"cursor":"...","fields":["id","status",...],"log_tail":0,
+   "since":1700000000000}
   {"type":"job_submit_or_update","job":{"id":"job-1","opponent":"...","fen":"...","limit_type":0,"limit_value":40,"multipv":3}}
+  {"type":"jobs_submit_batch","jobs":[{...same as "job" above...}, ...]}
   {"type":"job_cancel","job_id":"job-1"}
+  {"type":"job_extend","job":{...same as "job" above, with a higher limit_value...}}
 
-- Server -> client (direct response to jobs_list/job_get):
-  {"type":"jobs_list","server_id":"srv1","jobs":[...]} 
+- Server -> client (direct response to jobs_list/job_get/ping):
+  {"type":"jobs_list","server_id":"srv1","jobs":[...],"next_cursor":"...","server_time_ms":...}
   {"type":"job_state","server_id":"srv1","job":{...} | null}
+  {"type":"pong","seq":17,"server_time_ms":...}   (only if the ping had "seq")
 
 - Server -> client:
-  {"type":"server_status","server_id":"srv1","status":1,"running_jobs":2,"max_jobs":4,"threads":8,"logical_cores":32}
+  {"type":"server_status","server_id":"srv1","status":1,"running_jobs":2,"max_jobs":4,"threads":8,"logical_cores":32,
+   "pool_size":4,"pool_idle":2,"pool_busy":2}
+  With --pin-cores also "cpu_pinning":1,"numa_nodes":2,"free_cpus":16,"next_job_threads":8: CPUs in the
+  slots no job is using, and the thread count of the largest one (what the next job gets).
   {"type":"job_update","job_id":"job-1","status":2,"depth":23,...,"log_line":"info ..."}
+
+Encoding: newline-delimited JSON by default. A client may offer binary framing
+with {"type":"hello","protocols":["cbor1","json"]}; the server answers
+{"type":"hello","protocol":"cbor1"} and then sends frames to that client:
+
+  0xB1 | kind (1 byte) | payload length (u32 big-endian) | CBOR payload
+
+kind 0 is any message as a CBOR map; kind 1 is a compact job_update with
+integer keys (see JU_* below) where analysis fields unchanged since the last
+update of the same (job, multipv) are left out. Readers on both ends accept
+JSON lines and frames at any time (0xB1 never starts a JSON line).
+
+Batching: a client that lists "job_update_batch" in the hello "features" gets
+job updates merged per (job, multipv) and sent at most every --batch-ms:
+
+  {"type":"job_update_batch","server_id":"srv1","updates":[
+     {"job_id":"job-1","status":2,"multipv":1,"depth":23,...,"log_lines":[...]}, ...]}
+
+Each update has the job_update fields; "log_lines" carries the job's log lines
+in order. In binary mode the batch is a kind 2 frame: a CBOR array of compact
+job_update maps (JU_LOG_LINES instead of JU_LOG_LINE). Terminal updates flush
+the batch immediately.
+
+Listing: jobs_list returns job summaries newest first, at most "limit" (max
+JOBS_LIST_MAX_LIMIT) per reply. "next_cursor" is present while more remain;
+pass it back as "cursor" for the next page. "fields" keeps only those keys
+("id" is always sent); "log_tail" defaults to 0, i.e. no log lines unless
+asked for. "since" (epoch ms) keeps only jobs whose last update is at or
+after it, so a reconnecting client that passes the server_time_ms of an
+earlier listing (or pong) fetches what changed meanwhile, not every job.
+"server_time_ms" is the server clock when the page was taken; jobs are only
+ever added or updated, so a since-listing misses nothing. Servers answer hello with "features"; one that lists
+"jobs_submit_batch" accepts many submissions in one message, each handled
+exactly like job_submit_or_update.
+
+Root-move splitting: job_submit_or_update may carry "searchmoves":["e2e4",...]
+to restrict the search to those root moves (UCI "go ... searchmoves"). The
+client uses it to spread one position across servers. It is echoed in
+jobs_list but not persisted: such jobs never survive a server restart anyway.
+
+Extending: job_extend re-runs a finished (or cancelled) job with a higher
+limit of the same type under the same id. Its record keeps the earlier lines;
+the engine that searched it stays reserved for it for --extend-grace-s after
+bestmove, and if it is still idle the search continues there without
+ucinewgame, so the transposition table carries the earlier work and the new
+run only pays for the extra depth. Lines shallower than the depth already
+reported are not sent again. A job the server no longer knows is submitted
+as new; one still running, or a lower limit, is answered with a job_update
+carrying the unchanged status and the reason in log_line. Servers that
+accept it list "job_extend" in the hello "features".
+
+Metrics: with --metrics-port the server also serves GET /metrics over plain
+HTTP in the Prometheus text format (message rates and handling time by type,
+bytes in/out, queue depth, engine pool, aggregate NPS of running jobs). It
+binds to --metrics-host, 127.0.0.1 by default; it has no authentication.
+
+Persistence (--db): job records live in memory; those changed since the last
+flush are written every --db-flush-ms by a writer thread in one transaction,
+so disk latency never blocks client I/O. Terminal results are committed
+right away.
 """
 
 import argparse
 import asyncio
 import json
 import os
+import queue
+import re
 import ssl
 import sqlite3
+import struct
+import threading
 import time
 from collections import deque
 from dataclasses import dataclass, field
-from typing import Deque, Dict, Optional, Set, Tuple, Union
+from typing import Any, Deque, Dict, List, Optional, Set, Tuple, Union
 
 # --- Enums must match C++ domain enums --------------------------------------
 
@@ -47,6 +118,9 @@ SERVER_OFFLINE = 3
 
 JsonVal = Union[int, str]
 
+# UCI move (e2e4, e7e8q); searchmoves go onto the engine's command line.
+UCI_MOVE_RE = re.compile(r"^[a-h][1-8][a-h][1-8][nbrq]?$")
+
 
 class JobStore:
     """SQLite persistence for job records and log lines.
@@ -58,9 +132,9 @@ class JobStore:
     processes are gone). On startup we mark such jobs as JOB_ERROR.
     """
 
-    def __init__(self, path: str) -> None:
+    def __init__(self, path: str, check_same_thread: bool = True) -> None:
         self.path = path
-        self.db = sqlite3.connect(self.path)
+        self.db = sqlite3.connect(self.path, check_same_thread=check_same_thread)
         self.db.row_factory = sqlite3.Row
         self._init_schema()
 
@@ -103,48 +177,138 @@ class JobStore:
             """
         )
         cur.execute("CREATE INDEX IF NOT EXISTS idx_job_logs_job_ts ON job_logs(job_id, ts_ms)")
+        # Finished results by position (FEN without move counters, so
+        # transpositions reached by different move orders share a row).
+        cur.execute(
+            """
+            CREATE TABLE IF NOT EXISTS analysis_cache (
+              pos TEXT,
+              limit_type INTEGER,
+              searchmoves TEXT,
+              multipv INTEGER,
+              limit_value INTEGER,
+              bestmove TEXT,
+              last_by_mpv_json TEXT,
+              job_id TEXT,
+              created_at_ms INTEGER,
+              PRIMARY KEY (pos, limit_type, searchmoves, multipv)
+            )
+            """
+        )
         self.db.commit()
 
-    def upsert_job(self, rec: "JobRecord") -> None:
-        cur = self.db.cursor()
+    @staticmethod
+    def cache_row(rec: "JobRecord") -> tuple:
+        return (
+            position_key(rec.fen),
+            int(rec.limit_type),
+            " ".join(rec.searchmoves),
+            int(rec.multipv),
+            int(rec.limit_value),
+            rec.bestmove,
+            json.dumps(rec.last_by_mpv, ensure_ascii=False),
+            rec.job_id,
+            epoch_ms(),
+        )
+
+    @staticmethod
+    def _put_cached(cur: sqlite3.Cursor, row: tuple) -> None:
+        """Remember a finished result unless a deeper one is already cached."""
         cur.execute(
             """
-            INSERT INTO jobs(
-              id, opponent, fen, limit_type, limit_value, multipv, status,
-              created_at_ms, started_at_ms, finished_at_ms, last_update_ms,
-              bestmove, last_by_mpv_json
-            ) VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?)
-            ON CONFLICT(id) DO UPDATE SET
-              opponent=excluded.opponent,
-              fen=excluded.fen,
-              limit_type=excluded.limit_type,
+            INSERT INTO analysis_cache (
+              pos, limit_type, searchmoves, multipv, limit_value,
+              bestmove, last_by_mpv_json, job_id, created_at_ms
+            ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+            ON CONFLICT(pos, limit_type, searchmoves, multipv) DO UPDATE SET
               limit_value=excluded.limit_value,
-              multipv=excluded.multipv,
-              status=excluded.status,
-              created_at_ms=excluded.created_at_ms,
-              started_at_ms=excluded.started_at_ms,
-              finished_at_ms=excluded.finished_at_ms,
-              last_update_ms=excluded.last_update_ms,
               bestmove=excluded.bestmove,
-              last_by_mpv_json=excluded.last_by_mpv_json
+              last_by_mpv_json=excluded.last_by_mpv_json,
+              job_id=excluded.job_id,
+              created_at_ms=excluded.created_at_ms
+            WHERE excluded.limit_value >= analysis_cache.limit_value
+            """,
+            row,
+        )
+
+    def find_cached(self, job: "PendingJob") -> Optional[sqlite3.Row]:
+        """Deepest cached result covering job (same limit type, >= limit, >= MultiPV)."""
+        cur = self.db.execute(
+            """
+            SELECT * FROM analysis_cache
+            WHERE pos = ? AND limit_type = ? AND searchmoves = ?
+              AND multipv >= ? AND limit_value >= ?
+            ORDER BY limit_value DESC
+            LIMIT 1
             """,
             (
-                rec.job_id,
-                rec.opponent,
-                rec.fen,
-                int(rec.limit_type),
-                int(rec.limit_value),
-                int(rec.multipv),
-                int(rec.status),
-                int(rec.created_at_ms),
-                int(rec.started_at_ms) if rec.started_at_ms is not None else None,
-                int(rec.finished_at_ms) if rec.finished_at_ms is not None else None,
-                int(rec.last_update_ms),
-                rec.bestmove,
-                json.dumps(rec.last_by_mpv, separators=(",", ":")),
+                position_key(job.fen),
+                int(job.limit_type),
+                " ".join(job.searchmoves),
+                int(job.multipv or 1),
+                int(job.limit_value),
             ),
         )
-        self.db.commit()
+        return cur.fetchone()
+
+    _UPSERT_SQL = """
+    INSERT INTO jobs(
+      id, opponent, fen, limit_type, limit_value, multipv, status,
+      created_at_ms, started_at_ms, finished_at_ms, last_update_ms,
+      bestmove, last_by_mpv_json
+    ) VALUES(?,?,?,?,?,?,?,?,?,?,?,?,?)
+    ON CONFLICT(id) DO UPDATE SET
+      opponent=excluded.opponent,
+      fen=excluded.fen,
+      limit_type=excluded.limit_type,
+      limit_value=excluded.limit_value,
+      multipv=excluded.multipv,
+      status=excluded.status,
+      created_at_ms=excluded.created_at_ms,
+      started_at_ms=excluded.started_at_ms,
+      finished_at_ms=excluded.finished_at_ms,
+      last_update_ms=excluded.last_update_ms,
+      bestmove=excluded.bestmove,
+      last_by_mpv_json=excluded.last_by_mpv_json
+    """
+
+    def write_batch(self,
+                    jobs: List[tuple],
+                    logs: List[Tuple[str, int, str]],
+                    cached: List[tuple] = ()) -> None:
+        """Upsert job rows (job_row), append log lines and store cache rows
+        (cache_row) in one transaction."""
+        cur = self.db.cursor()
+        try:
+            if jobs:
+                cur.executemany(self._UPSERT_SQL, jobs)
+            if logs:
+                cur.executemany("INSERT INTO job_logs(job_id, ts_ms, line) VALUES(?,?,?)", logs)
+            for row in cached:
+                self._put_cached(cur, row)
+            self.db.commit()
+        except Exception:
+            self.db.rollback()
+            raise
+
+    @staticmethod
+    def job_row(rec: "JobRecord") -> tuple:
+        """The jobs table row for rec, taken now (rec keeps changing)."""
+        return (
+            rec.job_id,
+            rec.opponent,
+            rec.fen,
+            int(rec.limit_type),
+            int(rec.limit_value),
+            int(rec.multipv),
+            int(rec.status),
+            int(rec.created_at_ms),
+            int(rec.started_at_ms) if rec.started_at_ms is not None else None,
+            int(rec.finished_at_ms) if rec.finished_at_ms is not None else None,
+            int(rec.last_update_ms),
+            rec.bestmove,
+            json.dumps(rec.last_by_mpv, separators=(",", ":")),
+        )
 
     def append_log(self, job_id: str, ts_ms: int, line: str) -> None:
         if not line:
@@ -159,13 +323,27 @@ class JobStore:
     def fetch_log_tail(self, job_id: str, limit: int = 200) -> list[str]:
         cur = self.db.cursor()
         cur.execute(
-            "SELECT line FROM job_logs WHERE job_id=? ORDER BY ts_ms DESC LIMIT ?",
+            "SELECT line FROM job_logs WHERE job_id=? ORDER BY ts_ms DESC, rowid DESC LIMIT ?",
             (job_id, int(limit)),
         )
         rows = [r[0] for r in cur.fetchall()]
         rows.reverse()
         return rows
 
+    def count_log(self, job_id: str) -> int:
+        cur = self.db.cursor()
+        cur.execute("SELECT COUNT(*) FROM job_logs WHERE job_id=?", (job_id,))
+        return int(cur.fetchone()[0])
+
+    def fetch_log_range(self, job_id: str, offset: int, limit: int) -> list[str]:
+        """Lines offset .. offset+limit-1 of the job's log, oldest first."""
+        cur = self.db.cursor()
+        cur.execute(
+            "SELECT line FROM job_logs WHERE job_id=? ORDER BY ts_ms, rowid LIMIT ? OFFSET ?",
+            (job_id, int(limit), int(offset)),
+        )
+        return [r[0] for r in cur.fetchall()]
+
     def list_jobs(self, include_finished: bool, limit: int) -> list[sqlite3.Row]:
         terminal = (JOB_FINISHED, JOB_ERROR, JOB_CANCELLED, JOB_STOPPED)
         cur = self.db.cursor()
@@ -211,6 +389,450 @@ class JobStore:
         return ids
 
 
+@dataclass
+class WriteBatch:
+    jobs: Dict[str, tuple] = field(default_factory=dict)   # job id -> JobStore.job_row
+    logs: List[Tuple[str, int, str]] = field(default_factory=list)
+    cached: List[tuple] = field(default_factory=list)      # JobStore.cache_row
+    urgent: bool = False                                   # commit without waiting out the window
+
+
+class JobStoreWriter:
+    """Writes to the JobStore file from a thread of its own.
+
+    The event loop only hands over rows that are already built (JobStore.job_row,
+    cache_row), so the records can keep changing meanwhile. The thread gathers
+    every batch that arrives within group_ms of the first one into a single
+    transaction, keeping one row per job. Urgent batches (terminal results)
+    end the window at once. Reads stay on the loop's own connection; WAL
+    lets them run while a transaction is open here.
+
+    Those reads see a change only once committed, up to a flush interval
+    plus the group window after the record took it. Whatever the records
+    still hold (state, the log ring) is served from memory; the DB only
+    supplies what memory has dropped.
+    """
+
+    def __init__(self, path: str, group_ms: int) -> None:
+        self.group_s = max(0, int(group_ms)) / 1000.0
+        self.commits = 0
+        self.rows_written = 0
+        self.errors = 0
+        self.commit_seconds = 0.0
+        self._queue: "queue.Queue[Optional[WriteBatch]]" = queue.Queue()
+        # Opened here so a bad path fails at startup; used by the thread only.
+        self._store = JobStore(path, check_same_thread=False)
+        self._thread = threading.Thread(target=self._run, name="jobstore-writer", daemon=True)
+        self._thread.start()
+
+    def submit(self, batch: WriteBatch) -> None:
+        if batch.jobs or batch.logs or batch.cached:
+            self._queue.put(batch)
+
+    def backlog(self) -> int:
+        return self._queue.qsize()
+
+    def close(self, timeout: float = 30.0) -> None:
+        """Commit everything submitted so far and stop the thread."""
+        self._queue.put(None)
+        self._thread.join(timeout)
+
+    def _run(self) -> None:
+        stopping = False
+        while not stopping:
+            batch = self._queue.get()
+            if batch is None:
+                break
+            merged = WriteBatch()
+            self._add(merged, batch)
+            deadline = time.monotonic() + self.group_s
+            while True:
+                if merged.urgent:
+                    timeout = 0.0
+                else:
+                    timeout = deadline - time.monotonic()
+                try:
+                    nxt = self._queue.get(timeout=timeout) if timeout > 0 else self._queue.get_nowait()
+                except queue.Empty:
+                    break
+                if nxt is None:
+                    stopping = True
+                    break
+                self._add(merged, nxt)
+            self._commit(merged)
+        self._store.close()
+
+    @staticmethod
+    def _add(into: WriteBatch, batch: WriteBatch) -> None:
+        into.jobs.update(batch.jobs)
+        into.logs.extend(batch.logs)
+        into.cached.extend(batch.cached)
+        into.urgent = into.urgent or batch.urgent
+
+    def _commit(self, batch: WriteBatch) -> None:
+        rows = list(batch.jobs.values())
+        started = time.perf_counter()
+        try:
+            self._store.write_batch(rows, batch.logs, batch.cached)
+        except Exception as exc:
+            # Don't take the server down because the DB is unavailable.
+            self.errors += 1
+            print(f"[server] DB write failed for {len(rows)} job(s): {exc}")
+            return
+        self.commits += 1
+        self.rows_written += len(rows) + len(batch.logs) + len(batch.cached)
+        self.commit_seconds += time.perf_counter() - started
+
+
+# --- Binary framing (must match src/net/WireProtocol.hpp) ---------------------
+
+PROTO_CBOR = "cbor1"
+PROTO_JSON = "json"
+
+FRAME_MARKER = 0xB1
+FRAME_HEADER = struct.Struct(">BBI")  # marker, kind, payload length
+FRAME_MESSAGE = 0
+FRAME_JOB_UPDATE = 1
+FRAME_JOB_UPDATE_BATCH = 2
+MAX_FRAME_PAYLOAD = 16 << 20
+
+JU_JOB_ID = 0
+JU_STATUS = 1
+JU_PRESENT = 2
+JU_BESTMOVE = 11
+JU_LOG_LINE = 12
+JU_LOG_LINES = 13
+# Analysis fields covered by the JU_PRESENT bit mask: bit = key - JU_MULTIPV.
+JU_MULTIPV = 3
+JU_ANALYSIS_KEYS = (
+    ("multipv", 3),
+    ("depth", 4),
+    ("seldepth", 5),
+    ("score_cp", 6),
+    ("score_mate", 7),
+    ("nodes", 8),
+    ("nps", 9),
+    ("pv", 10),
+)
+
+FEATURE_JOB_UPDATE_BATCH = "job_update_batch"
+FEATURE_JOBS_SUBMIT_BATCH = "jobs_submit_batch"
+FEATURE_JOB_EXTEND = "job_extend"
+SERVER_FEATURES = [FEATURE_JOB_UPDATE_BATCH, FEATURE_JOBS_SUBMIT_BATCH, FEATURE_JOB_EXTEND]
+
+# jobs_list page size bound; jobs_submit_batch size bound.
+JOBS_LIST_MAX_LIMIT = 1000
+SUBMIT_BATCH_MAX_JOBS = 5000
+TERMINAL_STATUSES = (JOB_FINISHED, JOB_ERROR, JOB_CANCELLED, JOB_STOPPED)
+# Terminal states whose result job_extend can build on.
+EXTENDABLE_STATUSES = (JOB_FINISHED, JOB_CANCELLED, JOB_STOPPED)
+
+
+def _cbor_head(major: int, n: int) -> bytes:
+    if n < 24:
+        return bytes([(major << 5) | n])
+    if n < 0x100:
+        return bytes([(major << 5) | 24, n])
+    if n < 0x10000:
+        return bytes([(major << 5) | 25]) + struct.pack(">H", n)
+    if n < 0x100000000:
+        return bytes([(major << 5) | 26]) + struct.pack(">I", n)
+    return bytes([(major << 5) | 27]) + struct.pack(">Q", n)
+
+
+def cbor_dumps(obj: Any) -> bytes:
+    """Minimal CBOR encoder for JSON-shaped values (RFC 8949 subset)."""
+    out = bytearray()
+
+    def enc(v: Any) -> None:
+        if v is None:
+            out.append(0xF6)
+        elif v is True:
+            out.append(0xF5)
+        elif v is False:
+            out.append(0xF4)
+        elif isinstance(v, int):
+            out.extend(_cbor_head(0, v) if v >= 0 else _cbor_head(1, -1 - v))
+        elif isinstance(v, float):
+            out.append(0xFB)
+            out.extend(struct.pack(">d", v))
+        elif isinstance(v, str):
+            b = v.encode("utf-8")
+            out.extend(_cbor_head(3, len(b)))
+            out.extend(b)
+        elif isinstance(v, (bytes, bytearray)):
+            out.extend(_cbor_head(2, len(v)))
+            out.extend(v)
+        elif isinstance(v, (list, tuple, deque)):
+            out.extend(_cbor_head(4, len(v)))
+            for x in v:
+                enc(x)
+        elif isinstance(v, dict):
+            out.extend(_cbor_head(5, len(v)))
+            for k, x in v.items():
+                enc(k)
+                enc(x)
+        else:
+            raise TypeError(f"cannot CBOR-encode {type(v).__name__}")
+
+    enc(obj)
+    return bytes(out)
+
+
+def cbor_loads(data: bytes) -> Any:
+    """Minimal CBOR decoder (definite lengths, no tags) matching cbor_dumps."""
+    pos = 0
+
+    def arg(info: int) -> int:
+        nonlocal pos
+        if info < 24:
+            return info
+        size = {24: 1, 25: 2, 26: 4, 27: 8}.get(info)
+        if size is None or pos + size > len(data):
+            raise ValueError("bad CBOR length")
+        v = int.from_bytes(data[pos : pos + size], "big")
+        pos += size
+        return v
+
+    def dec() -> Any:
+        nonlocal pos
+        if pos >= len(data):
+            raise ValueError("truncated CBOR")
+        ib = data[pos]
+        pos += 1
+        major, info = ib >> 5, ib & 0x1F
+        if major == 0:
+            return arg(info)
+        if major == 1:
+            return -1 - arg(info)
+        if major in (2, 3):
+            n = arg(info)
+            if pos + n > len(data):
+                raise ValueError("truncated CBOR string")
+            raw = data[pos : pos + n]
+            pos += n
+            return bytes(raw) if major == 2 else raw.decode("utf-8", errors="replace")
+        if major == 4:
+            return [dec() for _ in range(arg(info))]
+        if major == 5:
+            n = arg(info)
+            m = {}
+            for _ in range(n):
+                k = dec()
+                m[k] = dec()
+            return m
+        if major == 7:
+            if info == 20:
+                return False
+            if info == 21:
+                return True
+            if info in (22, 23):
+                return None
+            if info == 25:
+                v = struct.unpack(">e", data[pos : pos + 2])[0]
+                pos += 2
+                return v
+            if info == 26:
+                v = struct.unpack(">f", data[pos : pos + 4])[0]
+                pos += 4
+                return v
+            if info == 27:
+                v = struct.unpack(">d", data[pos : pos + 8])[0]
+                pos += 8
+                return v
+        raise ValueError(f"unsupported CBOR item 0x{ib:02x}")
+
+    return dec()
+
+
+def encode_frame(kind: int, payload: bytes) -> bytes:
+    return FRAME_HEADER.pack(FRAME_MARKER, kind, len(payload)) + payload
+
+
+@dataclass
+class PendingUpdate:
+    """job_update messages of one job merged since the last batch was sent."""
+
+    status: int = JOB_RUNNING
+    by_mpv: Dict[int, Dict[str, JsonVal]] = field(default_factory=dict)
+    bestmove: Optional[str] = None
+    log_lines: List[str] = field(default_factory=list)
+
+    def merge(self, msg: Dict[str, JsonVal]) -> None:
+        self.status = int(msg["status"])
+        fields = {name: msg[name] for name, _ in JU_ANALYSIS_KEYS if name in msg}
+        if fields:
+            mpv = int(msg.get("multipv", 1) or 1)
+            self.by_mpv.setdefault(mpv, {}).update(fields)
+        if "bestmove" in msg:
+            self.bestmove = str(msg["bestmove"])
+        if msg.get("log_line"):
+            self.log_lines.append(str(msg["log_line"]))
+
+    def to_updates(self, job_id: str) -> List[Dict[str, Any]]:
+        """One update per multipv line; bestmove and logs ride on the last."""
+        updates: List[Dict[str, Any]] = []
+        for mpv in sorted(self.by_mpv):
+            u: Dict[str, Any] = {"job_id": job_id, "status": self.status}
+            u.update(self.by_mpv[mpv])
+            u["multipv"] = mpv
+            updates.append(u)
+        if not updates:
+            updates.append({"job_id": job_id, "status": self.status})
+        if self.bestmove is not None:
+            updates[-1]["bestmove"] = self.bestmove
+        if self.log_lines:
+            updates[-1]["log_lines"] = list(self.log_lines)
+        return updates
+
+
+@dataclass
+class ClientSession:
+    """Per-connection protocol state."""
+
+    binary: bool = False
+    batching: bool = False
+    # Last analysis fields sent per (job_id, multipv); basis of compact deltas.
+    last_sent: Dict[Tuple[str, int], Dict[str, JsonVal]] = field(default_factory=dict)
+    # Batching state: merged updates per job (insertion ordered) and the
+    # earliest time the next batch may go out.
+    pending: Dict[str, PendingUpdate] = field(default_factory=dict)
+    next_send: float = 0.0
+    flush_handle: Optional[asyncio.TimerHandle] = None
+
+    def queue_job_update(self, msg: Dict[str, JsonVal]) -> None:
+        job_id = str(msg["job_id"])
+        p = self.pending.get(job_id)
+        if p is None:
+            p = PendingUpdate()
+            self.pending[job_id] = p
+        p.merge(msg)
+
+    def take_batch(self) -> List[Dict[str, Any]]:
+        updates: List[Dict[str, Any]] = []
+        for job_id, p in self.pending.items():
+            updates.extend(p.to_updates(job_id))
+        self.pending.clear()
+        return updates
+
+    def compact_job_update(self, msg: Dict[str, JsonVal]) -> bytes:
+        return encode_frame(FRAME_JOB_UPDATE, cbor_dumps(self._compact(msg)))
+
+    def compact_job_update_batch(self, updates: List[Dict[str, Any]]) -> bytes:
+        return encode_frame(FRAME_JOB_UPDATE_BATCH, cbor_dumps([self._compact(u) for u in updates]))
+
+    def _compact(self, msg: Dict[str, Any]) -> Dict[int, Any]:
+        job_id = str(msg["job_id"])
+        status = int(msg["status"])
+        out: Dict[int, JsonVal] = {JU_JOB_ID: job_id, JU_STATUS: status}
+
+        present = 0
+        mpv = int(msg.get("multipv", 1) or 1)
+        last = self.last_sent.setdefault((job_id, mpv), {})
+        for name, key in JU_ANALYSIS_KEYS:
+            if name not in msg:
+                continue
+            present |= 1 << (key - JU_MULTIPV)
+            value = msg[name]
+            # multipv is always sent: the receiver needs it to find its basis.
+            if key == JU_MULTIPV or last.get(name) != value:
+                out[key] = value
+                last[name] = value
+        if present:
+            out[JU_PRESENT] = present
+        if "bestmove" in msg:
+            out[JU_BESTMOVE] = msg["bestmove"]
+        if "log_line" in msg:
+            out[JU_LOG_LINE] = msg["log_line"]
+        if "log_lines" in msg:
+            out[JU_LOG_LINES] = list(msg["log_lines"])
+
+        if status in TERMINAL_STATUSES:
+            for k in [k for k in self.last_sent if k[0] == job_id]:
+                del self.last_sent[k]
+        return out
+
+
+class ServerMetrics:
+    """Counters behind the /metrics endpoint; updated on the event loop only."""
+
+    # Anything else is counted as "other" so clients cannot grow the label set.
+    MESSAGE_TYPES = ("hello", "ping", "jobs_list", "job_get", "job_submit_or_update",
+                     "jobs_submit_batch", "job_cancel", "job_extend")
+
+    def __init__(self) -> None:
+        self.started = time.monotonic()
+        self.messages_received: Dict[str, int] = {}
+        self.handle_seconds: Dict[str, float] = {}
+        self.bytes_received = 0
+        self.bytes_sent = 0
+        self.writes = 0
+        self.job_updates = 0
+        self.jobs_submitted = 0
+        self.jobs_extended = 0
+        self.jobs_extended_warm = 0  # continued on the engine that searched them
+        self.jobs_finished: Dict[int, int] = {}
+        self.connections = 0
+        # Latest nps per running job (multipv 1 lines only).
+        self.job_nps: Dict[str, int] = {}
+
+    def message_handled(self, msg_type: Any, seconds: float) -> None:
+        label = msg_type if msg_type in self.MESSAGE_TYPES else "other"
+        self.messages_received[label] = self.messages_received.get(label, 0) + 1
+        self.handle_seconds[label] = self.handle_seconds.get(label, 0.0) + seconds
+
+    def job_update(self, job_id: str, status: int, fields: Dict[str, JsonVal], was_terminal: bool) -> None:
+        self.job_updates += 1
+        if status in TERMINAL_STATUSES:
+            self.job_nps.pop(job_id, None)
+            if not was_terminal:
+                self.jobs_finished[status] = self.jobs_finished.get(status, 0) + 1
+        elif status == JOB_RUNNING and "nps" in fields and int(fields.get("multipv", 1) or 1) == 1:
+            try:
+                self.job_nps[job_id] = int(fields["nps"])
+            except (TypeError, ValueError):
+                pass
+
+
+async def read_message(reader: asyncio.StreamReader,
+                       metrics: Optional[ServerMetrics] = None) -> Optional[dict]:
+    """Read one JSON line or binary frame; None on EOF, {} on junk."""
+    first = await reader.read(1)
+    if not first:
+        return None
+    if first[0] == FRAME_MARKER:
+        rest = await reader.readexactly(FRAME_HEADER.size - 1)
+        _, kind, length = FRAME_HEADER.unpack(first + rest)
+        if length > MAX_FRAME_PAYLOAD:
+            raise ValueError("oversized frame")
+        payload = await reader.readexactly(length)
+        if metrics is not None:
+            metrics.bytes_received += FRAME_HEADER.size + length
+        if kind != FRAME_MESSAGE:
+            return {}
+        try:
+            obj = cbor_loads(payload)
+        except ValueError:
+            return {}
+        return obj if isinstance(obj, dict) else {}
+
+    raw = first + await reader.readline()
+    if metrics is not None:
+        metrics.bytes_received += len(raw)
+    line = raw.strip()
+    if not line:
+        return {}
+    try:
+        obj = json.loads(line.decode("utf-8", errors="ignore"))
+    except json.JSONDecodeError:
+        return {}
+    return obj if isinstance(obj, dict) else {}
+
+
+def position_key(fen: str) -> str:
+    """FEN without halfmove/fullmove counters (analysis does not depend on them)."""
+    return " ".join(fen.split()[:4])
+
 
 def epoch_ms() -> int:
     """Wall-clock milliseconds since Unix epoch."""
@@ -272,6 +894,9 @@ class PendingJob:
     limit_type: int
     limit_value: int
     multipv: int = 1
+    searchmoves: List[str] = field(default_factory=list)
+    # job_extend: per-multipv depth already reported; shallower lines are not resent.
+    reported_depth: Dict[int, int] = field(default_factory=dict)
 
 
 @dataclass
@@ -288,6 +913,7 @@ class JobRecord:
     limit_type: int = 0
     limit_value: int = 0
     multipv: int = 1
+    searchmoves: List[str] = field(default_factory=list)
 
     status: int = JOB_PENDING
 
@@ -302,12 +928,361 @@ class JobRecord:
     # Last seen bestmove.
     bestmove: str = ""
 
-    # Keep a bounded log tail.
+    # Keep a bounded log tail; log_total counts every line the job ever
+    # logged, so log_total - len(log) older lines are only in the DB.
     log: Deque[str] = field(default_factory=lambda: deque(maxlen=2000))
+    log_total: int = 0
 
     def append_log(self, line: str) -> None:
         if line:
             self.log.append(line)
+            self.log_total += 1
+
+
+class Engine:
+    """One Stockfish process; EnginePool keeps it alive across jobs."""
+
+    def __init__(self, proc: asyncio.subprocess.Process, slot: Optional[int] = None) -> None:
+        self.proc = proc
+        self.slot = slot  # CoreAllocator slot the process is pinned to
+        self.multipv = 1
+        # Game the transposition table currently holds (see EnginePool.acquire).
+        self.game_key = ""
+        # Last job searched, and until when (monotonic) it has first claim on
+        # this engine so job_extend can continue on the same TT.
+        self.job_id = ""
+        self.held_until = 0.0
+        # Idle beyond the pool size, only for the grace period.
+        self.lingering = False
+
+    def alive(self) -> bool:
+        return self.proc.returncode is None
+
+    async def send(self, cmd: str) -> None:
+        assert self.proc.stdin
+        self.proc.stdin.write((cmd + "\n").encode("utf-8"))
+        await self.proc.stdin.drain()
+
+    async def readline(self) -> str:
+        assert self.proc.stdout
+        line = await self.proc.stdout.readline()
+        if not line:
+            raise RuntimeError("Engine terminated unexpectedly")
+        return line.decode("utf-8", errors="ignore").strip()
+
+    async def wait_for(self, token: str) -> None:
+        while await self.readline() != token:
+            pass
+
+    async def close(self) -> None:
+        try:
+            if self.alive():
+                try:
+                    await self.send("quit")
+                    await asyncio.wait_for(self.proc.wait(), timeout=2.0)
+                except Exception:
+                    pass
+            if self.alive():
+                self.proc.kill()
+        except ProcessLookupError:
+            pass
+        try:
+            await self.proc.wait()
+        except Exception:
+            pass
+
+
+def parse_cpulist(text: str) -> List[int]:
+    """Linux cpulist syntax ("0-3,8,10-11") -> CPU numbers."""
+    cpus: List[int] = []
+    for part in text.strip().split(","):
+        if not part:
+            continue
+        lo, _, hi = part.partition("-")
+        cpus.extend(range(int(lo), int(hi or lo) + 1))
+    return cpus
+
+
+def host_cpu_topology() -> Dict[int, List[List[int]]]:
+    """Usable CPUs as NUMA node -> physical cores -> SMT siblings.
+
+    Read from sysfs and limited to this process' affinity mask; elsewhere
+    (or without sysfs) every CPU is its own core on node 0.
+    """
+    try:
+        allowed = set(os.sched_getaffinity(0))
+    except (AttributeError, OSError):
+        allowed = set(range(os.cpu_count() or 1))
+
+    def read(path: str) -> Optional[str]:
+        try:
+            with open(path, "r", encoding="ascii") as f:
+                return f.read()
+        except OSError:
+            return None
+
+    node_of: Dict[int, int] = {}
+    base = "/sys/devices/system/node"
+    try:
+        names = os.listdir(base)
+    except OSError:
+        names = []
+    for name in names:
+        if name.startswith("node") and name[4:].isdigit():
+            text = read(os.path.join(base, name, "cpulist"))
+            for cpu in parse_cpulist(text) if text else []:
+                node_of[cpu] = int(name[4:])
+
+    topology: Dict[int, List[List[int]]] = {}
+    seen: Set[int] = set()
+    for cpu in sorted(allowed):
+        if cpu in seen:
+            continue
+        text = read(f"/sys/devices/system/cpu/cpu{cpu}/topology/thread_siblings_list")
+        siblings = [c for c in parse_cpulist(text) if c in allowed] if text else [cpu]
+        if cpu not in siblings:
+            siblings = [cpu]
+        seen.update(siblings)
+        topology.setdefault(node_of.get(cpu, 0), []).append(siblings)
+    return topology
+
+
+class CoreAllocator:
+    """Disjoint CPU sets, one per job slot, for pinning engines.
+
+    Slots are spread over NUMA nodes in proportion to their cores and never
+    span a node unless there are fewer slots than nodes (then a slot takes
+    whole nodes). Cores are handed out whole, SMT siblings together; only
+    with more slots than cores do sets repeat. An
+    engine is pinned before it allocates Hash, so with the kernel's default
+    first-touch policy its table lands on the slot's own node.
+    """
+
+    def __init__(self, topology: Dict[int, List[List[int]]], slots: int) -> None:
+        self.sets: List[Tuple[int, List[int]]] = []  # (node, cpus) per slot
+        nodes = sorted(topology)
+        slots = max(1, slots)
+        if slots < len(nodes):
+            merged: List[List[int]] = [[] for _ in range(slots)]
+            owner: List[int] = [nodes[i] for i in range(slots)]
+            for i, node in enumerate(nodes):
+                merged[i % slots].extend(c for core in topology[node] for c in core)
+            self.sets = [(owner[i], sorted(merged[i])) for i in range(slots)]
+        else:
+            total = sum(len(topology[n]) for n in nodes)
+            # Largest remainder: every node gets at least one slot.
+            shares = {n: max(1, slots * len(topology[n]) // total) for n in nodes}
+            by_remainder = sorted(nodes, key=lambda n: -((slots * len(topology[n])) % total))
+            i = 0
+            while sum(shares.values()) < slots:
+                shares[by_remainder[i % len(nodes)]] += 1
+                i += 1
+            while sum(shares.values()) > slots:
+                n = max((n for n in nodes if shares[n] > 1), key=lambda n: shares[n])
+                shares[n] -= 1
+            for n in nodes:
+                cores = topology[n]
+                k = shares[n]
+                for j in range(k):
+                    if k <= len(cores):
+                        chunk = cores[j * len(cores) // k:(j + 1) * len(cores) // k]
+                    else:
+                        chunk = [cores[j % len(cores)]]  # more slots than cores: sets repeat
+                    self.sets.append((n, sorted(c for core in chunk for c in core)))
+        self.owned: List[bool] = [False] * len(self.sets)
+        self.busy: List[bool] = [False] * len(self.sets)
+
+    @property
+    def node_count(self) -> int:
+        return len({node for node, _ in self.sets})
+
+    def take(self) -> Optional[int]:
+        """A slot no engine holds yet (None when all are taken)."""
+        for i, owned in enumerate(self.owned):
+            if not owned:
+                self.owned[i] = True
+                return i
+        return None
+
+    def give(self, slot: Optional[int]) -> None:
+        if slot is not None:
+            self.owned[slot] = False
+            self.busy[slot] = False
+
+    def cpus(self, slot: int) -> List[int]:
+        return self.sets[slot][1]
+
+    def status(self) -> Dict[str, int]:
+        free = [len(cpus) for i, (_, cpus) in enumerate(self.sets) if not self.busy[i]]
+        return {
+            "cpu_pinning": 1,
+            "numa_nodes": self.node_count,
+            "free_cpus": sum(free),
+            "next_job_threads": max(free, default=0),
+        }
+
+
+class EnginePool:
+    """Warm Stockfish processes reused across jobs.
+
+    Spawning costs the NNUE load and the Hash allocation; a pooled engine pays
+    that once. Threads and Hash are fixed per engine, MultiPV is set per job.
+    Consecutive jobs of the same game key keep the transposition table (no
+    ucinewgame). size 0 = no pooling: every job gets a fresh engine.
+
+    With an allocator every engine holds one CPU slot for its lifetime, is
+    pinned to it and runs one thread per CPU of the slot; the pool is then
+    at most as big as the number of slots.
+
+    After a job the engine is held for it for grace_s: acquire() hands it to
+    a job extending that one first and to other jobs only when no other idle
+    engine is left. An engine the pool has no room for lingers idle for the
+    grace period instead of being closed at once.
+    """
+
+    def __init__(self, stockfish_path: str, threads: int, hash_mb: int, size: int,
+                 allocator: Optional[CoreAllocator] = None, grace_s: float = 0.0) -> None:
+        self.stockfish_path = stockfish_path
+        self.threads = threads
+        self.hash_mb = hash_mb
+        self.allocator = allocator
+        self.size = max(0, size) if allocator is None else min(max(0, size), len(allocator.sets))
+        self.grace_s = max(0.0, float(grace_s))
+        self.idle: List[Engine] = []
+        self.busy = 0
+        self._expiry_tasks: Set[asyncio.Task] = set()
+
+    async def _spawn(self) -> Engine:
+        slot = self.allocator.take() if self.allocator is not None else None
+        threads = self.threads
+        try:
+            proc = await asyncio.create_subprocess_exec(
+                self.stockfish_path,
+                stdin=asyncio.subprocess.PIPE,
+                stdout=asyncio.subprocess.PIPE,
+                stderr=asyncio.subprocess.STDOUT,
+            )
+        except Exception:
+            if self.allocator is not None:
+                self.allocator.give(slot)
+            raise
+        eng = Engine(proc, slot)
+        if slot is not None:
+            cpus = self.allocator.cpus(slot)
+            threads = len(cpus)
+            try:
+                # Before "uci": Stockfish's search threads inherit it.
+                os.sched_setaffinity(proc.pid, cpus)
+            except (AttributeError, OSError) as exc:
+                print(f"[server] Could not pin engine to CPUs {cpus}: {exc}")
+        try:
+            await eng.send("uci")
+            await eng.wait_for("uciok")
+            if threads > 0:
+                await eng.send(f"setoption name Threads value {threads}")
+            if self.hash_mb > 0:
+                await eng.send(f"setoption name Hash value {self.hash_mb}")
+            await eng.send("isready")
+            await eng.wait_for("readyok")
+        except Exception:
+            await self._close(eng)
+            raise
+        return eng
+
+    async def _close(self, eng: Engine) -> None:
+        await eng.close()
+        if self.allocator is not None:
+            self.allocator.give(eng.slot)
+
+    async def warm(self) -> None:
+        """Start engines up to the pool size so the first jobs skip startup."""
+        missing = self.size - len(self.idle) - self.busy
+        if missing <= 0:
+            return
+        results = await asyncio.gather(*(self._spawn() for _ in range(missing)), return_exceptions=True)
+        for r in results:
+            if isinstance(r, Engine):
+                self.idle.append(r)
+            else:
+                print(f"[server] Engine warm-up failed: {r}")
+
+    async def acquire(self, game_key: str, job_id: str = "") -> Engine:
+        """An idle engine: the one that last searched job_id, else one that
+        last searched game_key, else one no other job holds, else any."""
+        dead = [e for e in self.idle if not e.alive()]
+        if dead:
+            self.idle = [e for e in self.idle if e.alive()]
+            await asyncio.gather(*(self._close(e) for e in dead), return_exceptions=True)
+        now = time.monotonic()
+
+        def free(e: Engine) -> bool:
+            return e.held_until <= now
+
+        pick = None
+        if job_id:
+            pick = next((e for e in self.idle if e.job_id == job_id), None)
+        if pick is None and game_key:
+            pick = next((e for e in self.idle if e.game_key == game_key and free(e)), None)
+        if pick is None:
+            pick = next((e for e in self.idle if free(e)), None)
+        if pick is None and self.idle:
+            # Every idle engine is held: take the one whose hold ends first.
+            pick = min(self.idle, key=lambda e: e.held_until)
+        if pick is not None:
+            self.idle.remove(pick)
+            pick.lingering = False
+        else:
+            pick = await self._spawn()
+        self.busy += 1
+        if self.allocator is not None and pick.slot is not None:
+            self.allocator.busy[pick.slot] = True
+        return pick
+
+    async def release(self, eng: Engine, reusable: bool, job_id: str = "") -> None:
+        self.busy -= 1
+        if self.allocator is not None and eng.slot is not None:
+            self.allocator.busy[eng.slot] = False
+        if not reusable or not eng.alive():
+            await self._close(eng)
+            return
+        eng.job_id = job_id
+        eng.held_until = time.monotonic() + self.grace_s if job_id else 0.0
+        if len(self.idle) + self.busy < self.size:
+            self.idle.append(eng)
+        elif self.grace_s > 0 and job_id:
+            eng.lingering = True
+            self.idle.append(eng)
+            task = asyncio.create_task(self._expire(eng))
+            self._expiry_tasks.add(task)
+            task.add_done_callback(self._expiry_tasks.discard)
+        else:
+            await self._close(eng)
+
+    async def _expire(self, eng: Engine) -> None:
+        """Close a lingering engine once its hold is over (unless taken again)."""
+        while True:
+            delay = eng.held_until - time.monotonic()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            if not eng.lingering or eng not in self.idle:
+                return
+            if eng.held_until <= time.monotonic():
+                self.idle.remove(eng)
+                await self._close(eng)
+                return
+
+    async def close(self) -> None:
+        for task in list(self._expiry_tasks):
+            task.cancel()
+        idle, self.idle = self.idle, []
+        await asyncio.gather(*(self._close(e) for e in idle), return_exceptions=True)
+
+    def occupancy(self) -> Dict[str, int]:
+        return {"pool_size": self.size, "pool_idle": len(self.idle), "pool_busy": self.busy}
+
+    def cpu_allocation(self) -> Dict[str, int]:
+        """server_status fields describing the CPU slots; empty when not pinning."""
+        return self.allocator.status() if self.allocator is not None else {}
 
 
 @dataclass
@@ -315,60 +1290,55 @@ class EngineJobRunner:
     server: "ClusterServer"
     job: PendingJob
     cancel_event: asyncio.Event = field(default_factory=asyncio.Event)
-    proc: Optional[asyncio.subprocess.Process] = None
 
     def request_cancel(self) -> None:
         self.cancel_event.set()
 
-    async def run(self) -> Tuple[int, Dict[str, JsonVal]]:
+    async def run(self) -> Tuple[int, Dict[str, JsonVal], bool]:
         """
-        Run stockfish and stream updates.
-        Returns (final_status, last_fields)
+        Run the job on a pooled engine and stream updates.
+        Returns (final_status, last_fields, has_result); has_result is False
+        when an extension ended below its earlier depth and kept that result,
+        which then does not stand for the new limit.
         """
         last_by_mpv: Dict[int, Dict[str, JsonVal]] = {}
         job_id = self.job.job_id
+        pool = self.server.engine_pool
+        eng: Optional[Engine] = None
+        # Only an engine that answered bestmove is in a known state.
+        reusable = False
 
+        extending = bool(self.job.reported_depth)
         try:
-            self.proc = await asyncio.create_subprocess_exec(
-                self.server.stockfish_path,
-                stdin=asyncio.subprocess.PIPE,
-                stdout=asyncio.subprocess.PIPE,
-                stderr=asyncio.subprocess.STDOUT,
-            )
-            assert self.proc.stdin and self.proc.stdout
-
-            async def send(cmd: str) -> None:
-                self.proc.stdin.write((cmd + "\n").encode("utf-8"))
-                await self.proc.stdin.drain()
-
-            # UCI init
-            await send("uci")
-            while True:
-                line = await self.proc.stdout.readline()
-                if not line:
-                    raise RuntimeError("Engine closed stdout during UCI init")
-                if line.decode("utf-8", errors="ignore").strip() == "uciok":
-                    break
-
-            if self.server.threads > 0:
-                await send(f"setoption name Threads value {self.server.threads}")
+            eng = await pool.acquire(self.job.opponent, job_id)
+            await self.server.send_server_status()  # pool occupancy changed
+            # The engine still holds this job's search in its TT.
+            warm = extending and eng.job_id == job_id
+            if extending:
+                if warm:
+                    self.server.metrics.jobs_extended_warm += 1
+                await self.server.send_job_update(
+                    job_id, JOB_RUNNING, {},
+                    log_line="extend: continuing on the warm engine" if warm
+                    else "extend: its engine is gone, searching from scratch")
 
             # MultiPV: number of principal variations requested
             mpv = int(self.job.multipv or 1)
             if mpv < 1:
                 mpv = 1
-            await send(f"setoption name MultiPV value {mpv}")
+            if eng.multipv != mpv:
+                await eng.send(f"setoption name MultiPV value {mpv}")
+                eng.multipv = mpv
 
-            await send("isready")
-            while True:
-                line = await self.proc.stdout.readline()
-                if not line:
-                    raise RuntimeError("Engine closed stdout during isready")
-                if line.decode("utf-8", errors="ignore").strip() == "readyok":
-                    break
+            # Same game line: keep the TT, its entries are still useful.
+            if not warm and (not self.job.opponent or eng.game_key != self.job.opponent):
+                await eng.send("ucinewgame")
+            eng.game_key = self.job.opponent
 
-            await send("ucinewgame")
-            await send(f"position fen {self.job.fen}")
+            await eng.send("isready")
+            await eng.wait_for("readyok")
+
+            await eng.send(f"position fen {self.job.fen}")
 
             if self.job.limit_type == 0:
                 go_cmd = f"go depth {self.job.limit_value}"
@@ -378,18 +1348,18 @@ class EngineJobRunner:
                 go_cmd = f"go nodes {self.job.limit_value}"
             else:
                 go_cmd = "go depth 20"
-            await send(go_cmd)
+            if self.job.searchmoves:
+                go_cmd += " searchmoves " + " ".join(self.job.searchmoves)
+            await eng.send(go_cmd)
 
             # Stream output
+            stop_sent = False
             while True:
-                if self.cancel_event.is_set():
-                    await send("stop")
+                if self.cancel_event.is_set() and not stop_sent:
+                    await eng.send("stop")
+                    stop_sent = True
                     # We will likely still read a final bestmove; treat as cancelled.
-                line = await self.proc.stdout.readline()
-                if not line:
-                    raise RuntimeError("Engine terminated unexpectedly")
-
-                s = line.decode("utf-8", errors="ignore").strip()
+                s = await eng.readline()
                 if not s:
                     continue
 
@@ -400,10 +1370,14 @@ class EngineJobRunner:
                     cur.update(parsed)
                     cur["multipv"] = mpv
                     last_by_mpv[mpv] = cur
+                    # An extended job re-walks the depths it already has.
+                    if int(cur.get("depth", 0) or 0) < self.job.reported_depth.get(mpv, 0):
+                        continue
                     await self.server.send_job_update(
                         job_id, JOB_RUNNING, cur, log_line=s
                     )
                 elif s.startswith("bestmove"):
+                    reusable = True
                     bm = parse_bestmove_line(s)
                     final_status = JOB_CANCELLED if self.cancel_event.is_set() else JOB_FINISHED
 
@@ -411,28 +1385,25 @@ class EngineJobRunner:
                     fields = dict(last_by_mpv.get(1, {}))
                     fields.update(bm)
                     fields["multipv"] = 1
+                    has_result = True
+                    if int(fields.get("depth", 0) or 0) < self.job.reported_depth.get(1, 0):
+                        # Stopped before passing the earlier result: keep that one.
+                        fields = {"multipv": 1}
+                        has_result = False
 
                     await self.server.send_job_update(
                         job_id, final_status, fields, log_line=s
                     )
-                    return final_status, fields
+                    return final_status, fields, has_result
 
         except Exception as exc:
             await self.server.send_job_update(
                 job_id, JOB_ERROR, {}, log_line=f"[job {job_id}] Error: {exc}"
             )
-            return JOB_ERROR, {}
+            return JOB_ERROR, {}, False
         finally:
-            if self.proc is not None:
-                try:
-                    if self.proc.returncode is None:
-                        self.proc.kill()
-                except ProcessLookupError:
-                    pass
-                try:
-                    await self.proc.wait()
-                except Exception:
-                    pass
+            if eng is not None:
+                await pool.release(eng, reusable, job_id)
 
 
 class ClusterServer:
@@ -447,6 +1418,14 @@ class ClusterServer:
         db_path: Optional[str] = None,
         db_load_limit: int = 500,
         ssl_ctx: Optional[ssl.SSLContext] = None,
+        batch_ms: int = 100,
+        db_flush_ms: int = 500,
+        hash_mb: int = 0,
+        pool_size: Optional[int] = None,
+        metrics_host: str = "127.0.0.1",
+        metrics_port: int = 0,
+        pin_cores: bool = False,
+        extend_grace_s: float = 120.0,
     ) -> None:
         self.host = host
         self.port = port
@@ -454,8 +1433,36 @@ class ClusterServer:
         self.stockfish_path = stockfish_path
         self.threads = threads
         self.max_jobs = max_jobs
+        self.batch_ms = max(0, int(batch_ms))
+        self.db_flush_ms = max(0, int(db_flush_ms))
+
+        allocator: Optional[CoreAllocator] = None
+        if pin_cores and max_jobs > 0:
+            allocator = CoreAllocator(host_cpu_topology(), max_jobs)
+            for i, (node, cpus) in enumerate(allocator.sets):
+                print(f"[server] Job slot {i}: node {node}, {len(cpus)} CPU(s) {cpus[0]}..{cpus[-1]}")
+            # Report what a job actually gets.
+            self.threads = max(len(cpus) for _, cpus in allocator.sets)
+        elif pin_cores:
+            print("[server] --pin-cores needs --max-jobs > 0; engines are not pinned")
+
+        # One warm engine per job slot unless told otherwise.
+        self.engine_pool = EnginePool(
+            stockfish_path,
+            threads,
+            int(hash_mb),
+            max(1, max_jobs) if pool_size is None else int(pool_size),
+            allocator,
+            extend_grace_s,
+        )
 
-        self.store: Optional[JobStore] = None
+        self.store: Optional[JobStore] = None  # reads on the event loop
+        self.db_writer: Optional[JobStoreWriter] = None
+        # Job records stay in memory; the ones changed since the last flush
+        # go to the writer thread every db_flush_ms (terminal updates at once),
+        # which commits them in one transaction.
+        self._db_dirty: Dict[str, JobRecord] = {}
+        self._db_logs: List[Tuple[str, int, str]] = []
         if db_path:
             self.store = JobStore(db_path)
             # After restart, unfinished jobs are lost (engine procs are gone).
@@ -472,6 +1479,7 @@ class ClusterServer:
         self.ssl_ctx = ssl_ctx
 
         self.clients: Set[asyncio.StreamWriter] = set()
+        self.sessions: Dict[asyncio.StreamWriter, ClientSession] = {}
 
         self.active_jobs: Dict[str, EngineJobRunner] = {}
         self.pending: Deque[PendingJob] = deque()
@@ -482,6 +1490,10 @@ class ClusterServer:
 
         self._server: Optional[asyncio.AbstractServer] = None
 
+        self.metrics = ServerMetrics()
+        self.metrics_host = metrics_host
+        self.metrics_port = int(metrics_port)
+
         # Load last N jobs from DB so jobs_list works even after server restart.
         if self.store is not None:
             try:
@@ -491,9 +1503,11 @@ class ClusterServer:
                     # Load a bounded log tail.
                     tail = self.store.fetch_log_tail(rec.job_id, limit=2000)
                     rec.log = deque(tail, maxlen=2000)
+                    rec.log_total = max(len(tail), self.store.count_log(rec.job_id))
                     self.job_records[rec.job_id] = rec
             except Exception as exc:
                 print(f"[server] Failed to load DB history: {exc}")
+            self.db_writer = JobStoreWriter(db_path, self.db_flush_ms)
 
     def _row_to_record(self, row: sqlite3.Row) -> JobRecord:
         rec = JobRecord(job_id=str(row["id"]))
@@ -516,12 +1530,93 @@ class ClusterServer:
 
     # --- wire helpers --------------------------------------------------------
 
+    def _session(self, w: asyncio.StreamWriter) -> ClientSession:
+        s = self.sessions.get(w)
+        if s is None:
+            s = ClientSession()
+            self.sessions[w] = s
+        return s
+
+    def _drop_client(self, w: asyncio.StreamWriter) -> None:
+        self.clients.discard(w)
+        s = self.sessions.pop(w, None)
+        if s is not None and s.flush_handle is not None:
+            s.flush_handle.cancel()
+
+    @staticmethod
+    def _encode(obj: dict, binary: bool) -> bytes:
+        if binary:
+            return encode_frame(FRAME_MESSAGE, cbor_dumps(obj))
+        return json.dumps(obj, separators=(",", ":")).encode("utf-8") + b"\n"
+
+    def _take_batch(self, session: ClientSession) -> Optional[bytes]:
+        """Encode and clear the session's merged job updates, if any."""
+        if session.flush_handle is not None:
+            session.flush_handle.cancel()
+            session.flush_handle = None
+        updates = session.take_batch()
+        if not updates:
+            return None
+        session.next_send = time.monotonic() + self.batch_ms / 1000.0
+        if session.binary:
+            return session.compact_job_update_batch(updates)
+        return self._encode({"type": "job_update_batch", "server_id": self.server_id, "updates": updates}, False)
+
+    def _schedule_flush(self, w: asyncio.StreamWriter, session: ClientSession) -> None:
+        if session.flush_handle is not None:
+            return
+        delay = max(0.0, session.next_send - time.monotonic())
+        session.flush_handle = asyncio.get_running_loop().call_later(
+            delay, lambda: asyncio.ensure_future(self._flush_session(w))
+        )
+
+    async def _flush_session(self, w: asyncio.StreamWriter) -> None:
+        session = self.sessions.get(w)
+        if session is None:
+            return
+        session.flush_handle = None
+        data = self._take_batch(session)
+        if data is not None:
+            await self._write(w, data)
+
+    async def _write(self, w: asyncio.StreamWriter, data: bytes) -> None:
+        self.metrics.bytes_sent += len(data)
+        self.metrics.writes += 1
+        try:
+            w.write(data)
+            await w.drain()
+        except Exception:
+            try:
+                w.close()
+            except Exception:
+                pass
+            self._drop_client(w)
+
     async def _broadcast(self, obj: dict) -> None:
         if not self.clients:
             return
-        data = json.dumps(obj, separators=(",", ":")).encode("utf-8") + b"\n"
+        # Encode once per wire format; job_update deltas are per client.
+        cache: Dict[bool, bytes] = {}
+        is_job_update = obj.get("type") == "job_update"
+        terminal = is_job_update and int(obj.get("status", JOB_RUNNING)) in TERMINAL_STATUSES
         dead: Set[asyncio.StreamWriter] = set()
-        for w in self.clients:
+        for w in list(self.clients):
+            session = self._session(w)
+            if is_job_update and session.batching and self.batch_ms > 0:
+                session.queue_job_update(obj)
+                if not terminal:
+                    self._schedule_flush(w, session)
+                    continue
+                data = self._take_batch(session)
+            elif is_job_update and session.binary:
+                data = session.compact_job_update(obj)
+            else:
+                data = cache.get(session.binary)
+                if data is None:
+                    data = self._encode(obj, session.binary)
+                    cache[session.binary] = data
+            self.metrics.bytes_sent += len(data)
+            self.metrics.writes += 1
             try:
                 w.write(data)
                 await w.drain()
@@ -532,19 +1627,41 @@ class ClusterServer:
                 w.close()
             except Exception:
                 pass
-            self.clients.discard(w)
+            self._drop_client(w)
 
     async def _send_one(self, w: asyncio.StreamWriter, obj: dict) -> None:
-        data = json.dumps(obj, separators=(",", ":")).encode("utf-8") + b"\n"
-        try:
-            w.write(data)
-            await w.drain()
-        except Exception:
-            try:
-                w.close()
-            except Exception:
-                pass
-            self.clients.discard(w)
+        session = self._session(w)
+        # Send merged updates first so they do not land on top of a newer
+        # jobs_list / job_state (log lines would be duplicated).
+        data = self._take_batch(session) or b""
+        await self._write(w, data + self._encode(obj, session.binary))
+
+    # --- persistence ---------------------------------------------------------
+
+    def _queue_db_write(self, rec: JobRecord, ts: int, log_line: Optional[str]) -> None:
+        """The DB gets this with the next flush; never read it back over rec."""
+        self._db_dirty[rec.job_id] = rec
+        if log_line:
+            self._db_logs.append((rec.job_id, int(ts), log_line))
+
+    def _flush_db(self, urgent: bool = False, cached: Optional[List[tuple]] = None) -> None:
+        """Hand the changes since the last flush to the writer thread."""
+        if self.db_writer is None:
+            return
+        batch = WriteBatch(
+            jobs={job_id: JobStore.job_row(rec) for job_id, rec in self._db_dirty.items()},
+            logs=self._db_logs,
+            cached=cached or [],
+            urgent=urgent,
+        )
+        self._db_dirty = {}
+        self._db_logs = []
+        self.db_writer.submit(batch)
+
+    async def _db_flush_loop(self) -> None:
+        while True:
+            await asyncio.sleep(self.db_flush_ms / 1000.0)
+            self._flush_db()
 
     async def send_server_status(self) -> None:
         async with self._lock:
@@ -563,6 +1680,8 @@ class ClusterServer:
                 "max_jobs": max_jobs,
                 "threads": int(self.threads),
                 "logical_cores": int(os.cpu_count() or 0),
+                **self.engine_pool.occupancy(),
+                **self.engine_pool.cpu_allocation(),
             }
 
         await self._broadcast(msg)
@@ -576,20 +1695,19 @@ class ClusterServer:
     ) -> None:
         # Update persistent job record first (even if nobody is connected).
         ts = epoch_ms()
-        rec_for_db: Optional[JobRecord] = None
-        log_for_db: Optional[str] = None
         async with self._lock:
             rec = self.job_records.get(job_id)
             if rec is None:
                 rec = JobRecord(job_id=job_id)
                 self.job_records[job_id] = rec
 
+            self.metrics.job_update(job_id, int(status), fields, rec.status in TERMINAL_STATUSES)
             rec.status = int(status)
             rec.last_update_ms = ts
 
             if status == JOB_RUNNING and rec.started_at_ms is None:
                 rec.started_at_ms = ts
-            if status in (JOB_FINISHED, JOB_ERROR, JOB_CANCELLED, JOB_STOPPED) and rec.finished_at_ms is None:
+            if status in TERMINAL_STATUSES and rec.finished_at_ms is None:
                 rec.finished_at_ms = ts
 
             mpv = int(fields.get("multipv", 1) or 1) if fields else 1
@@ -605,19 +1723,12 @@ class ClusterServer:
             if log_line is not None:
                 rec.append_log(str(log_line))
 
-            # Persist outside the lock.
             if self.store is not None:
-                rec_for_db = rec
-                log_for_db = str(log_line) if log_line is not None else None
+                self._queue_db_write(rec, ts, str(log_line) if log_line is not None else None)
 
-        if self.store is not None and rec_for_db is not None:
-            try:
-                self.store.upsert_job(rec_for_db)
-                if log_for_db:
-                    self.store.append_log(job_id, ts, log_for_db)
-            except Exception as exc:
-                # Don't crash the server because DB is unavailable.
-                print(f"[server] DB write failed for {job_id}: {exc}")
+        # Results must survive a crash; everything else waits for the next flush.
+        if status in TERMINAL_STATUSES or self.db_flush_ms == 0:
+            self._flush_db(urgent=status in TERMINAL_STATUSES)
 
         msg: Dict[str, JsonVal] = {"type": "job_update", "job_id": job_id, "status": int(status)}
         for key in ("multipv", "depth", "seldepth", "score_cp", "score_mate", "nodes", "nps", "bestmove", "pv"):
@@ -627,7 +1738,15 @@ class ClusterServer:
             msg["log_line"] = log_line
         await self._broadcast(msg)
 
-    def _record_to_dict(self, rec: JobRecord, log_tail: int = 200) -> dict:
+    def _record_to_dict(self, rec: JobRecord, log_tail: int = 200,
+                        fields: Optional[Set[str]] = None,
+                        log_lines: Optional[List[str]] = None) -> dict:
+        """fields: keys to keep (None = all); log_tail 0 leaves out "log_tail";
+        log_lines replaces rec.log as the source of the tail."""
+        if fields is not None and "snapshot" not in fields:
+            out = self._record_summary(rec)
+            return {k: v for k, v in out.items() if k in fields}
+
         # lines = all multipv lines we have, sorted by multipv.
         lines = []
         # Keys may be ints (runtime) or strings (restored from JSON).
@@ -653,6 +1772,16 @@ class ClusterServer:
         if lines:
             snap["lines"] = lines
 
+        out = self._record_summary(rec)
+        out["snapshot"] = snap
+        if log_tail > 0:
+            out["log_tail"] = list(rec.log if log_lines is None else log_lines)[-log_tail:]
+        if fields is not None:
+            out = {k: v for k, v in out.items() if k in fields}
+        return out
+
+    @staticmethod
+    def _record_summary(rec: JobRecord) -> dict:
         return {
             "id": rec.job_id,
             "opponent": rec.opponent,
@@ -660,15 +1789,35 @@ class ClusterServer:
             "limit_type": int(rec.limit_type),
             "limit_value": int(rec.limit_value),
             "multipv": int(rec.multipv),
+            **({"searchmoves": list(rec.searchmoves)} if rec.searchmoves else {}),
             "status": int(rec.status),
             "created_at_ms": int(rec.created_at_ms),
             "started_at_ms": int(rec.started_at_ms) if rec.started_at_ms is not None else None,
             "finished_at_ms": int(rec.finished_at_ms) if rec.finished_at_ms is not None else None,
             "last_update_ms": int(rec.last_update_ms),
-            "snapshot": snap,
-            "log_tail": list(rec.log)[-log_tail:],
         }
 
+    @staticmethod
+    def _pending_job_from_obj(job_obj: Any) -> Optional[PendingJob]:
+        """Validate one submitted job object; None if it must be ignored."""
+        if not isinstance(job_obj, dict):
+            return None
+        job_id = str(job_obj.get("id", ""))
+        opponent = str(job_obj.get("opponent", ""))
+        fen = str(job_obj.get("fen", ""))
+        if not job_id or not fen:
+            return None
+        try:
+            limit_type = int(job_obj.get("limit_type", 0))
+            limit_value = int(job_obj.get("limit_value", 30))
+            multipv = int(job_obj.get("multipv", 1) or 1)
+        except (TypeError, ValueError):
+            return None
+        searchmoves = [str(m) for m in (job_obj.get("searchmoves") or [])]
+        if not all(UCI_MOVE_RE.match(m) for m in searchmoves):
+            return None
+        return PendingJob(job_id, opponent, fen, limit_type, limit_value, multipv, searchmoves)
+
     # --- scheduling ----------------------------------------------------------
 
     async def _try_start_next(self) -> None:
@@ -690,7 +1839,13 @@ class ClusterServer:
         job_id = runner.job.job_id
         await self.send_job_update(job_id, JOB_RUNNING, {}, log_line="started")
         try:
-            await runner.run()
+            status, _, has_result = await runner.run()
+            # An extension that kept its earlier result leaves the cache row
+            # of the earlier limit in place.
+            if status == JOB_FINISHED and has_result and self.db_writer is not None:
+                rec = self.job_records.get(job_id)
+                if rec is not None:
+                    self._flush_db(urgent=True, cached=[JobStore.cache_row(rec)])
         finally:
             async with self._lock:
                 self.active_jobs.pop(job_id, None)
@@ -711,6 +1866,8 @@ class ClusterServer:
             if job.job_id in self.active_jobs or any(j.job_id == job.job_id for j in self.pending):
                 return
 
+            self.metrics.jobs_submitted += 1
+
             # Create initial record (so clients can list it even while queued).
             rec = JobRecord(
                 job_id=job.job_id,
@@ -719,36 +1876,133 @@ class ClusterServer:
                 limit_type=int(job.limit_type),
                 limit_value=int(job.limit_value),
                 multipv=int(job.multipv or 1),
+                searchmoves=list(job.searchmoves),
             )
             self.job_records[job.job_id] = rec
 
             if self.store is not None:
                 rec_for_db = rec
 
-            if self.max_jobs > 0 and len(self.active_jobs) >= self.max_jobs:
-                self.pending.append(job)
-                queued = True
-            else:
-                queued = False
-                runner = EngineJobRunner(server=self, job=job)
-                self.active_jobs[job.job_id] = runner
-                asyncio.create_task(self._run_job(runner))
+            cached = self._find_cached(job)
+            queued = cached is None and self._start_or_queue(job)
+
+        if cached is not None:
+            await self._finish_from_cache(job, cached)
+            return
 
         if queued:
             await self.send_job_update(job.job_id, JOB_QUEUED, {}, log_line="queued")
         await self.send_server_status()
 
         if self.store is not None and rec_for_db is not None:
-            try:
-                self.store.upsert_job(rec_for_db)
-                self.store.append_log(job.job_id, epoch_ms(), "submitted")
-            except Exception as exc:
-                print(f"[server] DB write failed for {job.job_id}: {exc}")
+            # Through the ring too, so it holds exactly the newest DB lines.
+            async with self._lock:
+                rec_for_db.append_log("submitted")
+            self._queue_db_write(rec_for_db, epoch_ms(), "submitted")
+            if self.db_flush_ms == 0:
+                self._flush_db()
 
         if queued:
             # In case capacity is unlimited or became free.
             await self._try_start_next()
 
+    def _find_cached(self, job: PendingJob) -> Optional[sqlite3.Row]:
+        if self.store is None:
+            return None
+        try:
+            return self.store.find_cached(job)
+        except Exception as exc:
+            print(f"[server] Cache lookup failed for {job.job_id}: {exc}")
+            return None
+
+    def _start_or_queue(self, job: PendingJob) -> bool:
+        """Run job now if a slot is free, else queue it; True if queued. Holds _lock."""
+        if self.max_jobs > 0 and len(self.active_jobs) >= self.max_jobs:
+            self.pending.append(job)
+            return True
+        runner = EngineJobRunner(server=self, job=job)
+        self.active_jobs[job.job_id] = runner
+        asyncio.create_task(self._run_job(runner))
+        return False
+
+    async def extend_job(self, job: PendingJob) -> None:
+        """Search a finished job again under its id with job's higher limit."""
+        reject: Optional[str] = None
+        async with self._lock:
+            rec = self.job_records.get(job.job_id)
+            if rec is None:
+                known = False
+            else:
+                known = True
+                if job.job_id in self.active_jobs or any(j.job_id == job.job_id for j in self.pending):
+                    reject = "job is still running"
+                elif rec.status not in EXTENDABLE_STATUSES:
+                    reject = "job has no result to extend"
+                elif int(job.limit_type) != rec.limit_type or int(job.limit_value) <= rec.limit_value:
+                    reject = "needs a higher limit of the same type"
+            if known and reject is None:
+                self.metrics.jobs_extended += 1
+                previous = rec.limit_value
+                rec.limit_value = int(job.limit_value)
+                rec.finished_at_ms = None
+                rec.last_update_ms = epoch_ms()  # jobs_list "since" sees the new limit
+                # The record is authoritative for what is being searched.
+                job = PendingJob(rec.job_id, rec.opponent, rec.fen, rec.limit_type, rec.limit_value,
+                                 rec.multipv, list(rec.searchmoves))
+                for key, line in rec.last_by_mpv.items():
+                    try:
+                        job.reported_depth[int(key)] = int(line.get("depth", 0) or 0)
+                    except (TypeError, ValueError, AttributeError):
+                        continue
+                cached = self._find_cached(job)
+                queued = cached is None and self._start_or_queue(job)
+
+        if not known:
+            # Restarted or evicted: all the client has to go on is the request.
+            await self.submit_job(job)
+            return
+        if reject is not None:
+            await self.send_job_update(job.job_id, rec.status, {}, log_line=f"extend rejected: {reject}")
+            return
+
+        note = f"extend: limit {previous} -> {job.limit_value}"
+        if cached is not None:
+            await self.send_job_update(job.job_id, JOB_RUNNING, {}, log_line=note)
+            await self._finish_from_cache(job, cached)
+            return
+        if queued:
+            await self.send_job_update(job.job_id, JOB_QUEUED, {}, log_line=note + " (queued)")
+        else:
+            await self.send_job_update(job.job_id, JOB_RUNNING, {}, log_line=note)
+        await self.send_server_status()
+        if queued:
+            await self._try_start_next()
+
+    async def _finish_from_cache(self, job: PendingJob, cached: sqlite3.Row) -> None:
+        """Answer a job with a cached result instead of searching again."""
+        try:
+            by_mpv = json.loads(cached["last_by_mpv_json"] or "{}")
+        except Exception:
+            by_mpv = {}
+        wanted = int(job.multipv or 1)
+        lines = sorted(
+            (int(k), dict(v)) for k, v in by_mpv.items() if str(k).isdigit() and int(k) <= wanted
+        )
+        for mpv, fields in lines:
+            if mpv != 1:
+                fields["multipv"] = mpv
+                await self.send_job_update(job.job_id, JOB_RUNNING, fields)
+        top = dict(next((f for mpv, f in lines if mpv == 1), {}))
+        top["multipv"] = 1
+        if cached["bestmove"]:
+            top["bestmove"] = str(cached["bestmove"])
+        await self.send_job_update(
+            job.job_id,
+            JOB_FINISHED,
+            top,
+            log_line=f"cache hit: {cached['job_id']} ({int(cached['limit_value'])})",
+        )
+
     async def cancel_job(self, job_id: str) -> None:
         async with self._lock:
             runner = self.active_jobs.get(job_id)
@@ -772,24 +2026,64 @@ class ClusterServer:
 
     async def handle_message(self, obj: dict, writer: asyncio.StreamWriter) -> None:
         msg_type = obj.get("type")
+        if msg_type == "hello":
+            offered = obj.get("protocols") or []
+            proto = PROTO_CBOR if PROTO_CBOR in offered else PROTO_JSON
+            # The answer still goes out in the old encoding; frames follow it.
+            await self._send_one(writer, {"type": "hello", "server_id": self.server_id, "protocol": proto,
+                                          "features": SERVER_FEATURES})
+            session = self._session(writer)
+            session.binary = proto == PROTO_CBOR
+            session.batching = FEATURE_JOB_UPDATE_BATCH in (obj.get("features") or [])
+            return
+
         if msg_type == "ping":
+            # seq-carrying pings get a direct answer the client can time;
+            # server_status is broadcast and so useless for that.
+            seq = obj.get("seq")
+            if isinstance(seq, int) and not isinstance(seq, bool):
+                await self._send_one(writer, {"type": "pong", "seq": seq, "server_time_ms": epoch_ms()})
             await self.send_server_status()
             return
 
         if msg_type == "jobs_list":
             include_finished = bool(obj.get("include_finished", True))
-            limit = int(obj.get("limit", 200) or 200)
+            limit = max(1, min(int(obj.get("limit", 200) or 200), JOBS_LIST_MAX_LIMIT))
+            log_tail = max(0, min(int(obj.get("log_tail", 0) or 0), 20000))
+            fields_val = obj.get("fields")
+            fields = {str(f) for f in fields_val} | {"id"} if isinstance(fields_val, list) else None
+            since_val = obj.get("since")
+            since = int(since_val) if isinstance(since_val, int) and not isinstance(since_val, bool) else None
+            # Keyset cursor: "<created_at_ms>:<job_id>" of the last job sent.
+            after: Optional[Tuple[int, str]] = None
+            cursor = obj.get("cursor")
+            if isinstance(cursor, str) and ":" in cursor:
+                ms, _, cid = cursor.partition(":")
+                try:
+                    after = (int(ms), cid)
+                except ValueError:
+                    after = None
             async with self._lock:
+                now_ms = epoch_ms()
                 recs = list(self.job_records.values())
                 if not include_finished:
-                    recs = [r for r in recs if int(r.status) not in (JOB_FINISHED, JOB_ERROR, JOB_CANCELLED, JOB_STOPPED)]
-                recs.sort(key=lambda r: int(r.created_at_ms), reverse=True)
-                recs = recs[: max(0, limit)]
+                    recs = [r for r in recs if int(r.status) not in TERMINAL_STATUSES]
+                if since is not None:
+                    recs = [r for r in recs if int(r.last_update_ms) >= since]
+                if after is not None:
+                    recs = [r for r in recs if (int(r.created_at_ms), r.job_id) < after]
+                recs.sort(key=lambda r: (int(r.created_at_ms), r.job_id), reverse=True)
+                more = len(recs) > limit
+                recs = recs[:limit]
                 msg = {
                     "type": "jobs_list",
                     "server_id": self.server_id,
-                    "jobs": [self._record_to_dict(r) for r in recs],
+                    "jobs": [self._record_to_dict(r, log_tail=log_tail, fields=fields) for r in recs],
+                    "server_time_ms": now_ms,
                 }
+                if more:
+                    last = recs[-1]
+                    msg["next_cursor"] = f"{int(last.created_at_ms)}:{last.job_id}"
             await self._send_one(writer, msg)
             return
 
@@ -801,32 +2095,46 @@ class ClusterServer:
             log_tail = max(0, min(log_tail, 20000))
             async with self._lock:
                 rec = self.job_records.get(job_id)
-                # If DB is enabled, load a fresh tail for this job on demand.
-                if self.store is not None and rec is not None and log_tail > 0:
-                    try:
-                        tail = self.store.fetch_log_tail(job_id, limit=log_tail)
-                        rec.log = deque(tail, maxlen=max(2000, log_tail))
-                    except Exception:
-                        pass
+                lines: Optional[List[str]] = None
+                # The ring has the newest lines (the DB trails it by up to a
+                # flush); only lines it has already dropped come from the DB.
+                if self.store is not None and rec is not None and len(rec.log) < log_tail:
+                    older = rec.log_total - len(rec.log)
+                    if older > 0:
+                        want = min(older, log_tail - len(rec.log))
+                        try:
+                            lines = self.store.fetch_log_range(job_id, older - want, want) + list(rec.log)
+                        except Exception:
+                            lines = None
                 msg = {
                     "type": "job_state",
                     "server_id": self.server_id,
-                    "job": self._record_to_dict(rec, log_tail=log_tail) if rec else None,
+                    "job": self._record_to_dict(rec, log_tail=log_tail, log_lines=lines) if rec else None,
                 }
             await self._send_one(writer, msg)
             return
 
         if msg_type == "job_submit_or_update":
-            job_obj = obj.get("job") or {}
-            job_id = str(job_obj.get("id", ""))
-            opponent = str(job_obj.get("opponent", ""))
-            fen = str(job_obj.get("fen", ""))
-            if not job_id or not fen:
+            job = self._pending_job_from_obj(obj.get("job") or {})
+            if job is not None:
+                await self.submit_job(job)
+            return
+
+        if msg_type == "jobs_submit_batch":
+            jobs = obj.get("jobs")
+            if not isinstance(jobs, list):
                 return
-            limit_type = int(job_obj.get("limit_type", 0))
-            limit_value = int(job_obj.get("limit_value", 30))
-            multipv = int(job_obj.get("multipv", 1) or 1)
-            await self.submit_job(PendingJob(job_id, opponent, fen, limit_type, limit_value, multipv))
+            # Same as that many job_submit_or_update messages, in order.
+            for job_obj in jobs[:SUBMIT_BATCH_MAX_JOBS]:
+                job = self._pending_job_from_obj(job_obj)
+                if job is not None:
+                    await self.submit_job(job)
+            return
+
+        if msg_type == "job_extend":
+            job = self._pending_job_from_obj(obj.get("job") or {})
+            if job is not None:
+                await self.extend_job(job)
             return
 
         if msg_type == "job_cancel":
@@ -841,21 +2149,22 @@ class ClusterServer:
         addr = writer.get_extra_info("peername")
         print(f"[server] Client connected: {addr}")
         self.clients.add(writer)
+        self.sessions[writer] = ClientSession()
+        self.metrics.connections += 1
         await self.send_server_status()
 
         try:
             while True:
-                line = await reader.readline()
-                if not line:
-                    break
-                line = line.strip()
-                if not line:
-                    continue
                 try:
-                    obj = json.loads(line.decode("utf-8", errors="ignore"))
-                except json.JSONDecodeError:
-                    continue
-                await self.handle_message(obj, writer)
+                    obj = await read_message(reader, self.metrics)
+                except (asyncio.IncompleteReadError, ValueError):
+                    break
+                if obj is None:
+                    break
+                if obj:
+                    started = time.perf_counter()
+                    await self.handle_message(obj, writer)
+                    self.metrics.message_handled(obj.get("type"), time.perf_counter() - started)
         finally:
             print(f"[server] Client disconnected: {addr}")
             try:
@@ -863,15 +2172,117 @@ class ClusterServer:
                 await writer.wait_closed()
             except Exception:
                 pass
-            self.clients.discard(writer)
+            self._drop_client(writer)
+
+    # --- metrics -------------------------------------------------------------
+
+    def metrics_text(self) -> str:
+        """Prometheus text exposition format (version 0.0.4)."""
+        m = self.metrics
+        sid = self.server_id.replace("\\", "\\\\").replace('"', '\\"')
+        out: List[str] = []
+
+        def metric(name: str, kind: str, help_text: str, samples: List[Tuple[str, float]]) -> None:
+            out.append(f"# HELP corrchess_{name} {help_text}")
+            out.append(f"# TYPE corrchess_{name} {kind}")
+            for labels, value in samples:
+                extra = f",{labels}" if labels else ""
+                out.append(f'corrchess_{name}{{server_id="{sid}"{extra}}} {value}')
+
+        status_names = {JOB_FINISHED: "finished", JOB_ERROR: "error",
+                        JOB_CANCELLED: "cancelled", JOB_STOPPED: "stopped"}
+        pool = self.engine_pool.occupancy()
+
+        metric("uptime_seconds", "gauge", "Seconds since the server started.",
+               [("", round(time.monotonic() - m.started, 3))])
+        metric("clients", "gauge", "Connected clients.", [("", len(self.clients))])
+        metric("connections_total", "counter", "Client connections accepted.", [("", m.connections)])
+        metric("messages_received_total", "counter", "Client messages handled, by type.",
+               [(f'type="{t}"', n) for t, n in sorted(m.messages_received.items())])
+        metric("message_handle_seconds_total", "counter",
+               "Time spent handling client messages (including sending replies), by type.",
+               [(f'type="{t}"', round(s, 6)) for t, s in sorted(m.handle_seconds.items())])
+        metric("bytes_received_total", "counter", "Bytes read from clients.", [("", m.bytes_received)])
+        metric("bytes_sent_total", "counter", "Bytes written to clients.", [("", m.bytes_sent)])
+        metric("writes_total", "counter", "Socket writes (messages, frames or batches).", [("", m.writes)])
+        metric("job_updates_total", "counter", "Engine updates recorded for jobs.", [("", m.job_updates)])
+        metric("jobs_submitted_total", "counter", "New jobs accepted.", [("", m.jobs_submitted)])
+        metric("jobs_extended_total", "counter", "Finished jobs searched again with a higher limit.",
+               [("", m.jobs_extended)])
+        metric("jobs_extended_warm_total", "counter",
+               "Extended jobs that continued on the engine holding their search.",
+               [("", m.jobs_extended_warm)])
+        metric("jobs_finished_total", "counter", "Jobs that reached a terminal state, by status.",
+               [(f'status="{status_names.get(s, str(s))}"', n) for s, n in sorted(m.jobs_finished.items())])
+        metric("jobs_running", "gauge", "Jobs on an engine.", [("", len(self.active_jobs))])
+        metric("jobs_pending", "gauge", "Jobs waiting for a free slot.", [("", len(self.pending))])
+        metric("max_jobs", "gauge", "Concurrent job slots.", [("", int(self.max_jobs))])
+        metric("engine_pool_size", "gauge", "Warm engines.", [("", pool.get("pool_size", 0))])
+        metric("engine_pool_idle", "gauge", "Idle warm engines.", [("", pool.get("pool_idle", 0))])
+        metric("engine_pool_busy", "gauge", "Engines running a job.", [("", pool.get("pool_busy", 0))])
+        metric("nps", "gauge", "Latest nodes per second summed over running jobs.",
+               [("", sum(m.job_nps.values()))])
+        if self.db_writer is not None:
+            w = self.db_writer
+            metric("db_write_backlog", "gauge", "Batches waiting for the DB writer thread.", [("", w.backlog())])
+            metric("db_commits_total", "counter", "DB transactions committed.", [("", w.commits)])
+            metric("db_rows_written_total", "counter", "Job, log and cache rows written.", [("", w.rows_written)])
+            metric("db_commit_seconds_total", "counter", "Time spent in DB transactions.",
+                   [("", round(w.commit_seconds, 6))])
+            metric("db_write_errors_total", "counter", "Failed DB transactions (rows dropped).", [("", w.errors)])
+        return "\n".join(out) + "\n"
+
+    async def handle_metrics_http(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        try:
+            request = await asyncio.wait_for(reader.readline(), timeout=5.0)
+            # Skip headers; the request line is all we need.
+            while True:
+                line = await asyncio.wait_for(reader.readline(), timeout=5.0)
+                if not line or line in (b"\r\n", b"\n"):
+                    break
+            parts = request.decode("latin-1", errors="replace").split()
+            path = parts[1].split("?", 1)[0] if len(parts) >= 2 else ""
+            if len(parts) >= 2 and parts[0] == "GET" and path in ("/metrics", "/"):
+                body = self.metrics_text().encode("utf-8")
+                head = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            else:
+                body = b"not found\n"
+                head = "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n"
+            head += f"Content-Length: {len(body)}\r\nConnection: close\r\n\r\n"
+            writer.write(head.encode("latin-1") + body)
+            await writer.drain()
+        except (asyncio.TimeoutError, ConnectionError):
+            pass
+        finally:
+            try:
+                writer.close()
+            except Exception:
+                pass
 
     async def start(self) -> None:
         self._server = await asyncio.start_server(self.handle_client, self.host, self.port, ssl=self.ssl_ctx)
         addrs = ", ".join(str(sock.getsockname()) for sock in (self._server.sockets or []))
         proto = "TLS" if self.ssl_ctx is not None else "TCP"
         print(f"[server] Listening on {addrs} ({proto}, server_id={self.server_id})")
-        async with self._server:
-            await self._server.serve_forever()
+        metrics_server: Optional[asyncio.AbstractServer] = None
+        if self.metrics_port > 0:
+            metrics_server = await asyncio.start_server(self.handle_metrics_http, self.metrics_host, self.metrics_port)
+            print(f"[server] Metrics on http://{self.metrics_host}:{self.metrics_port}/metrics")
+        flusher = asyncio.create_task(self._db_flush_loop()) if self.db_writer is not None and self.db_flush_ms > 0 else None
+        warmer = asyncio.create_task(self.engine_pool.warm())
+        try:
+            async with self._server:
+                await self._server.serve_forever()
+        finally:
+            if flusher is not None:
+                flusher.cancel()
+            if metrics_server is not None:
+                metrics_server.close()
+            warmer.cancel()
+            self._flush_db()
+            if self.db_writer is not None:
+                self.db_writer.close()
+            await self.engine_pool.close()
 
 
 def parse_args(argv=None):
@@ -880,8 +2291,34 @@ def parse_args(argv=None):
     p.add_argument("--host", default="0.0.0.0", help="Host to bind")
     p.add_argument("--port", type=int, default=9000, help="Port to listen on")
     p.add_argument("--stockfish", required=True, help="Path to Stockfish binary")
-    p.add_argument("--threads", type=int, default=32, help="Threads per job")
+    p.add_argument("--threads", type=int, default=32, help="Threads per job (ignored with --pin-cores)")
     p.add_argument("--max-jobs", type=int, default=1, help="Max concurrent jobs")
+    p.add_argument("--hash-mb", type=int, default=0, help="Hash size per engine in MB (0 = engine default)")
+    p.add_argument(
+        "--engine-pool",
+        type=int,
+        default=None,
+        help="Warm engines kept between jobs (default: --max-jobs; 0 = start an engine per job)",
+    )
+    p.add_argument(
+        "--pin-cores",
+        action="store_true",
+        help="Split the CPUs into --max-jobs disjoint sets (whole cores, NUMA-local) and pin each "
+             "engine to one; an engine runs one thread per CPU of its set",
+    )
+    p.add_argument(
+        "--extend-grace-s",
+        type=float,
+        default=120.0,
+        help="Keep the engine of a finished job reserved for it this long, so job_extend can "
+             "continue on its transposition table (0 = no reservation)",
+    )
+    p.add_argument(
+        "--batch-ms",
+        type=int,
+        default=100,
+        help="Send merged job updates to batching clients at most every N ms (0 = one message per engine line)",
+    )
 
     # Persistence
     p.add_argument(
@@ -895,6 +2332,25 @@ def parse_args(argv=None):
         default=500,
         help="How many recent jobs to load into memory at startup (only used when --db is set)",
     )
+    p.add_argument(
+        "--db-flush-ms",
+        type=int,
+        default=500,
+        help="Group job update and log writes into one transaction every N ms (0 = commit every line)",
+    )
+
+    # Monitoring
+    p.add_argument(
+        "--metrics-port",
+        type=int,
+        default=0,
+        help="Serve Prometheus metrics over HTTP on this port (0 = off)",
+    )
+    p.add_argument(
+        "--metrics-host",
+        default="127.0.0.1",
+        help="Address for the metrics endpoint (no authentication; keep it internal)",
+    )
 
     # TLS / mTLS
     p.add_argument("--tls-cert", help="Path to server certificate (PEM)")
@@ -932,6 +2388,14 @@ def main(argv=None) -> int:
         db_path=args.db,
         db_load_limit=args.db_load_limit,
         ssl_ctx=ssl_ctx,
+        batch_ms=args.batch_ms,
+        db_flush_ms=args.db_flush_ms,
+        hash_mb=args.hash_mb,
+        pool_size=args.engine_pool,
+        metrics_host=args.metrics_host,
+        metrics_port=args.metrics_port,
+        pin_cores=args.pin_cores,
+        extend_grace_s=args.extend_grace_s,
     )
     try:
         asyncio.run(server.start())
@@ -0,0 +1,269 @@
+// JobManager regression checks (no Qt, no network).
+//
+//   corrchess_job_manager_test
+//
+// Each case drives a JobManager against an in-memory ServerManager the way
+// the network layer would (applyRemoteUpdate for server reports) and checks
+// the jobs it ends up with. Exit status is 0 only if every check passed.
+
+#include "app/IHistoryRepository.hpp"
+#include "app/JobManager.hpp"
+#include "app/ServerManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace sf::client::app;
+using namespace sf::client::domain;
+
+namespace {
+
+const char* const kStartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++failures;                                                          \
+        }                                                                        \
+    } while (0)
+
+ServerInfo server(const std::string& id) {
+    ServerInfo s;
+    s.id = id;
+    s.name = id;
+    s.maxJobs = 8;
+    return s;
+}
+
+// Two servers that reported in (server_status, hello with job_extend).
+void bringOnline(ServerManager& servers) {
+    for (const ServerInfo& s : std::vector<ServerInfo>(servers.servers())) {
+        servers.updateServerRuntime(s.id, ServerStatus::Online, 0, s.maxJobs, 1, 8);
+        servers.updateServerFeatures(s.id, true);
+    }
+}
+
+SearchLimit depth(int value) {
+    SearchLimit limit;
+    limit.type = LimitType::Depth;
+    limit.value = value;
+    return limit;
+}
+
+void finish(JobManager& jobs, const JobId& id) {
+    JobSnapshot snapshot;
+    snapshot.bestMove = "e2e4";
+    jobs.applyRemoteUpdate(id, JobStatus::Finished, snapshot, std::nullopt);
+}
+
+const Job* find(const JobManager& jobs, const JobId& id) {
+    for (const Job& job : jobs.jobs()) {
+        if (job.id == id) {
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+// An extended cluster job answers a new request for its position as a
+// whole; none of its sub-jobs (which search only some root moves) may.
+void extendedClusterJobIsSharedWhole() {
+    ServerManager servers({server("a"), server("b")});
+    bringOnline(servers);
+    JobManager jobs(servers);
+
+    const JobId parentId = jobs.enqueueClusterJob("", kStartFen, depth(10), 1, 2);
+    const Job* parent = find(jobs, parentId);
+    CHECK(parent && parent->subJobIds.size() == 2);
+    if (!parent) {
+        return;
+    }
+    for (const JobId& childId : std::vector<JobId>(parent->subJobIds)) {
+        finish(jobs, childId);
+    }
+    CHECK(parent->status == JobStatus::Finished);
+
+    // Another request for the position drops the finished job from the
+    // in-flight index.
+    SearchLimit nodes;
+    nodes.type = LimitType::Nodes;
+    nodes.value = 1000000;
+    jobs.enqueueJob("", kStartFen, nodes, 1, std::nullopt);
+
+    CHECK(jobs.extendJob(parentId, 20));
+    const JobId shared = jobs.enqueueJob("", kStartFen, depth(20), 1, std::nullopt);
+    CHECK(shared == parentId);
+}
+
+// A batch item runs hidden behind its batch's summary row, so a new
+// interactive request never shares it.
+void batchItemIsNotShared() {
+    ServerManager servers({server("a"), server("b")});
+    bringOnline(servers);
+    JobManager jobs(servers);
+
+    const JobId batchId = jobs.enqueueBatch("batch", {BatchPosition{"start", kStartFen, 0}}, depth(20), 1);
+    const JobId interactive = jobs.enqueueJob("", kStartFen, depth(20), 1, std::nullopt);
+    const Job* job = find(jobs, interactive);
+    CHECK(job && !job->parentJobId && interactive != batchId);
+}
+
+// A batch position another job is searching counts that job's outcome:
+// stopping it leaves the position failed instead of the batch finishing.
+void sharedBatchPositionFollowsItsJob() {
+    ServerManager servers({server("a"), server("b")});
+    bringOnline(servers);
+    JobManager jobs(servers);
+
+    const JobId interactive = jobs.enqueueJob("", kStartFen, depth(20), 1, std::nullopt);
+    const JobId batchId = jobs.enqueueBatch("batch", {BatchPosition{"start", kStartFen, 0}}, depth(20), 1);
+    const Job* batch = find(jobs, batchId);
+    CHECK(batch && batch->batch && batch->batch->total == 1 && batch->subJobIds.empty());
+    if (!batch || !batch->batch) {
+        return;
+    }
+    CHECK(!std::count_if(jobs.jobs().begin(), jobs.jobs().end(),
+                         [&](const Job& j) { return j.parentJobId == batchId; }));
+
+    jobs.requestStopJob(interactive);
+    CHECK(batch->batch->failed == 1);
+    CHECK(batch->status == JobStatus::Cancelled);
+
+    // And a finishing one counts as done.
+    const JobId second = jobs.enqueueJob("", kStartFen, depth(20), 1, std::nullopt);
+    const JobId secondBatchId = jobs.enqueueBatch("batch", {BatchPosition{"start", kStartFen, 0}}, depth(20), 1);
+    const Job* secondBatch = find(jobs, secondBatchId);
+    CHECK(secondBatch && secondBatch->status == JobStatus::Queued);
+    finish(jobs, second);
+    CHECK(secondBatch && secondBatch->status == JobStatus::Finished && secondBatch->batch->finished == 1);
+}
+
+// Records what JobManager hands to history and the analysis cache.
+class HistoryRecorder : public IHistoryRepository {
+public:
+    std::vector<int>   cachedLimits;
+    std::vector<JobId> forgotten;
+
+    void saveJob(const Job&) override {}
+    std::vector<Job> loadAllJobs() const override { return {}; }
+    HistoryPage loadJobsPage(const std::optional<HistoryCursor>&, int, bool) const override { return {}; }
+    std::optional<Job> loadJobDetails(const JobId&) const override { return std::nullopt; }
+    bool scanJobs(bool, const JobVisitor&) const override { return true; }
+    void forgetJob(const JobId& id) override { forgotten.push_back(id); }
+    void saveCachedAnalysis(std::uint64_t, const Job& job) override { cachedLimits.push_back(job.limit.value); }
+};
+
+// An extension that ends without getting past its earlier depth keeps the
+// earlier result, which must not be cached under the raised limit.
+void shallowExtensionIsNotCached() {
+    ServerManager servers({server("a")});
+    bringOnline(servers);
+    HistoryRecorder history;
+    JobManager jobs(servers, &history);
+
+    SearchLimit nodes;
+    nodes.type = LimitType::Nodes;
+    nodes.value = 1000000;
+    const JobId id = jobs.enqueueJob("", kStartFen, nodes, 1, std::nullopt);
+
+    JobSnapshot result;
+    result.depth = 20;
+    result.bestMove = "e2e4";
+    jobs.applyRemoteUpdate(id, JobStatus::Finished, result, std::nullopt);
+    CHECK((history.cachedLimits == std::vector<int>{1000000}));
+
+    // The server kept its earlier result: the final update carries no line.
+    CHECK(jobs.extendJob(id, 2000000));
+    jobs.applyRemoteUpdate(id, JobStatus::Finished, JobSnapshot{}, std::nullopt);
+    CHECK((history.cachedLimits == std::vector<int>{1000000}));
+
+    CHECK(jobs.extendJob(id, 4000000));
+    result.depth = 24;
+    jobs.applyRemoteUpdate(id, JobStatus::Finished, result, std::nullopt);
+    CHECK((history.cachedLimits == std::vector<int>{1000000, 4000000}));
+}
+
+// History drops its per-job save state once a job leaves memory.
+void evictedJobIsForgotten() {
+    ServerManager servers({server("a")});
+    bringOnline(servers);
+    HistoryRecorder history;
+    JobManager jobs(servers, &history);
+
+    const JobId id = jobs.enqueueJob("", kStartFen, depth(10), 1, std::nullopt);
+    finish(jobs, id);
+    CHECK(jobs.evictTerminalJobs(Clock::now() + std::chrono::seconds(1)) == 1);
+    CHECK((history.forgotten == std::vector<JobId>{id}));
+}
+
+std::vector<std::string> readLines(const std::filesystem::path& path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Spill files of server-supplied ids stay inside the spill directory, and a
+// job listed again after a restart does not repeat its spilled lines.
+void remoteJobSpillsInsideItsDirectory() {
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "corrchess_job_manager_test";
+    const fs::path dir = root / "job_logs";
+    fs::remove_all(root);
+    fs::create_directories(dir);
+
+    for (int session = 0; session < 2; ++session) {
+        ServerManager servers({server("a")});
+        bringOnline(servers);
+        JobManager jobs(servers);
+        jobs.setLogLimits(1, dir.string());
+
+        // As parsed from a jobs_list item (a log of its own each time).
+        Job remote;
+        remote.id = "../escaped";
+        remote.fen = kStartFen;
+        remote.status = JobStatus::Finished;
+        remote.assignedServer = "a";
+        remote.logLines.assign({"one", "two", "three"});
+        jobs.upsertRemoteJob(remote);
+    }
+
+    CHECK(!fs::exists(root / "escaped.log"));
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        files.push_back(entry.path());
+    }
+    CHECK(files.size() == 1);
+    if (files.size() == 1) {
+        CHECK((readLines(files.front()) == std::vector<std::string>{"one", "two"}));
+    }
+    fs::remove_all(root);
+}
+
+} // namespace
+
+int main() {
+    extendedClusterJobIsSharedWhole();
+    batchItemIsNotShared();
+    sharedBatchPositionFollowsItsJob();
+    remoteJobSpillsInsideItsDirectory();
+    shallowExtensionIsNotCached();
+    evictedJobIsForgotten();
+
+    if (failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
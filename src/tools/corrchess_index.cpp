@@ -0,0 +1,186 @@
+// Headless reference DB import: builds the .refdb sidecar (and optionally the
+// .cctree opening tree) for a PGN without the GUI, for large imports on a
+// server.
+//
+//   corrchess_index [options] FILE.pgn
+//
+// Same pipeline and output files as "Build reference index" in the client
+// (ReferenceDbImporter), so the results can be copied next to the PGN on a
+// workstation and opened there. Progress goes to stderr every couple of
+// seconds. SIGINT/SIGTERM stop the import after the current batch; every
+// committed batch stays in the database.
+//
+// Exit status: 0 on success, 1 on import failure, 2 on bad arguments,
+// 130 when cancelled.
+
+#include "infra/refdb/OpeningTreeFile.hpp"
+#include "infra/refdb/ReferenceDbImporter.hpp"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+
+namespace {
+
+using sf::client::infra::refdb::ImportOptions;
+using sf::client::infra::refdb::ImportProgress;
+using sf::client::infra::refdb::ImportResult;
+using sf::client::infra::refdb::OccurrenceFormat;
+using sf::client::infra::refdb::ReferenceDbImporter;
+
+std::atomic<bool> g_cancel{false};
+
+extern "C" void onStopSignal(int) {
+    g_cancel.store(true, std::memory_order_relaxed);
+}
+
+bool parseNonNegative(const QCommandLineParser& parser, const QCommandLineOption& option, int& out) {
+    if (!parser.isSet(option)) {
+        return true;
+    }
+    bool ok = false;
+    const int value = parser.value(option).toInt(&ok);
+    if (!ok || value < 0) {
+        std::fprintf(stderr, "corrchess_index: invalid --%s value '%s'\n",
+                     qPrintable(option.names().constLast()), qPrintable(parser.value(option)));
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("corrchess_index"));
+
+    // Same plugin lookup as the client, so a qsqlite driver shipped next to
+    // the binary is found.
+    const QString appDir = QCoreApplication::applicationDirPath();
+    QCoreApplication::addLibraryPath(appDir);
+    QCoreApplication::addLibraryPath(appDir + "/plugins");
+    QCoreApplication::addLibraryPath(appDir + "/sqldrivers");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Build the CorrChess reference DB (.refdb) for a PGN file."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("pgn"), QStringLiteral("PGN file to index."));
+
+    const QCommandLineOption dbOption(
+        QStringLiteral("db"), QStringLiteral("Output database (default: <pgn>.refdb)."),
+        QStringLiteral("path"));
+    const QCommandLineOption treeOption(
+        QStringLiteral("tree"), QStringLiteral("Opening tree file (default: <pgn>.cctree)."),
+        QStringLiteral("path"));
+    const QCommandLineOption noTreeOption(
+        QStringLiteral("no-tree"), QStringLiteral("Do not write the opening tree file."));
+    const QCommandLineOption threadsOption(
+        QStringLiteral("threads"), QStringLiteral("Scan threads (default: hardware threads minus one)."),
+        QStringLiteral("n"));
+    const QCommandLineOption batchOption(
+        QStringLiteral("batch"), QStringLiteral("Games per writer transaction (default: 2000)."),
+        QStringLiteral("n"));
+    const QCommandLineOption maxPliesOption(
+        QStringLiteral("max-plies"), QStringLiteral("Index only the first N plies of each game (0 = all)."),
+        QStringLiteral("n"));
+    const QCommandLineOption noOccurrencesOption(
+        QStringLiteral("no-occurrences"),
+        QStringLiteral("Skip per-game position occurrences (move statistics only)."));
+    const QCommandLineOption occurrenceRowsOption(
+        QStringLiteral("occurrence-rows"),
+        QStringLiteral("Store occurrences one row per ply with the move played, not as posting lists."));
+    const QCommandLineOption quietOption(
+        QStringLiteral("quiet"), QStringLiteral("No progress output."));
+    parser.addOptions({dbOption, treeOption, noTreeOption, threadsOption, batchOption,
+                       maxPliesOption, noOccurrencesOption, occurrenceRowsOption, quietOption});
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1) {
+        std::fprintf(stderr, "corrchess_index: expected exactly one PGN file (see --help)\n");
+        return 2;
+    }
+    if (parser.isSet(treeOption) && parser.isSet(noTreeOption)) {
+        std::fprintf(stderr, "corrchess_index: --tree and --no-tree are mutually exclusive\n");
+        return 2;
+    }
+
+    ImportOptions options;
+    options.pgnPath = args.constFirst();
+    if (!QFileInfo(options.pgnPath).isFile()) {
+        std::fprintf(stderr, "corrchess_index: %s: no such file\n", qPrintable(options.pgnPath));
+        return 2;
+    }
+    options.dbPath = parser.isSet(dbOption) ? parser.value(dbOption)
+                                            : options.pgnPath + QStringLiteral(".refdb");
+    if (!parser.isSet(noTreeOption)) {
+        options.openingTreePath =
+            parser.isSet(treeOption)
+                ? parser.value(treeOption)
+                : options.pgnPath + QLatin1String(sf::client::infra::refdb::kOpeningTreeSuffix);
+    }
+    options.storeOccurrences = !parser.isSet(noOccurrencesOption);
+    if (parser.isSet(occurrenceRowsOption)) {
+        options.occurrenceFormat = OccurrenceFormat::Rows;
+    }
+    if (!parseNonNegative(parser, threadsOption, options.workerThreads)
+        || !parseNonNegative(parser, batchOption, options.batchGames)
+        || !parseNonNegative(parser, maxPliesOption, options.maxPlies)) {
+        return 2;
+    }
+    if (options.batchGames == 0) {
+        options.batchGames = ImportOptions{}.batchGames;
+    }
+
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+
+    const bool quiet = parser.isSet(quietOption);
+    using Clock = std::chrono::steady_clock;
+    auto lastReport = Clock::now();
+
+    std::fprintf(stderr, "indexing %s -> %s\n", qPrintable(options.pgnPath), qPrintable(options.dbPath));
+    const ImportResult result = ReferenceDbImporter::run(options, g_cancel, [&](const ImportProgress& p) {
+        const auto now = Clock::now();
+        if (quiet || now - lastReport < std::chrono::seconds(2)) {
+            return;
+        }
+        lastReport = now;
+        const double percent = p.totalBytes > 0 ? 100.0 * p.bytesProcessed / p.totalBytes : 0.0;
+        std::fprintf(stderr, "%5.1f%%  %lld games (%lld skipped)  %.1f MB/s  %.0f games/s\n",
+                     percent,
+                     static_cast<long long>(p.gamesImported),
+                     static_cast<long long>(p.gamesSkipped),
+                     p.bytesPerSecond / (1024.0 * 1024.0),
+                     p.gamesPerSecond);
+    });
+
+    if (result.cancelled) {
+        std::fprintf(stderr, "cancelled after %lld games (committed batches kept in %s)\n",
+                     static_cast<long long>(result.gamesImported), qPrintable(options.dbPath));
+        return 130;
+    }
+    if (!result.ok) {
+        std::fprintf(stderr, "corrchess_index: import failed: %s\n", qPrintable(result.error));
+        return 1;
+    }
+
+    std::fprintf(stderr, "indexed %lld games (%lld skipped, %lld plies) in %.1f s\n",
+                 static_cast<long long>(result.gamesImported),
+                 static_cast<long long>(result.gamesSkipped),
+                 static_cast<long long>(result.pliesIndexed),
+                 result.seconds);
+    if (!options.openingTreePath.isEmpty()) {
+        std::fprintf(stderr, "opening tree: %s\n", qPrintable(options.openingTreePath));
+    }
+    return 0;
+}
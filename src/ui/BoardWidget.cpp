@@ -1,8 +1,11 @@
 #include "ui/BoardWidget.hpp"
 
+#include "infra/trace/Trace.hpp"
+
 #include <QPainter>
 #include <QPainterPath>
 #include <QPaintEvent>
+#include <QResizeEvent>
 #include <QFont>
 #include <QtMath>
 #include <cmath>
@@ -39,18 +42,27 @@ BoardWidget::BoardWidget(QWidget* parent) : QWidget(parent) {
 }
 
 void BoardWidget::setFen(const QString& fen) {
+    // Only the placement field is drawn; side to move, clocks etc. don't matter.
+    const bool samePlacement = fen.section(' ', 0, 0) == fen_.section(' ', 0, 0);
     fen_ = fen;
+    if (samePlacement) return;
+
     parseFenPieces(fen_);
+    piecesLayer_ = QPixmap();
     update();
 }
 
 void BoardWidget::setArrows(const QVector<Arrow>& arrows) {
+    if (arrows == arrows_) return;
     arrows_ = arrows;
+    arrowsLayer_ = QPixmap();
     update();
 }
 
 void BoardWidget::setHighlights(const QVector<Square>& squares) {
+    if (squares == highlights_) return;
     highlights_ = squares;
+    boardLayer_ = QPixmap();
     update();
 }
 
@@ -132,16 +144,48 @@ QPointF BoardWidget::squareCenter(int file, int rank) const {
     return QPointF(r.center().x(), r.center().y());
 }
 
+QPixmap BoardWidget::makeLayer() const {
+    const qreal dpr = devicePixelRatioF();
+    QPixmap layer(size() * dpr);
+    layer.setDevicePixelRatio(dpr);
+    layer.fill(Qt::transparent);
+    return layer;
+}
+
+void BoardWidget::resizeEvent(QResizeEvent* ev) {
+    QWidget::resizeEvent(ev);
+    boardLayer_ = QPixmap();
+    piecesLayer_ = QPixmap();
+    arrowsLayer_ = QPixmap();
+}
+
 void BoardWidget::paintEvent(QPaintEvent* ev) {
     Q_UNUSED(ev);
+    CORRCHESS_TRACE_SCOPE("ui.boardPaint");
+
+    // A move to a screen with another device pixel ratio sends no resize,
+    // so the cached layers are also redrawn when their ratio is stale.
+    const qreal dpr = devicePixelRatioF();
+    const auto renderLayer = [this, dpr](QPixmap& layer, auto&& draw) {
+        if (!layer.isNull() && qFuzzyCompare(layer.devicePixelRatio(), dpr)) return;
+        layer = makeLayer();
+        QPainter lp(&layer);
+        lp.setRenderHint(QPainter::Antialiasing, true);
+        lp.setRenderHint(QPainter::TextAntialiasing, true);
+        draw(lp);
+    };
+    renderLayer(boardLayer_, [this](QPainter& lp) {
+        drawBoard(lp);
+        drawHighlights(lp);
+    });
+    renderLayer(piecesLayer_, [this](QPainter& lp) { drawPieces(lp); });
+    renderLayer(arrowsLayer_, [this](QPainter& lp) { drawArrows(lp); });
+
     QPainter p(this);
     p.setRenderHint(QPainter::Antialiasing, true);
-    p.setRenderHint(QPainter::TextAntialiasing, true);
-
-    drawBoard(p);
-    drawHighlights(p);
-    drawPieces(p);
-    drawArrows(p);
+    p.drawPixmap(0, 0, boardLayer_);
+    p.drawPixmap(0, 0, piecesLayer_);
+    p.drawPixmap(0, 0, arrowsLayer_);
 
     // border
     p.setPen(QPen(QColor(0,0,0,60), 1.0));
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QWidget>
+#include <QPixmap>
 #include <QString>
 #include <QRectF>
 #include <QPointF>
@@ -8,6 +9,7 @@
 #include <optional>
 
 class QPainter;
+class QResizeEvent;
 
 namespace sf::client::ui {
 
@@ -16,6 +18,10 @@ struct Square {
     int rank = 0; // 0=1..7=8
 };
 
+inline bool operator==(const Square& a, const Square& b) {
+    return a.file == b.file && a.rank == b.rank;
+}
+
 struct Arrow {
     Square from;
     Square to;
@@ -25,6 +31,17 @@ struct Arrow {
     int multipv = 1;
 };
 
+inline bool operator==(const Arrow& a, const Arrow& b) {
+    return a.from == b.from && a.to == b.to && a.scoreCp == b.scoreCp
+        && a.scoreMate == b.scoreMate && a.multipv == b.multipv;
+}
+
+// Paints from three cached layers (squares + highlights, pieces, arrows),
+// each re-rendered only when its own input changes or the widget resizes.
+// The setters ignore values equal to the current ones, so feeding the same
+// position and PV on every engine update costs nothing; a new PV repaints
+// the arrow layer only.
+
 class BoardWidget : public QWidget {
     Q_OBJECT
 public:
@@ -42,6 +59,7 @@ public:
 
 protected:
     void paintEvent(QPaintEvent* ev) override;
+    void resizeEvent(QResizeEvent* ev) override;
 
 private:
     struct Piece {
@@ -58,12 +76,20 @@ private:
     void drawPieces(QPainter& p);
     void drawArrows(QPainter& p);
 
+    // Transparent pixmap covering the widget at device resolution.
+    QPixmap makeLayer() const;
+
     // internal: [rank][file] with rank 0=1st rank
     Piece pieces_[8][8];
 
     QString fen_;
     QVector<Arrow> arrows_;
     QVector<Square> highlights_;
+
+    // Null = stale; rebuilt by the next paintEvent.
+    QPixmap boardLayer_;  // squares + highlights
+    QPixmap piecesLayer_; // pieces of fen_
+    QPixmap arrowsLayer_; // arrows_
 };
 
 } // namespace sf::client::ui
@@ -1,6 +1,7 @@
 #include "ui/GameViewerDialog.hpp"
 
-#include "domain/chess_san_to_fen.hpp"
+#include "domain/chess/Position.hpp"
+#include "infra/refdb/ReferenceDbQuery.hpp"
 #include "ui/BoardWidget.hpp"
 
 #include <QAbstractItemView>
@@ -8,12 +9,54 @@
 #include <QLabel>
 #include <QListWidget>
 #include <QPushButton>
+#include <QHeaderView>
 #include <QSplitter>
+#include <QTreeWidget>
 #include <QVBoxLayout>
 
 namespace sf::client::ui {
 
-using sf::client::domain::chess::FenTimelineResult;
+using sf::client::domain::chess::GameTree;
+using sf::client::infra::refdb::ReferenceDbQuery;
+
+namespace {
+
+// Positions ahead in the game that are fetched together with the shown one.
+constexpr int kGamePrefetchPlies = 4;
+
+// Moves list indent per variation level.
+constexpr int kVariationIndent = 4;
+
+// games.date_int (YYYYMMDD, unknown parts 0) as a PGN date.
+QString pgnDate(int dateInt) {
+    const auto part = [](int v, int width) {
+        return v > 0 ? QStringLiteral("%1").arg(v, width, 10, QLatin1Char('0')) : QString(width, QLatin1Char('?'));
+    };
+    return part(dateInt / 10000, 4) + QLatin1Char('.') + part(dateInt / 100 % 100, 2)
+         + QLatin1Char('.') + part(dateInt % 100, 2);
+}
+
+const char* nagSymbol(int nag) {
+    switch (nag) {
+        case 1: return "!";
+        case 2: return "?";
+        case 3: return "!!";
+        case 4: return "??";
+        case 5: return "!?";
+        case 6: return "?!";
+        default: return "";
+    }
+}
+
+QString formatScore(const sf::client::domain::Score& score) {
+    using sf::client::domain::ScoreType;
+    if (score.type == ScoreType::Mate) {
+        return QStringLiteral("#%1").arg(score.value);
+    }
+    return QString::asprintf("%+.2f", score.value / 100.0);
+}
+
+} // namespace
 
 GameViewerDialog::GameViewerDialog(QWidget* parent)
     : QDialog(parent) {
@@ -36,12 +79,45 @@ void GameViewerDialog::setupUi() {
     boardWidget_ = new BoardWidget(splitter);
     boardWidget_->setMinimumSize(360, 360);
 
-    movesList_ = new QListWidget(splitter);
+    auto* rightSplitter = new QSplitter(Qt::Vertical, splitter);
+
+    auto* movesBox = new QWidget(rightSplitter);
+    auto* movesLayout = new QVBoxLayout(movesBox);
+    movesLayout->setContentsMargins(0, 0, 0, 0);
+    movesList_ = new QListWidget(movesBox);
     movesList_->setSelectionMode(QAbstractItemView::SingleSelection);
     movesList_->setUniformItemSizes(true);
+    notesLabel_ = new QLabel(movesBox);
+    notesLabel_->setWordWrap(true);
+    notesLabel_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    movesLayout->addWidget(movesList_, 1);
+    movesLayout->addWidget(notesLabel_);
+
+    auto* explorerBox = new QWidget(rightSplitter);
+    auto* explorerLayout = new QVBoxLayout(explorerBox);
+    explorerLayout->setContentsMargins(0, 0, 0, 0);
+    explorerStatus_ = new QLabel(explorerBox);
+    explorerTree_ = new QTreeWidget(explorerBox);
+    explorerTree_->setRootIsDecorated(false);
+    explorerTree_->setUniformRowHeights(true);
+    explorerTree_->setHeaderLabels({tr("Move"), tr("Games"), tr("Score"), tr("W / D / L"), tr("Years")});
+    explorerTree_->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    gamesTree_ = new QTreeWidget(explorerBox);
+    gamesTree_->setRootIsDecorated(false);
+    gamesTree_->setUniformRowHeights(true);
+    gamesTree_->setHeaderLabels({tr("White"), tr("Black"), tr("Result"), tr("Date"), tr("Ply")});
+    gamesTree_->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    gamesTree_->setVisible(false); // shown when the index has occurrences
+    explorerLayout->addWidget(explorerStatus_);
+    explorerLayout->addWidget(explorerTree_, 1);
+    explorerLayout->addWidget(gamesTree_, 1);
+    explorerBox->setVisible(false); // shown while a reference index is open
+
+    rightSplitter->addWidget(movesBox);
+    rightSplitter->addWidget(explorerBox);
 
     splitter->addWidget(boardWidget_);
-    splitter->addWidget(movesList_);
+    splitter->addWidget(rightSplitter);
     splitter->setStretchFactor(0, 1);
     splitter->setStretchFactor(1, 1);
 
@@ -73,36 +149,12 @@ void GameViewerDialog::setupUi() {
     connect(lastBtn_,  &QPushButton::clicked, this, &GameViewerDialog::onLastClicked);
     connect(analyzeBtn_, &QPushButton::clicked, this, &GameViewerDialog::onAnalyzeClicked);
 
-    setCurrentPly(-1);
+    setCurrentPly(GameTree::kRoot);
 }
 
-bool GameViewerDialog::setGame(const Meta& meta,
-                              const FenTimelineResult& timeline,
-                              QString* outError) {
+void GameViewerDialog::setGame(const Meta& meta, GameTree tree) {
     meta_ = meta;
-
-    if (!timeline.ok) {
-        if (outError) {
-            *outError = QString::fromStdString(timeline.error);
-        }
-        return false;
-    }
-
-    startFen_ = !meta.startFen.trimmed().isEmpty()
-                   ? meta.startFen.trimmed()
-                   : QString::fromStdString(timeline.startFen);
-
-    plies_.clear();
-    plies_.reserve(timeline.plies.size());
-    for (const auto& p : timeline.plies) {
-        Ply o;
-        o.plyIndex = p.plyIndex;
-        o.san = p.san;
-        o.uci = p.uci;
-        o.fenAfter = p.fenAfter;
-        o.posHashBefore = p.posHashBefore;
-        plies_.push_back(std::move(o));
-    }
+    tree_ = std::move(tree);
 
     QString title = tr("Game viewer");
     if (!meta_.white.isEmpty() || !meta_.black.isEmpty()) {
@@ -123,46 +175,82 @@ bool GameViewerDialog::setGame(const Meta& meta,
     headerLabel_->setText(headerLines.join("\n"));
 
     rebuildMovesList();
-    setCurrentPly(-1);
+    setCurrentPly(GameTree::kRoot);
+}
 
-    return true;
+void GameViewerDialog::mergeEngineResult(const std::string& fen,
+                                         const sf::client::domain::JobSnapshot& snapshot) {
+    const auto pos = sf::client::domain::chess::Position::fromFen(fen);
+    if (!pos || !tree_.mergeEval(pos->key(), snapshot)) {
+        return;
+    }
+    if (tree_.key(currentPly_) == pos->key()) {
+        updateNotes();
+    }
+}
+
+void GameViewerDialog::setReferenceQuery(ReferenceDbQuery* query) {
+    if (refQuery_) {
+        disconnect(refQuery_, nullptr, this, nullptr);
+    }
+    refQuery_ = query;
+    if (refQuery_) {
+        connect(refQuery_, &ReferenceDbQuery::positionReady,
+                this, &GameViewerDialog::onExplorerPositionReady);
+        connect(refQuery_, &ReferenceDbQuery::gamesReady,
+                this, &GameViewerDialog::onExplorerGamesReady);
+        connect(refQuery_, &ReferenceDbQuery::opened, this, [this]() {
+            gamesRequested_.reset();
+            gamesShown_.reset();
+            updateExplorer();
+        });
+    }
+    gamesRequested_.reset();
+    gamesShown_.reset();
+    updateExplorer();
 }
 
 void GameViewerDialog::rebuildMovesList() {
     ignoreSelection_ = true;
     movesList_->clear();
+    rowOfPly_.assign(tree_.plyCount(), -1);
 
-    for (size_t i = 0; i < plies_.size(); ++i) {
-        const int ply = static_cast<int>(i);
-        const int moveNo = (ply / 2) + 1;
-        const bool isWhite = (ply % 2 == 0);
-        const QString san = QString::fromStdString(plies_[i].san);
+    appendLine(tree_.firstChild(GameTree::kRoot), 0);
 
-        QString text;
-        if (isWhite) {
-            text = QString("%1. %2").arg(moveNo).arg(san);
-        } else {
-            text = QString("%1... %2").arg(moveNo).arg(san);
+    ignoreSelection_ = false;
+}
+
+// One row per ply in PGN order: a move, then the variations that replace
+// it (indented, each with its own continuation), then the next move.
+void GameViewerDialog::appendLine(GameTree::PlyId first, int indent) {
+    for (GameTree::PlyId ply = first; ply != GameTree::kNone; ply = tree_.firstChild(ply)) {
+        const QString san = QString::fromUtf8(tree_.san(ply).data(), static_cast<int>(tree_.san(ply).size()))
+                          + QString::fromLatin1(nagSymbol(tree_.nag(ply)));
+        QString text = tree_.isWhiteMove(ply)
+            ? QString("%1. %2").arg(tree_.moveNumber(ply)).arg(san)
+            : QString("%1... %2").arg(tree_.moveNumber(ply)).arg(san);
+        if (!tree_.comment(ply).empty()) {
+            text += QStringLiteral(" *");
         }
 
-        auto* item = new QListWidgetItem(text);
-        item->setData(Qt::UserRole, ply);
+        auto* item = new QListWidgetItem(QString(indent * kVariationIndent, QLatin1Char(' ')) + text);
+        item->setData(Qt::UserRole, static_cast<uint>(ply));
+        rowOfPly_[ply] = movesList_->count();
         movesList_->addItem(item);
-    }
 
-    ignoreSelection_ = false;
+        if (tree_.firstChild(tree_.parent(ply)) == ply) {
+            for (GameTree::PlyId alt = tree_.nextSibling(ply); alt != GameTree::kNone; alt = tree_.nextSibling(alt)) {
+                appendLine(alt, indent + 1);
+            }
+        }
+    }
 }
 
-void GameViewerDialog::setCurrentPly(int plyIndex) {
-    if (plyIndex < -1) plyIndex = -1;
-    if (!plies_.empty()) {
-        const int last = static_cast<int>(plies_.size()) - 1;
-        if (plyIndex > last) plyIndex = last;
-    } else {
-        plyIndex = -1;
+void GameViewerDialog::setCurrentPly(GameTree::PlyId ply) {
+    if (ply == GameTree::kNone || ply >= tree_.plyCount()) {
+        ply = GameTree::kRoot;
     }
-
-    currentPly_ = plyIndex;
+    currentPly_ = ply;
 
     if (boardWidget_) {
         boardWidget_->setFen(currentFen());
@@ -172,8 +260,9 @@ void GameViewerDialog::setCurrentPly(int plyIndex) {
 
     ignoreSelection_ = true;
     if (movesList_) {
-        if (currentPly_ >= 0) {
-            movesList_->setCurrentRow(currentPly_);
+        const int row = rowOfPly_.empty() ? -1 : rowOfPly_[currentPly_];
+        if (row >= 0) {
+            movesList_->setCurrentRow(row);
         } else {
             movesList_->clearSelection();
             movesList_->setCurrentRow(-1);
@@ -181,25 +270,139 @@ void GameViewerDialog::setCurrentPly(int plyIndex) {
     }
     ignoreSelection_ = false;
 
-    const bool hasMoves = !plies_.empty();
-    const bool atStart = (currentPly_ <= -1);
-    const bool atEnd = hasMoves && (currentPly_ >= static_cast<int>(plies_.size()) - 1);
+    const bool atStart = currentPly_ == GameTree::kRoot;
+    const bool atEnd = tree_.firstChild(currentPly_) == GameTree::kNone;
 
-    if (firstBtn_) firstBtn_->setEnabled(hasMoves && !atStart);
-    if (prevBtn_)  prevBtn_->setEnabled(hasMoves && !atStart);
-    if (nextBtn_)  nextBtn_->setEnabled(hasMoves && !atEnd);
-    if (lastBtn_)  lastBtn_->setEnabled(hasMoves && !atEnd);
+    if (firstBtn_) firstBtn_->setEnabled(!atStart);
+    if (prevBtn_)  prevBtn_->setEnabled(!atStart);
+    if (nextBtn_)  nextBtn_->setEnabled(!atEnd);
+    if (lastBtn_)  lastBtn_->setEnabled(!atEnd);
     if (analyzeBtn_) analyzeBtn_->setEnabled(true);
+
+    updateNotes();
+    updateExplorer();
 }
 
-QString GameViewerDialog::currentFen() const {
-    if (currentPly_ < 0) {
-        return startFen_;
+void GameViewerDialog::updateNotes() {
+    if (!notesLabel_) {
+        return;
     }
-    if (currentPly_ >= 0 && currentPly_ < static_cast<int>(plies_.size())) {
-        return QString::fromStdString(plies_[static_cast<size_t>(currentPly_)].fenAfter);
+    QStringList notes;
+    if (!tree_.comment(currentPly_).empty()) {
+        const auto c = tree_.comment(currentPly_);
+        notes << QString::fromUtf8(c.data(), static_cast<int>(c.size()));
+    }
+    if (const auto* eval = tree_.eval(currentPly_)) {
+        notes << tr("Engine: %1 (depth %2)").arg(formatScore(eval->score)).arg(eval->depth);
+    }
+    notesLabel_->setText(notes.join(QStringLiteral("\n")));
+    notesLabel_->setVisible(!notes.isEmpty());
+}
+
+std::uint64_t GameViewerDialog::currentPosHash() const {
+    return tree_.key(currentPly_);
+}
+
+void GameViewerDialog::updateExplorer() {
+    if (!explorerTree_) {
+        return;
+    }
+    const bool active = refQuery_ && refQuery_->isOpen();
+    explorerTree_->parentWidget()->setVisible(active);
+    if (!active) {
+        return;
+    }
+    explorerHash_ = currentPosHash();
+    updateGames();
+
+    const auto stats = refQuery_->cached(explorerHash_);
+    if (!stats) {
+        explorerTree_->clear();
+        explorerStatus_->setText(tr("Loading..."));
+
+        std::vector<std::uint64_t> ahead;
+        GameTree::PlyId next = tree_.firstChild(currentPly_);
+        for (int i = 0; i < kGamePrefetchPlies && next != GameTree::kNone; ++i) {
+            ahead.push_back(tree_.key(next));
+            next = tree_.firstChild(next);
+        }
+        refQuery_->request(explorerHash_, currentFen(), std::move(ahead));
+        return;
+    }
+
+    explorerTree_->clear();
+    explorerStatus_->setText(stats->games > 0
+        ? tr("%1 games").arg(stats->games)
+        : tr("Position not in reference index"));
+
+    for (const auto& m : stats->moves) {
+        auto* item = new QTreeWidgetItem(explorerTree_);
+        item->setText(0, m.uci);
+        item->setText(1, QString::number(m.games));
+        item->setText(2, QStringLiteral("%1%").arg(m.scorePercent(), 0, 'f', 1));
+        item->setText(3, QStringLiteral("%1 / %2 / %3").arg(m.w).arg(m.d).arg(m.l));
+        if (m.yearMin > 0) {
+            item->setText(4, m.yearMin == m.yearMax
+                ? QString::number(m.yearMin)
+                : QStringLiteral("%1-%2").arg(m.yearMin).arg(m.yearMax));
+        }
+        for (int c = 1; c < 5; ++c) {
+            item->setTextAlignment(c, Qt::AlignRight | Qt::AlignVCenter);
+        }
+    }
+
+    // Re-request on a hit too: it is a no-op for the DB but keeps the
+    // children of the shown position warm.
+    refQuery_->request(explorerHash_, currentFen());
+}
+
+void GameViewerDialog::onExplorerPositionReady(quint64 posHash) {
+    if (posHash == explorerHash_) {
+        updateExplorer();
+    }
+}
+
+void GameViewerDialog::updateGames() {
+    if (gamesShown_ == explorerHash_) {
+        return;
+    }
+    const auto games = refQuery_->games(explorerHash_);
+    if (!games) {
+        if (gamesRequested_ != explorerHash_) {
+            gamesRequested_ = explorerHash_;
+            gamesTree_->clear();
+            refQuery_->requestGames(explorerHash_);
+        }
+        return;
+    }
+    gamesShown_ = explorerHash_;
+    gamesTree_->clear();
+    gamesTree_->setVisible(!games->games.empty());
+    gamesTree_->headerItem()->setToolTip(0, games->occurrences > static_cast<qint64>(games->games.size())
+        ? tr("First %1 games of %2 occurrences").arg(games->games.size()).arg(games->occurrences)
+        : QString());
+
+    for (const auto& g : games->games) {
+        auto* item = new QTreeWidgetItem(gamesTree_);
+        item->setText(0, g.white);
+        item->setText(1, g.black);
+        item->setText(2, g.result);
+        if (g.dateInt > 0) {
+            item->setText(3, pgnDate(g.dateInt));
+        }
+        item->setText(4, QString::number(g.ply));
+        item->setTextAlignment(4, Qt::AlignRight | Qt::AlignVCenter);
     }
-    return startFen_;
+}
+
+void GameViewerDialog::onExplorerGamesReady(quint64 posHash) {
+    if (refQuery_ && posHash == explorerHash_) {
+        updateGames();
+    }
+}
+
+QString GameViewerDialog::currentFen() const {
+    return QString::fromStdString(tree_.fen(currentPly_));
 }
 
 QString GameViewerDialog::opponentHint() const {
@@ -219,32 +422,32 @@ void GameViewerDialog::onMoveSelectionChanged() {
     if (ignoreSelection_) {
         return;
     }
-    const int row = movesList_ ? movesList_->currentRow() : -1;
-    if (row < 0) {
-        setCurrentPly(-1);
+    const QListWidgetItem* item = movesList_ ? movesList_->currentItem() : nullptr;
+    if (!item) {
+        setCurrentPly(GameTree::kRoot);
         return;
     }
-    setCurrentPly(row);
+    setCurrentPly(static_cast<GameTree::PlyId>(item->data(Qt::UserRole).toUInt()));
 }
 
 void GameViewerDialog::onFirstClicked() {
-    setCurrentPly(-1);
+    setCurrentPly(GameTree::kRoot);
 }
 
 void GameViewerDialog::onPrevClicked() {
-    setCurrentPly(currentPly_ - 1);
+    setCurrentPly(tree_.parent(currentPly_));
 }
 
+// Next and last follow the line of the shown ply, variation or not.
 void GameViewerDialog::onNextClicked() {
-    setCurrentPly(currentPly_ + 1);
+    const GameTree::PlyId next = tree_.firstChild(currentPly_);
+    if (next != GameTree::kNone) {
+        setCurrentPly(next);
+    }
 }
 
 void GameViewerDialog::onLastClicked() {
-    if (plies_.empty()) {
-        setCurrentPly(-1);
-        return;
-    }
-    setCurrentPly(static_cast<int>(plies_.size()) - 1);
+    setCurrentPly(tree_.lineEnd(currentPly_));
 }
 
 void GameViewerDialog::onAnalyzeClicked() {
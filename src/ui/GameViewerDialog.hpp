@@ -3,20 +3,25 @@
 #include <QDialog>
 #include <QString>
 
+#include "domain/domain_model.hpp"
+#include "domain/game_tree.hpp"
+
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
-namespace sf::client::domain::chess {
-struct FenTimelineResult;
-} // namespace sf::client::domain::chess
-
 QT_BEGIN_NAMESPACE
 class QListWidget;
 class QLabel;
 class QPushButton;
+class QTreeWidget;
 QT_END_NAMESPACE
 
+namespace sf::client::infra::refdb {
+class ReferenceDbQuery;
+}
+
 namespace sf::client::ui {
 
 class BoardWidget;
@@ -38,11 +43,18 @@ public:
 
     explicit GameViewerDialog(QWidget* parent = nullptr);
 
-    // Loads a ready-made SAN timeline into the viewer.
-    // Start position is meta.startFen if provided, otherwise timeline.startFen.
-    bool setGame(const Meta& meta,
-                 const sf::client::domain::chess::FenTimelineResult& timeline,
-                 QString* outError = nullptr);
+    // Loads a parsed game with its variations (GameTree::fromMovetext);
+    // FENs are built only for the shown ply.
+    void setGame(const Meta& meta, sf::client::domain::chess::GameTree tree);
+
+    // Engine result for a position (job FEN): kept in the tree if the game
+    // reaches that position and shown while one of its plies is.
+    void mergeEngineResult(const std::string& fen, const sf::client::domain::JobSnapshot& snapshot);
+
+    // Optional opening explorer (moves played from the shown position and
+    // the games that reach it).
+    // The query service is shared and must outlive the dialog.
+    void setReferenceQuery(sf::client::infra::refdb::ReferenceDbQuery* query);
 
 signals:
     // Requests analysis of the currently selected position.
@@ -55,26 +67,26 @@ private slots:
     void onNextClicked();
     void onLastClicked();
     void onAnalyzeClicked();
+    void onExplorerPositionReady(quint64 posHash);
+    void onExplorerGamesReady(quint64 posHash);
 
 private:
-    struct Ply {
-        int plyIndex{0};
-        std::string san;
-        std::string uci;
-        std::string fenAfter;
-        std::uint64_t posHashBefore{0};
-    };
-
     void setupUi();
     void rebuildMovesList();
-    void setCurrentPly(int plyIndex); // -1=start
+    void appendLine(sf::client::domain::chess::GameTree::PlyId first, int indent);
+    void setCurrentPly(sf::client::domain::chess::GameTree::PlyId ply);
     QString currentFen() const;
+    std::uint64_t currentPosHash() const;
+    void updateExplorer();
+    void updateGames();
+    void updateNotes();
     QString opponentHint() const;
 
 private:
     BoardWidget* boardWidget_{nullptr};
     QListWidget* movesList_{nullptr};
     QLabel* headerLabel_{nullptr};
+    QLabel* notesLabel_{nullptr}; // comment and engine result of the shown ply
 
     QPushButton* firstBtn_{nullptr};
     QPushButton* prevBtn_{nullptr};
@@ -82,11 +94,19 @@ private:
     QPushButton* lastBtn_{nullptr};
     QPushButton* analyzeBtn_{nullptr};
 
+    QTreeWidget* explorerTree_{nullptr};
+    QLabel* explorerStatus_{nullptr};
+    QTreeWidget* gamesTree_{nullptr};
+    sf::client::infra::refdb::ReferenceDbQuery* refQuery_{nullptr};
+    std::uint64_t explorerHash_{0};
+    std::optional<std::uint64_t> gamesRequested_; // games list asked for ...
+    std::optional<std::uint64_t> gamesShown_;     // ... and the one shown
+
     Meta meta_;
-    QString startFen_;
-    std::vector<Ply> plies_;
+    sf::client::domain::chess::GameTree tree_;
+    std::vector<int> rowOfPly_; // moves list row per ply id, -1 for the root
 
-    int currentPly_{-1};
+    sf::client::domain::chess::GameTree::PlyId currentPly_{sf::client::domain::chess::GameTree::kRoot};
     bool ignoreSelection_{false};
 };
 
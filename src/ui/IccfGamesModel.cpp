@@ -2,6 +2,8 @@
 
 #include <QVariant>
 
+#include <algorithm>
+
 namespace sf::client::ui {
 
 IccfGamesModel::IccfGamesModel(QObject* parent)
@@ -14,6 +16,64 @@ void IccfGamesModel::setGames(QVector<sf::client::infra::iccf::IccfGame> games)
     endResetModel();
 }
 
+void IccfGamesModel::applyDelta(const sf::client::app::IccfGamesDelta& delta) {
+    if (games_.isEmpty()) {
+        QVector<sf::client::infra::iccf::IccfGame> games = delta.added;
+        games += delta.changed;
+        std::sort(games.begin(), games.end(), sf::client::app::iccfGameBefore);
+        setGames(std::move(games));
+        return;
+    }
+
+    for (const int id : delta.removedIds) {
+        const int row = rowOfId(id);
+        if (row < 0) continue;
+        beginRemoveRows(QModelIndex(), row, row);
+        games_.removeAt(row);
+        endRemoveRows();
+    }
+    for (const auto& g : delta.changed) upsert(g);
+    for (const auto& g : delta.added) upsert(g);
+}
+
+int IccfGamesModel::rowOfId(int id) const {
+    // Rows are sorted, but by turn first; a scan over a few hundred ids
+    // is cheaper than keeping an index in step.
+    for (int row = 0; row < games_.size(); ++row) {
+        if (games_[row].id == id) return row;
+    }
+    return -1;
+}
+
+int IccfGamesModel::sortedRowFor(const sf::client::infra::iccf::IccfGame& g, int skip) const {
+    int row = 0;
+    for (int i = 0; i < games_.size(); ++i) {
+        if (i != skip && sf::client::app::iccfGameBefore(games_[i], g)) ++row;
+    }
+    return row;
+}
+
+void IccfGamesModel::upsert(const sf::client::infra::iccf::IccfGame& g) {
+    const int row = rowOfId(g.id);
+    if (row < 0) {
+        const int at = sortedRowFor(g);
+        beginInsertRows(QModelIndex(), at, at);
+        games_.insert(at, g);
+        endInsertRows();
+        return;
+    }
+
+    const int to = sortedRowFor(g, row);
+    if (to != row) {
+        // beginMoveRows() wants the destination counted before the move.
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), to > row ? to + 1 : to);
+        games_.move(row, to);
+        endMoveRows();
+    }
+    games_[to] = g;
+    emit dataChanged(index(to, 0), index(to, ColumnCount - 1));
+}
+
 const sf::client::infra::iccf::IccfGame* IccfGamesModel::gameAt(int row) const {
     if (row < 0 || row >= games_.size()) return nullptr;
     return &games_[row];
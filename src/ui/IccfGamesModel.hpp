@@ -2,6 +2,7 @@
 
 #include <QAbstractTableModel>
 
+#include "app/IccfGameCache.hpp"
 #include "infra/iccf/IccfModels.hpp"
 
 namespace sf::client::ui {
@@ -25,6 +26,9 @@ public:
     explicit IccfGamesModel(QObject* parent = nullptr);
 
     void setGames(QVector<sf::client::infra::iccf::IccfGame> games);
+    // Row-level inserts, moves and updates; rows stay in iccfGameBefore()
+    // order. An empty model is reset in one go instead.
+    void applyDelta(const sf::client::app::IccfGamesDelta& delta);
     const sf::client::infra::iccf::IccfGame* gameAt(int row) const;
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -33,6 +37,11 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
 
 private:
+    int rowOfId(int id) const;
+    // Row where g belongs, ignoring the row at skip.
+    int sortedRowFor(const sf::client::infra::iccf::IccfGame& g, int skip = -1) const;
+    void upsert(const sf::client::infra::iccf::IccfGame& g);
+
     QVector<sf::client::infra::iccf::IccfGame> games_;
 };
 
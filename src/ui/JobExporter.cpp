@@ -2,19 +2,24 @@
 #include "ui/UiFormatters.hpp"
 
 #include <QDateTime>
+#include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTextStream>
 #include <QTimeZone>
 
+#include <unordered_set>
+
 namespace sf::client::ui {
 
 using sf::client::domain::Job;
 
 namespace {
 
-QJsonObject jobToJsonObject(const Job& job) {
+constexpr int kProgressEveryJobs = 100;
+
+QJsonObject jobToJsonObject(const Job& job, bool includeLogs) {
     QJsonObject o;
     o.insert(QStringLiteral("id"), QString::fromStdString(job.id));
     o.insert(QStringLiteral("opponent"), QString::fromStdString(job.opponent));
@@ -49,16 +54,18 @@ QJsonObject jobToJsonObject(const Job& job) {
         snap.insert(QStringLiteral("bestmove"), QString::fromStdString(job.snapshot.bestMove));
     }
     if (!job.snapshot.pv.empty()) {
-        snap.insert(QStringLiteral("pv"), QString::fromStdString(job.snapshot.pv));
+        snap.insert(QStringLiteral("pv"), QString::fromStdString(job.snapshot.pv.toUci()));
     }
     o.insert(QStringLiteral("snapshot"), snap);
 
     // log
-    QJsonArray logArr;
-    for (const auto& line : job.logLines) {
-        logArr.append(QString::fromStdString(line));
+    if (includeLogs) {
+        QJsonArray logArr;
+        for (const auto& line : job.logLines) {
+            logArr.append(QString::fromStdString(line));
+        }
+        o.insert(QStringLiteral("log"), logArr);
     }
-    o.insert(QStringLiteral("log"), logArr);
 
     return o;
 }
@@ -89,28 +96,149 @@ void appendJobPgn(QTextStream& out, const Job& job) {
         out << ", bestmove " << QString::fromStdString(job.snapshot.bestMove);
     }
     if (!job.snapshot.pv.empty()) {
-        out << ", pv " << QString::fromStdString(job.snapshot.pv);
+        out << ", pv " << QString::fromStdString(job.snapshot.pv.toUci());
     }
     out << " }\n\n";
 }
 
+// One output file in one format; jobs are encoded and written as they come.
+class JobStreamWriter {
+public:
+    JobStreamWriter(QFile& file, const ExportOptions& options)
+        : file_(file)
+        , options_(options)
+        , text_(&file) {}
+
+    void begin() {
+        if (options_.format == ExportFormat::Json) {
+            file_.write("[\n");
+        }
+    }
+
+    void write(const Job& job) {
+        switch (options_.format) {
+            case ExportFormat::Json: {
+                if (written_ > 0) {
+                    file_.write(",\n");
+                }
+                QByteArray bytes = QJsonDocument(jobToJsonObject(job, options_.includeLogs)).toJson(QJsonDocument::Indented);
+                bytes.chop(1); // trailing newline
+                file_.write(bytes);
+                break;
+            }
+            case ExportFormat::JsonLines:
+                file_.write(QJsonDocument(jobToJsonObject(job, options_.includeLogs)).toJson(QJsonDocument::Compact));
+                file_.write("\n");
+                break;
+            case ExportFormat::Pgn:
+                appendJobPgn(text_, job);
+                break;
+        }
+        ++written_;
+    }
+
+    void end() {
+        if (options_.format == ExportFormat::Json) {
+            file_.write(written_ > 0 ? "\n]\n" : "]\n");
+        }
+        text_.flush();
+    }
+
+    int written() const noexcept { return written_; }
+
+private:
+    QFile&               file_;
+    const ExportOptions& options_;
+    QTextStream          text_; // PGN only
+    int                  written_{0};
+};
+
 } // namespace
 
-QJsonDocument JobExporter::toJson(const std::vector<Job>& jobs) {
-    QJsonArray arr;
-    for (const auto& job : jobs) {
-        arr.append(jobToJsonObject(job));
+ExportResult JobExporter::run(const ExportOptions& options,
+                              const sf::client::app::IHistoryRepository* history,
+                              const std::vector<Job>& liveJobs,
+                              const std::atomic<bool>& cancel,
+                              const ProgressCallback& onProgress) {
+    ExportResult result;
+
+    QFile file(options.path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    JobStreamWriter writer(file, options);
+    writer.begin();
+
+    // Saved jobs win over their live copies, as in the history view.
+    std::unordered_set<std::string> liveIds;
+    liveIds.reserve(liveJobs.size());
+    for (const auto& job : liveJobs) {
+        liveIds.insert(job.id);
+    }
+
+    ExportProgress progress;
+    progress.jobsTotal = static_cast<int>(liveJobs.size());
+    const auto report = [&] {
+        progress.jobsWritten = writer.written();
+        if (onProgress) {
+            onProgress(progress);
+        }
+    };
+    const auto writeOne = [&](const Job& job) {
+        writer.write(job);
+        if (writer.written() % kProgressEveryJobs == 0) {
+            report();
+        }
+        return !cancel.load(std::memory_order_relaxed) && file.error() == QFileDevice::NoError;
+    };
+
+    bool keepGoing = true;
+    if (history) {
+        const bool withLogs = options.includeLogs && options.format != ExportFormat::Pgn;
+        int liveSaved = 0;
+        history->scanJobs(withLogs, [&](const Job& job, int total) {
+            liveSaved += static_cast<int>(liveIds.erase(job.id));
+            progress.jobsTotal = total + static_cast<int>(liveJobs.size()) - liveSaved;
+            keepGoing = writeOne(job);
+            return keepGoing;
+        });
+    }
+
+    for (const auto& job : liveJobs) {
+        if (!keepGoing) {
+            break;
+        }
+        if (liveIds.count(job.id) == 0) {
+            continue; // already written from history (or a duplicate)
+        }
+        liveIds.erase(job.id);
+        keepGoing = writeOne(job);
+    }
+
+    writer.end();
+    report();
+
+    result.jobsWritten = writer.written();
+    result.cancelled   = cancel.load();
+    if (!file.flush() || file.error() != QFileDevice::NoError) {
+        result.error = file.errorString();
+        return result;
     }
-    return QJsonDocument(arr);
+    file.close();
+    result.ok = !result.cancelled;
+    return result;
 }
 
-QString JobExporter::toPgn(const std::vector<Job>& jobs) {
-    QString outStr;
-    QTextStream out(&outStr);
-    for (const auto& job : jobs) {
-        appendJobPgn(out, job);
+Job JobExporter::detachedForExport(const Job& job, bool withLogs) {
+    Job copy = job;
+    // JobLog copies share one ring; give the copy its own (or none).
+    copy.logLines = sf::client::domain::JobLog();
+    if (withLogs) {
+        copy.logLines.assign(std::vector<std::string>(job.logLines.begin(), job.logLines.end()));
     }
-    return outStr;
+    return copy;
 }
 
 } // namespace sf::client::ui
@@ -1,17 +1,57 @@
 #pragma once
 
-#include <QJsonDocument>
 #include <QString>
+#include <atomic>
+#include <functional>
 #include <vector>
 
+#include "app/IHistoryRepository.hpp"
 #include "domain/domain_model.hpp"
 
 namespace sf::client::ui {
 
+enum class ExportFormat {
+    Json,      // one JSON array
+    JsonLines, // one JSON object per line
+    Pgn,
+};
+
+struct ExportOptions {
+    QString      path;
+    ExportFormat format{ExportFormat::Json};
+    bool         includeLogs{true}; // JSON formats only
+};
+
+struct ExportProgress {
+    int jobsWritten{0};
+    int jobsTotal{0};
+};
+
+struct ExportResult {
+    bool    ok{false};
+    bool    cancelled{false};
+    int     jobsWritten{0};
+    QString error;
+};
+
+// Writes jobs to a file one at a time, so memory use does not grow with the
+// history: saved jobs are streamed from the history store (newest first),
+// followed by live jobs that are not saved yet.
 class JobExporter final {
 public:
-    static QJsonDocument toJson(const std::vector<sf::client::domain::Job>& jobs);
-    static QString       toPgn(const std::vector<sf::client::domain::Job>& jobs);
+    using ProgressCallback = std::function<void(const ExportProgress&)>;
+
+    // Blocking; meant for a worker thread. history may be null. liveJobs
+    // must not share logs with jobs the GUI thread keeps changing (see
+    // detachedForExport). A cancelled export leaves a truncated file.
+    static ExportResult run(const ExportOptions& options,
+                            const sf::client::app::IHistoryRepository* history,
+                            const std::vector<sf::client::domain::Job>& liveJobs,
+                            const std::atomic<bool>& cancel,
+                            const ProgressCallback& onProgress);
+
+    // Copy of a live job that is safe to hand to run() on another thread.
+    static sf::client::domain::Job detachedForExport(const sf::client::domain::Job& job, bool withLogs);
 
 private:
     JobExporter() = delete;
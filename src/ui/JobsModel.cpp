@@ -5,92 +5,161 @@
 
 namespace sf::client::ui {
 
-using sf::client::domain::Job;
+using sf::client::app::JobSummaryStore;
+using sf::client::app::JobSummaryStoreListener;
 using sf::client::domain::JobId;
+using sf::client::domain::Score;
 using sf::client::domain::ScoreType;
 
-JobsModel::JobsModel(QObject* parent)
-    : QAbstractTableModel(parent) {
+namespace {
+
+// Mate for the side to move sorts above any centipawn score, sooner mates
+// higher; no score sorts below everything.
+qint64 scoreSortKey(const Score& score) {
+    constexpr qint64 kMate = 1'000'000;
+    switch (score.type) {
+        case ScoreType::Cp:
+            return score.value;
+        case ScoreType::Mate:
+            return score.value > 0 ? kMate - score.value : -kMate - score.value;
+        default:
+            return -2 * kMate;
+    }
 }
 
-void JobsModel::setJobs(const std::vector<Job>& jobs) {
-    beginResetModel();
-    jobs_ = jobs;
-    endResetModel();
+} // namespace
+
+JobsModel::JobsModel(JobSummaryStore& store, QObject* parent)
+    : QAbstractTableModel(parent)
+    , store_(store) {
+    JobSummaryStoreListener listener;
+    listener.rowsAboutToBeInserted = [this](int first, int last) {
+        beginInsertRows(QModelIndex(), first, last);
+    };
+    listener.rowsInserted = [this] { endInsertRows(); };
+    listener.rowChanged = [this](int row) {
+        emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    };
+    listener.rowAboutToBeRemoved = [this](int row) {
+        beginRemoveRows(QModelIndex(), row, row);
+    };
+    listener.rowRemoved = [this] { endRemoveRows(); };
+    store_.setListener(std::move(listener));
 }
 
-void JobsModel::upsertJob(const Job& job) {
-    for (int row = 0; row < static_cast<int>(jobs_.size()); ++row) {
-        if (jobs_[row].id == job.id) {
-            jobs_[row] = job;
-            const QModelIndex topLeft     = index(row, 0);
-            const QModelIndex bottomRight = index(row, ColumnCount - 1);
-            emit dataChanged(topLeft, bottomRight);
-            return;
-        }
-    }
+JobsModel::~JobsModel() {
+    store_.setListener({});
+}
 
-    const int newRow = static_cast<int>(jobs_.size());
-    beginInsertRows(QModelIndex(), newRow, newRow);
-    jobs_.push_back(job);
-    endInsertRows();
+void JobsModel::setHistorySource(const sf::client::app::IHistoryRepository* history) {
+    history_ = history;
+    historyCursor_.reset();
+    historyDone_ = (history_ == nullptr);
 }
 
-void JobsModel::removeJob(const JobId& id) {
-    for (int row = 0; row < static_cast<int>(jobs_.size()); ++row) {
-        if (jobs_[row].id == id) {
-            beginRemoveRows(QModelIndex(), row, row);
-            jobs_.erase(jobs_.begin() + row);
-            endRemoveRows();
-            return;
-        }
+bool JobsModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && !historyDone_;
+}
+
+void JobsModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid() || historyDone_ || !history_) {
+        return;
     }
+
+    const auto page = history_->loadJobsPage(historyCursor_, kHistoryPageSize);
+    historyCursor_ = page.next;
+    historyDone_ = !page.next.has_value();
+
+    // Rows already shown (a live job that is also in history) stay where they are.
+    store_.appendNew(page.jobs);
 }
 
 int JobsModel::rowCount(const QModelIndex& parent) const {
-    return parent.isValid() ? 0 : static_cast<int>(jobs_.size());
+    return parent.isValid() ? 0 : store_.size();
 }
 
 int JobsModel::columnCount(const QModelIndex& parent) const {
     return parent.isValid() ? 0 : ColumnCount;
 }
 
-QVariant JobsModel::displayData(const Job& job, Column col) const {
+QVariant JobsModel::displayData(int row, Column col) const {
     switch (col) {
         case ColId:
-            return QString::fromStdString(job.id);
+            return QString::fromStdString(store_.id(row));
 
         case ColOpponent:
-            return QString::fromStdString(job.opponent);
+            return QString::fromStdString(store_.opponent(row));
 
-        case ColServer:
-            return job.assignedServer ? QString::fromStdString(*job.assignedServer) : QStringLiteral("-");
+        case ColServer: {
+            const auto& server = store_.server(row);
+            return server.empty() ? QStringLiteral("-") : QString::fromStdString(server);
+        }
 
-        case ColStatus:
-            return QString::fromStdString(sf::client::domain::to_string(job.status));
+        case ColStatus: {
+            const QString status = QString::fromStdString(sf::client::domain::to_string(store_.status(row)));
+            if (const int total = store_.batchTotal(row); total > 0) {
+                return QStringLiteral("%1 (%2/%3)").arg(status).arg(store_.batchDone(row)).arg(total);
+            }
+            return status;
+        }
+
+        case ColPriority:
+            return store_.priority(row);
 
         case ColDepth:
-            return job.snapshot.depth ? QVariant(*job.snapshot.depth) : QVariant();
+            if (const auto depth = store_.depth(row)) {
+                return *depth;
+            }
+            return {};
 
-        case ColEval:
-            if (job.snapshot.score.type != ScoreType::None) {
-                return QString::fromStdString(sf::client::domain::to_string(job.snapshot.score));
+        case ColEval: {
+            const Score score = store_.score(row);
+            if (score.type != ScoreType::None) {
+                return QString::fromStdString(sf::client::domain::to_string(score));
+            }
+            return {};
+        }
+
+        case ColNodes:
+            if (const auto nodes = store_.nodes(row)) {
+                return static_cast<qlonglong>(*nodes);
             }
             return {};
 
         case ColLastUpdate:
-            return sf::client::ui::fmt::formatLocalIso(job.lastUpdateAt);
+            return sf::client::ui::fmt::formatLocalIso(store_.lastUpdateAt(row));
 
         default:
             return {};
     }
 }
 
+QVariant JobsModel::sortData(int row, Column col) const {
+    switch (col) {
+        case ColStatus:
+            return static_cast<int>(store_.status(row));
+        case ColPriority:
+            return store_.priority(row);
+        case ColDepth:
+            return store_.depth(row).value_or(-1);
+        case ColEval:
+            return scoreSortKey(store_.score(row));
+        case ColNodes:
+            return static_cast<qlonglong>(store_.nodes(row).value_or(-1));
+        case ColLastUpdate:
+            return sf::client::ui::fmt::toUnixMs(store_.lastUpdateAt(row));
+        default:
+            return displayData(row, col);
+    }
+}
+
 QVariant JobsModel::alignmentData(Column col) const {
     // Make numeric columns easier to read.
     switch (col) {
+        case ColPriority:
         case ColDepth:
         case ColEval:
+        case ColNodes:
             return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
         default:
             return static_cast<int>(Qt::AlignLeft | Qt::AlignVCenter);
@@ -103,23 +172,26 @@ QVariant JobsModel::data(const QModelIndex& index, int role) const {
     }
 
     const int row = index.row();
-    const int col = index.column();
+    const auto col = static_cast<Column>(index.column());
 
-    if (row < 0 || row >= static_cast<int>(jobs_.size())) {
+    if (row < 0 || row >= store_.size()) {
         return {};
     }
 
-    const Job& job = jobs_[row];
-
-    if (role == Qt::DisplayRole) {
-        return displayData(job, static_cast<Column>(col));
-    }
-
-    if (role == Qt::TextAlignmentRole) {
-        return alignmentData(static_cast<Column>(col));
+    switch (role) {
+        case Qt::DisplayRole:
+            return displayData(row, col);
+        case Qt::TextAlignmentRole:
+            return alignmentData(col);
+        case SortRole:
+            return sortData(row, col);
+        case FilterRole:
+            return QString::fromStdString(store_.id(row) + ' ' + store_.opponent(row) + ' '
+                                          + store_.server(row) + ' '
+                                          + sf::client::domain::to_string(store_.status(row)));
+        default:
+            return {};
     }
-
-    return {};
 }
 
 QVariant JobsModel::headerData(int section, Qt::Orientation orientation, int role) const {
@@ -133,10 +205,14 @@ QVariant JobsModel::headerData(int section, Qt::Orientation orientation, int rol
                 return QStringLiteral("Server");
             case ColStatus:
                 return QStringLiteral("Status");
+            case ColPriority:
+                return QStringLiteral("Priority");
             case ColDepth:
                 return QStringLiteral("Depth");
             case ColEval:
                 return QStringLiteral("Eval");
+            case ColNodes:
+                return QStringLiteral("Nodes");
             case ColLastUpdate:
                 return QStringLiteral("Last update");
             default:
@@ -146,11 +222,15 @@ QVariant JobsModel::headerData(int section, Qt::Orientation orientation, int rol
     return QAbstractTableModel::headerData(section, orientation, role);
 }
 
-std::optional<Job> JobsModel::jobAtRow(int row) const {
-    if (row < 0 || row >= static_cast<int>(jobs_.size())) {
+std::optional<JobId> JobsModel::jobIdAtRow(int row) const {
+    if (row < 0 || row >= store_.size()) {
         return std::nullopt;
     }
-    return jobs_[row];
+    return store_.id(row);
+}
+
+std::optional<int> JobsModel::rowOf(const JobId& id) const {
+    return store_.rowOf(id);
 }
 
 } // namespace sf::client::ui
@@ -2,44 +2,70 @@
 
 #include <QAbstractTableModel>
 #include <optional>
-#include <vector>
 
+#include "app/IHistoryRepository.hpp"
+#include "app/JobSummaryStore.hpp"
 #include "domain/domain_model.hpp"
 
 namespace sf::client::ui {
 
+// Read-only view onto the app layer's JobSummaryStore: rows are the store's
+// rows (live jobs as they arrive, history pages behind them) and cells are
+// formatted only when the view asks for them, i.e. for visible rows.
+//
+// History is pulled a page at a time as the view scrolls (canFetchMore /
+// fetchMore). Put a QSortFilterProxyModel on top for ordering and
+// filtering; it should sort on SortRole and filter on FilterRole.
 class JobsModel : public QAbstractTableModel {
     Q_OBJECT
 public:
-    explicit JobsModel(QObject* parent = nullptr);
-
-    void setJobs(const std::vector<sf::client::domain::Job>& jobs);
-    void upsertJob(const sf::client::domain::Job& job);
-    void removeJob(const sf::client::domain::JobId& id);
-
-    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
-    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
-    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
-    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
-
-    std::optional<sf::client::domain::Job> jobAtRow(int row) const;
-
-private:
     enum Column {
         ColId = 0,
         ColOpponent,
         ColServer,
         ColStatus,
+        ColPriority,
         ColDepth,
         ColEval,
+        ColNodes,
         ColLastUpdate,
         ColumnCount
     };
 
-    QVariant displayData(const sf::client::domain::Job& job, Column col) const;
+    static constexpr int kHistoryPageSize = 200;
+
+    // Raw value for ordering (numbers stay numbers, mates beat centipawns).
+    static constexpr int SortRole   = Qt::UserRole;
+    // Id, opponent, server and status in one string.
+    static constexpr int FilterRole = Qt::UserRole + 1;
+
+    explicit JobsModel(sf::client::app::JobSummaryStore& store, QObject* parent = nullptr);
+    ~JobsModel() override;
+
+    // Starts paging history from the newest job; nullptr = live jobs only.
+    void setHistorySource(const sf::client::app::IHistoryRepository* history);
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    std::optional<sf::client::domain::JobId> jobIdAtRow(int row) const;
+    std::optional<int> rowOf(const sf::client::domain::JobId& id) const;
+
+private:
+    QVariant displayData(int row, Column col) const;
+    QVariant sortData(int row, Column col) const;
     QVariant alignmentData(Column col) const;
 
-    std::vector<sf::client::domain::Job> jobs_;
+    sf::client::app::JobSummaryStore&            store_;
+
+    const sf::client::app::IHistoryRepository*  history_{nullptr};
+    std::optional<sf::client::app::HistoryCursor> historyCursor_;
+    bool                                         historyDone_{true};
 };
 
 } // namespace sf::client::ui
@@ -1,19 +1,27 @@
 #include "ui/MainWindow.hpp"
 
 #include "app/IHistoryRepository.hpp"
+#include "app/IccfAnalysisPipeline.hpp"
 #include "app/IccfSyncManager.hpp"
+#include "infra/refdb/OpeningTreeFile.hpp"
+#include "infra/refdb/ReferenceDbImporter.hpp"
+#include "infra/refdb/ReferenceDbQuery.hpp"
+#include "infra/trace/Trace.hpp"
 
 #include <algorithm>
-#include <unordered_set>
+#include <limits>
 
 #include <QAction>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QDateTime>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFormLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
+#include <QInputDialog>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -21,8 +29,10 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QPlainTextEdit>
+#include <QProgressDialog>
 #include <QOverload>
 #include <QSignalBlocker>
+#include <QSortFilterProxyModel>
 #include <QPushButton>
 #include <QSpinBox>
 #include <QSplitter>
@@ -32,16 +42,19 @@
 #include <QTabWidget>
 #include <QTextCursor>
 #include <QTextStream>
+#include <QThread>
 #include <QStringConverter>
 #include <QTimer>
 #include <QVBoxLayout>
 
 #include "domain/domain_model.hpp"
 #include "domain/chess_san_to_fen.hpp"
+#include "domain/game_tree.hpp"
 #include "domain/pgn/PgnParser.hpp"
 #include "ui/BoardWidget.hpp"
 #include "ui/GameViewerDialog.hpp"
 #include "ui/JobExporter.hpp"
+#include "ui/MemoryDiagnosticsDialog.hpp"
 #include <QTimeZone>
 
 namespace sf::client::ui {
@@ -50,6 +63,29 @@ using sf::client::domain::Job;
 using sf::client::domain::LimitType;
 using sf::client::domain::SearchLimit;
 
+namespace {
+
+// The game's moves with their variations, from startFen if it is set.
+std::optional<sf::client::domain::chess::GameTree> parseGameTree(const std::string& movetext,
+                                                                 const QString& startFen,
+                                                                 QString* error) {
+    using sf::client::domain::chess::Position;
+    const auto start = startFen.isEmpty() ? std::optional<Position>(Position::startpos())
+                                          : Position::fromFen(startFen.toStdString());
+    if (!start) {
+        *error = QObject::tr("Invalid start FEN: %1").arg(startFen);
+        return std::nullopt;
+    }
+    std::string err;
+    auto tree = sf::client::domain::chess::GameTree::fromMovetext(movetext, *start, &err);
+    if (!tree) {
+        *error = QString::fromStdString(err);
+    }
+    return tree;
+}
+
+} // namespace
+
 MainWindow::MainWindow(sf::client::app::JobManager& jobManager,
                        sf::client::app::ServerManager& serverManager,
                        sf::client::app::IHistoryRepository* historyRepo,
@@ -62,17 +98,31 @@ MainWindow::MainWindow(sf::client::app::JobManager& jobManager,
                        sf::client::app::IccfSyncManager* iccfSync,
                        QWidget* parent)
     : QMainWindow(parent)
-    , jobsModel_(this)
+    , jobsModel_(jobManager.summaries(), this)
     , serversModel_(this)
     , iccfGamesModel_(this)
+    , pvLinesModel_(this)
     , jobManager_(jobManager)
     , serverManager_(serverManager)
     , historyRepo_(historyRepo)
     , iccfSync_(iccfSync) {
+    refDbQuery_ = new sf::client::infra::refdb::ReferenceDbQuery(this);
+    connect(refDbQuery_, &sf::client::infra::refdb::ReferenceDbQuery::opened,
+            this, [this](const QString& path) {
+                statusBar()->showMessage(tr("Reference index: %1").arg(path), 5000);
+            });
+    connect(refDbQuery_, &sf::client::infra::refdb::ReferenceDbQuery::failed,
+            this, [this](const QString& message) {
+                QMessageBox::warning(this, tr("Reference index"), message);
+            });
+
     setupUi();
     setupConnections();
     refreshServersTable();
 
+    // History rows are paged in by the jobs view as it scrolls.
+    jobsModel_.setHistorySource(historyRepo_);
+
     // Periodic refresh so server_status updates are reflected in UI.
     serversRefreshTimer_ = new QTimer(this);
     serversRefreshTimer_->setInterval(1000);
@@ -81,7 +131,16 @@ MainWindow::MainWindow(sf::client::app::JobManager& jobManager,
     serversRefreshTimer_->start();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow() {
+    if (refIndexThread_) {
+        refIndexCancel_->store(true);
+        refIndexThread_->wait();
+    }
+    if (exportThread_) {
+        exportCancel_->store(true);
+        exportThread_->wait();
+    }
+}
 
 void MainWindow::setupUi() {
     resize(1200, 700);
@@ -106,6 +165,18 @@ void MainWindow::setupMenu() {
     connect(openPgnAction, &QAction::triggered,
             this, &MainWindow::openPgnFile);
 
+    auto* batchPgnAction = fileMenu->addAction(tr("Batch-analyze PGN..."));
+    connect(batchPgnAction, &QAction::triggered,
+            this, &MainWindow::batchAnalyzePgnFile);
+
+    auto* buildIndexAction = fileMenu->addAction(tr("Build reference index..."));
+    connect(buildIndexAction, &QAction::triggered,
+            this, &MainWindow::buildReferenceIndex);
+
+    auto* openIndexAction = fileMenu->addAction(tr("Open reference index..."));
+    connect(openIndexAction, &QAction::triggered,
+            this, &MainWindow::openReferenceIndex);
+
     fileMenu->addSeparator();
 
     auto* exportJsonAction =
@@ -117,6 +188,167 @@ void MainWindow::setupMenu() {
         fileMenu->addAction(tr("Export jobs to PGN"));
     connect(exportPgnAction, &QAction::triggered,
             this, &MainWindow::exportJobsToPgn);
+
+    auto* toolsMenu = menuBar()->addMenu(tr("&Tools"));
+
+    memoryAction_ = toolsMenu->addAction(tr("Memory usage..."));
+    memoryAction_->setEnabled(false); // until setMemoryBudget()
+    connect(memoryAction_, &QAction::triggered,
+            this, &MainWindow::showMemoryDiagnostics);
+
+    if (sf::client::infra::trace::kCompiledIn) {
+        toolsMenu->addSeparator();
+        traceRecordAction_ = toolsMenu->addAction(tr("Record trace"));
+        traceRecordAction_->setCheckable(true);
+        traceRecordAction_->setChecked(sf::client::infra::trace::isRecording());
+        connect(traceRecordAction_, &QAction::toggled, this, [this](bool on) {
+            sf::client::infra::trace::setRecording(on);
+            statusBar()->showMessage(on ? tr("Trace recording started") : tr("Trace recording stopped"), 3000);
+        });
+
+        auto* saveTraceAction = toolsMenu->addAction(tr("Save trace..."));
+        connect(saveTraceAction, &QAction::triggered,
+                this, &MainWindow::saveTrace);
+    }
+}
+
+void MainWindow::saveTrace() {
+    namespace trace = sf::client::infra::trace;
+
+    if (trace::bufferedSpanCount() == 0) {
+        QMessageBox::information(this, tr("Save trace"),
+                                 tr("No trace spans recorded yet. Use Tools > Record trace first."));
+        return;
+    }
+
+    // Stop first so the ring buffers do not wrap under the dump.
+    traceRecordAction_->setChecked(false);
+
+    const QString defaultName =
+        QStringLiteral("corrchess-trace-%1.json")
+            .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")));
+    const QString path = QFileDialog::getSaveFileName(
+        this, tr("Save trace"), defaultName, tr("Chrome trace (*.json);;All files (*.*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    std::string error;
+    if (!trace::writeChromeTrace(QFile::encodeName(path).toStdString(), &error)) {
+        QMessageBox::warning(this, tr("Save trace"),
+                             tr("Failed to write trace:\n%1").arg(QString::fromStdString(error)));
+        return;
+    }
+    statusBar()->showMessage(
+        tr("Trace saved to %1 (open in chrome://tracing or ui.perfetto.dev)").arg(path), 8000);
+}
+
+void MainWindow::buildReferenceIndex() {
+    using sf::client::infra::refdb::ImportOptions;
+    using sf::client::infra::refdb::ImportProgress;
+    using sf::client::infra::refdb::ImportResult;
+    using sf::client::infra::refdb::ReferenceDbImporter;
+
+    if (refIndexThread_) {
+        QMessageBox::information(this, tr("Build reference index"),
+                                 tr("An import is already running."));
+        return;
+    }
+
+    const QString pgnPath = QFileDialog::getOpenFileName(
+        this,
+        tr("Build reference index"),
+        QString(),
+        tr("PGN files (*.pgn *.PGN);;All files (*.*)"));
+    if (pgnPath.isEmpty()) {
+        return;
+    }
+
+    ImportOptions options;
+    options.pgnPath = pgnPath;
+    options.dbPath = pgnPath + QStringLiteral(".refdb");
+    if (QMessageBox::question(
+            this, tr("Build reference index"),
+            tr("Also write a compact opening tree file (.cctree) for fast lookups?"))
+        == QMessageBox::Yes) {
+        options.openingTreePath = pgnPath + QLatin1String(sf::client::infra::refdb::kOpeningTreeSuffix);
+    }
+
+    auto* progress = new QProgressDialog(
+        tr("Indexing %1...").arg(QFileInfo(pgnPath).fileName()),
+        tr("Cancel"), 0, 1000, this);
+    progress->setWindowTitle(tr("Build reference index"));
+    progress->setMinimumDuration(0);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    progress->setValue(0);
+
+    refIndexCancel_ = std::make_shared<std::atomic<bool>>(false);
+    auto cancel = refIndexCancel_;
+    connect(progress, &QProgressDialog::canceled, this, [cancel]() {
+        cancel->store(true);
+    });
+
+    // The dialog outlives the thread (deleted in the finished handler), so
+    // queued progress updates always have a live receiver.
+    auto result = std::make_shared<ImportResult>();
+    refIndexThread_ = QThread::create([options, cancel, result, progress]() {
+        *result = ReferenceDbImporter::run(options, *cancel, [progress](const ImportProgress& p) {
+            QMetaObject::invokeMethod(progress, [progress, p]() {
+                if (p.totalBytes > 0) {
+                    progress->setValue(static_cast<int>(p.bytesProcessed * 1000 / p.totalBytes));
+                }
+                progress->setLabelText(
+                    QObject::tr("%1 games (%2 skipped)\n%3 MB/s, %4 games/s")
+                        .arg(p.gamesImported)
+                        .arg(p.gamesSkipped)
+                        .arg(p.bytesPerSecond / (1024.0 * 1024.0), 0, 'f', 1)
+                        .arg(p.gamesPerSecond, 0, 'f', 0));
+            }, Qt::QueuedConnection);
+        });
+    });
+
+    connect(refIndexThread_, &QThread::finished, this, [this, progress, result, options]() {
+        progress->close();
+        progress->deleteLater();
+        refIndexThread_->deleteLater();
+        refIndexThread_ = nullptr;
+        refIndexCancel_.reset();
+
+        if (result->cancelled) {
+            statusBar()->showMessage(
+                tr("Reference index cancelled after %1 games").arg(result->gamesImported), 5000);
+        } else if (!result->ok) {
+            QMessageBox::warning(this, tr("Build reference index"),
+                                 tr("Import failed:\n%1").arg(result->error));
+        } else {
+            const QString openPath =
+                options.openingTreePath.isEmpty() ? options.dbPath : options.openingTreePath;
+            refDbQuery_->open(openPath);
+            QMessageBox::information(
+                this, tr("Build reference index"),
+                tr("Indexed %1 games (%2 skipped, %3 plies) in %4 s.\n%5")
+                    .arg(result->gamesImported)
+                    .arg(result->gamesSkipped)
+                    .arg(result->pliesIndexed)
+                    .arg(result->seconds, 0, 'f', 1)
+                    .arg(openPath));
+        }
+    });
+
+    refIndexThread_->start();
+}
+
+void MainWindow::openReferenceIndex() {
+    const QString path = QFileDialog::getOpenFileName(
+        this,
+        tr("Open reference index"),
+        QString(),
+        tr("Reference index (*.refdb *.cctree);;All files (*.*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    refDbQuery_->open(path);
 }
 
 void MainWindow::openPgnFile() {
@@ -172,31 +404,78 @@ void MainWindow::openPgnFile() {
 
     // SetUp/FEN tags: use FEN when present.
     meta.startFen = tag("FEN");
-    std::optional<std::string> startFen;
-    if (!meta.startFen.isEmpty()) {
-        startFen = meta.startFen.toStdString();
-    }
-
-    const auto timeline = sf::client::domain::chess::fenTimelineFromSanMoves(
-        g.movetext, startFen);
-
-    auto* dlg = new GameViewerDialog(this);
-    dlg->setAttribute(Qt::WA_DeleteOnClose, true);
 
     QString err;
-    if (!dlg->setGame(meta, timeline, &err)) {
+    auto tree = parseGameTree(g.movetext, meta.startFen, &err);
+    if (!tree) {
         QMessageBox::warning(this, tr("Open PGN"),
-                             tr("Failed to build moves timeline:\n\n%1").arg(err));
-        dlg->deleteLater();
+                             tr("Failed to read the moves:\n\n%1").arg(err));
         return;
     }
 
+    auto* dlg = new GameViewerDialog(this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose, true);
+    dlg->setReferenceQuery(refDbQuery_);
+    dlg->setGame(meta, std::move(*tree));
+
     connect(dlg, &GameViewerDialog::analyzeRequested,
             this, [this](const QString& fen, const QString& opponentHint) {
                 enqueueJobWithFen(opponentHint, fen);
             });
 
-    dlg->show();
+    showGameViewer(dlg);
+}
+
+void MainWindow::batchAnalyzePgnFile() {
+    const QString path = QFileDialog::getOpenFileName(
+        this,
+        tr("Batch-analyze PGN"),
+        QString(),
+        tr("PGN files (*.pgn *.PGN);;All files (*.*)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, tr("Batch analysis"),
+                             tr("Failed to open file:\n%1").arg(path));
+        return;
+    }
+
+    QTextStream ts(&f);
+    ts.setEncoding(QStringConverter::Utf8);
+    const auto parsed = sf::client::domain::pgn::parsePgnText(ts.readAll().toStdString(),
+                                                              std::numeric_limits<int>::max());
+    if (!parsed.ok || parsed.games.empty()) {
+        QMessageBox::warning(this, tr("Batch analysis"),
+                             tr("No games found in the PGN file.\n\n%1")
+                                 .arg(QString::fromStdString(parsed.error)));
+        return;
+    }
+
+    std::vector<sf::client::app::BatchGame> games;
+    games.reserve(parsed.games.size());
+    for (std::size_t i = 0; i < parsed.games.size(); ++i) {
+        const auto& g = parsed.games[i];
+        const auto tag = [&](const char* key) {
+            const auto it = g.tags.find(key);
+            return it == g.tags.end() ? std::string() : it->second;
+        };
+
+        sf::client::app::BatchGame game;
+        game.label = tag("White") + " vs " + tag("Black");
+        if (game.label == " vs ") {
+            game.label = "Game " + std::to_string(i + 1);
+        }
+        game.movetext = g.movetext;
+        if (const std::string fen = tag("FEN"); !fen.empty()) {
+            game.startFen = fen;
+        }
+        games.push_back(std::move(game));
+    }
+
+    enqueueBatch(tr("%1 (%2 games)").arg(QFileInfo(path).fileName()).arg(games.size()), games);
 }
 
 void MainWindow::setupTopForm(QVBoxLayout* mainLayout) {
@@ -235,9 +514,17 @@ void MainWindow::setupTopForm(QVBoxLayout* mainLayout) {
     multiPvSpin_->setRange(1, 10);
     multiPvSpin_->setValue(1);
 
+    // Higher priority jobs leave the pending queue first.
+    prioritySpin_ = new QSpinBox(centralWidget_);
+    prioritySpin_->setRange(-100, 100);
+    prioritySpin_->setValue(0);
+
     serverCombo_ = new QComboBox(centralWidget_);
     serverCombo_->addItem(tr("Auto"), QVariant(QString()));
 
+    // Cluster job: root moves are split across all enabled servers.
+    splitCheck_ = new QCheckBox(tr("Split root moves across servers"), centralWidget_);
+
     formLayout->addRow(tr("Opponent:"), opponentLineEdit_);
     formLayout->addRow(tr("Position input:"), positionInputCombo_);
     formLayout->addRow(tr("FEN:"), fenLineEdit_);
@@ -245,7 +532,9 @@ void MainWindow::setupTopForm(QVBoxLayout* mainLayout) {
     formLayout->addRow(tr("Limit type:"), limitTypeCombo_);
     formLayout->addRow(tr("Limit value:"), limitValueSpin_);
     formLayout->addRow(tr("MultiPV:"), multiPvSpin_);
+    formLayout->addRow(tr("Priority:"), prioritySpin_);
     formLayout->addRow(tr("Server:"), serverCombo_);
+    formLayout->addRow(QString(), splitCheck_);
 
     mainLayout->addLayout(formLayout);
 
@@ -257,8 +546,14 @@ void MainWindow::setupButtonsRow(QVBoxLayout* mainLayout) {
     auto* buttonsLayout = new QHBoxLayout();
     startButton_ = new QPushButton(tr("Start"), centralWidget_);
     stopButton_  = new QPushButton(tr("Stop"), centralWidget_);
+    priorityButton_ = new QPushButton(tr("Priority..."), centralWidget_);
+    extendButton_ = new QPushButton(tr("Extend..."), centralWidget_);
+    extendButton_->setToolTip(tr("Search the selected finished job deeper on the server that ran it, "
+                                 "reusing its engine's hash"));
     buttonsLayout->addWidget(startButton_);
     buttonsLayout->addWidget(stopButton_);
+    buttonsLayout->addWidget(priorityButton_);
+    buttonsLayout->addWidget(extendButton_);
     buttonsLayout->addStretch();
     mainLayout->addLayout(buttonsLayout);
 }
@@ -266,17 +561,42 @@ void MainWindow::setupButtonsRow(QVBoxLayout* mainLayout) {
 void MainWindow::setupMainSplitter(QVBoxLayout* mainLayout) {
     auto* splitter = new QSplitter(Qt::Horizontal, centralWidget_);
 
-    jobsTableView_ = new QTableView(splitter);
-    jobsTableView_->setModel(&jobsModel_);
+    // Jobs: filter box + table; sorting and filtering run on the proxy, on
+    // raw values from the summary store (see JobsModel::SortRole).
+    auto* jobsPane = new QWidget(splitter);
+    auto* jobsLayout = new QVBoxLayout(jobsPane);
+    jobsLayout->setContentsMargins(0, 0, 0, 0);
+
+    jobsFilterEdit_ = new QLineEdit(jobsPane);
+    jobsFilterEdit_->setPlaceholderText(tr("Filter by job id, opponent, server or status"));
+    jobsFilterEdit_->setClearButtonEnabled(true);
+
+    jobsProxy_ = new QSortFilterProxyModel(this);
+    jobsProxy_->setSourceModel(&jobsModel_);
+    jobsProxy_->setSortRole(JobsModel::SortRole);
+    jobsProxy_->setFilterRole(JobsModel::FilterRole);
+    jobsProxy_->setFilterKeyColumn(0);
+    jobsProxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+    jobsTableView_ = new QTableView(jobsPane);
+    jobsTableView_->setModel(jobsProxy_);
     jobsTableView_->setSelectionBehavior(QAbstractItemView::SelectRows);
     jobsTableView_->setSelectionMode(QAbstractItemView::SingleSelection);
     jobsTableView_->setEditTriggers(QAbstractItemView::NoEditTriggers);
     jobsTableView_->horizontalHeader()->setStretchLastSection(true);
+    jobsTableView_->setSortingEnabled(true);
+    jobsTableView_->sortByColumn(JobsModel::ColLastUpdate, Qt::DescendingOrder);
+
+    jobsLayout->addWidget(jobsFilterEdit_);
+    jobsLayout->addWidget(jobsTableView_, 1);
 
     detailsTabs_ = new QTabWidget(splitter);
 
     logPlainTextEdit_ = new QPlainTextEdit(detailsTabs_);
     logPlainTextEdit_->setReadOnly(true);
+    // Same bound as the per-job ring; older lines live in the spill file.
+    logPlainTextEdit_->setMaximumBlockCount(
+        static_cast<int>(sf::client::domain::JobLogOptions::kDefaultCapacity));
     detailsTabs_->addTab(logPlainTextEdit_, tr("Log"));
 
     // Board tab: board + PV lines
@@ -285,19 +605,24 @@ void MainWindow::setupMainSplitter(QVBoxLayout* mainLayout) {
     boardLayout->setContentsMargins(0, 0, 0, 0);
     boardWidget_ = new BoardWidget(boardTab);
 
-    pvPlainTextEdit_ = new QPlainTextEdit(boardTab);
-    pvPlainTextEdit_->setReadOnly(true);
-    pvPlainTextEdit_->setMaximumBlockCount(2000);
-    pvPlainTextEdit_->setMinimumHeight(90);
+    pvLinesView_ = new QTableView(boardTab);
+    pvLinesView_->setModel(&pvLinesModel_);
+    pvLinesView_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    pvLinesView_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    pvLinesView_->setWordWrap(false);
+    pvLinesView_->verticalHeader()->hide();
+    pvLinesView_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    pvLinesView_->horizontalHeader()->setStretchLastSection(true);
+    pvLinesView_->setMinimumHeight(90);
 
     boardLayout->addWidget(boardWidget_, 1);
-    boardLayout->addWidget(pvPlainTextEdit_, 0);
+    boardLayout->addWidget(pvLinesView_, 0);
     detailsTabs_->addTab(boardTab, tr("Board"));
 
     // ICCF tab
     setupIccfTab();
 
-    splitter->addWidget(jobsTableView_);
+    splitter->addWidget(jobsPane);
     splitter->addWidget(detailsTabs_);
     splitter->setStretchFactor(0, 3);
     splitter->setStretchFactor(1, 2);
@@ -341,10 +666,19 @@ void MainWindow::setupIccfTab() {
     iccfRefreshButton_ = new QPushButton(tr("Refresh"), tab);
     iccfAnalyzeButton_ = new QPushButton(tr("Analyze selected"), tab);
     iccfOpenViewerButton_ = new QPushButton(tr("Open in viewer"), tab);
+    iccfBatchButton_ = new QPushButton(tr("Analyze all games (batch)"), tab);
     buttonsLayout->addWidget(iccfRefreshButton_);
     buttonsLayout->addWidget(iccfOpenViewerButton_);
     buttonsLayout->addWidget(iccfAnalyzeButton_);
+    buttonsLayout->addWidget(iccfBatchButton_);
     buttonsLayout->addStretch(1);
+    iccfAutoAnalyzeCheck_ = new QCheckBox(tr("Auto-analyze my moves"), tab);
+    iccfAutoAnalyzeCheck_->setToolTip(
+        tr("Submit each game's position when a sync reports a move: my-turn games first, "
+           "the opponent's likely replies (most played in the reference DB when it has the position) "
+           "when engines are idle. Uses the limit and MultiPV set when switched on."));
+    iccfAutoAnalyzeCheck_->setEnabled(false); // until setIccfAnalysisPipeline()
+    buttonsLayout->addWidget(iccfAutoAnalyzeCheck_);
     layout->addLayout(buttonsLayout);
 
     iccfGamesTableView_ = new QTableView(tab);
@@ -360,6 +694,7 @@ void MainWindow::setupIccfTab() {
         iccfRefreshButton_->setEnabled(false);
         iccfAnalyzeButton_->setEnabled(false);
         iccfOpenViewerButton_->setEnabled(false);
+        iccfBatchButton_->setEnabled(false);
         iccfUsernameLineEdit_->setPlaceholderText(tr("ICCF is not wired (use constructor overload with IccfSyncManager*)"));
     }
 
@@ -371,6 +706,10 @@ void MainWindow::setupConnections() {
             this, &MainWindow::onStartButtonClicked);
     connect(stopButton_, &QPushButton::clicked,
             this, &MainWindow::onStopButtonClicked);
+    connect(priorityButton_, &QPushButton::clicked,
+            this, &MainWindow::onPriorityButtonClicked);
+    connect(extendButton_, &QPushButton::clicked,
+            this, &MainWindow::onExtendButtonClicked);
 
     if (positionInputCombo_) {
         connect(positionInputCombo_,
@@ -383,6 +722,8 @@ void MainWindow::setupConnections() {
         connect(selectionModel, &QItemSelectionModel::selectionChanged,
                 this, &MainWindow::onJobSelectionChanged);
     }
+    connect(jobsFilterEdit_, &QLineEdit::textChanged,
+            jobsProxy_, &QSortFilterProxyModel::setFilterFixedString);
 
     // ICCF
     if (iccfRefreshButton_) {
@@ -393,14 +734,18 @@ void MainWindow::setupConnections() {
         connect(iccfAnalyzeButton_, &QPushButton::clicked,
                 this, &MainWindow::onIccfAnalyzeClicked);
     }
+    if (iccfBatchButton_) {
+        connect(iccfBatchButton_, &QPushButton::clicked,
+                this, &MainWindow::onIccfBatchAnalyzeClicked);
+    }
     if (iccfOpenViewerButton_) {
         connect(iccfOpenViewerButton_, &QPushButton::clicked,
                 this, &MainWindow::onIccfOpenViewerClicked);
     }
 
     if (iccfSync_) {
-        connect(iccfSync_, &sf::client::app::IccfSyncManager::gamesUpdated,
-                this, &MainWindow::onIccfGamesUpdated);
+        connect(iccfSync_, &sf::client::app::IccfSyncManager::gamesChanged,
+                this, &MainWindow::onIccfGamesChanged);
         connect(iccfSync_, &sf::client::app::IccfSyncManager::error,
                 this, &MainWindow::onIccfError);
     }
@@ -420,7 +765,7 @@ std::optional<int> MainWindow::selectedJobRow() const {
     if (selected.isEmpty()) {
         return std::nullopt;
     }
-    return selected.first().row();
+    return jobsProxy_->mapToSource(selected.first()).row();
 }
 
 std::optional<Job> MainWindow::selectedJob() const {
@@ -428,30 +773,40 @@ std::optional<Job> MainWindow::selectedJob() const {
     if (!row.has_value()) {
         return std::nullopt;
     }
-    return jobsModel_.jobAtRow(*row);
+    return jobForRow(*row);
 }
 
-void MainWindow::selectJobRow(int row) {
-    auto* selectionModel = jobsSelectionModel();
-    if (!selectionModel) {
-        return;
+std::optional<Job> MainWindow::jobForRow(int row) const {
+    const auto id = jobsModel_.jobIdAtRow(row);
+    if (!id.has_value()) {
+        return std::nullopt;
+    }
+    if (const Job* live = jobManager_.jobById(*id)) {
+        return *live;
     }
 
-    selectionModel->select(jobsModel_.index(row, 0),
-                           QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    // History rows are listed from their summary only; load the rest on demand.
+    if (!historyDetails_ || historyDetails_->id != *id) {
+        historyDetails_.reset();
+        if (historyRepo_) {
+            historyDetails_ = historyRepo_->loadJobDetails(*id);
+        }
+    }
+    return historyDetails_;
 }
 
-void MainWindow::ensureLastRowSelectedIfNone() {
-    if (selectedJobRow().has_value()) {
-        return;
-    }
-    if (jobsModel_.rowCount() <= 0) {
+void MainWindow::selectJobRow(int row) {
+    auto* selectionModel = jobsSelectionModel();
+    if (!selectionModel) {
         return;
     }
 
-    const int row = jobsModel_.rowCount() - 1;
-    selectJobRow(row);
-    updateLogForSelectedRow(row);
+    const QModelIndex proxyIndex = jobsProxy_->mapFromSource(jobsModel_.index(row, 0));
+    if (!proxyIndex.isValid()) {
+        return; // filtered out
+    }
+    selectionModel->select(proxyIndex,
+                           QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 }
 
 void MainWindow::refreshSelectedJobDetails() {
@@ -464,20 +819,39 @@ void MainWindow::refreshSelectedJobDetails() {
 }
 
 void MainWindow::notifyJobAddedOrUpdated(const Job& job) {
-    jobsModel_.upsertJob(job);
+    CORRCHESS_TRACE_SCOPE("ui.jobUpdated");
+    // The jobs table already shows the change: JobManager updated its
+    // summary store before calling us.
+
+    // If nothing selected yet, auto-select this job (helps UX for first run;
+    // the last row may be an old history entry).
+    if (!selectedJobRow().has_value()) {
+        if (const auto row = jobsModel_.rowOf(job.id)) {
+            selectJobRow(*row);
+        }
+    }
 
-    // If nothing selected yet, auto-select the last row (helps UX for first run).
-    ensureLastRowSelectedIfNone();
+    // Open viewers keep the result if their game reaches the position.
+    if (job.snapshot.score.type != sf::client::domain::ScoreType::None) {
+        for (const auto& viewer : gameViewers_) {
+            if (viewer) {
+                viewer->mergeEngineResult(job.fen, job.snapshot);
+            }
+        }
+    }
 
-    // If the updated job is currently selected -> live-update details view.
-    const auto current = selectedJob();
-    if (current && current->id == job.id) {
-        refreshSelectedJobDetails();
+    // If the updated job is currently selected -> live-update details view
+    // from the live job (the row's id is compared, nothing is copied).
+    const auto selectedRow = selectedJobRow();
+    if (selectedRow && jobsModel_.rowOf(job.id) == selectedRow) {
+        showJobDetails(job);
     }
 }
 
 void MainWindow::notifyJobRemoved(const Job& job) {
-    jobsModel_.removeJob(job.id);
+    if (historyDetails_ && historyDetails_->id == job.id) {
+        historyDetails_.reset();
+    }
 
     // Selection might become empty or point to a different row after removal.
     refreshSelectedJobDetails();
@@ -563,7 +937,7 @@ void MainWindow::onStartButtonClicked() {
     enqueueJobWithFen(opponent, fen);
 }
 
-void MainWindow::enqueueJobWithFen(const QString& opponent, const QString& fen) {
+SearchLimit MainWindow::currentSearchLimit() const {
     const int limitTypeInt  = limitTypeCombo_ ? limitTypeCombo_->currentData().toInt()
                                               : static_cast<int>(LimitType::Depth);
     const int limitValue    = limitValueSpin_ ? limitValueSpin_->value() : 30;
@@ -580,6 +954,47 @@ void MainWindow::enqueueJobWithFen(const QString& opponent, const QString& fen)
             limit = sf::client::domain::nodes(limitValue);
             break;
     }
+    return limit;
+}
+
+void MainWindow::enqueueBatch(const QString& name, const std::vector<sf::client::app::BatchGame>& games) {
+    const auto plan = sf::client::app::planBatch(games);
+    if (plan.positions.empty()) {
+        QStringList errors;
+        for (const auto& e : plan.errors) {
+            errors << QString::fromStdString(e);
+        }
+        QMessageBox::warning(this, tr("Batch analysis"),
+                             tr("No positions to analyze.\n\n%1").arg(errors.join('\n')));
+        return;
+    }
+
+    QString summary = tr("Analyze %1 positions from %2 games?")
+                          .arg(plan.positions.size())
+                          .arg(plan.games);
+    if (plan.duplicates > 0) {
+        summary += tr("\n%1 repeated positions are analyzed once.").arg(plan.duplicates);
+    }
+    if (!plan.errors.empty()) {
+        summary += tr("\n%1 games could not be replayed and are skipped.").arg(plan.errors.size());
+    }
+    if (QMessageBox::question(this, tr("Batch analysis"), summary) != QMessageBox::Yes) {
+        return;
+    }
+
+    const int multiPv = multiPvSpin_ ? multiPvSpin_->value() : 1;
+    const int priority = prioritySpin_ ? prioritySpin_->value() : 0;
+    jobManager_.enqueueBatch(name.toStdString(), plan.positions, currentSearchLimit(), multiPv, priority);
+}
+
+void MainWindow::showGameViewer(GameViewerDialog* dlg) {
+    gameViewers_.removeAll(nullptr);
+    gameViewers_.append(dlg);
+    dlg->show();
+}
+
+void MainWindow::enqueueJobWithFen(const QString& opponent, const QString& fen) {
+    const SearchLimit limit = currentSearchLimit();
 
     std::optional<std::string> preferredServer;
     const QString serverId = serverCombo_ ? serverCombo_->currentData().toString() : QString();
@@ -588,12 +1003,24 @@ void MainWindow::enqueueJobWithFen(const QString& opponent, const QString& fen)
     }
 
     const int multiPv = multiPvSpin_ ? multiPvSpin_->value() : 1;
+    const int priority = prioritySpin_ ? prioritySpin_->value() : 0;
+
+    if (splitCheck_ && splitCheck_->isChecked()) {
+        jobManager_.enqueueClusterJob(opponent.toStdString(),
+                                      fen.toStdString(),
+                                      limit,
+                                      multiPv,
+                                      0,
+                                      priority);
+        return;
+    }
 
     jobManager_.enqueueJob(opponent.toStdString(),
                            fen.toStdString(),
                            limit,
                            multiPv,
-                           preferredServer);
+                           preferredServer,
+                           priority);
 }
 
 void MainWindow::onStopButtonClicked() {
@@ -604,12 +1031,60 @@ void MainWindow::onStopButtonClicked() {
     jobManager_.requestStopJob(job->id);
 }
 
+void MainWindow::onPriorityButtonClicked() {
+    const auto job = selectedJob();
+    if (!job) {
+        return;
+    }
+    bool ok = false;
+    const int priority = QInputDialog::getInt(this,
+                                              tr("Job priority"),
+                                              tr("Priority (higher dispatches first):"),
+                                              job->priority, -100, 100, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    jobManager_.setJobPriority(job->id, priority);
+}
+
+void MainWindow::onExtendButtonClicked() {
+    const auto job = selectedJob();
+    if (!job) {
+        return;
+    }
+    // Depth goes up in plies, time and nodes by doubling.
+    const int current = job->limit.value;
+    const int suggested = job->limit.type == LimitType::Depth
+                              ? current + 10
+                              : static_cast<int>(std::min<long long>(2LL * current, 1'000'000'000));
+    bool ok = false;
+    const int value = QInputDialog::getInt(this,
+                                           tr("Extend analysis"),
+                                           tr("New limit (currently %1):").arg(current),
+                                           suggested, current + 1, 1'000'000'000, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    if (!jobManager_.extendJob(job->id, value)) {
+        QMessageBox::information(this, tr("Extend analysis"),
+                                 tr("This job cannot be extended in place: only finished or stopped "
+                                    "jobs on a connected server that supports it can. Start a new "
+                                    "job with the higher limit instead."));
+    }
+}
+
 void MainWindow::onJobSelectionChanged() {
     refreshSelectedJobDetails();
 }
 
 void MainWindow::updateLogForSelectedRow(int row) {
-    const auto optJob = jobsModel_.jobAtRow(row);
+    if (const auto id = jobsModel_.jobIdAtRow(row)) {
+        if (const Job* live = jobManager_.jobById(*id)) {
+            showJobDetails(*live);
+            return;
+        }
+    }
+    const auto optJob = jobForRow(row);
     if (!optJob.has_value()) {
         clearDetailsView();
         return;
@@ -621,9 +1096,9 @@ void MainWindow::clearDetailsView() {
     if (logPlainTextEdit_) {
         logPlainTextEdit_->clear();
     }
-    if (pvPlainTextEdit_) {
-        pvPlainTextEdit_->clear();
-    }
+    logViewJobId_.clear();
+    logViewLog_ = {};
+    pvLinesModel_.clear();
     if (boardWidget_) {
         boardWidget_->setFen(QString());
         boardWidget_->setArrows({});
@@ -637,19 +1112,49 @@ void MainWindow::showJobDetails(const Job& job) {
 }
 
 void MainWindow::updateLogView(const Job& job) {
+    const auto& log = job.logLines;
+
+    // Append only the lines the view has not shown yet; start over for a
+    // different job or a replaced log.
+    const bool sameStream = logViewJobId_ == job.id &&
+                            logViewLog_.sharesStateWith(log) &&
+                            logViewEpoch_ == log.epoch();
+    if (!sameStream) {
+        logPlainTextEdit_->clear();
+        logViewJobId_ = job.id;
+        logViewLog_ = log;
+        logViewEpoch_ = log.epoch();
+        logViewNextSeq_ = log.firstSeq();
+    }
+
     QStringList lines;
-    lines.reserve(static_cast<int>(job.logLines.size()));
-    for (const auto& l : job.logLines) {
-        lines.append(QString::fromStdString(l));
+    for (auto it = log.fromSeq(logViewNextSeq_); it != log.end(); ++it) {
+        lines.append(QString::fromStdString(*it));
+    }
+    logViewNextSeq_ = log.endSeq();
+
+    if (!lines.isEmpty()) {
+        logPlainTextEdit_->appendPlainText(lines.join('\n'));
+    }
+    if (!sameStream) {
+        logPlainTextEdit_->moveCursor(QTextCursor::End);
     }
-    logPlainTextEdit_->setPlainText(lines.join('\n'));
-    logPlainTextEdit_->moveCursor(QTextCursor::End);
 }
 
 void MainWindow::updatePvAndBoardView(const Job& job) {
-    if (pvPlainTextEdit_) {
-        pvPlainTextEdit_->clear();
+    // PV lines (only rows that changed are redrawn; see PvLinesModel).
+    if (!job.snapshot.lines.empty()) {
+        pvLinesModel_.setLines(job.fen, job.snapshot.lines);
+    } else if (!job.snapshot.pv.empty()) {
+        sf::client::domain::PvLine line;
+        line.depth = job.snapshot.depth;
+        line.score = job.snapshot.score;
+        line.pv = job.snapshot.pv;
+        pvLinesModel_.setLines(job.fen, {line});
+    } else {
+        pvLinesModel_.setLines(job.fen, {});
     }
+
     if (!boardWidget_) {
         return;
     }
@@ -659,29 +1164,6 @@ void MainWindow::updatePvAndBoardView(const Job& job) {
     QVector<sf::client::ui::Arrow> arrows;
     QVector<sf::client::ui::Square> hl;
 
-    // PV text box
-    if (pvPlainTextEdit_) {
-        QStringList pvLines;
-        if (!job.snapshot.lines.empty()) {
-            for (const auto& line : job.snapshot.lines) {
-                QString scoreStr;
-                if (line.score.type == sf::client::domain::ScoreType::Cp) {
-                    scoreStr = QString::number(line.score.value) + " cp";
-                } else if (line.score.type == sf::client::domain::ScoreType::Mate) {
-                    scoreStr = "M" + QString::number(line.score.value);
-                }
-                const QString pv = QString::fromStdString(line.pv);
-                pvLines << QString("#%1  %2  %3").arg(line.multipv).arg(scoreStr, pv);
-            }
-        } else {
-            const QString pv = QString::fromStdString(job.snapshot.pv);
-            if (!pv.trimmed().isEmpty()) {
-                pvLines << pv;
-            }
-        }
-        pvPlainTextEdit_->setPlainText(pvLines.join('\n'));
-    }
-
     // Helper: create arrow from first move in PV (UCI)
     const auto makeArrow = [&](const QString& uciMove,
                                const sf::client::domain::Score& score,
@@ -707,14 +1189,18 @@ void MainWindow::updatePvAndBoardView(const Job& job) {
         }
     };
 
+    const auto firstMove = [](const sf::client::domain::chess::MoveLine& pv) {
+        return pv.empty() ? QString()
+                          : QString::fromStdString(sf::client::domain::chess::packedToUci(pv.front()));
+    };
+
     // Prefer MultiPV lines, otherwise fallback to bestmove/pv.
     if (!job.snapshot.lines.empty()) {
         int added = 0;
         const int maxArrows = std::min(3, std::clamp(job.multiPv, 1, 10));
         for (const auto& line : job.snapshot.lines) {
             if (added >= maxArrows) break; // keep it readable
-            const QString pv = QString::fromStdString(line.pv).trimmed();
-            const QString first = pv.split(' ', Qt::SkipEmptyParts).value(0);
+            const QString first = firstMove(line.pv);
             makeArrow(first, line.score, line.multipv);
             if (!first.isEmpty()) {
                 added++;
@@ -723,10 +1209,7 @@ void MainWindow::updatePvAndBoardView(const Job& job) {
     } else {
         QString uci = QString::fromStdString(job.snapshot.bestMove).trimmed();
         if (uci.isEmpty()) {
-            const QString pv = QString::fromStdString(job.snapshot.pv).trimmed();
-            if (!pv.isEmpty()) {
-                uci = pv.split(' ', Qt::SkipEmptyParts).value(0);
-            }
+            uci = firstMove(job.snapshot.pv);
         }
         makeArrow(uci, job.snapshot.score, 1);
     }
@@ -735,78 +1218,104 @@ void MainWindow::updatePvAndBoardView(const Job& job) {
     boardWidget_->setHighlights(hl);
 }
 
-std::vector<Job> MainWindow::collectJobsForExport() const {
-    std::vector<Job> jobs;
-
-    // 1) History (terminal jobs)
-    if (historyRepo_) {
-        jobs = historyRepo_->loadAllJobs();
-    }
-
-    // Track existing IDs so we can append only new in-memory jobs (preserve order).
-    std::unordered_set<std::string> seen;
-    seen.reserve(jobs.size() + jobManager_.jobs().size());
-    for (const auto& j : jobs) {
-        seen.insert(j.id);
-    }
-
-    // 2) Active jobs (in-memory)
-    const auto& active = jobManager_.jobs();
-    for (const auto& j : active) {
-        if (seen.insert(j.id).second) {
-            jobs.push_back(j);
-        }
-    }
-
-    return jobs;
+void MainWindow::exportJobsToJson() {
+    startJobExport(false);
 }
 
-void MainWindow::exportJobsToJson() {
-    const auto jobs = collectJobsForExport();
+void MainWindow::exportJobsToPgn() {
+    startJobExport(true);
+}
 
-    const QString fileName = QFileDialog::getSaveFileName(
-        this,
-        tr("Export jobs as JSON"),
-        QString(),
-        tr("JSON files (*.json)"));
-    if (fileName.isEmpty()) {
+void MainWindow::startJobExport(bool pgn) {
+    if (exportThread_) {
+        QMessageBox::information(this, tr("Export jobs"),
+                                 tr("An export is already running."));
         return;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Error"),
-                             tr("Failed to open file for writing."));
+    const QString jsonFilter  = tr("JSON files (*.json)");
+    const QString jsonlFilter = tr("JSON Lines files (*.jsonl)");
+    QString selectedFilter;
+    const QString fileName = pgn
+        ? QFileDialog::getSaveFileName(this, tr("Export jobs as PGN"), QString(),
+                                       tr("PGN files (*.pgn);;All files (*.*)"))
+        : QFileDialog::getSaveFileName(this, tr("Export jobs as JSON"), QString(),
+                                       jsonFilter + QStringLiteral(";;") + jsonlFilter, &selectedFilter);
+    if (fileName.isEmpty()) {
         return;
     }
 
-    const QJsonDocument doc = JobExporter::toJson(jobs);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
-}
-
-void MainWindow::exportJobsToPgn() {
-    const auto jobs = collectJobsForExport();
-
-    const QString fileName = QFileDialog::getSaveFileName(
-        this,
-        tr("Export jobs as PGN"),
-        QString(),
-        tr("PGN files (*.pgn);;All files (*.*)"));
-    if (fileName.isEmpty()) {
-        return;
+    ExportOptions options;
+    options.path = fileName;
+    if (pgn) {
+        options.format = ExportFormat::Pgn;
+        options.includeLogs = false;
+    } else {
+        options.format = (selectedFilter == jsonlFilter || fileName.endsWith(QStringLiteral(".jsonl")))
+            ? ExportFormat::JsonLines
+            : ExportFormat::Json;
+        options.includeLogs =
+            QMessageBox::question(this, tr("Export jobs as JSON"),
+                                  tr("Include engine log lines? They make up most of the file."),
+                                  QMessageBox::Yes | QMessageBox::No, QMessageBox::No)
+            == QMessageBox::Yes;
     }
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, tr("Error"),
-                             tr("Failed to open file for writing."));
-        return;
+    // Live jobs are copied here, on the GUI thread; history is read by the worker.
+    std::vector<Job> liveJobs;
+    liveJobs.reserve(jobManager_.jobs().size());
+    for (const auto& j : jobManager_.jobs()) {
+        liveJobs.push_back(JobExporter::detachedForExport(j, options.includeLogs));
     }
 
-    const QString pgn = JobExporter::toPgn(jobs);
-    file.write(pgn.toUtf8());
-    file.close();
+    auto* progress = new QProgressDialog(
+        tr("Exporting jobs to %1...").arg(QFileInfo(fileName).fileName()),
+        tr("Cancel"), 0, 0, this);
+    progress->setWindowTitle(tr("Export jobs"));
+    progress->setMinimumDuration(500);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    progress->setValue(0);
+
+    exportCancel_ = std::make_shared<std::atomic<bool>>(false);
+    auto cancel = exportCancel_;
+    connect(progress, &QProgressDialog::canceled, this, [cancel]() {
+        cancel->store(true);
+    });
+
+    // Same lifetime rules as the reference index import above.
+    auto result = std::make_shared<ExportResult>();
+    const auto* history = historyRepo_;
+    exportThread_ = QThread::create([options, history, liveJobs = std::move(liveJobs), cancel, result, progress]() {
+        *result = JobExporter::run(options, history, liveJobs, *cancel, [progress](const ExportProgress& p) {
+            QMetaObject::invokeMethod(progress, [progress, p]() {
+                progress->setMaximum(p.jobsTotal);
+                progress->setValue(std::min(p.jobsWritten, p.jobsTotal));
+                progress->setLabelText(QObject::tr("%1 of %2 jobs written").arg(p.jobsWritten).arg(p.jobsTotal));
+            }, Qt::QueuedConnection);
+        });
+    });
+
+    connect(exportThread_, &QThread::finished, this, [this, progress, result, fileName]() {
+        progress->close();
+        progress->deleteLater();
+        exportThread_->deleteLater();
+        exportThread_ = nullptr;
+        exportCancel_.reset();
+
+        if (result->cancelled) {
+            statusBar()->showMessage(
+                tr("Export cancelled after %1 jobs").arg(result->jobsWritten), 5000);
+        } else if (!result->ok) {
+            QMessageBox::warning(this, tr("Export jobs"),
+                                 tr("Export failed:\n%1").arg(result->error));
+        } else {
+            statusBar()->showMessage(
+                tr("Exported %1 jobs to %2").arg(result->jobsWritten).arg(fileName), 5000);
+        }
+    });
+
+    exportThread_->start();
 }
 
 // ---------------- ICCF slots ----------------
@@ -866,6 +1375,33 @@ void MainWindow::onIccfAnalyzeClicked() {
     enqueueJobWithFen(label, QString::fromStdString(res.fen));
 }
 
+void MainWindow::onIccfBatchAnalyzeClicked() {
+    std::vector<sf::client::app::BatchGame> games;
+    for (int row = 0; row < iccfGamesModel_.rowCount(); ++row) {
+        const auto* g = iccfGamesModel_.gameAt(row);
+        if (!g) {
+            continue;
+        }
+        sf::client::app::BatchGame game;
+        game.label = QStringLiteral("ICCF #%1: %2 vs %3")
+                         .arg(g->id)
+                         .arg(g->white)
+                         .arg(g->black)
+                         .toStdString();
+        game.movetext = g->moves.toStdString();
+        if (g->setup && !g->fen.trimmed().isEmpty()) {
+            game.startFen = g->fen.trimmed().toStdString();
+        }
+        games.push_back(std::move(game));
+    }
+    if (games.empty()) {
+        QMessageBox::information(this, tr("ICCF"), tr("No games loaded; refresh first."));
+        return;
+    }
+
+    enqueueBatch(tr("ICCF batch (%1 games)").arg(games.size()), games);
+}
+
 void MainWindow::onIccfOpenViewerClicked() {
     if (!iccfGamesTableView_) return;
 
@@ -901,40 +1437,91 @@ void MainWindow::onIccfOpenViewerClicked() {
         meta.startFen = g->fen.trimmed();
     }
 
-    std::optional<std::string> startFen;
-    if (!meta.startFen.isEmpty()) {
-        startFen = meta.startFen.toStdString();
-    }
-
-    const auto timeline = sf::client::domain::chess::fenTimelineFromSanMoves(
-        g->moves.toStdString(), startFen);
-
-    auto* dlg = new GameViewerDialog(this);
-    dlg->setAttribute(Qt::WA_DeleteOnClose, true);
-
     QString err;
-    if (!dlg->setGame(meta, timeline, &err)) {
+    auto tree = parseGameTree(g->moves.toStdString(), meta.startFen, &err);
+    if (!tree) {
         QMessageBox::warning(this, tr("ICCF"),
-                             tr("Failed to build moves timeline.\n\n%1").arg(err));
-        dlg->deleteLater();
+                             tr("Failed to read the moves.\n\n%1").arg(err));
         return;
     }
 
+    auto* dlg = new GameViewerDialog(this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose, true);
+    dlg->setReferenceQuery(refDbQuery_);
+    dlg->setGame(meta, std::move(*tree));
+
     connect(dlg, &GameViewerDialog::analyzeRequested,
             this, [this, label](const QString& fen, const QString&) {
                 enqueueJobWithFen(label, fen);
             });
 
-    dlg->show();
+    showGameViewer(dlg);
 }
 
-void MainWindow::onIccfGamesUpdated(QVector<sf::client::infra::iccf::IccfGame> games) {
-    iccfGamesModel_.setGames(std::move(games));
+void MainWindow::onIccfGamesChanged(const sf::client::app::IccfGamesDelta& delta) {
+    iccfGamesModel_.applyDelta(delta);
     if (statusBar()) {
         statusBar()->showMessage(tr("ICCF games updated."), 3000);
     }
 }
 
+void MainWindow::setMemoryBudget(sf::client::app::MemoryBudget* budget) {
+    memoryBudget_ = budget;
+    if (memoryAction_) {
+        memoryAction_->setEnabled(budget != nullptr);
+    }
+}
+
+void MainWindow::showMemoryDiagnostics() {
+    if (!memoryBudget_) {
+        return;
+    }
+    if (!memoryDialog_) {
+        memoryDialog_ = new MemoryDiagnosticsDialog(*memoryBudget_, this);
+        memoryDialog_->setAttribute(Qt::WA_DeleteOnClose);
+    }
+    memoryDialog_->show();
+    memoryDialog_->raise();
+    memoryDialog_->activateWindow();
+}
+
+void MainWindow::setIccfAnalysisPipeline(sf::client::app::IccfAnalysisPipeline* pipeline) {
+    if (iccfPipeline_) {
+        disconnect(iccfPipeline_, nullptr, this, nullptr);
+    }
+    iccfPipeline_ = pipeline;
+    if (pipeline) {
+        pipeline->setReferenceQuery(refDbQuery_);
+    }
+    if (!iccfAutoAnalyzeCheck_) return;
+
+    disconnect(iccfAutoAnalyzeCheck_, &QCheckBox::toggled, this, &MainWindow::onIccfAutoAnalyzeToggled);
+    iccfAutoAnalyzeCheck_->setChecked(pipeline && pipeline->isEnabled());
+    iccfAutoAnalyzeCheck_->setEnabled(pipeline && iccfSync_);
+    if (!pipeline) return;
+
+    connect(iccfAutoAnalyzeCheck_, &QCheckBox::toggled, this, &MainWindow::onIccfAutoAnalyzeToggled);
+    connect(pipeline, &sf::client::app::IccfAnalysisPipeline::status, this, [this](const QString& text) {
+        statusBar()->showMessage(text, 4000);
+    });
+}
+
+void MainWindow::onIccfAutoAnalyzeToggled(bool on) {
+    if (!iccfPipeline_) return;
+
+    if (on) {
+        sf::client::app::IccfAnalysisOptions options;
+        options.limit   = currentSearchLimit();
+        options.multiPv = multiPvSpin_ ? multiPvSpin_->value() : 1;
+        iccfPipeline_->setOptions(options);
+    }
+    iccfPipeline_->setEnabled(on);
+    // Games already loaded count as just arrived.
+    if (on && iccfSync_) {
+        iccfPipeline_->analyzeAll(iccfSync_->games().sortedGames());
+    }
+}
+
 void MainWindow::onIccfError(const QString& message) {
     if (statusBar()) {
         statusBar()->showMessage(message, 6000);
@@ -1,11 +1,16 @@
 #pragma once
 
+#include <QList>
 #include <QMainWindow>
+#include <QPointer>
+#include <atomic>
+#include <memory>
 #include <optional>
 
 #include "ui/JobsModel.hpp"
 #include "ui/ServersModel.hpp"
 #include "ui/IccfGamesModel.hpp"
+#include "ui/PvLinesModel.hpp"
 #include "app/JobManager.hpp"
 #include "app/ServerManager.hpp"
 
@@ -13,22 +18,34 @@ class QLineEdit;
 class QFormLayout;
 class QSpinBox;
 class QComboBox;
+class QCheckBox;
 class QPushButton;
 class QTableView;
 class QPlainTextEdit;
 class QTabWidget;
 class QTimer;
+class QAction;
 class QItemSelectionModel;
+class QSortFilterProxyModel;
 class QVBoxLayout;
+class QThread;
 
 namespace sf::client::app {
 class IHistoryRepository;
 class IccfSyncManager;
+class IccfAnalysisPipeline;
+class MemoryBudget;
+}
+
+namespace sf::client::infra::refdb {
+class ReferenceDbQuery;
 }
 
 namespace sf::client::ui {
 
 class BoardWidget;
+class GameViewerDialog;
+class MemoryDiagnosticsDialog;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -52,19 +69,34 @@ public:
     void notifyJobAddedOrUpdated(const sf::client::domain::Job& job);
     void notifyJobRemoved(const sf::client::domain::Job& job);
 
+    // Enables the ICCF tab's auto-analyze switch; nullptr keeps it off.
+    void setIccfAnalysisPipeline(sf::client::app::IccfAnalysisPipeline* pipeline);
+
+    // Enables Tools > Memory usage; must outlive the window.
+    void setMemoryBudget(sf::client::app::MemoryBudget* budget);
+
 private slots:
     void onStartButtonClicked();
     void onStopButtonClicked();
+    void onPriorityButtonClicked();
+    void onExtendButtonClicked();
     void onJobSelectionChanged();
     void exportJobsToJson();
     void exportJobsToPgn();
     void openPgnFile();
+    void batchAnalyzePgnFile();
+    void buildReferenceIndex();
+    void openReferenceIndex();
+    void saveTrace();
+    void showMemoryDiagnostics();
 
     // ICCF
     void onIccfRefreshClicked();
     void onIccfAnalyzeClicked();
+    void onIccfBatchAnalyzeClicked();
     void onIccfOpenViewerClicked();
-    void onIccfGamesUpdated(QVector<sf::client::infra::iccf::IccfGame> games);
+    void onIccfGamesChanged(const sf::client::app::IccfGamesDelta& delta);
+    void onIccfAutoAnalyzeToggled(bool on);
     void onIccfError(const QString& message);
 
 private:
@@ -86,8 +118,10 @@ private:
     QItemSelectionModel* jobsSelectionModel() const;
     std::optional<int> selectedJobRow() const;
     std::optional<sf::client::domain::Job> selectedJob() const;
+    // Full job for a JobsModel row: the live one, else its history details.
+    std::optional<sf::client::domain::Job> jobForRow(int row) const;
+    // Rows are JobsModel (source) rows; the view shows them through jobsProxy_.
     void selectJobRow(int row);
-    void ensureLastRowSelectedIfNone();
     void refreshSelectedJobDetails();
 
     void updatePositionInputModeUi();
@@ -98,9 +132,15 @@ private:
     void updateLogView(const sf::client::domain::Job& job);
     void updatePvAndBoardView(const sf::client::domain::Job& job);
 
-    std::vector<sf::client::domain::Job> collectJobsForExport() const;
+    // History and live jobs, streamed to the file on a worker thread.
+    void startJobExport(bool pgn);
 
     void enqueueJobWithFen(const QString& opponent, const QString& fen);
+    // Shows the dialog and feeds it the engine results of jobs from now on.
+    void showGameViewer(GameViewerDialog* dlg);
+    // Every position of the games as one batch job, with the form's limit.
+    void enqueueBatch(const QString& name, const std::vector<sf::client::app::BatchGame>& games);
+    sf::client::domain::SearchLimit currentSearchLimit() const;
 
 private:
     QWidget*        centralWidget_{nullptr};
@@ -115,17 +155,31 @@ private:
     QComboBox*      limitTypeCombo_{nullptr};
     QSpinBox*       limitValueSpin_{nullptr};
     QSpinBox*       multiPvSpin_{nullptr};
+    QSpinBox*       prioritySpin_{nullptr};
 
     QComboBox*      serverCombo_{nullptr};
+    QCheckBox*      splitCheck_{nullptr};
 
     QPushButton*    startButton_{nullptr};
     QPushButton*    stopButton_{nullptr};
+    QPushButton*    priorityButton_{nullptr};
+    QPushButton*    extendButton_{nullptr};
 
+    QLineEdit*      jobsFilterEdit_{nullptr};
     QTableView*     jobsTableView_{nullptr};
+    QSortFilterProxyModel* jobsProxy_{nullptr};
+    // Last history job loaded for the details view (selection re-reads it often).
+    mutable std::optional<sf::client::domain::Job> historyDetails_;
     QTabWidget*     detailsTabs_{nullptr};
     QPlainTextEdit* logPlainTextEdit_{nullptr};
+
+    // What the log view currently shows (it is appended to incrementally).
+    sf::client::domain::JobId  logViewJobId_;
+    sf::client::domain::JobLog logViewLog_;
+    std::uint64_t              logViewEpoch_{0};
+    std::uint64_t              logViewNextSeq_{0};
     BoardWidget*    boardWidget_{nullptr};
-    QPlainTextEdit* pvPlainTextEdit_{nullptr};
+    QTableView*     pvLinesView_{nullptr};
 
     QTableView*     serversTableView_{nullptr};
 
@@ -135,12 +189,15 @@ private:
     QLineEdit*   iccfPasswordLineEdit_{nullptr};
     QPushButton* iccfRefreshButton_{nullptr};
     QPushButton* iccfAnalyzeButton_{nullptr};
+    QPushButton* iccfBatchButton_{nullptr};
     QPushButton* iccfOpenViewerButton_{nullptr};
+    QCheckBox*   iccfAutoAnalyzeCheck_{nullptr};
     QTableView*  iccfGamesTableView_{nullptr};
 
     JobsModel       jobsModel_;
     ServersModel    serversModel_;
     IccfGamesModel  iccfGamesModel_;
+    PvLinesModel    pvLinesModel_;
 
     sf::client::app::JobManager&    jobManager_;
     sf::client::app::ServerManager& serverManager_;
@@ -148,8 +205,31 @@ private:
 
     // ICCF (optional)
     sf::client::app::IccfSyncManager* iccfSync_{nullptr};
+    sf::client::app::IccfAnalysisPipeline* iccfPipeline_{nullptr};
 
     QTimer* serversRefreshTimer_{nullptr};
+
+    // Open game viewers (closed ones drop out as null).
+    QList<QPointer<GameViewerDialog>> gameViewers_;
+
+    // Opening explorer backend shared by all game viewers.
+    sf::client::infra::refdb::ReferenceDbQuery* refDbQuery_{nullptr};
+
+    // Reference DB import (at most one at a time).
+    QThread* refIndexThread_{nullptr};
+    std::shared_ptr<std::atomic<bool>> refIndexCancel_;
+
+    // Job export (at most one at a time).
+    QThread* exportThread_{nullptr};
+    std::shared_ptr<std::atomic<bool>> exportCancel_;
+
+    // Tools > Record trace (only in builds with trace spans compiled in).
+    QAction* traceRecordAction_{nullptr};
+
+    // Tools > Memory usage.
+    sf::client::app::MemoryBudget* memoryBudget_{nullptr};
+    QAction* memoryAction_{nullptr};
+    QPointer<MemoryDiagnosticsDialog> memoryDialog_;
 };
 
 } // namespace sf::client::ui
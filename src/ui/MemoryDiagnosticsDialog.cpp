@@ -0,0 +1,97 @@
+#include "ui/MemoryDiagnosticsDialog.hpp"
+
+#include "app/MemoryBudget.hpp"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+namespace sf::client::ui {
+
+namespace {
+
+constexpr int kRefreshIntervalMs = 2000;
+
+QString formatBytes(std::size_t bytes) {
+    if (bytes >= (std::size_t{1} << 20)) {
+        return QStringLiteral("%1 MiB").arg(static_cast<double>(bytes) / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    return QStringLiteral("%1 KiB").arg(static_cast<double>(bytes) / 1024.0, 0, 'f', 1);
+}
+
+} // namespace
+
+MemoryDiagnosticsDialog::MemoryDiagnosticsDialog(sf::client::app::MemoryBudget& budget, QWidget* parent)
+    : QDialog(parent)
+    , budget_(budget) {
+    setWindowTitle(tr("Memory usage"));
+    resize(640, 280);
+
+    auto* layout = new QVBoxLayout(this);
+    policyLabel_ = new QLabel(this);
+    policyLabel_->setWordWrap(true);
+    tree_ = new QTreeWidget(this);
+    tree_->setRootIsDecorated(false);
+    tree_->setUniformRowHeights(true);
+    tree_->setHeaderLabels({tr("Subsystem"), tr("Items"), tr("Memory"), tr("Details")});
+    tree_->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    tree_->header()->setStretchLastSection(true);
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    auto* evictButton = buttons->addButton(tr("Apply budget now"), QDialogButtonBox::ActionRole);
+    connect(evictButton, &QPushButton::clicked, this, &MemoryDiagnosticsDialog::onEvictNowClicked);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    layout->addWidget(policyLabel_);
+    layout->addWidget(tree_, 1);
+    layout->addWidget(buttons);
+
+    refreshTimer_ = new QTimer(this);
+    refreshTimer_->setInterval(kRefreshIntervalMs);
+    connect(refreshTimer_, &QTimer::timeout, this, &MemoryDiagnosticsDialog::refresh);
+    refreshTimer_->start();
+    refresh();
+}
+
+void MemoryDiagnosticsDialog::refresh() {
+    const auto& options = budget_.options();
+    policyLabel_->setText(
+        tr("Finished jobs leave memory %1 min after they end, or sooner while live jobs take more "
+           "than %2; selecting one reloads it from history. %3 evicted this session.")
+            .arg(options.evictAfter.count())
+            .arg(formatBytes(options.jobBytes))
+            .arg(budget_.evictedTotal()));
+
+    const auto rows = budget_.report();
+    std::size_t total = 0;
+    tree_->clear();
+    for (const auto& row : rows) {
+        total += row.bytes;
+        auto* item = new QTreeWidgetItem(tree_);
+        item->setText(0, QString::fromStdString(row.name));
+        item->setText(1, QString::number(row.items));
+        item->setText(2, formatBytes(row.bytes));
+        item->setText(3, QString::fromStdString(row.detail));
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        item->setTextAlignment(2, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    auto* totalItem = new QTreeWidgetItem(tree_);
+    totalItem->setText(0, tr("Total"));
+    totalItem->setText(2, formatBytes(total));
+    totalItem->setTextAlignment(2, Qt::AlignRight | Qt::AlignVCenter);
+    QFont bold = totalItem->font(0);
+    bold.setBold(true);
+    totalItem->setFont(0, bold);
+    totalItem->setFont(2, bold);
+}
+
+void MemoryDiagnosticsDialog::onEvictNowClicked() {
+    budget_.enforce();
+    refresh();
+}
+
+} // namespace sf::client::ui
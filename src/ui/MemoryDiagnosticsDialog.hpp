@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QDialog>
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QTimer;
+class QTreeWidget;
+QT_END_NAMESPACE
+
+namespace sf::client::app {
+class MemoryBudget;
+}
+
+namespace sf::client::ui {
+
+// Tools > Memory usage: what each subsystem holds (MemoryBudget::report()),
+// refreshed every couple of seconds while open, and the eviction policy.
+class MemoryDiagnosticsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit MemoryDiagnosticsDialog(sf::client::app::MemoryBudget& budget, QWidget* parent = nullptr);
+
+private slots:
+    void refresh();
+    void onEvictNowClicked();
+
+private:
+    sf::client::app::MemoryBudget& budget_;
+    QLabel*      policyLabel_{nullptr};
+    QTreeWidget* tree_{nullptr};
+    QTimer*      refreshTimer_{nullptr};
+};
+
+} // namespace sf::client::ui
@@ -0,0 +1,178 @@
+#include "ui/PvLinesModel.hpp"
+
+#include <QStringList>
+#include <algorithm>
+
+namespace sf::client::ui {
+
+using sf::client::domain::PvLine;
+using sf::client::domain::ScoreType;
+
+namespace {
+
+// Side to move and move number from FEN fields 2 and 6 (defaults: white, 1).
+void moveNumberOf(const std::string& fen, bool& whiteToMove, int& fullmove) {
+    const QStringList fields = QString::fromStdString(fen).split(' ', Qt::SkipEmptyParts);
+    whiteToMove = fields.value(1) != QStringLiteral("b");
+    bool ok = false;
+    fullmove = fields.value(5).toInt(&ok);
+    if (!ok || fullmove < 1) {
+        fullmove = 1;
+    }
+}
+
+} // namespace
+
+PvLinesModel::PvLinesModel(QObject* parent)
+    : QAbstractTableModel(parent) {
+}
+
+QString PvLinesModel::formatLine(const sf::client::domain::chess::MoveLine& pv) {
+    const auto san = sanCache_.sanMoves(fen_, pv);
+
+    bool white = true;
+    int moveNo = 1;
+    moveNumberOf(fen_, white, moveNo);
+
+    QString out;
+    for (std::size_t i = 0; i < san.size(); ++i) {
+        if (!out.isEmpty()) {
+            out += QLatin1Char(' ');
+        }
+        if (white) {
+            out += QString::number(moveNo) + QStringLiteral(". ");
+        } else if (i == 0) {
+            out += QString::number(moveNo) + QStringLiteral("... ");
+        }
+        out += QString::fromStdString(san[i]);
+        if (!white) {
+            ++moveNo;
+        }
+        white = !white;
+    }
+
+    // Moves past the first one that is not legal here stay in UCI.
+    for (std::size_t i = san.size(); i < pv.size(); ++i) {
+        if (!out.isEmpty()) {
+            out += QLatin1Char(' ');
+        }
+        out += QString::fromStdString(sf::client::domain::chess::packedToUci(pv[i]));
+    }
+    return out;
+}
+
+void PvLinesModel::setLines(const std::string& fen, std::vector<PvLine> lines) {
+    std::stable_sort(lines.begin(), lines.end(), [](const PvLine& a, const PvLine& b) {
+        return a.multipv < b.multipv;
+    });
+
+    if (fen != fen_) {
+        beginResetModel();
+        fen_ = fen;
+        rows_.clear();
+        rows_.reserve(lines.size());
+        for (const auto& line : lines) {
+            rows_.push_back(Row{line.multipv, line.score, line.depth, line.pv, formatLine(line.pv)});
+        }
+        endResetModel();
+        return;
+    }
+
+    const std::size_t common = std::min(rows_.size(), lines.size());
+    for (std::size_t i = 0; i < common; ++i) {
+        Row& row = rows_[i];
+        const PvLine& line = lines[i];
+        const bool samePv = row.pv == line.pv;
+        if (samePv && row.multipv == line.multipv && row.depth == line.depth
+            && row.score.type == line.score.type && row.score.value == line.score.value) {
+            continue;
+        }
+        row.multipv = line.multipv;
+        row.score = line.score;
+        row.depth = line.depth;
+        if (!samePv) {
+            row.pv = line.pv;
+            row.text = formatLine(line.pv);
+        }
+        const int r = static_cast<int>(i);
+        emit dataChanged(index(r, 0), index(r, ColumnCount - 1));
+    }
+
+    if (lines.size() > rows_.size()) {
+        beginInsertRows(QModelIndex(), static_cast<int>(rows_.size()), static_cast<int>(lines.size()) - 1);
+        for (std::size_t i = rows_.size(); i < lines.size(); ++i) {
+            const PvLine& line = lines[i];
+            rows_.push_back(Row{line.multipv, line.score, line.depth, line.pv, formatLine(line.pv)});
+        }
+        endInsertRows();
+    } else if (lines.size() < rows_.size()) {
+        beginRemoveRows(QModelIndex(), static_cast<int>(lines.size()), static_cast<int>(rows_.size()) - 1);
+        rows_.resize(lines.size());
+        endRemoveRows();
+    }
+}
+
+void PvLinesModel::clear() {
+    if (fen_.empty() && rows_.empty()) {
+        return;
+    }
+    beginResetModel();
+    fen_.clear();
+    rows_.clear();
+    endResetModel();
+}
+
+int PvLinesModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int PvLinesModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant PvLinesModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= static_cast<int>(rows_.size())) {
+        return {};
+    }
+    const Row& row = rows_[static_cast<std::size_t>(index.row())];
+
+    if (role == Qt::TextAlignmentRole) {
+        return index.column() == ColLine
+            ? static_cast<int>(Qt::AlignLeft | Qt::AlignVCenter)
+            : static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+
+    switch (index.column()) {
+        case ColMultiPv:
+            return row.multipv;
+        case ColEval:
+            if (row.score.type == ScoreType::None) {
+                return {};
+            }
+            return QString::fromStdString(sf::client::domain::to_string(row.score));
+        case ColDepth:
+            return row.depth ? QVariant(*row.depth) : QVariant();
+        case ColLine:
+            return row.text;
+        default:
+            return {};
+    }
+}
+
+QVariant PvLinesModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+            case ColMultiPv: return QStringLiteral("#");
+            case ColEval:    return QStringLiteral("Eval");
+            case ColDepth:   return QStringLiteral("Depth");
+            case ColLine:    return QStringLiteral("Line");
+            default:         break;
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+} // namespace sf::client::ui
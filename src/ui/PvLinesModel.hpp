@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "domain/domain_model.hpp"
+#include "domain/pv_san_cache.hpp"
+
+namespace sf::client::ui {
+
+// One row per MultiPV line of the selected job, PV shown in SAN.
+//
+// setLines() diffs against what is shown: a new position resets the
+// model, otherwise only rows whose line changed emit dataChanged (and only
+// a changed PV is converted again, through the shared PvSanCache).
+class PvLinesModel final : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColMultiPv = 0,
+        ColEval,
+        ColDepth,
+        ColLine,
+        ColumnCount
+    };
+
+    explicit PvLinesModel(QObject* parent = nullptr);
+
+    // Lines in any order; rows follow multipv.
+    void setLines(const std::string& fen, std::vector<sf::client::domain::PvLine> lines);
+    void clear();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+private:
+    struct Row {
+        int                                 multipv{1};
+        sf::client::domain::Score           score;
+        std::optional<int>                  depth;
+        sf::client::domain::chess::MoveLine pv;
+        QString                             text; // numbered SAN
+    };
+
+    QString formatLine(const sf::client::domain::chess::MoveLine& pv);
+
+    std::string                           fen_;
+    std::vector<Row>                      rows_;
+    sf::client::domain::chess::PvSanCache sanCache_;
+};
+
+} // namespace sf::client::ui
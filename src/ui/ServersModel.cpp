@@ -8,9 +8,24 @@ namespace sf::client::ui {
 
 using sf::client::domain::ServerInfo;
 using sf::client::domain::ServerStatus;
+using sf::client::domain::ServerTelemetry;
 
 namespace {
 
+// 1234567 -> "1.23 M", 85000 -> "85 k".
+QString formatRate(double value) {
+    if (value >= 1e9) {
+        return QStringLiteral("%1 G").arg(value / 1e9, 0, 'f', 2);
+    }
+    if (value >= 1e6) {
+        return QStringLiteral("%1 M").arg(value / 1e6, 0, 'f', 2);
+    }
+    if (value >= 1e4) {
+        return QStringLiteral("%1 k").arg(value / 1e3, 0, 'f', 0);
+    }
+    return QString::number(value, 'f', value < 10.0 ? 1 : 0);
+}
+
 QString statusText(ServerStatus s) {
     switch (s) {
         case ServerStatus::Online:
@@ -81,6 +96,26 @@ QVariant ServersModel::displayData(const ServerInfo& s, Column col) const {
             return s.threadsPerJob;
         case ColMaxJobs:
             return (s.runtime.maxJobs > 0 ? s.runtime.maxJobs : s.maxJobs);
+        case ColEngines:
+            // busy / warm pool size
+            if (s.runtime.enginePoolSize <= 0 && s.runtime.enginePoolBusy <= 0) {
+                return QStringLiteral("-");
+            }
+            return QStringLiteral("%1 / %2").arg(s.runtime.enginePoolBusy).arg(s.runtime.enginePoolSize);
+        case ColNps:
+            if (s.runtime.telemetry.reportingJobs == 0) {
+                return QStringLiteral("-");
+            }
+            return formatRate(static_cast<double>(s.runtime.telemetry.aggregateNps));
+        case ColRtt:
+            if (s.runtime.telemetry.rttMs < 0.0) {
+                return QStringLiteral("-");
+            }
+            return QStringLiteral("%1 ms").arg(s.runtime.telemetry.rttMs, 0, 'f', 1);
+        case ColMessageRate:
+            return formatRate(s.runtime.telemetry.messagesPerSecond);
+        case ColBandwidth:
+            return QStringLiteral("%1 KB/s").arg(s.runtime.telemetry.bytesPerSecond / 1024.0, 0, 'f', 1);
         default:
             return {};
     }
@@ -93,6 +128,34 @@ QVariant ServersModel::backgroundData(const ServerInfo& s, Column col) const {
     return statusBrush(s.runtime.status);
 }
 
+QVariant ServersModel::toolTipData(const ServerInfo& s, Column col) const {
+    const ServerTelemetry& t = s.runtime.telemetry;
+    switch (col) {
+        case ColNps:
+            return QStringLiteral("Sum of the latest NPS of %1 running job(s)").arg(t.reportingJobs);
+        case ColRtt:
+            return QStringLiteral("Ping round trip (servers without pong support show -)");
+        case ColCores:
+        case ColThreadsPerJob:
+            if (s.runtime.numaNodes <= 0) {
+                return {};
+            }
+            return QStringLiteral("Engines pinned to disjoint CPU sets over %1 NUMA node(s)\n"
+                                  "%2 CPU(s) free, next job gets %3 thread(s)")
+                .arg(s.runtime.numaNodes)
+                .arg(s.runtime.freeCpus)
+                .arg(s.runtime.nextJobThreads);
+        case ColMessageRate:
+        case ColBandwidth:
+            return QStringLiteral("%1 messages, %2 MB received\n%3 \u00b5s decoding per message")
+                .arg(t.messagesReceived)
+                .arg(t.bytesReceived / (1024.0 * 1024.0), 0, 'f', 1)
+                .arg(t.parseMicrosPerMessage, 0, 'f', 1);
+        default:
+            return {};
+    }
+}
+
 QVariant ServersModel::alignmentData(Column col) const {
     switch (col) {
         case ColPort:
@@ -101,6 +164,11 @@ QVariant ServersModel::alignmentData(Column col) const {
         case ColCores:
         case ColThreadsPerJob:
         case ColMaxJobs:
+        case ColEngines:
+        case ColNps:
+        case ColRtt:
+        case ColMessageRate:
+        case ColBandwidth:
             return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
         case ColStatus:
             return static_cast<int>(Qt::AlignCenter);
@@ -133,6 +201,9 @@ QVariant ServersModel::data(const QModelIndex& index, int role) const {
     if (role == Qt::TextAlignmentRole) {
         return alignmentData(colEnum);
     }
+    if (role == Qt::ToolTipRole) {
+        return toolTipData(s, colEnum);
+    }
 
     return {};
 }
@@ -160,6 +231,16 @@ QVariant ServersModel::headerData(int section, Qt::Orientation orientation, int
                 return QStringLiteral("Threads/job");
             case ColMaxJobs:
                 return QStringLiteral("Max jobs");
+            case ColEngines:
+                return QStringLiteral("Engines");
+            case ColNps:
+                return QStringLiteral("NPS");
+            case ColRtt:
+                return QStringLiteral("RTT");
+            case ColMessageRate:
+                return QStringLiteral("Msgs/s");
+            case ColBandwidth:
+                return QStringLiteral("Received");
             default:
                 break;
         }
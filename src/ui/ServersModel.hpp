@@ -31,12 +31,18 @@ private:
         ColCores,
         ColThreadsPerJob,
         ColMaxJobs,
+        ColEngines,
+        ColNps,
+        ColRtt,
+        ColMessageRate,
+        ColBandwidth,
         ColumnCount
     };
 
     QVariant displayData(const sf::client::domain::ServerInfo& server, Column col) const;
     QVariant backgroundData(const sf::client::domain::ServerInfo& server, Column col) const;
     QVariant alignmentData(Column col) const;
+    QVariant toolTipData(const sf::client::domain::ServerInfo& server, Column col) const;
 
     std::vector<sf::client::domain::ServerInfo> servers_;
 };